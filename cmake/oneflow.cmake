@@ -142,6 +142,9 @@ foreach(oneflow_single_file ${oneflow_all_src})
     elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/(core|user|xrt)/.*_test\\.cpp$")
       # test file
       list(APPEND of_all_test_cc ${oneflow_single_file})
+    elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/(core|user)/.*_benchmark\\.cpp$")
+      # benchmark file
+      list(APPEND of_benchmark_cc ${oneflow_single_file})
     elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/core/graph/.*\\.cpp$")
     else()
       # not test file
@@ -160,6 +163,18 @@ foreach(oneflow_single_file ${oneflow_all_src})
   endif()
 endforeach()
 
+# math functions do not set errno in the cpu model update and elementwise math kernels, so that
+# their loops calling sqrt vectorize, nothing there reading errno after a math call. The loops are
+# templates of cpu_elementwise.h, so the flag goes on the sources instantiating them, and loops
+# instantiated in any other source still set errno
+if(NOT WIN32)
+  set_source_files_properties(
+    ${PROJECT_SOURCE_DIR}/oneflow/user/kernels/model_update_kernel_util.cpp
+    ${PROJECT_SOURCE_DIR}/oneflow/user/kernels/math_unary_elementwise_kernel.cpp
+    ${PROJECT_SOURCE_DIR}/oneflow/user/kernels/math_binary_elementwise_kernel.cpp
+    PROPERTIES COMPILE_FLAGS -fno-math-errno)
+endif()
+
 # clang format
 add_custom_target(of_format
   COMMAND ${Python_EXECUTABLE} ${CMAKE_CURRENT_SOURCE_DIR}/ci/check/run_license_format.py -i ${CMAKE_CURRENT_SOURCE_DIR}/oneflow --fix
@@ -237,7 +252,7 @@ add_dependencies(of_pyext_obj of_ccobj)
 if(APPLE)
   set(of_libs -Wl,-force_load of_ccobj of_protoobj of_cfgobj)
 elseif(UNIX)
-  set(of_libs -Wl,--whole-archive of_ccobj of_protoobj of_cfgobj -Wl,--no-whole-archive -ldl)
+  set(of_libs -Wl,--whole-archive of_ccobj of_protoobj of_cfgobj -Wl,--no-whole-archive -ldl -lrt)
 elseif(WIN32)
   set(of_libs of_ccobj of_protoobj of_cfgobj)
   set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} /WHOLEARCHIVE:of_ccobj")
@@ -349,6 +364,15 @@ foreach(cc ${of_transport_test_cc})
   set_target_properties(${transport_test_exe_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
 endforeach()
 
+# build benchmark
+if(BUILD_TESTING)
+  foreach(cc ${of_benchmark_cc})
+    get_filename_component(benchmark_name ${cc} NAME_WE)
+    oneflow_add_executable(${benchmark_name} ${cc})
+    target_link_libraries(${benchmark_name} ${of_libs} ${oneflow_third_party_libs})
+    set_target_properties(${benchmark_name} PROPERTIES RUNTIME_OUTPUT_DIRECTORY "${PROJECT_BINARY_DIR}/bin")
+  endforeach()
+endif()
 
 # build include
 set(ONEFLOW_INCLUDE_DIR "${PROJECT_BINARY_DIR}/python_scripts/oneflow/include")
@@ -642,14 +642,16 @@ void Actor::HandleConsumedNaiveDataRegstToProducer(std::function<bool(Regst*)> I
 }
 
 void Actor::AsyncSendEORDMsgForAllProducedRegstDesc() {
+  SendSyncQueuedMsg();
   for (auto& pair : produced_regsts_) {
     CHECK(!pair.second.empty());
     const RtRegstDesc* regst_desc = pair.second.front()->regst_desc();
     device_ctx_->AddCallBack([regst_desc]() {
+      std::deque<ActorMsg> msgs;
       for (int64_t consumer : regst_desc->consumers_actor_id()) {
-        Global<ActorMsgBus>::Get()->SendMsg(
-            ActorMsg::BuildEordMsg(consumer, regst_desc->regst_desc_id()));
+        msgs.push_back(ActorMsg::BuildEordMsg(consumer, regst_desc->regst_desc_id()));
       }
+      Global<ActorMsgBus>::Get()->SendMsgs(msgs);
     });
   }
 }
@@ -703,7 +705,7 @@ void Actor::EnqueueAsyncMsg(const ActorMsg& msg) {
   if (is_kernel_launch_synchronized_
       && GetGlobalWorkStreamId()
              == Global<IDMgr>::Get()->GlobalWorkStreamId4ActorId(msg.dst_actor_id())) {
-    Global<ActorMsgBus>::Get()->SendMsg(msg);
+    sync_msg_queue_.push_back(msg);
   } else {
     async_msg_queue_.push_back(msg);
   }
@@ -745,12 +747,18 @@ std::unique_ptr<Actor> NewActor(const TaskProto& task_proto, const ThreadCtx& th
 }
 
 void Actor::AsyncSendQueuedMsg() {
+  SendSyncQueuedMsg();
   if (!async_msg_queue_.empty()) {
     std::deque<ActorMsg> msgs;
     msgs.swap(async_msg_queue_);
-    device_ctx_->AddCallBack([msgs]() {
-      for (const ActorMsg& msg : msgs) { Global<ActorMsgBus>::Get()->SendMsg(msg); }
-    });
+    device_ctx_->AddCallBack([msgs]() { Global<ActorMsgBus>::Get()->SendMsgs(msgs); });
+  }
+}
+
+void Actor::SendSyncQueuedMsg() {
+  if (!sync_msg_queue_.empty()) {
+    Global<ActorMsgBus>::Get()->SendMsgs(sync_msg_queue_);
+    sync_msg_queue_.clear();
   }
 }
 
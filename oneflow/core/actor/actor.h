@@ -41,7 +41,11 @@ class Actor {
 
   // 1: success, and actor finish
   // 0: success, and actor not finish
-  int ProcessMsg(const ActorMsg& msg) { return (this->*msg_handler_)(msg); }
+  int ProcessMsg(const ActorMsg& msg) {
+    int ret = (this->*msg_handler_)(msg);
+    SendSyncQueuedMsg();
+    return ret;
+  }
 
   int64_t machine_id() const { return Global<IDMgr>::Get()->MachineId4ActorId(actor_id_); }
   int64_t thrd_id() const { return Global<IDMgr>::Get()->ThrdId4ActorId(actor_id_); }
@@ -194,6 +198,7 @@ class Actor {
   virtual void VirtualAsyncSendNaiveConsumedRegstMsgToProducer();
   void AsyncSendConsumedCtrlRegstMsgToProducer();
   void AsyncSendProducedCtrlRegstMsgToConsumer();
+  void SendSyncQueuedMsg();
 
   // Customized Consumed virtual func
   virtual void ForEachCurCustomizedReadableRegst(std::function<void(const Regst*)>) const {}
@@ -249,6 +254,8 @@ class Actor {
   HashMap<int64_t, int64_t> inplace_regst_desc_id_out2in_;
 
   std::deque<ActorMsg> async_msg_queue_;
+  // msgs which need no callback, buffered during an act and sent per destination thread at once
+  std::deque<ActorMsg> sync_msg_queue_;
   bool is_kernel_launch_synchronized_;
   std::vector<int64_t> tmp_regst_desc_id_vec_;
 };
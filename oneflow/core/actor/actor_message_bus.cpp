@@ -21,6 +21,22 @@ limitations under the License.
 
 namespace oneflow {
 
+ActorMsgBus::ActorMsgBus() : flush_cnt_(0), flushed_msg_cnt_(0) {
+  for (auto& cnt : enqueue_size_histogram_) { cnt.store(0); }
+}
+
+ActorMsgBus::~ActorMsgBus() {
+  if (flush_cnt_ == 0) { return; }
+  std::string histogram;
+  FOR_RANGE(int64_t, i, 0, kEnqueueSizeBucketNum) {
+    histogram += " [" + std::to_string(1 << i) + ", "
+                 + (i == kEnqueueSizeBucketNum - 1 ? "inf" : std::to_string(1 << (i + 1)))
+                 + "): " + std::to_string(enqueue_size_histogram_.at(i).load());
+  }
+  LOG(INFO) << "actor msg bus flushed " << flushed_msg_cnt_ << " msgs in " << flush_cnt_
+            << " flushes, msgs per thread enqueue:" << histogram;
+}
+
 void ActorMsgBus::SendMsg(const ActorMsg& msg) {
   int64_t dst_machine_id = Global<IDMgr>::Get()->MachineId4ActorId(msg.dst_actor_id());
   if (dst_machine_id == Global<MachineCtx>::Get()->this_machine_id()) {
@@ -37,4 +53,37 @@ void ActorMsgBus::SendMsgWithoutCommNet(const ActorMsg& msg) {
   Global<ThreadMgr>::Get()->GetThrd(thrd_id)->EnqueueActorMsg(msg);
 }
 
+void ActorMsgBus::SendMsgs(const std::deque<ActorMsg>& msgs) {
+  if (msgs.empty()) { return; }
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  // an act only talks to a few threads, so a linear search beats hashing here
+  std::vector<std::pair<int64_t, std::vector<ActorMsg>>> thrd_id7msgs;
+  for (const ActorMsg& msg : msgs) {
+    int64_t dst_machine_id = Global<IDMgr>::Get()->MachineId4ActorId(msg.dst_actor_id());
+    if (dst_machine_id != this_machine_id) {
+      Global<CommNet>::Get()->SendActorMsg(dst_machine_id, msg);
+      continue;
+    }
+    int64_t thrd_id = Global<IDMgr>::Get()->ThrdId4ActorId(msg.dst_actor_id());
+    auto it = std::find_if(thrd_id7msgs.begin(), thrd_id7msgs.end(),
+                           [thrd_id](const std::pair<int64_t, std::vector<ActorMsg>>& pair) {
+                             return pair.first == thrd_id;
+                           });
+    if (it == thrd_id7msgs.end()) {
+      thrd_id7msgs.emplace_back(thrd_id, std::vector<ActorMsg>());
+      it = thrd_id7msgs.end() - 1;
+    }
+    it->second.push_back(msg);
+  }
+  for (const auto& pair : thrd_id7msgs) {
+    Global<ThreadMgr>::Get()->GetThrd(pair.first)->EnqueueActorMsgs(pair.second);
+    const int64_t msg_cnt = pair.second.size();
+    int64_t bucket = 0;
+    while (bucket < kEnqueueSizeBucketNum - 1 && (int64_t(2) << bucket) <= msg_cnt) { ++bucket; }
+    enqueue_size_histogram_.at(bucket).fetch_add(1, std::memory_order_relaxed);
+  }
+  flush_cnt_.fetch_add(1, std::memory_order_relaxed);
+  flushed_msg_cnt_.fetch_add(msgs.size(), std::memory_order_relaxed);
+}
+
 }  // namespace oneflow
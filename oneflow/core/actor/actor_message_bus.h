@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_ACTOR_ACTOR_MESSAGE_BUS_H_
 #define ONEFLOW_CORE_ACTOR_ACTOR_MESSAGE_BUS_H_
 
+#include <array>
+#include <deque>
 #include "oneflow/core/actor/actor_message.h"
 #include "oneflow/core/common/util.h"
 
@@ -24,14 +26,22 @@ namespace oneflow {
 class ActorMsgBus final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ActorMsgBus);
-  ~ActorMsgBus() = default;
+  ~ActorMsgBus();
 
   void SendMsg(const ActorMsg& msg);
   void SendMsgWithoutCommNet(const ActorMsg& msg);
+  // messages to the same local thread are enqueued with a single enqueue, keeping their order
+  void SendMsgs(const std::deque<ActorMsg>& msgs);
 
  private:
   friend class Global<ActorMsgBus>;
-  ActorMsgBus() = default;
+  ActorMsgBus();
+
+  // bucket i counts the thread enqueues of SendMsgs which carried [2^i, 2^(i+1)) messages
+  static const int64_t kEnqueueSizeBucketNum = 8;
+  std::atomic<int64_t> flush_cnt_;
+  std::atomic<int64_t> flushed_msg_cnt_;
+  std::array<std::atomic<int64_t>, kEnqueueSizeBucketNum> enqueue_size_histogram_;
 };
 
 }  // namespace oneflow
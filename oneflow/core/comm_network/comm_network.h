@@ -23,6 +23,7 @@ limitations under the License.
 #include "oneflow/core/job/plan.pb.h"
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/range.h"
 
 namespace oneflow {
 
@@ -43,6 +44,11 @@ class CommNet {
   virtual void* RegisterMemory(void* ptr, size_t byte_size) = 0;
   virtual void UnRegisterMemory(void* token) = 0;
   virtual void RegisterMemoryDone() = 0;
+  // the registered memory holds fp32 gradients from fp32_offset on, in fp32_ranges of the values
+  // from there, the rest being padding. The regst opted in at compile time. A comm net may send
+  // them lossy encoded if it is configured to, the others ignore it.
+  virtual void MarkFp32Memory(void* token, size_t fp32_offset,
+                              const std::vector<Range>& fp32_ranges) {}
 
   // Stream
   void* NewActorReadId();
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+#include "oneflow/core/comm_network/epoll/wire_codec.h"
 #include "glog/logging.h"
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/job/machine_context.h"
@@ -38,7 +39,7 @@ sockaddr_in GetSockAddr(const std::string& addr, uint16_t port) {
   return sa;
 }
 
-int SockListen(int listen_sockfd, uint16_t listen_port, int32_t total_machine_num) {
+int SockListen(int listen_sockfd, uint16_t listen_port, int32_t backlog) {
   sockaddr_in sa = GetSockAddr("0.0.0.0", listen_port);
   int reuse = 1;
   int ret_setopt =
@@ -46,7 +47,7 @@ int SockListen(int listen_sockfd, uint16_t listen_port, int32_t total_machine_nu
   CHECK_EQ(ret_setopt, 0);
   int bind_result = bind(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa));
   if (bind_result == 0) {
-    PCHECK(listen(listen_sockfd, total_machine_num) == 0);
+    PCHECK(listen(listen_sockfd, backlog) == 0);
     LOG(INFO) << "CommNet:Epoll listening on "
               << "0.0.0.0:" + std::to_string(listen_port);
   } else {
@@ -55,14 +56,15 @@ int SockListen(int listen_sockfd, uint16_t listen_port, int32_t total_machine_nu
   return bind_result;
 }
 
-int64_t GetMachineId(const sockaddr_in& sa) {
-  char addr[INET_ADDRSTRLEN];
-  memset(addr, '\0', sizeof(addr));
-  PCHECK(inet_ntop(AF_INET, &(sa.sin_addr), addr, INET_ADDRSTRLEN));
-  for (int64_t i = 0; i < Global<ResourceDesc, ForSession>::Get()->TotalMachineNum(); ++i) {
-    if (Global<ResourceDesc, ForSession>::Get()->machine(i).addr() == addr) { return i; }
-  }
-  UNIMPLEMENTED();
+// sent right after connecting, the order of accepting is not the order of connecting and the
+// address does not tell apart several processes on one host
+struct SocketHandshake {
+  int64_t machine_id;
+  int32_t socket_idx;
+};
+
+std::string GenShmNameKey(int64_t src_machine_id, int64_t dst_machine_id) {
+  return "EpollShmName/" + std::to_string(src_machine_id) + "/" + std::to_string(dst_machine_id);
 }
 
 std::string GenPortKey(int64_t machine_id) { return "EpollPort/" + std::to_string(machine_id); }
@@ -80,6 +82,21 @@ uint16_t PullPort(int64_t machine_id) {
 }  // namespace
 
 EpollCommNet::~EpollCommNet() {
+  const SocketWriteStats stats = GetSocketWriteStats();
+  LOG(INFO) << "CommNet socket write msg: " << stats.msg_cnt << " bytes: " << stats.byte_cnt
+            << " syscalls: " << stats.write_syscall_cnt
+            << " blocked syscalls: " << stats.blocked_write_cnt
+            << " zerocopy bytes: " << stats.zerocopy_byte_cnt
+            << " zerocopy copied sends: " << stats.zerocopy_copied_cnt;
+  int64_t shm_byte_cnt = 0;
+  for (const auto& pair : machine_id2shm_write_helper_) { shm_byte_cnt += pair.second->byte_cnt(); }
+  LOG(INFO) << "CommNet shared memory write bytes: " << shm_byte_cnt;
+  const WireCodecStats codec_stats = GetWireCodecStats();
+  LOG(INFO) << "CommNet wire codec bodies: " << codec_stats.body_cnt
+            << " bytes saved: " << codec_stats.raw_byte_cnt - codec_stats.encoded_byte_cnt
+            << " of: " << codec_stats.raw_byte_cnt
+            << " encode ms: " << codec_stats.encode_nanos / 1000000
+            << " decode ms: " << codec_stats.decode_nanos / 1000000;
   for (size_t i = 0; i < pollers_.size(); ++i) {
     LOG(INFO) << "CommNet Thread " << i << " finish";
     pollers_[i]->Stop();
@@ -88,17 +105,27 @@ EpollCommNet::~EpollCommNet() {
   OF_SESSION_BARRIER();
   for (IOEventPoller* poller : pollers_) { delete poller; }
   for (auto& pair : sockfd2helper_) { delete pair.second; }
+  for (auto& pair : machine_id2shm_write_helper_) { delete pair.second; }
+  for (ShmReadHelper* shm_read_helper : shm_read_helpers_) { delete shm_read_helper; }
 }
 
 void EpollCommNet::RegisterMemoryDone() {
   // do nothing
 }
 
+void EpollCommNet::MarkFp32Memory(void* token, size_t fp32_offset,
+                                  const std::vector<Range>& fp32_ranges) {
+  auto mem_desc = static_cast<SocketMemDesc*>(token);
+  CHECK_LE(fp32_offset, mem_desc->byte_size);
+  mem_desc->fp32_offset = fp32_offset;
+  mem_desc->fp32_ranges = fp32_ranges;
+}
+
 void EpollCommNet::SendActorMsg(int64_t dst_machine_id, const ActorMsg& actor_msg) {
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kActor;
   msg.actor_msg = actor_msg;
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(dst_machine_id)->AsyncWrite(msg);
 }
 
 void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg& transport_msg) {
@@ -109,13 +136,145 @@ void EpollCommNet::SendTransportMsg(int64_t dst_machine_id, const TransportMsg&
 }
 
 void EpollCommNet::SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg) {
-  GetSocketHelper(dst_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(dst_machine_id)->AsyncWrite(msg);
+}
+
+void EpollCommNet::SendRegstBody(int64_t dst_machine_id, void* src_token, void* dst_token,
+                                 void* read_id) {
+  SocketMemDesc* src_mem_desc = static_cast<SocketMemDesc*>(src_token);
+  const size_t byte_size = src_mem_desc->byte_size;
+  SocketMsg msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_type = SocketMsgType::kRequestRead;
+  msg.request_read_msg.src_token = src_token;
+  msg.request_read_msg.dst_token = dst_token;
+  msg.request_read_msg.read_id = read_id;
+  msg.request_read_msg.codec = kWireCodecNone;
+  msg.request_read_msg.fp32_offset = src_mem_desc->fp32_offset;
+  msg.request_read_msg.encoded_body = nullptr;
+  // the shared memory ring beats any codec
+  auto shm_it = machine_id2shm_write_helper_.find(dst_machine_id);
+  if (shm_it != machine_id2shm_write_helper_.end()) {
+    shm_it->second->AsyncWrite(msg);
+    return;
+  }
+  // encoded bodies are not striped, the receiver decodes them as a whole
+  const int64_t chunk_num = EncodeRegstBody(src_mem_desc, &msg.request_read_msg)
+                                ? 1
+                                : RegstBodyChunkNum(dst_machine_id, byte_size);
+  // consecutive bodies and chunks go to consecutive sockets
+  const int64_t first_stripe =
+      machine_id2next_stripe_[dst_machine_id].fetch_add(chunk_num, std::memory_order_relaxed);
+  if (chunk_num == 1) {
+    GetSocketHelper(dst_machine_id, first_stripe % stripe_socket_num_)->AsyncWrite(msg);
+    return;
+  }
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_type = SocketMsgType::kRequestReadChunk;
+  msg.request_read_chunk_msg.src_token = src_token;
+  msg.request_read_chunk_msg.dst_token = dst_token;
+  msg.request_read_chunk_msg.read_id = read_id;
+  msg.request_read_chunk_msg.chunk_num = chunk_num;
+  FOR_RANGE(int64_t, i, 0, chunk_num) {
+    msg.request_read_chunk_msg.offset = i * stripe_chunk_size_;
+    msg.request_read_chunk_msg.byte_size =
+        std::min(stripe_chunk_size_, byte_size - i * stripe_chunk_size_);
+    GetSocketHelper(dst_machine_id, (first_stripe + i) % stripe_socket_num_)->AsyncWrite(msg);
+  }
+}
+
+void EpollCommNet::RegstBodyChunkDone(void* read_id, int64_t chunk_num) {
+  {
+    // the first chunk received, whichever socket it came from, registers the count
+    std::unique_lock<std::mutex> lck(read_id2remaining_chunk_num_mtx_);
+    auto it = read_id2remaining_chunk_num_.emplace(read_id, chunk_num).first;
+    it->second -= 1;
+    if (it->second > 0) { return; }
+    read_id2remaining_chunk_num_.erase(it);
+  }
+  ReadDone(read_id);
+}
+
+bool EpollCommNet::EncodeRegstBody(SocketMemDesc* mem_desc, RequestReadMsg* msg) {
+  if (mem_desc->byte_size < wire_codec_min_size_) { return false; }
+  WireCodec codec = kWireCodecNone;
+  if (fp32_wire_codec_ != kWireCodecNone && mem_desc->fp32_offset >= 0) {
+    codec = fp32_wire_codec_;
+  } else if (enable_lz4_wire_codec_) {
+    codec = kWireCodecLz4;
+  } else {
+    return false;
+  }
+  const size_t fp32_offset = std::max<int64_t>(mem_desc->fp32_offset, 0);
+  const size_t max_encoded_size =
+      WireCodecMaxEncodedSize(codec, mem_desc->byte_size, fp32_offset, topk_ratio_);
+  if (max_encoded_size == 0) { return false; }
+  // the fp32 codecs have a fixed encoded size, skip them before top-k touches the residual
+  if (IsFp32WireCodec(codec) && max_encoded_size >= mem_desc->byte_size) { return false; }
+  float* topk_residual = nullptr;
+  if (codec == kWireCodecTopK) {
+    // a regst is not sent again before its last send is read, so nothing else touches it
+    mem_desc->topk_residual.resize(WireCodecFp32Num(mem_desc->byte_size, fp32_offset), 0);
+    topk_residual = mem_desc->topk_residual.data();
+  }
+  const double start = GetCurTime();
+  char* encoded_body = new char[max_encoded_size];
+  const size_t encoded_size = WireEncode(codec, static_cast<const char*>(mem_desc->mem_ptr),
+                                         mem_desc->byte_size, fp32_offset, mem_desc->fp32_ranges,
+                                         topk_ratio_, topk_residual, encoded_body);
+  wire_codec_encode_nanos_.fetch_add(GetCurTime() - start, std::memory_order_relaxed);
+  if (encoded_size >= mem_desc->byte_size) {
+    // incompressible, e.g. already compressed images
+    delete[] encoded_body;
+    return false;
+  }
+  msg->codec = codec;
+  msg->encoded_size = encoded_size;
+  msg->encoded_body = encoded_body;
+  wire_codec_body_cnt_.fetch_add(1, std::memory_order_relaxed);
+  wire_codec_raw_byte_cnt_.fetch_add(mem_desc->byte_size, std::memory_order_relaxed);
+  wire_codec_encoded_byte_cnt_.fetch_add(encoded_size, std::memory_order_relaxed);
+  return true;
+}
+
+void EpollCommNet::DecodeRegstBody(const RequestReadMsg& msg, const char* encoded_body) {
+  auto dst_mem_desc = static_cast<const SocketMemDesc*>(msg.dst_token);
+  const double start = GetCurTime();
+  WireDecode(msg.codec, encoded_body, msg.encoded_size, std::max<int64_t>(msg.fp32_offset, 0),
+             static_cast<char*>(dst_mem_desc->mem_ptr), dst_mem_desc->byte_size);
+  wire_codec_decode_nanos_.fetch_add(GetCurTime() - start, std::memory_order_relaxed);
+}
+
+SocketWriteStats EpollCommNet::GetSocketWriteStats() const {
+  SocketWriteStats stats;
+  memset(&stats, 0, sizeof(stats));
+  for (const auto& pair : sockfd2helper_) {
+    const SocketWriteStats helper_stats = pair.second->GetWriteStats();
+    stats.msg_cnt += helper_stats.msg_cnt;
+    stats.byte_cnt += helper_stats.byte_cnt;
+    stats.write_syscall_cnt += helper_stats.write_syscall_cnt;
+    stats.blocked_write_cnt += helper_stats.blocked_write_cnt;
+    stats.zerocopy_byte_cnt += helper_stats.zerocopy_byte_cnt;
+    stats.zerocopy_copied_cnt += helper_stats.zerocopy_copied_cnt;
+  }
+  return stats;
+}
+
+WireCodecStats EpollCommNet::GetWireCodecStats() const {
+  WireCodecStats stats;
+  stats.body_cnt = wire_codec_body_cnt_.load();
+  stats.raw_byte_cnt = wire_codec_raw_byte_cnt_.load();
+  stats.encoded_byte_cnt = wire_codec_encoded_byte_cnt_.load();
+  stats.encode_nanos = wire_codec_encode_nanos_.load();
+  stats.decode_nanos = wire_codec_decode_nanos_.load();
+  return stats;
 }
 
 SocketMemDesc* EpollCommNet::NewMemDesc(void* ptr, size_t byte_size) {
   SocketMemDesc* mem_desc = new SocketMemDesc;
   mem_desc->mem_ptr = ptr;
   mem_desc->byte_size = byte_size;
+  mem_desc->fp32_offset = -1;
   return mem_desc;
 }
 
@@ -123,6 +282,7 @@ EpollCommNet::EpollCommNet() {
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
+  InitShmTransport();
   for (IOEventPoller* poller : pollers_) { poller->Start(); }
 }
 
@@ -130,6 +290,7 @@ EpollCommNet::EpollCommNet(const Plan& plan) : CommNetIf(plan) {
   pollers_.resize(Global<ResourceDesc, ForSession>::Get()->CommNetWorkerNum(), nullptr);
   for (size_t i = 0; i < pollers_.size(); ++i) { pollers_[i] = new IOEventPoller; }
   InitSockets();
+  InitShmTransport();
   for (IOEventPoller* poller : pollers_) { poller->Start(); }
 }
 
@@ -137,26 +298,45 @@ void EpollCommNet::InitSockets() {
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   auto this_machine = Global<ResourceDesc, ForSession>::Get()->machine(this_machine_id);
   int64_t total_machine_num = Global<ResourceDesc, ForSession>::Get()->TotalMachineNum();
-  machine_id2sockfd_.assign(total_machine_num, -1);
+  const EpollCommNetConf conf = Global<ResourceDesc, ForSession>::Get()->epoll_comm_net_conf();
+  stripe_socket_num_ = std::max<int32_t>(conf.stripe_socket_num(), 1);
+  stripe_chunk_size_ = std::max<int64_t>(conf.stripe_chunk_kbyte(), 1) << 10;
+  enable_low_latency_lane_ = conf.enable_low_latency_lane();
+  enable_lz4_wire_codec_ = conf.enable_lz4_wire_codec();
+  fp32_wire_codec_ = conf.fp32_wire_codec();
+  CHECK(fp32_wire_codec_ == kWireCodecNone || IsFp32WireCodec(fp32_wire_codec_));
+  wire_codec_min_size_ = conf.wire_codec_min_kbyte() << 10;
+  topk_ratio_ = conf.topk_ratio();
+  CHECK(topk_ratio_ > 0 && topk_ratio_ <= 1);
+  wire_codec_body_cnt_ = 0;
+  wire_codec_raw_byte_cnt_ = 0;
+  wire_codec_encoded_byte_cnt_ = 0;
+  wire_codec_encode_nanos_ = 0;
+  wire_codec_decode_nanos_ = 0;
+  const int32_t socket_num_per_peer = stripe_socket_num_ + (enable_low_latency_lane_ ? 1 : 0);
+  machine_id2sockfds_.assign(total_machine_num, std::vector<int>(socket_num_per_peer, -1));
+  machine_id2next_stripe_.reset(new std::atomic<int64_t>[total_machine_num]);
+  FOR_RANGE(int64_t, machine_id, 0, total_machine_num) { machine_id2next_stripe_[machine_id] = 0; }
   sockfd2helper_.clear();
   size_t poller_idx = 0;
   auto NewSocketHelper = [&](int sockfd) {
     IOEventPoller* poller = pollers_[poller_idx];
     poller_idx = (poller_idx + 1) % pollers_.size();
-    return new SocketHelper(sockfd, poller);
+    return new SocketHelper(sockfd, poller, conf);
   };
 
   // listen
   int listen_sockfd = socket(AF_INET, SOCK_STREAM, 0);
   int32_t this_listen_port = Global<EnvDesc>::Get()->data_port();
+  const int32_t listen_backlog = total_machine_num * socket_num_per_peer;
   if (this_listen_port != -1) {
-    CHECK_EQ(SockListen(listen_sockfd, this_listen_port, total_machine_num), 0);
+    CHECK_EQ(SockListen(listen_sockfd, this_listen_port, listen_backlog), 0);
     PushPort(this_machine_id,
              ((this_machine.data_port_agent() != -1) ? (this_machine.data_port_agent())
                                                      : (this_listen_port)));
   } else {
     for (this_listen_port = 1024; this_listen_port < GetMaxVal<uint16_t>(); ++this_listen_port) {
-      if (SockListen(listen_sockfd, this_listen_port, total_machine_num) == 0) {
+      if (SockListen(listen_sockfd, this_listen_port, listen_backlog) == 0) {
         PushPort(this_machine_id, this_listen_port);
         break;
       }
@@ -174,39 +354,100 @@ void EpollCommNet::InitSockets() {
     uint16_t peer_port = PullPort(peer_id);
     auto peer_machine = Global<ResourceDesc, ForSession>::Get()->machine(peer_id);
     sockaddr_in peer_sockaddr = GetSockAddr(peer_machine.addr(), peer_port);
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    const int val = 1;
-    PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
-    PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
-           == 0);
-    CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    machine_id2sockfd_[peer_id] = sockfd;
+    FOR_RANGE(int32_t, socket_idx, 0, socket_num_per_peer) {
+      int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+      const int val = 1;
+      PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+      PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), sizeof(peer_sockaddr))
+             == 0);
+      SocketHandshake handshake;
+      handshake.machine_id = this_machine_id;
+      handshake.socket_idx = socket_idx;
+      PCHECK(write(sockfd, &handshake, sizeof(handshake)) == sizeof(handshake));
+      CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
+      machine_id2sockfds_[peer_id][socket_idx] = sockfd;
+    }
   }
 
   // accept
-  FOR_RANGE(int32_t, idx, 0, src_machine_count) {
+  FOR_RANGE(int32_t, idx, 0, src_machine_count * socket_num_per_peer) {
     sockaddr_in peer_sockaddr;
     socklen_t len = sizeof(peer_sockaddr);
     int sockfd = accept(listen_sockfd, reinterpret_cast<sockaddr*>(&peer_sockaddr), &len);
     PCHECK(sockfd != -1);
+    SocketHandshake handshake;
+    PCHECK(recv(sockfd, &handshake, sizeof(handshake), MSG_WAITALL) == sizeof(handshake));
+    const int64_t peer_machine_id = handshake.machine_id;
+    const int32_t socket_idx = handshake.socket_idx;
+    CHECK(peer_machine_id >= 0 && peer_machine_id < this_machine_id);
+    CHECK(socket_idx >= 0 && socket_idx < socket_num_per_peer);
+    CHECK_EQ(machine_id2sockfds_[peer_machine_id][socket_idx], -1);
     CHECK(sockfd2helper_.emplace(sockfd, NewSocketHelper(sockfd)).second);
-    int64_t peer_machine_id = GetMachineId(peer_sockaddr);
-    machine_id2sockfd_[peer_machine_id] = sockfd;
+    machine_id2sockfds_[peer_machine_id][socket_idx] = sockfd;
   }
   PCHECK(close(listen_sockfd) == 0);
   ClearPort(this_machine_id);
 
   // useful log
   FOR_RANGE(int64_t, machine_id, 0, total_machine_num) {
-    LOG(INFO) << "machine " << machine_id << " sockfd " << machine_id2sockfd_[machine_id];
+    std::string sockfds;
+    for (int sockfd : machine_id2sockfds_[machine_id]) {
+      sockfds += (sockfds.empty() ? "" : ",") + std::to_string(sockfd);
+    }
+    LOG(INFO) << "machine " << machine_id << " sockfd " << sockfds;
   }
 }
 
-SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id) {
-  int sockfd = machine_id2sockfd_.at(machine_id);
+SocketHelper* EpollCommNet::GetSocketHelper(int64_t machine_id, int32_t socket_idx) {
+  int sockfd = machine_id2sockfds_.at(machine_id).at(socket_idx);
   return sockfd2helper_.at(sockfd);
 }
 
+SocketHelper* EpollCommNet::GetCtrlSocketHelper(int64_t machine_id) {
+  return GetSocketHelper(machine_id, enable_low_latency_lane_ ? stripe_socket_num_ : 0);
+}
+
+void EpollCommNet::InitShmTransport() {
+  const EpollCommNetConf conf = Global<ResourceDesc, ForSession>::Get()->epoll_comm_net_conf();
+  if (!conf.enable_shm_transport()) { return; }
+  const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  const std::string& this_addr =
+      Global<ResourceDesc, ForSession>::Get()->machine(this_machine_id).addr();
+  std::vector<int64_t> shm_peer_machine_ids;
+  for (int64_t peer_id : peer_machine_id()) {
+    if (Global<ResourceDesc, ForSession>::Get()->machine(peer_id).addr() == this_addr) {
+      shm_peer_machine_ids.push_back(peer_id);
+    }
+  }
+  // the reader creates the ring, the pid tells apart the jobs running on the host
+  for (int64_t peer_id : shm_peer_machine_ids) {
+    const std::string shm_name = "/oneflow_" + std::to_string(getpid()) + "_"
+                                 + std::to_string(peer_id) + "_" + std::to_string(this_machine_id);
+    shm_read_helpers_.push_back(new ShmReadHelper(shm_name, conf.shm_ring_mbyte() << 20));
+    Global<CtrlClient>::Get()->PushKV(GenShmNameKey(peer_id, this_machine_id), shm_name);
+  }
+  for (int64_t peer_id : shm_peer_machine_ids) {
+    std::string shm_name;
+    Global<CtrlClient>::Get()->PullKV(GenShmNameKey(this_machine_id, peer_id), &shm_name);
+    CHECK(machine_id2shm_write_helper_.emplace(peer_id, new ShmWriteHelper(shm_name)).second);
+  }
+  // no name is needed once every writer has mapped its ring
+  OF_SESSION_BARRIER();
+  for (ShmReadHelper* shm_read_helper : shm_read_helpers_) { shm_read_helper->Unlink(); }
+  for (int64_t peer_id : shm_peer_machine_ids) {
+    Global<CtrlClient>::Get()->ClearKV(GenShmNameKey(peer_id, this_machine_id));
+    LOG(INFO) << "machine " << peer_id << " regst bodies through shared memory";
+  }
+}
+
+int64_t EpollCommNet::RegstBodyChunkNum(int64_t peer_machine_id, size_t byte_size) const {
+  if (machine_id2shm_write_helper_.find(peer_machine_id) != machine_id2shm_write_helper_.end()) {
+    return 1;
+  }
+  if (stripe_socket_num_ == 1 || byte_size <= stripe_chunk_size_) { return 1; }
+  return RoundUp(byte_size, stripe_chunk_size_) / stripe_chunk_size_;
+}
+
 void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) {
   SocketMsg msg;
   msg.msg_type = SocketMsgType::kRequestWrite;
@@ -214,7 +455,7 @@ void EpollCommNet::DoRead(void* read_id, int64_t src_machine_id, void* src_token
   msg.request_write_msg.dst_machine_id = Global<MachineCtx>::Get()->this_machine_id();
   msg.request_write_msg.dst_token = dst_token;
   msg.request_write_msg.read_id = read_id;
-  GetSocketHelper(src_machine_id)->AsyncWrite(msg);
+  GetCtrlSocketHelper(src_machine_id)->AsyncWrite(msg);
 }
 
 }  // namespace oneflow
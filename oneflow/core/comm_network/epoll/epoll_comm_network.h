@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_CORE_COMM_NETWORK_EPOLL_EPOLL_COMM_NETWORK_H_
 
 #include "oneflow/core/comm_network/comm_network.h"
+#include "oneflow/core/comm_network/epoll/shm_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_helper.h"
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
 
@@ -24,6 +25,15 @@ limitations under the License.
 
 namespace oneflow {
 
+struct WireCodecStats {
+  int64_t body_cnt;
+  // sizes of the encoded bodies before and after encoding
+  int64_t raw_byte_cnt;
+  int64_t encoded_byte_cnt;
+  int64_t encode_nanos;
+  int64_t decode_nanos;
+};
+
 class EpollCommNet final : public CommNetIf<SocketMemDesc> {
  public:
   OF_DISALLOW_COPY_AND_MOVE(EpollCommNet);
@@ -34,10 +44,21 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   }
 
   void RegisterMemoryDone() override;
+  void MarkFp32Memory(void* token, size_t fp32_offset,
+                      const std::vector<Range>& fp32_ranges) override;
 
   void SendActorMsg(int64_t dst_machine_id, const ActorMsg& msg) override;
   void SendSocketMsg(int64_t dst_machine_id, const SocketMsg& msg);
   void SendTransportMsg(int64_t dst_machine_id, const TransportMsg& msg);
+  // sends the regst body behind src_token encoded, as a whole or striped in chunks over the data
+  // sockets
+  void SendRegstBody(int64_t dst_machine_id, void* src_token, void* dst_token, void* read_id);
+  // ReadDone when the last of the chunk_num chunks of the regst body of read_id is received
+  void RegstBodyChunkDone(void* read_id, int64_t chunk_num);
+  // decodes the received encoded body of msg into its dst regst
+  void DecodeRegstBody(const RequestReadMsg& msg, const char* encoded_body);
+  SocketWriteStats GetSocketWriteStats() const;
+  WireCodecStats GetWireCodecStats() const;
 
  private:
   SocketMemDesc* NewMemDesc(void* ptr, size_t byte_size) override;
@@ -46,12 +67,38 @@ class EpollCommNet final : public CommNetIf<SocketMemDesc> {
   EpollCommNet();
   DEPRECATED EpollCommNet(const Plan& plan);
   void InitSockets();
-  SocketHelper* GetSocketHelper(int64_t machine_id);
+  // rings to and from the peers with the same address as this machine
+  void InitShmTransport();
+  SocketHelper* GetSocketHelper(int64_t machine_id, int32_t socket_idx);
+  // actor, transport and request messages go to the low latency lane if there is one
+  SocketHelper* GetCtrlSocketHelper(int64_t machine_id);
+  int64_t RegstBodyChunkNum(int64_t peer_machine_id, size_t byte_size) const;
+  // sets codec, encoded_size and encoded_body of msg, returns false if the body goes as it is
+  bool EncodeRegstBody(SocketMemDesc* mem_desc, RequestReadMsg* msg);
   void DoRead(void* read_id, int64_t src_machine_id, void* src_token, void* dst_token) override;
 
   std::vector<IOEventPoller*> pollers_;
-  std::vector<int> machine_id2sockfd_;
+  // the first stripe_socket_num_ sockets of a peer carry regst bodies, followed by the low
+  // latency lane if it is enabled
+  std::vector<std::vector<int>> machine_id2sockfds_;
   HashMap<int, SocketHelper*> sockfd2helper_;
+  int32_t stripe_socket_num_;
+  size_t stripe_chunk_size_;
+  bool enable_low_latency_lane_;
+  std::unique_ptr<std::atomic<int64_t>[]> machine_id2next_stripe_;
+  std::mutex read_id2remaining_chunk_num_mtx_;
+  HashMap<void*, int64_t> read_id2remaining_chunk_num_;
+  HashMap<int64_t, ShmWriteHelper*> machine_id2shm_write_helper_;
+  std::vector<ShmReadHelper*> shm_read_helpers_;
+  bool enable_lz4_wire_codec_;
+  WireCodec fp32_wire_codec_;
+  size_t wire_codec_min_size_;
+  float topk_ratio_;
+  std::atomic<int64_t> wire_codec_body_cnt_;
+  std::atomic<int64_t> wire_codec_raw_byte_cnt_;
+  std::atomic<int64_t> wire_codec_encoded_byte_cnt_;
+  std::atomic<int64_t> wire_codec_encode_nanos_;
+  std::atomic<int64_t> wire_codec_decode_nanos_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,75 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/shm_helper.h"
+#include "oneflow/core/comm_network/epoll/epoll_comm_network.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+ShmWriteHelper::~ShmWriteHelper() {
+  stop_ = true;
+  ring_buffer_->WakeUp();
+  msg_queue_.Close();
+  thread_.join();
+  delete ring_buffer_;
+}
+
+ShmWriteHelper::ShmWriteHelper(const std::string& shm_name) : stop_(false), byte_cnt_(0) {
+  ring_buffer_ = new ShmRingBuffer(shm_name);
+  thread_ = std::thread(&ShmWriteHelper::PollMsgQueue, this);
+}
+
+void ShmWriteHelper::AsyncWrite(const SocketMsg& msg) {
+  CHECK(msg.msg_type == SocketMsgType::kRequestRead);
+  CHECK_EQ(msg_queue_.Send(msg), kChannelStatusSuccess);
+}
+
+void ShmWriteHelper::PollMsgQueue() {
+  SocketMsg msg;
+  while (msg_queue_.Receive(&msg) == kChannelStatusSuccess) {
+    auto src_mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.src_token);
+    if (!ring_buffer_->Write(&msg, sizeof(msg), stop_)) { return; }
+    if (!ring_buffer_->Write(src_mem_desc->mem_ptr, src_mem_desc->byte_size, stop_)) { return; }
+    byte_cnt_.fetch_add(sizeof(msg) + src_mem_desc->byte_size, std::memory_order_relaxed);
+  }
+}
+
+ShmReadHelper::~ShmReadHelper() {
+  stop_ = true;
+  ring_buffer_->WakeUp();
+  thread_.join();
+  delete ring_buffer_;
+}
+
+ShmReadHelper::ShmReadHelper(const std::string& shm_name, size_t capacity) : stop_(false) {
+  ring_buffer_ = new ShmRingBuffer(shm_name, capacity);
+  thread_ = std::thread(&ShmReadHelper::PollRingBuffer, this);
+}
+
+void ShmReadHelper::PollRingBuffer() {
+  SocketMsg msg;
+  while (ring_buffer_->Read(&msg, sizeof(msg), stop_)) {
+    CHECK(msg.msg_type == SocketMsgType::kRequestRead);
+    auto dst_mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.dst_token);
+    if (!ring_buffer_->Read(dst_mem_desc->mem_ptr, dst_mem_desc->byte_size, stop_)) { return; }
+    Global<EpollCommNet>::Get()->ReadDone(msg.request_read_msg.read_id);
+  }
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
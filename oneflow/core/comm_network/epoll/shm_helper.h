@@ -0,0 +1,76 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
+
+#include "oneflow/core/comm_network/epoll/shm_ring_buffer.h"
+#include "oneflow/core/comm_network/epoll/socket_message.h"
+#include "oneflow/core/common/channel.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+// Copies the regst bodies for a peer process on the same host into the shared memory ring the
+// peer created, each body behind its RequestRead message head.
+class ShmWriteHelper final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmWriteHelper);
+  ShmWriteHelper() = delete;
+  ~ShmWriteHelper();
+
+  explicit ShmWriteHelper(const std::string& shm_name);
+
+  void AsyncWrite(const SocketMsg& msg);
+  int64_t byte_cnt() const { return byte_cnt_.load(); }
+
+ private:
+  void PollMsgQueue();
+
+  ShmRingBuffer* ring_buffer_;
+  Channel<SocketMsg> msg_queue_;
+  std::atomic<bool> stop_;
+  std::atomic<int64_t> byte_cnt_;
+  std::thread thread_;
+};
+
+// Creates the ring a peer process on the same host writes regst bodies into and copies them out
+// to the destination regsts.
+class ShmReadHelper final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmReadHelper);
+  ShmReadHelper() = delete;
+  ~ShmReadHelper();
+
+  ShmReadHelper(const std::string& shm_name, size_t capacity);
+
+  const std::string& shm_name() const { return ring_buffer_->name(); }
+  // once the peer has opened the ring
+  void Unlink() { ring_buffer_->Unlink(); }
+
+ private:
+  void PollRingBuffer();
+
+  ShmRingBuffer* ring_buffer_;
+  std::atomic<bool> stop_;
+  std::thread thread_;
+};
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_HELPER_H_
@@ -0,0 +1,237 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/shm_ring_buffer.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+
+namespace oneflow {
+
+namespace {
+
+constexpr size_t kCacheLineSize = 64;
+constexpr size_t kPageSize = 4096;
+// the other side can start copying after at most this many bytes
+constexpr size_t kMaxCopySizePerStep = 1 << 20;
+
+// spins first and then yields for a bounded number of waits while the other side is behind,
+// after which the caller goes to sleep on the futex of the ring
+class Backoff final {
+ public:
+  Backoff() : wait_cnt_(0) {}
+  void Reset() { wait_cnt_ = 0; }
+  bool TryWait() {
+    if (wait_cnt_ >= 128) { return false; }
+    if (wait_cnt_ >= 64) { std::this_thread::yield(); }
+    ++wait_cnt_;
+    return true;
+  }
+
+ private:
+  int64_t wait_cnt_;
+};
+
+// no FUTEX_PRIVATE_FLAG, the futex word is shared with the other process
+void FutexWait(std::atomic<uint32_t>* futex, uint32_t val) {
+  const long ret = syscall(SYS_futex, reinterpret_cast<uint32_t*>(futex), FUTEX_WAIT, val,
+                           nullptr, nullptr, 0);
+  PCHECK(ret == 0 || errno == EAGAIN || errno == EINTR);
+}
+
+void FutexWake(std::atomic<uint32_t>* futex) {
+  PCHECK(syscall(SYS_futex, reinterpret_cast<uint32_t*>(futex), FUTEX_WAKE, INT_MAX, nullptr,
+                 nullptr, 0)
+         != -1);
+}
+
+// The sleeper announces itself before it re-checks the ring, and the other side bumps seq after it
+// has moved its position, so either the sleeper sees the new position or the futex wait returns.
+template<typename IsReadyT>
+void SleepUntil(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* sleeping, IsReadyT IsReady,
+                const std::atomic<bool>& stop) {
+  const uint32_t cur_seq = seq->load();
+  sleeping->store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!IsReady() && !stop.load()) { FutexWait(seq, cur_seq); }
+  sleeping->store(0, std::memory_order_relaxed);
+}
+
+void WakeUpIfSleeping(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* sleeping) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping->load(std::memory_order_relaxed) == 0) { return; }
+  seq->fetch_add(1);
+  FutexWake(seq);
+}
+
+}  // namespace
+
+// the writer and the reader positions never wrap, they are taken modulo capacity on access
+struct ShmRingBuffer::Header {
+  std::atomic<uint64_t> write_pos;
+  char write_pos_padding[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> read_pos;
+  char read_pos_padding[kCacheLineSize - sizeof(std::atomic<uint64_t>)];
+  // the futex words the reader sleeps on while the ring is empty and the writer while it is full
+  std::atomic<uint32_t> readable_seq;
+  std::atomic<uint32_t> is_reader_sleeping;
+  std::atomic<uint32_t> writable_seq;
+  std::atomic<uint32_t> is_writer_sleeping;
+  char futex_padding[kCacheLineSize - 4 * sizeof(std::atomic<uint32_t>)];
+  uint64_t capacity;
+};
+
+ShmRingBuffer::~ShmRingBuffer() {
+  PCHECK(munmap(header_, map_size_) == 0);
+  if (is_creator_ && !is_unlinked_) { Unlink(); }
+}
+
+ShmRingBuffer::ShmRingBuffer(const std::string& name, size_t capacity)
+    : name_(name), is_creator_(true), is_unlinked_(false), capacity_(capacity) {
+  CHECK_GT(capacity_, 0);
+  // a left over of a crashed process which had the same pid
+  shm_unlink(name_.c_str());
+  int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  PCHECK(fd != -1) << name_;
+  const size_t map_size = RoundUp(sizeof(Header), kPageSize) + capacity_;
+  PCHECK(ftruncate(fd, map_size) == 0) << name_;
+  // reserve the pages now, a full /dev/shm would raise SIGBUS on first touch instead
+  const int err = posix_fallocate(fd, 0, map_size);
+  CHECK_EQ(err, 0) << name_ << ": " << strerror(err) << ", not enough space in /dev/shm for "
+                   << map_size << " bytes";
+  Map(fd, map_size);
+  new (header_) Header;
+  CHECK(header_->write_pos.is_lock_free());
+  header_->write_pos.store(0);
+  header_->read_pos.store(0);
+  header_->readable_seq.store(0);
+  header_->is_reader_sleeping.store(0);
+  header_->writable_seq.store(0);
+  header_->is_writer_sleeping.store(0);
+  header_->capacity = capacity_;
+}
+
+ShmRingBuffer::ShmRingBuffer(const std::string& name)
+    : name_(name), is_creator_(false), is_unlinked_(false) {
+  int fd = shm_open(name_.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+  PCHECK(fd != -1) << name_;
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0) << name_;
+  Map(fd, st.st_size);
+  capacity_ = header_->capacity;
+  CHECK_EQ(RoundUp(sizeof(Header), kPageSize) + capacity_, map_size_);
+}
+
+void ShmRingBuffer::Map(int fd, size_t map_size) {
+  void* ptr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PCHECK(ptr != MAP_FAILED) << name_;
+  PCHECK(close(fd) == 0);
+  map_size_ = map_size;
+  header_ = static_cast<Header*>(ptr);
+  data_ = static_cast<char*>(ptr) + RoundUp(sizeof(Header), kPageSize);
+}
+
+size_t ShmRingBuffer::TryWrite(const void* ptr, size_t size) {
+  const uint64_t write_pos = header_->write_pos.load(std::memory_order_relaxed);
+  const uint64_t read_pos = header_->read_pos.load(std::memory_order_acquire);
+  const size_t n = std::min<size_t>(size, capacity_ - (write_pos - read_pos));
+  if (n == 0) { return 0; }
+  const size_t offset = write_pos % capacity_;
+  const size_t first_n = std::min(n, capacity_ - offset);
+  memcpy(data_ + offset, ptr, first_n);
+  memcpy(data_, static_cast<const char*>(ptr) + first_n, n - first_n);
+  header_->write_pos.store(write_pos + n, std::memory_order_release);
+  return n;
+}
+
+size_t ShmRingBuffer::TryRead(void* ptr, size_t size) {
+  const uint64_t read_pos = header_->read_pos.load(std::memory_order_relaxed);
+  const uint64_t write_pos = header_->write_pos.load(std::memory_order_acquire);
+  const size_t n = std::min<size_t>(size, write_pos - read_pos);
+  if (n == 0) { return 0; }
+  const size_t offset = read_pos % capacity_;
+  const size_t first_n = std::min(n, capacity_ - offset);
+  memcpy(ptr, data_ + offset, first_n);
+  memcpy(static_cast<char*>(ptr) + first_n, data_, n - first_n);
+  header_->read_pos.store(read_pos + n, std::memory_order_release);
+  return n;
+}
+
+bool ShmRingBuffer::Write(const void* ptr, size_t size, const std::atomic<bool>& stop) {
+  const char* cur_ptr = static_cast<const char*>(ptr);
+  auto IsWritable = [this]() {
+    return header_->write_pos.load() - header_->read_pos.load() < capacity_;
+  };
+  Backoff backoff;
+  while (size > 0) {
+    const size_t n = TryWrite(cur_ptr, std::min(size, kMaxCopySizePerStep));
+    if (n > 0) {
+      cur_ptr += n;
+      size -= n;
+      backoff.Reset();
+      WakeUpIfSleeping(&header_->readable_seq, &header_->is_reader_sleeping);
+    } else if (stop.load(std::memory_order_relaxed)) {
+      return false;
+    } else if (!backoff.TryWait()) {
+      SleepUntil(&header_->writable_seq, &header_->is_writer_sleeping, IsWritable, stop);
+    }
+  }
+  return true;
+}
+
+bool ShmRingBuffer::Read(void* ptr, size_t size, const std::atomic<bool>& stop) {
+  char* cur_ptr = static_cast<char*>(ptr);
+  auto IsReadable = [this]() { return header_->write_pos.load() != header_->read_pos.load(); };
+  Backoff backoff;
+  while (size > 0) {
+    const size_t n = TryRead(cur_ptr, std::min(size, kMaxCopySizePerStep));
+    if (n > 0) {
+      cur_ptr += n;
+      size -= n;
+      backoff.Reset();
+      WakeUpIfSleeping(&header_->writable_seq, &header_->is_writer_sleeping);
+    } else if (stop.load(std::memory_order_relaxed)) {
+      return false;
+    } else if (!backoff.TryWait()) {
+      SleepUntil(&header_->readable_seq, &header_->is_reader_sleeping, IsReadable, stop);
+    }
+  }
+  return true;
+}
+
+void ShmRingBuffer::WakeUp() {
+  header_->readable_seq.fetch_add(1);
+  FutexWake(&header_->readable_seq);
+  header_->writable_seq.fetch_add(1);
+  FutexWake(&header_->writable_seq);
+}
+
+void ShmRingBuffer::Unlink() {
+  CHECK(is_creator_);
+  CHECK(!is_unlinked_);
+  PCHECK(shm_unlink(name_.c_str()) == 0) << name_;
+  is_unlinked_ = true;
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
@@ -0,0 +1,74 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_RING_BUFFER_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_RING_BUFFER_H_
+
+#include "oneflow/core/common/platform.h"
+#include "oneflow/core/common/util.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+namespace oneflow {
+
+// A single producer single consumer byte ring in a POSIX shared memory object, so that the
+// writer and the reader can be different processes on the same host.
+class ShmRingBuffer final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ShmRingBuffer);
+  ShmRingBuffer() = delete;
+  ~ShmRingBuffer();
+
+  // creates the shared memory object of name
+  ShmRingBuffer(const std::string& name, size_t capacity);
+  // maps the shared memory object of name created by another ShmRingBuffer
+  explicit ShmRingBuffer(const std::string& name);
+
+  const std::string& name() const { return name_; }
+  size_t capacity() const { return capacity_; }
+
+  // both copy at most size bytes and return the number of bytes copied, which is less than size
+  // when the ring is full or empty
+  size_t TryWrite(const void* ptr, size_t size);
+  size_t TryRead(void* ptr, size_t size);
+  // both wait for the other side until all size bytes are copied, return false if stop is set
+  // before that. After a short spin they sleep on a futex in the ring, which the other side wakes
+  // once it has moved its position.
+  bool Write(const void* ptr, size_t size, const std::atomic<bool>& stop);
+  bool Read(void* ptr, size_t size, const std::atomic<bool>& stop);
+  // wakes a sleeping Write or Read, call it after setting their stop
+  void WakeUp();
+
+  // removes the name once the other side has mapped the ring, the memory lives until both unmap
+  void Unlink();
+
+ private:
+  struct Header;
+  void Map(int fd, size_t map_size);
+
+  std::string name_;
+  bool is_creator_;
+  bool is_unlinked_;
+  size_t capacity_;
+  size_t map_size_;
+  Header* header_;
+  char* data_;
+};
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_SHM_RING_BUFFER_H_
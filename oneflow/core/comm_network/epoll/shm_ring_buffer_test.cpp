@@ -0,0 +1,106 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/shm_ring_buffer.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <sys/wait.h>
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+std::string GenShmName(const std::string& suffix) {
+  return "/oneflow_shm_ring_buffer_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+}  // namespace
+
+TEST(ShmRingBuffer, wrap_around) {
+  ShmRingBuffer writer(GenShmName("wrap_around"), 10);
+  ShmRingBuffer reader(writer.name());
+  writer.Unlink();
+  ASSERT_EQ(reader.capacity(), 10);
+  char buf[16];
+  ASSERT_EQ(writer.TryWrite("abcdefgh", 8), 8);
+  ASSERT_EQ(writer.TryWrite("ijkl", 4), 2);
+  ASSERT_EQ(reader.TryRead(buf, 6), 6);
+  ASSERT_EQ(std::string(buf, 6), "abcdef");
+  ASSERT_EQ(writer.TryWrite("klmnopq", 7), 6);
+  ASSERT_EQ(writer.TryWrite("q", 1), 0);
+  ASSERT_EQ(reader.TryRead(buf, 16), 10);
+  ASSERT_EQ(std::string(buf, 10), "ghijklmnop");
+  ASSERT_EQ(reader.TryRead(buf, 16), 0);
+}
+
+TEST(ShmRingBuffer, across_processes) {
+  const size_t byte_size = 64 << 20;
+  ShmRingBuffer reader(GenShmName("across_processes"), 1 << 20);
+  pid_t writer_pid = fork();
+  ASSERT_NE(writer_pid, -1);
+  if (writer_pid == 0) {
+    ShmRingBuffer writer(reader.name());
+    std::atomic<bool> stop(false);
+    std::vector<uint32_t> data(byte_size / sizeof(uint32_t));
+    std::iota(data.begin(), data.end(), 0);
+    const char* ptr = reinterpret_cast<const char*>(data.data());
+    // pieces of varying size so that the positions hit every offset of the ring
+    size_t offset = 0;
+    for (size_t piece = 1; offset < byte_size; piece = piece * 3 % 1000003) {
+      const size_t size = std::min(piece, byte_size - offset);
+      if (!writer.Write(ptr + offset, size, stop)) { _exit(1); }
+      offset += size;
+    }
+    _exit(0);
+  }
+  std::atomic<bool> stop(false);
+  std::vector<uint32_t> data(byte_size / sizeof(uint32_t));
+  ASSERT_TRUE(reader.Read(data.data(), byte_size, stop));
+  int status = 0;
+  ASSERT_EQ(waitpid(writer_pid, &status, 0), writer_pid);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  FOR_RANGE(size_t, i, 0, data.size()) { ASSERT_EQ(data.at(i), i); }
+  stop = true;
+  ASSERT_FALSE(reader.Read(data.data(), 1, stop));
+}
+
+TEST(ShmRingBuffer, wake_up_sleeping_reader) {
+  ShmRingBuffer reader(GenShmName("wake_up_sleeping_reader"), 16);
+  ShmRingBuffer writer(reader.name());
+  reader.Unlink();
+  std::atomic<bool> stop(false);
+  // long enough for the reader to be asleep on the futex
+  std::thread writer_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(writer.Write("abcdefghijklmnopqrstuvwxyz", 26, stop));
+  });
+  char buf[26];
+  ASSERT_TRUE(reader.Read(buf, 26, stop));
+  ASSERT_EQ(std::string(buf, 26), "abcdefghijklmnopqrstuvwxyz");
+  writer_thread.join();
+  std::thread stop_thread([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stop = true;
+    reader.WakeUp();
+  });
+  ASSERT_FALSE(reader.Read(buf, 1, stop));
+  stop_thread.join();
+}
+
+}  // namespace oneflow
+
+#endif  // OF_PLATFORM_POSIX
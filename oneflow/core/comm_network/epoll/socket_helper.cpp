@@ -19,11 +19,12 @@ limitations under the License.
 
 namespace oneflow {
 
-SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller) {
+SocketHelper::SocketHelper(int sockfd, IOEventPoller* poller, const EpollCommNetConf& conf) {
   read_helper_ = new SocketReadHelper(sockfd);
-  write_helper_ = new SocketWriteHelper(sockfd, poller);
+  write_helper_ = new SocketWriteHelper(sockfd, poller, conf);
   poller->AddFd(sockfd, [this]() { read_helper_->NotifyMeSocketReadable(); },
-                [this]() { write_helper_->NotifyMeSocketWriteable(); });
+                [this]() { write_helper_->NotifyMeSocketWriteable(); },
+                [this]() { write_helper_->NotifyMeSocketError(); });
 }
 
 SocketHelper::~SocketHelper() {
@@ -30,9 +30,10 @@ class SocketHelper final {
   SocketHelper() = delete;
   ~SocketHelper();
 
-  SocketHelper(int sockfd, IOEventPoller* poller);
+  SocketHelper(int sockfd, IOEventPoller* poller, const EpollCommNetConf& conf);
 
   void AsyncWrite(const SocketMsg& msg);
+  SocketWriteStats GetWriteStats() const { return write_helper_->GetStats(); }
 
  private:
   SocketReadHelper* read_helper_;
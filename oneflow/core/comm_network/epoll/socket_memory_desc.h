@@ -17,6 +17,8 @@ limitations under the License.
 #define ONEFLOW_CORE_COMM_NETWORK_EPOLL_SOCKET_MEMORY_DESC_H_
 
 #include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+#include "oneflow/core/common/range.h"
+#include <vector>
 
 #ifdef OF_PLATFORM_POSIX
 
@@ -25,6 +27,13 @@ namespace oneflow {
 struct SocketMemDesc {
   void* mem_ptr;
   size_t byte_size;
+  // the regst body holds fp32 gradients from fp32_offset on, which may be sent lossy encoded, -1
+  // if it does not
+  int64_t fp32_offset;
+  // the ranges of the fp32 values from fp32_offset which hold blob bodies, not padding
+  std::vector<Range> fp32_ranges;
+  // the values top-k encoding has not sent yet
+  std::vector<float> topk_residual;
 };
 
 }  // namespace oneflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/platform.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/comm_network/comm_network.h"
+#include "oneflow/core/job/resource.pb.h"
 
 #ifdef OF_PLATFORM_POSIX
 
@@ -35,10 +36,11 @@ limitations under the License.
 
 namespace oneflow {
 
-#define SOCKET_MSG_TYPE_SEQ                         \
-  OF_PP_MAKE_TUPLE_SEQ(RequestWrite, request_write) \
-  OF_PP_MAKE_TUPLE_SEQ(RequestRead, request_read)   \
-  OF_PP_MAKE_TUPLE_SEQ(Actor, actor)                \
+#define SOCKET_MSG_TYPE_SEQ                                  \
+  OF_PP_MAKE_TUPLE_SEQ(RequestWrite, request_write)          \
+  OF_PP_MAKE_TUPLE_SEQ(RequestRead, request_read)            \
+  OF_PP_MAKE_TUPLE_SEQ(RequestReadChunk, request_read_chunk) \
+  OF_PP_MAKE_TUPLE_SEQ(Actor, actor)                         \
   OF_PP_MAKE_TUPLE_SEQ(Transport, transport)
 
 enum class SocketMsgType {
@@ -54,10 +56,26 @@ struct RequestWriteMsg {
   void* read_id;
 };
 
+// the body follows as it is if codec is kWireCodecNone, else the encoded_size bytes encoded_body
+// points to on the sender, which the socket write helper frees once they are written
 struct RequestReadMsg {
   void* src_token;
   void* dst_token;
   void* read_id;
+  WireCodec codec;
+  int64_t encoded_size;
+  int64_t fp32_offset;
+  char* encoded_body;
+};
+
+// [offset, offset + byte_size) of a regst body striped over several sockets
+struct RequestReadChunkMsg {
+  void* src_token;
+  void* dst_token;
+  void* read_id;
+  int64_t offset;
+  int64_t byte_size;
+  int64_t chunk_num;
 };
 
 struct SocketMsg {
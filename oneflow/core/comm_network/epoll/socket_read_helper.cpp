@@ -83,26 +83,45 @@ void SocketReadHelper::SetStatusWhenMsgHeadDone() {
 
 void SocketReadHelper::SetStatusWhenMsgBodyDone() {
   if (cur_msg_.msg_type == SocketMsgType::kRequestRead) {
+    if (cur_msg_.request_read_msg.codec != kWireCodecNone) {
+      Global<EpollCommNet>::Get()->DecodeRegstBody(cur_msg_.request_read_msg, encoded_body_.data());
+    }
     Global<EpollCommNet>::Get()->ReadDone(cur_msg_.request_read_msg.read_id);
+  } else if (cur_msg_.msg_type == SocketMsgType::kRequestReadChunk) {
+    Global<EpollCommNet>::Get()->RegstBodyChunkDone(cur_msg_.request_read_chunk_msg.read_id,
+                                                    cur_msg_.request_read_chunk_msg.chunk_num);
   }
   SwitchToMsgHeadReadHandle();
 }
 
 void SocketReadHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  SocketMsg msg_to_send;
-  msg_to_send.msg_type = SocketMsgType::kRequestRead;
-  msg_to_send.request_read_msg.src_token = cur_msg_.request_write_msg.src_token;
-  msg_to_send.request_read_msg.dst_token = cur_msg_.request_write_msg.dst_token;
-  msg_to_send.request_read_msg.read_id = cur_msg_.request_write_msg.read_id;
-  Global<EpollCommNet>::Get()->SendSocketMsg(cur_msg_.request_write_msg.dst_machine_id,
-                                             msg_to_send);
+  Global<EpollCommNet>::Get()->SendRegstBody(
+      cur_msg_.request_write_msg.dst_machine_id, cur_msg_.request_write_msg.src_token,
+      cur_msg_.request_write_msg.dst_token, cur_msg_.request_write_msg.read_id);
   SwitchToMsgHeadReadHandle();
 }
 
 void SocketReadHelper::SetStatusWhenRequestReadMsgHeadDone() {
-  auto mem_desc = static_cast<const SocketMemDesc*>(cur_msg_.request_read_msg.dst_token);
-  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
-  read_size_ = mem_desc->byte_size;
+  const RequestReadMsg& request_read = cur_msg_.request_read_msg;
+  auto mem_desc = static_cast<const SocketMemDesc*>(request_read.dst_token);
+  if (request_read.codec == kWireCodecNone) {
+    read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr);
+    read_size_ = mem_desc->byte_size;
+  } else {
+    // decoded into the regst once the whole encoded body is received
+    encoded_body_.resize(request_read.encoded_size);
+    read_ptr_ = encoded_body_.data();
+    read_size_ = request_read.encoded_size;
+  }
+  cur_read_handle_ = &SocketReadHelper::MsgBodyReadHandle;
+}
+
+void SocketReadHelper::SetStatusWhenRequestReadChunkMsgHeadDone() {
+  const RequestReadChunkMsg& chunk = cur_msg_.request_read_chunk_msg;
+  auto mem_desc = static_cast<const SocketMemDesc*>(chunk.dst_token);
+  CHECK_LE(chunk.offset + chunk.byte_size, mem_desc->byte_size);
+  read_ptr_ = reinterpret_cast<char*>(mem_desc->mem_ptr) + chunk.offset;
+  read_size_ = chunk.byte_size;
   cur_read_handle_ = &SocketReadHelper::MsgBodyReadHandle;
 }
 
@@ -0,0 +1,241 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/socket_write_helper.h"
+#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <netinet/tcp.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+int64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void ReadFully(int sockfd, char* ptr, size_t size) {
+  while (size > 0) {
+    ssize_t n = read(sockfd, ptr, size);
+    PCHECK(n > 0);
+    ptr += n;
+    size -= n;
+  }
+}
+
+// connected pairs of loopback tcp sockets, the first of a pair for the writer
+std::vector<std::pair<int, int>> ConnectLoopbackSockets(int32_t num) {
+  int listen_sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(listen_sockfd != -1);
+  sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = 0;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  PCHECK(bind(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+  PCHECK(listen(listen_sockfd, num) == 0);
+  socklen_t len = sizeof(sa);
+  PCHECK(getsockname(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+  std::vector<std::pair<int, int>> sockfd_pairs;
+  FOR_RANGE(int32_t, i, 0, num) {
+    int reader_sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    PCHECK(connect(reader_sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    int writer_sockfd = accept(listen_sockfd, nullptr, nullptr);
+    PCHECK(writer_sockfd != -1);
+    const int val = 1;
+    PCHECK(setsockopt(writer_sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+    sockfd_pairs.emplace_back(writer_sockfd, reader_sockfd);
+  }
+  PCHECK(close(listen_sockfd) == 0);
+  return sockfd_pairs;
+}
+
+// One thread per socket parses the stream like SocketReadHelper does and reassembles the chunks.
+// The writer is told on the first socket when all bodies are received, and every socket ends
+// with a transport message.
+void RunReader(const std::vector<int>& sockfds, size_t body_size, int64_t body_num) {
+  std::vector<char> body(body_size);
+  std::atomic<int64_t> remaining_byte_size(body_size * body_num);
+  std::mutex latency_mtx;
+  std::vector<int64_t> actor_msg_latencies;
+  std::vector<std::thread> threads;
+  for (int sockfd : sockfds) {
+    threads.emplace_back([&, sockfd]() {
+      while (true) {
+        SocketMsg msg;
+        ReadFully(sockfd, reinterpret_cast<char*>(&msg), sizeof(msg));
+        size_t received = 0;
+        if (msg.msg_type == SocketMsgType::kRequestRead) {
+          ReadFully(sockfd, body.data(), body_size);
+          received = body_size;
+        } else if (msg.msg_type == SocketMsgType::kRequestReadChunk) {
+          const RequestReadChunkMsg& chunk = msg.request_read_chunk_msg;
+          ReadFully(sockfd, body.data() + chunk.offset, chunk.byte_size);
+          received = chunk.byte_size;
+        } else if (msg.msg_type == SocketMsgType::kActor) {
+          int64_t send_nanos = 0;
+          memcpy(&send_nanos, &msg.actor_msg, sizeof(send_nanos));
+          std::unique_lock<std::mutex> lck(latency_mtx);
+          actor_msg_latencies.push_back(NowNanos() - send_nanos);
+        } else {
+          CHECK(msg.msg_type == SocketMsgType::kTransport);
+          return;
+        }
+        if (received > 0 && remaining_byte_size.fetch_sub(received) == received) {
+          const char done = 1;
+          PCHECK(write(sockfds.front(), &done, 1) == 1);
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  std::sort(actor_msg_latencies.begin(), actor_msg_latencies.end());
+  const size_t latency_num = actor_msg_latencies.size();
+  std::cout << "  actor msg num: " << latency_num;
+  if (latency_num > 0) {
+    std::cout << " latency us p50: " << actor_msg_latencies.at(latency_num / 2) / 1e3
+              << " p99: " << actor_msg_latencies.at(latency_num * 99 / 100) / 1e3
+              << " max: " << actor_msg_latencies.back() / 1e3;
+  }
+  std::cout << std::endl;
+  _exit(0);
+}
+
+// Sends body_num regst bodies striped the way EpollCommNet::SendRegstBody does, while an actor
+// message goes out every millisecond until the reader has all bodies.
+void BenchmarkStripe(int32_t stripe_socket_num, size_t chunk_size, bool enable_low_latency_lane,
+                     size_t body_size, int64_t body_num) {
+  const int32_t socket_num = stripe_socket_num + (enable_low_latency_lane ? 1 : 0);
+  const std::vector<std::pair<int, int>> sockfd_pairs = ConnectLoopbackSockets(socket_num);
+  pid_t reader_pid = fork();
+  PCHECK(reader_pid != -1);
+  if (reader_pid == 0) {
+    std::vector<int> reader_sockfds;
+    for (const auto& pair : sockfd_pairs) {
+      PCHECK(close(pair.first) == 0);
+      reader_sockfds.push_back(pair.second);
+    }
+    RunReader(reader_sockfds, body_size, body_num);
+  }
+  std::vector<char> body(body_size);
+  SocketMemDesc mem_desc;
+  mem_desc.mem_ptr = body.data();
+  mem_desc.byte_size = body_size;
+  std::vector<IOEventPoller*> pollers;
+  std::vector<SocketWriteHelper*> write_helpers;
+  for (const auto& pair : sockfd_pairs) {
+    PCHECK(close(pair.second) == 0);
+    auto* poller = new IOEventPoller();
+    auto* write_helper = new SocketWriteHelper(pair.first, poller, EpollCommNetConf());
+    poller->AddFd(pair.first, []() {},
+                  [write_helper]() { write_helper->NotifyMeSocketWriteable(); },
+                  [write_helper]() { write_helper->NotifyMeSocketError(); });
+    poller->Start();
+    pollers.push_back(poller);
+    write_helpers.push_back(write_helper);
+  }
+  const int64_t chunk_num = stripe_socket_num == 1 || body_size <= chunk_size
+                                ? 1
+                                : RoundUp(body_size, chunk_size) / chunk_size;
+  const auto start = std::chrono::steady_clock::now();
+  int64_t next_stripe = 0;
+  FOR_RANGE(int64_t, body_idx, 0, body_num) {
+    SocketMsg msg;
+    memset(&msg, 0, sizeof(msg));
+    if (chunk_num == 1) {
+      msg.msg_type = SocketMsgType::kRequestRead;
+      msg.request_read_msg.src_token = &mem_desc;
+      write_helpers.at(next_stripe % stripe_socket_num)->AsyncWrite(msg);
+      next_stripe += 1;
+      continue;
+    }
+    msg.msg_type = SocketMsgType::kRequestReadChunk;
+    msg.request_read_chunk_msg.src_token = &mem_desc;
+    msg.request_read_chunk_msg.chunk_num = chunk_num;
+    FOR_RANGE(int64_t, i, 0, chunk_num) {
+      msg.request_read_chunk_msg.offset = i * chunk_size;
+      msg.request_read_chunk_msg.byte_size = std::min(chunk_size, body_size - i * chunk_size);
+      write_helpers.at((next_stripe + i) % stripe_socket_num)->AsyncWrite(msg);
+    }
+    next_stripe += chunk_num;
+  }
+  SocketWriteHelper* ctrl_write_helper = write_helpers.back();
+  if (!enable_low_latency_lane) { ctrl_write_helper = write_helpers.front(); }
+  char done = 0;
+  while (recv(sockfd_pairs.front().first, &done, 1, MSG_DONTWAIT) != 1) {
+    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+    SocketMsg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = SocketMsgType::kActor;
+    const int64_t send_nanos = NowNanos();
+    memcpy(&msg.actor_msg, &send_nanos, sizeof(send_nanos));
+    ctrl_write_helper->AsyncWrite(msg);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (SocketWriteHelper* write_helper : write_helpers) {
+    SocketMsg msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_type = SocketMsgType::kTransport;
+    write_helper->AsyncWrite(msg);
+  }
+  std::cout << "stripe_socket_num: " << stripe_socket_num
+            << " low_latency_lane: " << enable_low_latency_lane
+            << " MB/s: " << body_size * body_num / seconds / (1 << 20) << std::endl;
+  int status = 0;
+  PCHECK(waitpid(reader_pid, &status, 0) == reader_pid);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  for (IOEventPoller* poller : pollers) {
+    poller->Stop();
+    delete poller;
+  }
+  for (SocketWriteHelper* write_helper : write_helpers) { delete write_helper; }
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int32(stripe_socket_num, 4, "number of sockets the regst bodies are striped over");
+DEFINE_int64(stripe_chunk_kbyte, 4096, "size of the chunks of a striped regst body");
+DEFINE_int64(body_mbyte, 64, "size of every regst body");
+DEFINE_int64(body_num, 16, "number of regst bodies sent");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(2);
+  const size_t chunk_size = FLAGS_stripe_chunk_kbyte << 10;
+  const size_t body_size = FLAGS_body_mbyte << 20;
+  BenchmarkStripe(1, chunk_size, false, body_size, FLAGS_body_num);
+  BenchmarkStripe(FLAGS_stripe_socket_num, chunk_size, false, body_size, FLAGS_body_num);
+  BenchmarkStripe(FLAGS_stripe_socket_num, chunk_size, true, body_size, FLAGS_body_num);
+  return 0;
+}
+
+#else
+
+int main(int argc, char* argv[]) { return 0; }
+
+#endif  // OF_PLATFORM_POSIX
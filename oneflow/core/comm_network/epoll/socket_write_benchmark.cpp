@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/socket_write_helper.h"
+#include "oneflow/core/comm_network/epoll/socket_memory_desc.h"
+
+#ifdef OF_PLATFORM_POSIX
+
+#include <netinet/tcp.h>
+#include <sys/wait.h>
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+void ReadFully(int sockfd, char* ptr, size_t size) {
+  while (size > 0) {
+    ssize_t n = read(sockfd, ptr, size);
+    PCHECK(n > 0);
+    ptr += n;
+    size -= n;
+  }
+}
+
+// the peer process parses the stream like SocketReadHelper does and exits when all is received
+void RunReader(int sockfd, int64_t msg_num, size_t body_size) {
+  std::vector<char> body(std::max<size_t>(body_size, 1));
+  FOR_RANGE(int64_t, i, 0, msg_num) {
+    SocketMsg msg;
+    ReadFully(sockfd, reinterpret_cast<char*>(&msg), sizeof(msg));
+    if (msg.msg_type == SocketMsgType::kRequestRead) { ReadFully(sockfd, body.data(), body_size); }
+  }
+  _exit(0);
+}
+
+int ListenOnLoopback(uint16_t* port) {
+  int listen_sockfd = socket(AF_INET, SOCK_STREAM, 0);
+  PCHECK(listen_sockfd != -1);
+  sockaddr_in sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = 0;
+  sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  PCHECK(bind(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+  PCHECK(listen(listen_sockfd, 1) == 0);
+  socklen_t len = sizeof(sa);
+  PCHECK(getsockname(listen_sockfd, reinterpret_cast<sockaddr*>(&sa), &len) == 0);
+  *port = ntohs(sa.sin_port);
+  return listen_sockfd;
+}
+
+// every body_every-th message is a regst body of body_size bytes, the rest are actor messages
+void BenchmarkSocketWrite(const EpollCommNetConf& conf, int64_t msg_num, int64_t body_every,
+                          size_t body_size) {
+  uint16_t port = 0;
+  int listen_sockfd = ListenOnLoopback(&port);
+  pid_t reader_pid = fork();
+  PCHECK(reader_pid != -1);
+  if (reader_pid == 0) {
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    PCHECK(connect(sockfd, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0);
+    RunReader(sockfd, msg_num, body_size);
+  }
+  int sockfd = accept(listen_sockfd, nullptr, nullptr);
+  PCHECK(sockfd != -1);
+  PCHECK(close(listen_sockfd) == 0);
+  const int val = 1;
+  PCHECK(setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, (char*)&val, sizeof(int)) == 0);
+
+  std::vector<char> body(body_size);
+  SocketMemDesc mem_desc;
+  mem_desc.mem_ptr = body.data();
+  mem_desc.byte_size = body_size;
+  auto* poller = new IOEventPoller();
+  auto* write_helper = new SocketWriteHelper(sockfd, poller, conf);
+  poller->AddFd(sockfd, []() {}, [write_helper]() { write_helper->NotifyMeSocketWriteable(); },
+                [write_helper]() { write_helper->NotifyMeSocketError(); });
+  poller->Start();
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, msg_num) {
+    SocketMsg msg;
+    memset(&msg, 0, sizeof(msg));
+    if (body_every > 0 && i % body_every == 0) {
+      msg.msg_type = SocketMsgType::kRequestRead;
+      msg.request_read_msg.src_token = &mem_desc;
+    } else {
+      msg.msg_type = SocketMsgType::kActor;
+    }
+    write_helper->AsyncWrite(msg);
+  }
+  int status = 0;
+  PCHECK(waitpid(reader_pid, &status, 0) == reader_pid);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  poller->Stop();
+  const SocketWriteStats stats = write_helper->GetStats();
+  delete poller;
+  delete write_helper;
+  std::cout << "max_write_batch_msg_num: " << conf.max_write_batch_msg_num()
+            << " zerocopy: " << conf.enable_zerocopy() << " msg/s: " << msg_num / seconds
+            << " MB/s: " << stats.byte_cnt / seconds / (1 << 20)
+            << " msg/syscall: " << static_cast<double>(stats.msg_cnt) / stats.write_syscall_cnt
+            << " blocked syscalls: " << stats.blocked_write_cnt
+            << " zerocopy MB: " << stats.zerocopy_byte_cnt / (1 << 20)
+            << " zerocopy copied sends: " << stats.zerocopy_copied_cnt << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(msg_num, 1000000, "number of socket messages written");
+DEFINE_int64(body_every, 100, "every body_every-th message carries a regst body, 0 for none");
+DEFINE_int64(body_kbyte, 64, "size of every regst body");
+DEFINE_bool(zerocopy, false, "also benchmark MSG_ZEROCOPY for the regst bodies");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(2);
+  for (int64_t batch_msg_num : {1, 8, 64, 256}) {
+    EpollCommNetConf conf;
+    conf.set_max_write_batch_msg_num(batch_msg_num);
+    BenchmarkSocketWrite(conf, FLAGS_msg_num, FLAGS_body_every, FLAGS_body_kbyte << 10);
+    if (FLAGS_zerocopy) {
+      conf.set_enable_zerocopy(true);
+      conf.set_zerocopy_threshold_kbyte(std::min<int64_t>(FLAGS_body_kbyte, 64));
+      BenchmarkSocketWrite(conf, FLAGS_msg_num, FLAGS_body_every, FLAGS_body_kbyte << 10);
+    }
+  }
+  return 0;
+}
+
+#else
+
+int main(int argc, char* argv[]) { return 0; }
+
+#endif  // OF_PLATFORM_POSIX
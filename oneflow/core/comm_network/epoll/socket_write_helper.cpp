@@ -18,21 +18,83 @@ limitations under the License.
 
 #ifdef OF_PLATFORM_POSIX
 
+#include <linux/errqueue.h>
 #include <sys/eventfd.h>
 
 namespace oneflow {
 
+namespace {
+
+// linux caps the iovecs of one sendmsg at IOV_MAX, usually 1024
+constexpr size_t kMaxIovecNum = 1024;
+
+bool HasEncodedBody(const SocketMsg& msg) {
+  return msg.msg_type == SocketMsgType::kRequestRead
+         && msg.request_read_msg.encoded_body != nullptr;
+}
+
+bool GetMsgBody(const SocketMsg& msg, const char** body_ptr, size_t* body_size) {
+  if (HasEncodedBody(msg)) {
+    *body_ptr = msg.request_read_msg.encoded_body;
+    *body_size = msg.request_read_msg.encoded_size;
+    return true;
+  } else if (msg.msg_type == SocketMsgType::kRequestRead) {
+    auto src_mem_desc = static_cast<const SocketMemDesc*>(msg.request_read_msg.src_token);
+    *body_ptr = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
+    *body_size = src_mem_desc->byte_size;
+    return true;
+  } else if (msg.msg_type == SocketMsgType::kRequestReadChunk) {
+    const RequestReadChunkMsg& chunk = msg.request_read_chunk_msg;
+    auto src_mem_desc = static_cast<const SocketMemDesc*>(chunk.src_token);
+    CHECK_LE(chunk.offset + chunk.byte_size, src_mem_desc->byte_size);
+    *body_ptr = reinterpret_cast<const char*>(src_mem_desc->mem_ptr) + chunk.offset;
+    *body_size = chunk.byte_size;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+void FreeEncodedBody(const SocketMsg& msg) {
+  if (HasEncodedBody(msg)) { delete[] msg.request_read_msg.encoded_body; }
+}
+
+void FreeEncodedBodies(std::queue<SocketMsg>* msg_queue) {
+  for (; !msg_queue->empty(); msg_queue->pop()) { FreeEncodedBody(msg_queue->front()); }
+}
+
+}  // namespace
+
 SocketWriteHelper::~SocketWriteHelper() {
+  for (const SocketMsg& msg : batch_msgs_) { FreeEncodedBody(msg); }
+  FreeEncodedBodies(cur_msg_queue_);
   delete cur_msg_queue_;
   cur_msg_queue_ = nullptr;
   {
     std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
+    FreeEncodedBodies(pending_msg_queue_);
     delete pending_msg_queue_;
     pending_msg_queue_ = nullptr;
   }
 }
 
-SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
+SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller,
+                                     const EpollCommNetConf& conf)
+    : max_batch_msg_num_(std::min<size_t>(std::max<int64_t>(conf.max_write_batch_msg_num(), 1),
+                                          kMaxIovecNum / 2)),
+      max_batch_byte_size_(std::max<int64_t>(conf.max_write_batch_kbyte(), 1) << 10),
+      zerocopy_threshold_(conf.zerocopy_threshold_kbyte() << 10),
+      use_zerocopy_(false),
+      iov_idx_(0),
+      is_zerocopy_batch_(false),
+      zerocopy_body_ptr_(nullptr),
+      zerocopy_body_size_(0),
+      msg_cnt_(0),
+      byte_cnt_(0),
+      write_syscall_cnt_(0),
+      blocked_write_cnt_(0),
+      zerocopy_byte_cnt_(0),
+      zerocopy_copied_cnt_(0) {
   sockfd_ = sockfd;
   queue_not_empty_fd_ = eventfd(0, 0);
   PCHECK(queue_not_empty_fd_ != -1);
@@ -40,9 +102,9 @@ SocketWriteHelper::SocketWriteHelper(int sockfd, IOEventPoller* poller) {
                                    std::bind(&SocketWriteHelper::ProcessQueueNotEmptyEvent, this));
   cur_msg_queue_ = new std::queue<SocketMsg>;
   pending_msg_queue_ = new std::queue<SocketMsg>;
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-  write_ptr_ = nullptr;
-  write_size_ = 0;
+  batch_msgs_.reserve(max_batch_msg_num_);
+  iovs_.reserve(2 * max_batch_msg_num_);
+  if (conf.enable_zerocopy()) { EnableZeroCopyIfSupported(); }
 }
 
 void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
@@ -55,6 +117,25 @@ void SocketWriteHelper::AsyncWrite(const SocketMsg& msg) {
 
 void SocketWriteHelper::NotifyMeSocketWriteable() { WriteUntilMsgQueueEmptyOrSocketNotWriteable(); }
 
+void SocketWriteHelper::NotifyMeSocketError() {
+  if (use_zerocopy_) { DrainZeroCopyCompletions(); }
+  int err = 0;
+  socklen_t len = sizeof(err);
+  PCHECK(getsockopt(sockfd_, SOL_SOCKET, SO_ERROR, &err, &len) == 0);
+  CHECK_EQ(err, 0) << "sockfd " << sockfd_ << ": " << strerror(err);
+}
+
+SocketWriteStats SocketWriteHelper::GetStats() const {
+  SocketWriteStats stats;
+  stats.msg_cnt = msg_cnt_.load();
+  stats.byte_cnt = byte_cnt_.load();
+  stats.write_syscall_cnt = write_syscall_cnt_.load();
+  stats.blocked_write_cnt = blocked_write_cnt_.load();
+  stats.zerocopy_byte_cnt = zerocopy_byte_cnt_.load();
+  stats.zerocopy_copied_cnt = zerocopy_copied_cnt_.load();
+  return stats;
+}
+
 void SocketWriteHelper::SendQueueNotEmptyEvent() {
   uint64_t event_num = 1;
   PCHECK(write(queue_not_empty_fd_, &event_num, 8) == 8);
@@ -67,81 +148,137 @@ void SocketWriteHelper::ProcessQueueNotEmptyEvent() {
 }
 
 void SocketWriteHelper::WriteUntilMsgQueueEmptyOrSocketNotWriteable() {
-  while ((this->*cur_write_handle_)()) {}
-}
-
-bool SocketWriteHelper::InitMsgWriteHandle() {
-  if (cur_msg_queue_->empty()) {
-    {
-      std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
-      std::swap(cur_msg_queue_, pending_msg_queue_);
-    }
-    if (cur_msg_queue_->empty()) { return false; }
+  while (iov_idx_ < iovs_.size() || InitBatch()) {
+    if (!WriteBatch()) { return; }
   }
-  cur_msg_ = cur_msg_queue_->front();
-  cur_msg_queue_->pop();
-  write_ptr_ = reinterpret_cast<const char*>(&cur_msg_);
-  write_size_ = sizeof(cur_msg_);
-  cur_write_handle_ = &SocketWriteHelper::MsgHeadWriteHandle;
-  return true;
-}
-
-bool SocketWriteHelper::MsgHeadWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgHeadDone);
 }
 
-bool SocketWriteHelper::MsgBodyWriteHandle() {
-  return DoCurWrite(&SocketWriteHelper::SetStatusWhenMsgBodyDone);
-}
-
-bool SocketWriteHelper::DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)()) {
-  ssize_t n = write(sockfd_, write_ptr_, write_size_);
-  if (n == write_size_) {
-    (this->*set_cur_write_done)();
-    return true;
-  } else if (n >= 0) {
-    write_ptr_ += n;
-    write_size_ -= n;
+bool SocketWriteHelper::InitBatch() {
+  // the previous batch is written
+  for (const SocketMsg& msg : batch_msgs_) { FreeEncodedBody(msg); }
+  batch_msgs_.clear();
+  iovs_.clear();
+  iov_idx_ = 0;
+  is_zerocopy_batch_ = false;
+  if (zerocopy_body_ptr_ != nullptr) {
+    AppendIovec(zerocopy_body_ptr_, zerocopy_body_size_);
+    is_zerocopy_batch_ = true;
+    zerocopy_body_ptr_ = nullptr;
+    zerocopy_body_size_ = 0;
     return true;
-  } else {
-    CHECK_EQ(n, -1);
-    PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
-    return false;
   }
-}
-
-void SocketWriteHelper::SetStatusWhenMsgHeadDone() {
-  switch (cur_msg_.msg_type) {
-#define MAKE_ENTRY(x, y) \
-  case SocketMsgType::k##x: return SetStatusWhen##x##MsgHeadDone();
-    OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
-    default: UNIMPLEMENTED();
+  size_t batch_byte_size = 0;
+  while (batch_msgs_.size() < max_batch_msg_num_ && batch_byte_size < max_batch_byte_size_) {
+    if (cur_msg_queue_->empty()) {
+      {
+        std::unique_lock<std::mutex> lck(pending_msg_queue_mtx_);
+        std::swap(cur_msg_queue_, pending_msg_queue_);
+      }
+      if (cur_msg_queue_->empty()) { break; }
+    }
+    batch_msgs_.push_back(cur_msg_queue_->front());
+    cur_msg_queue_->pop();
+    const SocketMsg& msg = batch_msgs_.back();
+    AppendIovec(&msg, sizeof(msg));
+    batch_byte_size += sizeof(msg);
+    const char* body_ptr = nullptr;
+    size_t body_size = 0;
+    if (GetMsgBody(msg, &body_ptr, &body_size)) {
+      // an encoded body is freed with the batch, before the kernel would be done with its pages
+      if (use_zerocopy_ && body_size >= zerocopy_threshold_ && !HasEncodedBody(msg)) {
+        // the heads of a zero-copy batch would be pinned too, but batch_msgs_ is reused
+        zerocopy_body_ptr_ = body_ptr;
+        zerocopy_body_size_ = body_size;
+        break;
+      }
+      AppendIovec(body_ptr, body_size);
+      batch_byte_size += body_size;
+    }
   }
+  msg_cnt_.fetch_add(batch_msgs_.size(), std::memory_order_relaxed);
+  return !iovs_.empty();
 }
 
-void SocketWriteHelper::SetStatusWhenMsgBodyDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
-}
-
-void SocketWriteHelper::SetStatusWhenRequestWriteMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+bool SocketWriteHelper::WriteBatch() {
+  while (iov_idx_ < iovs_.size()) {
+    msghdr msg_hdr;
+    memset(&msg_hdr, 0, sizeof(msg_hdr));
+    msg_hdr.msg_iov = iovs_.data() + iov_idx_;
+    msg_hdr.msg_iovlen = iovs_.size() - iov_idx_;
+    int flags = 0;
+#ifdef MSG_ZEROCOPY
+    if (is_zerocopy_batch_) { flags |= MSG_ZEROCOPY; }
+#endif
+    ssize_t n = sendmsg(sockfd_, &msg_hdr, flags);
+    write_syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
+    if (n == -1 && errno == ENOBUFS && is_zerocopy_batch_) {
+      // out of the socket option memory which tracks the pages pinned by zero-copy sends
+      is_zerocopy_batch_ = false;
+      continue;
+    }
+    if (n == -1) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      blocked_write_cnt_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    byte_cnt_.fetch_add(n, std::memory_order_relaxed);
+    if (is_zerocopy_batch_) { zerocopy_byte_cnt_.fetch_add(n, std::memory_order_relaxed); }
+    size_t written = n;
+    while (iov_idx_ < iovs_.size() && written >= iovs_.at(iov_idx_).iov_len) {
+      written -= iovs_.at(iov_idx_).iov_len;
+      ++iov_idx_;
+    }
+    if (written > 0) {
+      iovec* iov = &iovs_.at(iov_idx_);
+      iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+  return true;
 }
 
-void SocketWriteHelper::SetStatusWhenRequestReadMsgHeadDone() {
-  const void* src_token = cur_msg_.request_read_msg.src_token;
-  auto src_mem_desc = static_cast<const SocketMemDesc*>(src_token);
-  write_ptr_ = reinterpret_cast<const char*>(src_mem_desc->mem_ptr);
-  write_size_ = src_mem_desc->byte_size;
-  cur_write_handle_ = &SocketWriteHelper::MsgBodyWriteHandle;
+void SocketWriteHelper::AppendIovec(const void* ptr, size_t size) {
+  if (size == 0) { return; }
+  iovec iov;
+  iov.iov_base = const_cast<void*>(ptr);
+  iov.iov_len = size;
+  iovs_.push_back(iov);
 }
 
-void SocketWriteHelper::SetStatusWhenActorMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+void SocketWriteHelper::EnableZeroCopyIfSupported() {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  const int val = 1;
+  if (setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &val, sizeof(val)) == 0) {
+    use_zerocopy_ = true;
+    return;
+  }
+#endif
+  LOG(WARNING) << "MSG_ZEROCOPY is not supported on sockfd " << sockfd_;
 }
 
-void SocketWriteHelper::SetStatusWhenTransportMsgHeadDone() {
-  cur_write_handle_ = &SocketWriteHelper::InitMsgWriteHandle;
+void SocketWriteHelper::DrainZeroCopyCompletions() {
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+  while (true) {
+    char control[128];
+    msghdr msg_hdr;
+    memset(&msg_hdr, 0, sizeof(msg_hdr));
+    msg_hdr.msg_control = control;
+    msg_hdr.msg_controllen = sizeof(control);
+    if (recvmsg(sockfd_, &msg_hdr, MSG_ERRQUEUE) == -1) {
+      PCHECK(errno == EAGAIN || errno == EWOULDBLOCK);
+      return;
+    }
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&msg_hdr); cm != nullptr; cm = CMSG_NXTHDR(&msg_hdr, cm)) {
+      auto err = reinterpret_cast<const sock_extended_err*>(CMSG_DATA(cm));
+      CHECK_EQ(err->ee_errno, 0) << "sockfd " << sockfd_ << ": " << strerror(err->ee_errno);
+      CHECK_EQ(err->ee_origin, SO_EE_ORIGIN_ZEROCOPY);
+      if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+        // [ee_info, ee_data] is the range of completed sends
+        zerocopy_copied_cnt_.fetch_add(err->ee_data - err->ee_info + 1, std::memory_order_relaxed);
+      }
+    }
+  }
+#endif
 }
 
 }  // namespace oneflow
@@ -18,39 +18,57 @@ limitations under the License.
 
 #include "oneflow/core/comm_network/epoll/io_event_poller.h"
 #include "oneflow/core/comm_network/epoll/socket_message.h"
+#include "oneflow/core/job/resource.pb.h"
 
 #ifdef OF_PLATFORM_POSIX
 
+#include <sys/uio.h>
+
 namespace oneflow {
 
+struct SocketWriteStats {
+  int64_t msg_cnt;
+  int64_t byte_cnt;
+  int64_t write_syscall_cnt;
+  // syscalls which wrote nothing because the socket buffer was full
+  int64_t blocked_write_cnt;
+  int64_t zerocopy_byte_cnt;
+  // zero-copy sends the kernel had to copy after all, e.g. on loopback
+  int64_t zerocopy_copied_cnt;
+};
+
+// Writes the queued socket messages of one socket. Every call to sendmsg carries a batch of
+// message heads and regst bodies gathered into iovecs, so that a burst of small actor messages
+// costs one syscall instead of one per head and body. Bodies of at least zerocopy_threshold bytes
+// are sent in a batch of their own with MSG_ZEROCOPY when it is enabled. The sender regst is only
+// reused after the peer has received the body, which is after the kernel is done with its pages.
 class SocketWriteHelper final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SocketWriteHelper);
   SocketWriteHelper() = delete;
   ~SocketWriteHelper();
 
-  SocketWriteHelper(int sockfd, IOEventPoller* poller);
+  SocketWriteHelper(int sockfd, IOEventPoller* poller, const EpollCommNetConf& conf);
 
   void AsyncWrite(const SocketMsg& msg);
 
   void NotifyMeSocketWriteable();
+  void NotifyMeSocketError();
+
+  SocketWriteStats GetStats() const;
 
  private:
   void SendQueueNotEmptyEvent();
   void ProcessQueueNotEmptyEvent();
 
   void WriteUntilMsgQueueEmptyOrSocketNotWriteable();
-  bool InitMsgWriteHandle();
-  bool MsgHeadWriteHandle();
-  bool MsgBodyWriteHandle();
-
-  bool DoCurWrite(void (SocketWriteHelper::*set_cur_write_done)());
-  void SetStatusWhenMsgHeadDone();
-  void SetStatusWhenMsgBodyDone();
-
-#define MAKE_ENTRY(x, y) void SetStatusWhen##x##MsgHeadDone();
-  OF_PP_FOR_EACH_TUPLE(MAKE_ENTRY, SOCKET_MSG_TYPE_SEQ);
-#undef MAKE_ENTRY
+  // gathers the next batch from the queued messages, returns false when there is nothing to write
+  bool InitBatch();
+  // returns false when the socket is not writeable before the batch is done
+  bool WriteBatch();
+  void AppendIovec(const void* ptr, size_t size);
+  void EnableZeroCopyIfSupported();
+  void DrainZeroCopyCompletions();
 
   int sockfd_;
   int queue_not_empty_fd_;
@@ -60,10 +78,26 @@ class SocketWriteHelper final {
   std::mutex pending_msg_queue_mtx_;
   std::queue<SocketMsg>* pending_msg_queue_;
 
-  SocketMsg cur_msg_;
-  bool (SocketWriteHelper::*cur_write_handle_)();
-  const char* write_ptr_;
-  size_t write_size_;
+  const size_t max_batch_msg_num_;
+  const size_t max_batch_byte_size_;
+  const size_t zerocopy_threshold_;
+  bool use_zerocopy_;
+
+  // heads of the current batch, never reallocated so that the iovecs pointing into it stay valid
+  std::vector<SocketMsg> batch_msgs_;
+  std::vector<iovec> iovs_;
+  size_t iov_idx_;
+  bool is_zerocopy_batch_;
+  // a body waiting for a zero-copy batch of its own, its head went out with the previous batch
+  const char* zerocopy_body_ptr_;
+  size_t zerocopy_body_size_;
+
+  std::atomic<int64_t> msg_cnt_;
+  std::atomic<int64_t> byte_cnt_;
+  std::atomic<int64_t> write_syscall_cnt_;
+  std::atomic<int64_t> blocked_write_cnt_;
+  std::atomic<int64_t> zerocopy_byte_cnt_;
+  std::atomic<int64_t> zerocopy_copied_cnt_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,232 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/wire_codec.h"
+#include "oneflow/core/common/data_type.h"
+#include <lz4.h>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace oneflow {
+
+namespace {
+
+size_t Fp32Num(size_t byte_size, size_t fp32_offset) {
+  CHECK_LE(fp32_offset, byte_size);
+  return (byte_size - fp32_offset) / sizeof(float);
+}
+
+size_t TopKNum(size_t fp32_num, float topk_ratio) {
+  if (fp32_num == 0) { return 0; }
+  const size_t k = std::llround(fp32_num * static_cast<double>(topk_ratio));
+  return std::min(std::max<size_t>(k, 1), fp32_num);
+}
+
+float LoadFp32(const char* ptr) {
+  float val;
+  memcpy(&val, ptr, sizeof(float));
+  return val;
+}
+
+void StoreFp32(float val, char* ptr) { memcpy(ptr, &val, sizeof(float)); }
+
+uint16_t Fp32ToBf16(float val) {
+  uint32_t bits;
+  memcpy(&bits, &val, sizeof(bits));
+  // keep nan a quiet nan instead of rounding it to inf
+  if ((bits & 0x7fffffff) > 0x7f800000) { return (bits >> 16) | 0x40; }
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return bits >> 16;
+}
+
+float Bf16ToFp32(uint16_t val) {
+  const uint32_t bits = static_cast<uint32_t>(val) << 16;
+  float ret;
+  memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+template<typename T, T (*Encode)(float)>
+size_t EncodeFp32As(const char* src, size_t fp32_num, char* dst) {
+  FOR_RANGE(size_t, i, 0, fp32_num) {
+    const T val = Encode(LoadFp32(src + i * sizeof(float)));
+    memcpy(dst + i * sizeof(T), &val, sizeof(T));
+  }
+  return fp32_num * sizeof(T);
+}
+
+template<typename T, float (*Decode)(T)>
+size_t DecodeFp32As(const char* src, size_t fp32_num, char* dst) {
+  FOR_RANGE(size_t, i, 0, fp32_num) {
+    T val;
+    memcpy(&val, src + i * sizeof(T), sizeof(T));
+    StoreFp32(Decode(val), dst + i * sizeof(float));
+  }
+  return fp32_num * sizeof(T);
+}
+
+float16 Fp32ToFp16(float val) { return static_cast<float16>(val); }
+float Fp16ToFp32(float16 val) { return static_cast<float>(val); }
+
+size_t EncodeTopK(const char* src, size_t fp32_num, const std::vector<Range>& ranges,
+                  float topk_ratio, float* residual, char* dst) {
+  CHECK_LE(fp32_num, GetMaxVal<uint32_t>());
+  // the values outside the ranges, e.g. padding, stay zero and are neither ranked nor kept
+  std::vector<uint32_t> indices;
+  int64_t prev_end = 0;
+  for (const Range& range : ranges) {
+    CHECK_GE(range.begin(), prev_end);
+    CHECK_LE(range.begin(), range.end());
+    CHECK_LE(range.end(), static_cast<int64_t>(fp32_num));
+    const size_t prev_size = indices.size();
+    indices.resize(prev_size + range.size());
+    std::iota(indices.begin() + prev_size, indices.end(), range.begin());
+    prev_end = range.end();
+  }
+  const size_t k = TopKNum(indices.size(), topk_ratio);
+  // the values with the dropped ones of the earlier encodings added back
+  std::vector<float> values(fp32_num, 0);
+  std::vector<float> magnitudes(fp32_num, 0);
+  for (uint32_t i : indices) {
+    values[i] = LoadFp32(src + i * sizeof(float));
+    if (residual != nullptr) { values[i] += residual[i]; }
+    const float magnitude = std::fabs(values[i]);
+    // nan breaks the ordering of nth_element, send it like the largest value
+    magnitudes[i] = std::isnan(magnitude) ? std::numeric_limits<float>::infinity() : magnitude;
+  }
+  if (k < indices.size()) {
+    std::nth_element(indices.begin(), indices.begin() + k, indices.end(),
+                     [&](uint32_t lhs, uint32_t rhs) { return magnitudes[lhs] > magnitudes[rhs]; });
+  }
+  std::sort(indices.begin(), indices.begin() + k);
+  const uint64_t k_u64 = k;
+  memcpy(dst, &k_u64, sizeof(k_u64));
+  char* indices_ptr = dst + sizeof(k_u64);
+  char* values_ptr = indices_ptr + k * sizeof(uint32_t);
+  memcpy(indices_ptr, indices.data(), k * sizeof(uint32_t));
+  FOR_RANGE(size_t, i, 0, k) { StoreFp32(values[indices[i]], values_ptr + i * sizeof(float)); }
+  if (residual != nullptr) {
+    // what is sent leaves the residual, what is dropped stays in it
+    memcpy(residual, values.data(), fp32_num * sizeof(float));
+    FOR_RANGE(size_t, i, 0, k) { residual[indices[i]] = 0; }
+  }
+  return sizeof(k_u64) + k * (sizeof(uint32_t) + sizeof(float));
+}
+
+size_t DecodeTopK(const char* src, size_t fp32_num, char* dst) {
+  uint64_t k = 0;
+  memcpy(&k, src, sizeof(k));
+  CHECK_LE(k, fp32_num);
+  const char* indices_ptr = src + sizeof(k);
+  const char* values_ptr = indices_ptr + k * sizeof(uint32_t);
+  memset(dst, 0, fp32_num * sizeof(float));
+  FOR_RANGE(size_t, i, 0, k) {
+    uint32_t index;
+    memcpy(&index, indices_ptr + i * sizeof(uint32_t), sizeof(index));
+    CHECK_LT(index, fp32_num);
+    memcpy(dst + index * sizeof(float), values_ptr + i * sizeof(float), sizeof(float));
+  }
+  return sizeof(k) + k * (sizeof(uint32_t) + sizeof(float));
+}
+
+}  // namespace
+
+size_t WireCodecFp32Num(size_t byte_size, size_t fp32_offset) {
+  return Fp32Num(byte_size, fp32_offset);
+}
+
+bool IsFp32WireCodec(WireCodec codec) {
+  return codec == kWireCodecFp16 || codec == kWireCodecBf16 || codec == kWireCodecTopK;
+}
+
+size_t WireCodecMaxEncodedSize(WireCodec codec, size_t byte_size, size_t fp32_offset,
+                               float topk_ratio) {
+  if (codec == kWireCodecNone) { return byte_size; }
+  if (codec == kWireCodecLz4) {
+    if (byte_size > LZ4_MAX_INPUT_SIZE) { return 0; }
+    return LZ4_compressBound(byte_size);
+  }
+  CHECK(IsFp32WireCodec(codec));
+  const size_t fp32_num = Fp32Num(byte_size, fp32_offset);
+  const size_t raw_size = byte_size - fp32_num * sizeof(float);
+  if (codec == kWireCodecFp16) { return raw_size + fp32_num * sizeof(float16); }
+  if (codec == kWireCodecBf16) { return raw_size + fp32_num * sizeof(uint16_t); }
+  if (fp32_num > GetMaxVal<uint32_t>()) { return 0; }
+  return raw_size + sizeof(uint64_t)
+         + TopKNum(fp32_num, topk_ratio) * (sizeof(uint32_t) + sizeof(float));
+}
+
+size_t WireEncode(WireCodec codec, const char* src, size_t byte_size, size_t fp32_offset,
+                  const std::vector<Range>& topk_ranges, float topk_ratio, float* topk_residual,
+                  char* dst) {
+  if (codec == kWireCodecNone) {
+    memcpy(dst, src, byte_size);
+    return byte_size;
+  }
+  if (codec == kWireCodecLz4) {
+    const int encoded_size =
+        LZ4_compress_default(src, dst, byte_size, LZ4_compressBound(byte_size));
+    CHECK_GT(encoded_size, 0);
+    return encoded_size;
+  }
+  CHECK(IsFp32WireCodec(codec));
+  const size_t fp32_num = Fp32Num(byte_size, fp32_offset);
+  const size_t fp32_end = fp32_offset + fp32_num * sizeof(float);
+  char* cur_dst = dst;
+  memcpy(cur_dst, src, fp32_offset);
+  cur_dst += fp32_offset;
+  if (codec == kWireCodecFp16) {
+    cur_dst += EncodeFp32As<float16, Fp32ToFp16>(src + fp32_offset, fp32_num, cur_dst);
+  } else if (codec == kWireCodecBf16) {
+    cur_dst += EncodeFp32As<uint16_t, Fp32ToBf16>(src + fp32_offset, fp32_num, cur_dst);
+  } else {
+    cur_dst += EncodeTopK(src + fp32_offset, fp32_num, topk_ranges, topk_ratio, topk_residual,
+                          cur_dst);
+  }
+  memcpy(cur_dst, src + fp32_end, byte_size - fp32_end);
+  cur_dst += byte_size - fp32_end;
+  return cur_dst - dst;
+}
+
+void WireDecode(WireCodec codec, const char* src, size_t encoded_size, size_t fp32_offset,
+                char* dst, size_t byte_size) {
+  if (codec == kWireCodecNone) {
+    CHECK_EQ(encoded_size, byte_size);
+    memcpy(dst, src, byte_size);
+    return;
+  }
+  if (codec == kWireCodecLz4) {
+    CHECK_EQ(LZ4_decompress_safe(src, dst, encoded_size, byte_size), static_cast<int>(byte_size));
+    return;
+  }
+  CHECK(IsFp32WireCodec(codec));
+  const size_t fp32_num = Fp32Num(byte_size, fp32_offset);
+  const size_t fp32_end = fp32_offset + fp32_num * sizeof(float);
+  const char* cur_src = src;
+  memcpy(dst, cur_src, fp32_offset);
+  cur_src += fp32_offset;
+  if (codec == kWireCodecFp16) {
+    cur_src += DecodeFp32As<float16, Fp16ToFp32>(cur_src, fp32_num, dst + fp32_offset);
+  } else if (codec == kWireCodecBf16) {
+    cur_src += DecodeFp32As<uint16_t, Bf16ToFp32>(cur_src, fp32_num, dst + fp32_offset);
+  } else {
+    cur_src += DecodeTopK(cur_src, fp32_num, dst + fp32_offset);
+  }
+  memcpy(dst + fp32_end, cur_src, byte_size - fp32_end);
+  CHECK_EQ(static_cast<size_t>(cur_src - src) + byte_size - fp32_end, encoded_size);
+}
+
+}  // namespace oneflow
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMM_NETWORK_EPOLL_WIRE_CODEC_H_
+#define ONEFLOW_CORE_COMM_NETWORK_EPOLL_WIRE_CODEC_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/range.h"
+#include "oneflow/core/job/resource.pb.h"
+
+namespace oneflow {
+
+// Codecs for regst bodies on the wire. The fp32 codecs keep the bytes before fp32_offset, e.g. the
+// blob headers, and the bytes after the last whole fp32 value as they are.
+//
+// kWireCodecLz4: the LZ4 block format
+// kWireCodecFp16, kWireCodecBf16: every value rounded to nearest even
+// kWireCodecTopK: the number of kept values, their indices and their values, the decoder sets all
+//   the other values to zero. The encoder keeps the dropped values in a residual of the buffer and
+//   adds them back before the next selection, so that they are delayed rather than lost. Only the
+//   values in the given ranges are ranked, e.g. the blob bodies without the padding between them.
+
+bool IsFp32WireCodec(WireCodec codec);
+
+// upper bound of the size WireEncode returns, 0 if byte_size is too large for the codec
+size_t WireCodecMaxEncodedSize(WireCodec codec, size_t byte_size, size_t fp32_offset,
+                               float topk_ratio);
+
+// encodes byte_size bytes of src into dst of at least WireCodecMaxEncodedSize bytes and returns
+// the encoded size. topk_ranges are the sorted, disjoint ranges of the fp32 values kWireCodecTopK
+// ranks, indexed from fp32_offset, the others are sent as zeros. topk_residual holds one value per
+// fp32 value of src for kWireCodecTopK, zeros before the first encoding of a buffer, nullptr drops
+// the values for good.
+size_t WireEncode(WireCodec codec, const char* src, size_t byte_size, size_t fp32_offset,
+                  const std::vector<Range>& topk_ranges, float topk_ratio, float* topk_residual,
+                  char* dst);
+
+// the number of fp32 values WireEncode encodes lossy
+size_t WireCodecFp32Num(size_t byte_size, size_t fp32_offset);
+
+// decodes encoded_size bytes of src into the byte_size bytes of dst
+void WireDecode(WireCodec codec, const char* src, size_t encoded_size, size_t fp32_offset,
+                char* dst, size_t byte_size);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMM_NETWORK_EPOLL_WIRE_CODEC_H_
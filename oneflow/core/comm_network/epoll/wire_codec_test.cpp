@@ -0,0 +1,182 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/comm_network/epoll/wire_codec.h"
+#include <cmath>
+
+namespace oneflow {
+
+namespace {
+
+// a header of 7 bytes, then fp32 values and 3 tail bytes
+constexpr size_t kFp32Offset = 7;
+constexpr size_t kFp32Num = 1000;
+constexpr size_t kByteSize = kFp32Offset + kFp32Num * sizeof(float) + 3;
+
+std::vector<char> GenBody() {
+  std::vector<char> body(kByteSize);
+  std::mt19937 gen(0);
+  std::normal_distribution<float> dis(0, 1);
+  FOR_RANGE(size_t, i, 0, kFp32Offset) { body[i] = static_cast<char>(i + 1); }
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    const float val = dis(gen);
+    memcpy(body.data() + kFp32Offset + i * sizeof(float), &val, sizeof(float));
+  }
+  FOR_RANGE(size_t, i, kByteSize - 3, kByteSize) { body[i] = static_cast<char>(i); }
+  return body;
+}
+
+float Fp32At(const std::vector<char>& body, size_t i) {
+  float val;
+  memcpy(&val, body.data() + kFp32Offset + i * sizeof(float), sizeof(float));
+  return val;
+}
+
+std::vector<char> RoundTrip(WireCodec codec, const std::vector<char>& body, float topk_ratio,
+                            size_t* encoded_size) {
+  const size_t max_encoded_size =
+      WireCodecMaxEncodedSize(codec, body.size(), kFp32Offset, topk_ratio);
+  std::vector<char> encoded(max_encoded_size);
+  *encoded_size = WireEncode(codec, body.data(), body.size(), kFp32Offset, {Range(0, kFp32Num)},
+                             topk_ratio, nullptr, encoded.data());
+  EXPECT_LE(*encoded_size, max_encoded_size);
+  std::vector<char> decoded(body.size());
+  WireDecode(codec, encoded.data(), *encoded_size, kFp32Offset, decoded.data(), decoded.size());
+  // the header and the tail are never touched
+  EXPECT_TRUE(std::equal(body.begin(), body.begin() + kFp32Offset, decoded.begin()));
+  EXPECT_TRUE(std::equal(body.end() - 3, body.end(), decoded.end() - 3));
+  return decoded;
+}
+
+}  // namespace
+
+TEST(WireCodec, lz4) {
+  std::vector<char> body(1 << 20);
+  FOR_RANGE(size_t, i, 0, body.size()) { body[i] = static_cast<char>(i / 256 % 17); }
+  size_t encoded_size = 0;
+  ASSERT_EQ(RoundTrip(kWireCodecLz4, body, 0, &encoded_size), body);
+  ASSERT_LT(encoded_size, body.size() / 10);
+}
+
+TEST(WireCodec, fp16_and_bf16) {
+  const std::vector<char> body = GenBody();
+  for (WireCodec codec : {kWireCodecFp16, kWireCodecBf16}) {
+    size_t encoded_size = 0;
+    const std::vector<char> decoded = RoundTrip(codec, body, 0, &encoded_size);
+    ASSERT_EQ(encoded_size, kByteSize - kFp32Num * 2);
+    // 11 and 8 significant bits
+    const float max_rel_err = codec == kWireCodecFp16 ? 1.f / 2048 : 1.f / 256;
+    FOR_RANGE(size_t, i, 0, kFp32Num) {
+      const float val = Fp32At(body, i);
+      if (std::fabs(val) < 1e-3) { continue; }
+      ASSERT_LE(std::fabs(Fp32At(decoded, i) - val), std::fabs(val) * max_rel_err);
+    }
+  }
+}
+
+TEST(WireCodec, topk) {
+  const std::vector<char> body = GenBody();
+  size_t encoded_size = 0;
+  const std::vector<char> decoded = RoundTrip(kWireCodecTopK, body, 0.1, &encoded_size);
+  ASSERT_EQ(encoded_size, kFp32Offset + 8 + 100 * 8 + 3);
+  std::vector<float> magnitudes;
+  FOR_RANGE(size_t, i, 0, kFp32Num) { magnitudes.push_back(std::fabs(Fp32At(body, i))); }
+  std::sort(magnitudes.begin(), magnitudes.end());
+  const float threshold = magnitudes.at(kFp32Num - 100);
+  int64_t kept_num = 0;
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    const float val = Fp32At(body, i);
+    if (std::fabs(val) >= threshold) {
+      ASSERT_EQ(Fp32At(decoded, i), val);
+      ++kept_num;
+    } else {
+      ASSERT_EQ(Fp32At(decoded, i), 0);
+    }
+  }
+  ASSERT_EQ(kept_num, 100);
+}
+
+TEST(WireCodec, topk_residual) {
+  const std::vector<char> body = GenBody();
+  const float topk_ratio = 0.1;
+  std::vector<char> encoded(WireCodecMaxEncodedSize(kWireCodecTopK, body.size(), kFp32Offset,
+                                                    topk_ratio));
+  std::vector<float> residual(kFp32Num, 0);
+  std::vector<double> sent_sums(kFp32Num, 0);
+  const int64_t step_num = 30;
+  FOR_RANGE(int64_t, step, 0, step_num) {
+    const size_t encoded_size =
+        WireEncode(kWireCodecTopK, body.data(), body.size(), kFp32Offset, {Range(0, kFp32Num)},
+                   topk_ratio, residual.data(), encoded.data());
+    std::vector<char> decoded(body.size());
+    WireDecode(kWireCodecTopK, encoded.data(), encoded_size, kFp32Offset, decoded.data(),
+               decoded.size());
+    // nothing is lost: what was sent so far and what is left add up to the input so far
+    FOR_RANGE(size_t, i, 0, kFp32Num) {
+      sent_sums[i] += Fp32At(decoded, i);
+      const double expected = static_cast<double>(Fp32At(body, i)) * (step + 1);
+      ASSERT_NEAR(sent_sums[i] + residual[i], expected, 1e-3 * (step + 1));
+    }
+  }
+  // the dropped values build up until they are sent, without the residual the same 900 values
+  // would be dropped every step
+  int64_t never_sent_num = 0;
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    if (sent_sums[i] == 0) { ++never_sent_num; }
+  }
+  ASSERT_LT(never_sent_num, kFp32Num / 2);
+}
+
+TEST(WireCodec, topk_skips_padding) {
+  std::vector<char> body = GenBody();
+  // two blobs of 400 values, each followed by 100 values of padding holding garbage
+  const std::vector<Range> ranges{Range(0, 400), Range(500, 900)};
+  auto IsPadding = [](size_t i) { return (i >= 400 && i < 500) || i >= 900; };
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    if (!IsPadding(i)) { continue; }
+    const float val = i % 2 == 0 ? std::numeric_limits<float>::quiet_NaN() : 1e30f;
+    memcpy(body.data() + kFp32Offset + i * sizeof(float), &val, sizeof(float));
+  }
+  const float topk_ratio = 0.1;
+  std::vector<char> encoded(WireCodecMaxEncodedSize(kWireCodecTopK, body.size(), kFp32Offset,
+                                                    topk_ratio));
+  std::vector<float> residual(kFp32Num, 0);
+  const size_t encoded_size = WireEncode(kWireCodecTopK, body.data(), body.size(), kFp32Offset,
+                                         ranges, topk_ratio, residual.data(), encoded.data());
+  // 10% of the 800 blob values
+  ASSERT_EQ(encoded_size, kFp32Offset + 8 + 80 * 8 + 3);
+  std::vector<char> decoded(body.size());
+  WireDecode(kWireCodecTopK, encoded.data(), encoded_size, kFp32Offset, decoded.data(),
+             decoded.size());
+  std::vector<float> magnitudes;
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    if (!IsPadding(i)) { magnitudes.push_back(std::fabs(Fp32At(body, i))); }
+  }
+  std::sort(magnitudes.begin(), magnitudes.end());
+  const float threshold = magnitudes.at(magnitudes.size() - 80);
+  FOR_RANGE(size_t, i, 0, kFp32Num) {
+    if (IsPadding(i)) {
+      ASSERT_EQ(Fp32At(decoded, i), 0);
+      ASSERT_EQ(residual[i], 0);
+    } else if (std::fabs(Fp32At(body, i)) >= threshold) {
+      ASSERT_EQ(Fp32At(decoded, i), Fp32At(body, i));
+    } else {
+      ASSERT_EQ(Fp32At(decoded, i), 0);
+      ASSERT_EQ(residual[i], Fp32At(body, i));
+    }
+  }
+}
+
+}  // namespace oneflow
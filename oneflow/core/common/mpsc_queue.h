@@ -0,0 +1,237 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_MPSC_QUEUE_H_
+#define ONEFLOW_CORE_COMMON_MPSC_QUEUE_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/channel.h"
+
+namespace oneflow {
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+// A bounded lock-free multi-producer/single-consumer queue with the same interface as Channel.
+//
+// Producers claim slots of a power-of-two ring by CAS on tail_. The consumer spins, then yields,
+// then parks on cond_; producers only take mutex_ to wake it up when it is parked. When the ring
+// is full, producers spill into overflow_queue_ instead of blocking, so threads sending to each
+// other can never deadlock. Messages from the same producer are always received in send order.
+template<typename T>
+class MpscQueue final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MpscQueue);
+  explicit MpscQueue(size_t capacity)
+      : MpscQueue(capacity, std::thread::hardware_concurrency() > 1 ? 4096 : 0, 64) {}
+  MpscQueue(size_t capacity, int64_t spin_cnt, int64_t yield_cnt);
+  ~MpscQueue() = default;
+
+  ChannelStatus Send(const T& item) { return SendMany(&item, &item + 1); }
+  // items of one call are claimed with a single CAS and received back to back
+  template<typename ForwardIt>
+  ChannelStatus SendMany(ForwardIt first, ForwardIt last);
+  ChannelStatus Receive(T* item);
+  ChannelStatus ReceiveMany(std::queue<T>* items);
+  void Close();
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+  static constexpr size_t kCacheLineSize = 64;
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t ret = 1;
+    while (ret < n) { ret <<= 1; }
+    return ret;
+  }
+
+  template<typename ForwardIt>
+  bool TryPushMany(ForwardIt first, size_t num);
+  void WakeUpIfParked();
+  bool HasPending() const { return tail_.load() != head_ || overflow_cnt_.load() != 0; }
+  void WaitUntilHasPendingOrClosed();
+  void PopUntil(size_t end, std::queue<T>* items);
+
+  const size_t mask_;
+  const int64_t spin_cnt_;
+  const int64_t yield_cnt_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(kCacheLineSize) std::atomic<size_t> tail_;
+  alignas(kCacheLineSize) size_t head_;
+  std::queue<T> received_;
+  alignas(kCacheLineSize) std::atomic<int64_t> overflow_cnt_;
+  std::atomic<bool> consumer_parked_;
+  std::atomic<bool> is_closed_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::queue<T> overflow_queue_;
+};
+
+template<typename T>
+MpscQueue<T>::MpscQueue(size_t capacity, int64_t spin_cnt, int64_t yield_cnt)
+    : mask_(RoundUpToPowerOfTwo(std::max<size_t>(capacity, 2)) - 1),
+      spin_cnt_(spin_cnt),
+      yield_cnt_(yield_cnt),
+      cells_(new Cell[mask_ + 1]),
+      tail_(0),
+      head_(0),
+      overflow_cnt_(0),
+      consumer_parked_(false),
+      is_closed_(false) {
+  FOR_RANGE(size_t, i, 0, mask_ + 1) { cells_[i].sequence.store(i, std::memory_order_relaxed); }
+}
+
+template<typename T>
+template<typename ForwardIt>
+ChannelStatus MpscQueue<T>::SendMany(ForwardIt first, ForwardIt last) {
+  if (is_closed_.load(std::memory_order_acquire)) { return kChannelStatusErrorClosed; }
+  const size_t num = std::distance(first, last);
+  if (num == 0) { return kChannelStatusSuccess; }
+  // once anything has spilled, keep spilling until the consumer drains the overflow queue, so
+  // that a later item of this producer can never overtake an earlier one
+  if (overflow_cnt_.load() == 0 && num <= capacity() && TryPushMany(first, num)) {
+    WakeUpIfParked();
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (; first != last; ++first) { overflow_queue_.push(*first); }
+    overflow_cnt_.fetch_add(num);
+    cond_.notify_one();
+  }
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+template<typename ForwardIt>
+bool MpscQueue<T>::TryPushMany(ForwardIt first, size_t num) {
+  size_t pos = tail_.load(std::memory_order_relaxed);
+  while (true) {
+    // the consumer frees slots in order, so the last slot being free implies all of them are
+    const size_t last_pos = pos + num - 1;
+    const size_t seq = cells_[last_pos & mask_].sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(last_pos);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + num)) { break; }
+    } else if (diff < 0) {
+      return false;
+    } else {
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+  for (size_t i = 0; i < num; ++i, ++first) {
+    Cell* cell = &cells_[(pos + i) & mask_];
+    cell->data = *first;
+    cell->sequence.store(pos + i + 1, std::memory_order_release);
+  }
+  return true;
+}
+
+template<typename T>
+void MpscQueue<T>::WakeUpIfParked() {
+  // pairs with the store of consumer_parked_ before the consumer re-checks tail_
+  if (consumer_parked_.load()) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.notify_one();
+  }
+}
+
+template<typename T>
+void MpscQueue<T>::WaitUntilHasPendingOrClosed() {
+  auto Ready = [this]() { return HasPending() || is_closed_.load(std::memory_order_acquire); };
+  FOR_RANGE(int64_t, i, 0, spin_cnt_) {
+    if (Ready()) { return; }
+    CpuRelax();
+  }
+  FOR_RANGE(int64_t, i, 0, yield_cnt_) {
+    if (Ready()) { return; }
+    std::this_thread::yield();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  consumer_parked_.store(true);
+  cond_.wait(lock, Ready);
+  consumer_parked_.store(false);
+}
+
+template<typename T>
+void MpscQueue<T>::PopUntil(size_t end, std::queue<T>* items) {
+  for (; head_ != end; ++head_) {
+    Cell* cell = &cells_[head_ & mask_];
+    // the slot may be claimed by a producer which has not finished writing it yet
+    while (cell->sequence.load(std::memory_order_acquire) != head_ + 1) { CpuRelax(); }
+    items->push(std::move(cell->data));
+    cell->sequence.store(head_ + mask_ + 1, std::memory_order_release);
+  }
+}
+
+template<typename T>
+ChannelStatus MpscQueue<T>::Receive(T* item) {
+  if (received_.empty()) {
+    ChannelStatus status = ReceiveMany(&received_);
+    if (status != kChannelStatusSuccess) { return status; }
+  }
+  *item = std::move(received_.front());
+  received_.pop();
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+ChannelStatus MpscQueue<T>::ReceiveMany(std::queue<T>* items) {
+  if (items != &received_ && !received_.empty()) {
+    while (!received_.empty()) {
+      items->push(std::move(received_.front()));
+      received_.pop();
+    }
+    return kChannelStatusSuccess;
+  }
+  WaitUntilHasPendingOrClosed();
+  if (!HasPending()) { return kChannelStatusErrorClosed; }
+  PopUntil(tail_.load(), items);
+  if (overflow_cnt_.load() != 0) {
+    std::queue<T> overflow_items;
+    size_t end = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      end = tail_.load();
+      overflow_items.swap(overflow_queue_);
+      overflow_cnt_.store(0);
+    }
+    // slots claimed before the swap were sent before any spilled item of the same producer
+    PopUntil(end, items);
+    while (!overflow_items.empty()) {
+      items->push(std::move(overflow_items.front()));
+      overflow_items.pop();
+    }
+  }
+  return kChannelStatusSuccess;
+}
+
+template<typename T>
+void MpscQueue<T>::Close() {
+  is_closed_.store(true, std::memory_order_release);
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.notify_all();
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_MPSC_QUEUE_H_
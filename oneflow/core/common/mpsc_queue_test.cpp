@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/mpsc_queue.h"
+
+namespace oneflow {
+
+namespace {
+
+void SendFromProducerThread(MpscQueue<std::pair<int, int>>* queue, int producer_id, int num) {
+  FOR_RANGE(int, i, 0, num) {
+    if (queue->Send(std::make_pair(producer_id, i)) != kChannelStatusSuccess) { break; }
+  }
+}
+
+void SendManyFromProducerThread(MpscQueue<std::pair<int, int>>* queue, int producer_id, int num) {
+  std::vector<std::pair<int, int>> batch;
+  FOR_RANGE(int, i, 0, num) {
+    batch.push_back(std::make_pair(producer_id, i));
+    if (batch.size() == 1 + i % 5 || i == num - 1) {
+      if (queue->SendMany(batch.begin(), batch.end()) != kChannelStatusSuccess) { break; }
+      batch.clear();
+    }
+  }
+}
+
+void TestManyProducersKeepSendOrder(size_t capacity, bool send_many) {
+  MpscQueue<std::pair<int, int>> queue(capacity);
+  const int producer_num = 30;
+  const int msg_num = 2000;
+  std::vector<std::thread> producers;
+  FOR_RANGE(int, i, 0, producer_num) {
+    producers.push_back(std::thread(send_many ? SendManyFromProducerThread : SendFromProducerThread,
+                                    &queue, i, msg_num));
+  }
+  std::vector<int> next_expected(producer_num, 0);
+  FOR_RANGE(int, i, 0, producer_num * msg_num) {
+    std::pair<int, int> msg;
+    ASSERT_EQ(queue.Receive(&msg), kChannelStatusSuccess);
+    ASSERT_EQ(msg.second, next_expected.at(msg.first));
+    ++next_expected.at(msg.first);
+  }
+  for (std::thread& producer : producers) { producer.join(); }
+  for (int cnt : next_expected) { ASSERT_EQ(cnt, msg_num); }
+}
+
+}  // namespace
+
+TEST(MpscQueue, 30producer) { TestManyProducersKeepSendOrder(1024, false); }
+
+TEST(MpscQueue, 30producer_overflow) { TestManyProducersKeepSendOrder(2, false); }
+
+TEST(MpscQueue, 30producer_send_many) { TestManyProducersKeepSendOrder(16, true); }
+
+TEST(MpscQueue, receive_many_after_close) {
+  MpscQueue<int> queue(4);
+  FOR_RANGE(int, i, 0, 10) { ASSERT_EQ(queue.Send(i), kChannelStatusSuccess); }
+  queue.Close();
+  ASSERT_EQ(queue.Send(10), kChannelStatusErrorClosed);
+  std::queue<int> items;
+  ASSERT_EQ(queue.ReceiveMany(&items), kChannelStatusSuccess);
+  ASSERT_EQ(items.size(), 10);
+  FOR_RANGE(int, i, 0, 10) {
+    ASSERT_EQ(items.front(), i);
+    items.pop();
+  }
+  ASSERT_EQ(queue.ReceiveMany(&items), kChannelStatusErrorClosed);
+}
+
+TEST(MpscQueue, wake_up_parked_consumer) {
+  MpscQueue<int> queue(16, 0, 0);
+  std::thread consumer([&queue]() {
+    int sum = 0;
+    int item = 0;
+    while (queue.Receive(&item) == kChannelStatusSuccess) { sum += item; }
+    ASSERT_EQ(sum, 4950);
+  });
+  FOR_RANGE(int, i, 0, 100) {
+    queue.Send(i);
+    std::this_thread::sleep_for(std::chrono::microseconds(10));
+  }
+  queue.Close();
+  consumer.join();
+}
+
+}  // namespace oneflow
@@ -37,7 +37,12 @@ class TensorBuffer {
 
   OF_DISALLOW_COPY_AND_MOVE(TensorBuffer);
   TensorBuffer()
-      : data_(nullptr), num_bytes_(0), shape_(Shape()), data_type_(DataType::kInvalidDataType) {}
+      : data_(nullptr),
+        view_data_(nullptr),
+        is_read_only_view_(false),
+        num_bytes_(0),
+        shape_(Shape()),
+        data_type_(DataType::kInvalidDataType) {}
   virtual ~TensorBuffer() = default;
 
   const Shape& shape() const { return shape_; }
@@ -57,26 +62,53 @@ class TensorBuffer {
 
   template<typename T = void>
   inline T* mut_data() {
-    if (data_ == nullptr) { return nullptr; }
+    if (raw_data() == nullptr) { return nullptr; }
+    CHECK(!is_read_only_view_) << "TensorBuffer is a read-only view, Resize or CopyFrom it first.";
     CheckDataType<T>(data_type_);
-    return static_cast<T*>(data_.get());
+    return static_cast<T*>(raw_data());
   }
 
   template<typename T = void>
   inline const T* data() const {
-    if (data_ == nullptr) { return nullptr; }
+    if (raw_data() == nullptr) { return nullptr; }
     CheckDataType<T>(data_type_);
-    return static_cast<const T*>(data_.get());
+    return static_cast<const T*>(raw_data());
   }
 
+  // Points to the memory of ptr, which stays valid as long as owner is held, instead of a buffer
+  // of its own. A view is writable, and it is copied to a buffer of its own once it is resized.
+  void ResetToView(const Shape& shape, DataType data_type, void* ptr,
+                   std::shared_ptr<const void> owner) {
+    CheckTensorBufferDataType(data_type);
+    reset();
+    shape_ = shape;
+    data_type_ = data_type;
+    view_data_ = ptr;
+    view_owner_ = std::move(owner);
+    num_bytes_ = nbytes();
+  }
+
+  // A view of memory shared with others, e.g. a cache, which mut_data() refuses to hand out
+  void ResetToReadOnlyView(const Shape& shape, DataType data_type, const void* ptr,
+                           std::shared_ptr<const void> owner) {
+    ResetToView(shape, data_type, const_cast<void*>(ptr), std::move(owner));
+    is_read_only_view_ = true;
+  }
+
+  bool is_view() const { return view_data_ != nullptr; }
+
   void reset() {
     shape_ = Shape();
     data_.reset();
+    view_data_ = nullptr;
+    is_read_only_view_ = false;
+    view_owner_.reset();
     data_type_ = DataType::kInvalidDataType;
     num_bytes_ = 0;
   }
 
   void reserve(size_t new_num_bytes) {
+    if (is_view()) { CopyViewToOwnBuffer(std::max(new_num_bytes, num_bytes_)); }
     if (new_num_bytes <= num_bytes_) { return; }
     data_.reset();
     data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
@@ -95,6 +127,7 @@ class TensorBuffer {
     int64_t elem_cnt = new_shape.elem_cnt();
     if (new_type == DataType::kInvalidDataType || elem_cnt == 0) { return; }
     CheckTensorBufferDataType(new_type);
+    if (is_view()) { CopyViewToOwnBuffer(num_bytes_); }
 
     data_type_ = new_type;
     shape_ = new_shape;
@@ -120,18 +153,39 @@ class TensorBuffer {
 
   void Swap(TensorBuffer* lhs) {
     data_.swap(lhs->data_);
+    std::swap(view_data_, lhs->view_data_);
+    std::swap(is_read_only_view_, lhs->is_read_only_view_);
+    view_owner_.swap(lhs->view_owner_);
     std::swap(num_bytes_, lhs->num_bytes_);
     std::swap(shape_, lhs->shape_);
     std::swap(data_type_, lhs->data_type_);
   }
 
  private:
+  void* raw_data() const { return is_view() ? view_data_ : data_.get(); }
+
+  void CopyViewToOwnBuffer(size_t new_num_bytes) {
+    new_num_bytes = RoundUp(new_num_bytes, kTensorBufferAlignedSize);
+    data_.reset();
+    if (new_num_bytes > 0) {
+      data_.reset(MemoryAllocatorImpl::AllocateUnPinnedHostMem(new_num_bytes));
+      memcpy(data_.get(), view_data_, nbytes());
+    }
+    view_data_ = nullptr;
+    is_read_only_view_ = false;
+    view_owner_.reset();
+    num_bytes_ = new_num_bytes;
+  }
+
   // TODO(chengcheng)
   static double growth_factor_;
   static double shrink_threshold_;
   static constexpr size_t kTensorBufferAlignedSize = 1024;
 
   BufferType data_;
+  void* view_data_;
+  bool is_read_only_view_;
+  std::shared_ptr<const void> view_owner_;
   size_t num_bytes_;
   Shape shape_;
   DataType data_type_;
@@ -305,5 +305,8 @@ REGISTER_USER_OP_AREA_ID("indexed_slices_momentum_update", AreaType::kMdUpdtArea
 REGISTER_USER_OP_AREA_ID("adam_update", AreaType::kMdUpdtArea)
 REGISTER_USER_OP_AREA_ID("indexed_slices_adam_update", AreaType::kMdUpdtArea)
 REGISTER_USER_OP_AREA_ID("lamb_update", AreaType::kMdUpdtArea)
+REGISTER_USER_OP_AREA_ID("multi_tensor_sgd_update", AreaType::kMdUpdtArea)
+REGISTER_USER_OP_AREA_ID("multi_tensor_momentum_update", AreaType::kMdUpdtArea)
+REGISTER_USER_OP_AREA_ID("multi_tensor_adam_update", AreaType::kMdUpdtArea)
 
 }  // namespace oneflow
@@ -18,9 +18,55 @@ limitations under the License.
 #include "oneflow/core/persistence/tee_persistent_log_stream.h"
 #include "oneflow/core/graph/op_graph.h"
 #include "oneflow/core/job_rewriter/job_completer.h"
+#include "oneflow/core/job/job_builder.h"
 
 namespace oneflow {
 
+namespace {
+
+// Opts the regsts a CopyCommNet task reads from another machine or writes into the lossy wire
+// codecs if they hold only fp32 diff blobs of autograd, e.g. the gradients boxed across machines.
+void EnableLossyWireCodecOfGradientRegsts(const Job& job, Plan* plan) {
+  const auto& tag2lbi_relations = job.helper().tag2lbi_relations();
+  const auto relations_it = tag2lbi_relations.find(kProducedLbi2ConsumedDiffLbi);
+  if (relations_it == tag2lbi_relations.end()) { return; }
+  HashSet<LogicalBlobId> diff_lbis;
+  for (const auto& pair : relations_it->second.pair()) { diff_lbis.insert(pair.second()); }
+  HashSet<int64_t> comm_net_regst_desc_ids;
+  for (const TaskProto& task_proto : plan->task()) {
+    if (task_proto.task_type() != TaskType::kCopyCommNet) { continue; }
+    for (const auto& pair : task_proto.consumed_regst_desc_id()) {
+      for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+        comm_net_regst_desc_ids.insert(regst_desc_id);
+      }
+    }
+    for (const auto& pair : task_proto.produced_regst_desc()) {
+      comm_net_regst_desc_ids.insert(pair.second.regst_desc_id());
+    }
+  }
+  auto IsFp32Diff = [&](const LbiBlobDescPair& pair) {
+    return diff_lbis.find(pair.lbi()) != diff_lbis.end()
+           && pair.blob_desc().body().data_type() == DataType::kFloat;
+  };
+  for (TaskProto& task_proto : *plan->mutable_task()) {
+    for (auto& pair : *task_proto.mutable_produced_regst_desc()) {
+      RegstDescProto* regst_desc = &pair.second;
+      if (comm_net_regst_desc_ids.find(regst_desc->regst_desc_id())
+          == comm_net_regst_desc_ids.end()) {
+        continue;
+      }
+      if (!regst_desc->regst_desc_type().has_data_regst_desc()) { continue; }
+      const auto& lbi2blob_desc = regst_desc->regst_desc_type().data_regst_desc().lbi2blob_desc();
+      if (!lbi2blob_desc.empty()
+          && std::all_of(lbi2blob_desc.begin(), lbi2blob_desc.end(), IsFp32Diff)) {
+        regst_desc->set_enable_lossy_wire_codec(true);
+      }
+    }
+  }
+}
+
+}  // namespace
+
 void Compiler::GenNetTopo(Plan* plan) const {
   HashMap<int64_t, int64_t> rid2mid;
   HashMap<int64_t, int64_t> tid2mid;
@@ -90,6 +136,7 @@ void Compiler::Compile(Job* job, Plan* plan, bool need_job_complete) const {
     if (task_node->IsMeaningLess()) { return; }
     task_node->ToProto(plan->mutable_task()->Add());
   });
+  EnableLossyWireCodecOfGradientRegsts(*job, plan);
   {
     auto* job_id2job_conf = plan->mutable_job_confs()->mutable_job_id2job_conf();
     (*job_id2job_conf)[GlobalJobDesc().job_id()] = GlobalJobDesc().job_conf();
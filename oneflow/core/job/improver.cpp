@@ -439,6 +439,9 @@ void GenMemBlockAndChunk4Plan(Plan* plan) {
       mem_block.set_machine_id(machine_id);
       *(mem_block.mutable_mem_case()) = regst_desc->mem_case();
       mem_block.set_enable_reuse_mem(regst_desc->enable_reuse_mem());
+      // memory reused by other regsts carries no meaningful content when a regst gets it, so its
+      // readers can never depend on it being zero
+      mem_block.set_need_zero_init(!regst_desc->enable_reuse_mem());
       mem_block.set_mem_size(regst_main_size + mem_block_offset);
       CHECK(mem_block_id2mem_block.emplace(mem_block.mem_block_id(), mem_block).second);
     } else {
@@ -475,6 +478,7 @@ void GenMemBlockAndChunk4Plan(Plan* plan) {
       chunk.set_machine_id(mem_block->machine_id());
       *(chunk.mutable_mem_case()) = mem_block->mem_case();
       chunk.set_mem_size(mem_block->mem_size());
+      chunk.set_need_zero_init(mem_block->need_zero_init());
       CHECK(mzuid2chunk.emplace(mzuid, chunk).second);
       mem_block->set_chunk_id(chunk.chunk_id());
       mem_block->set_chunk_offset(0);
@@ -484,6 +488,7 @@ void GenMemBlockAndChunk4Plan(Plan* plan) {
       mem_block->set_chunk_id(chunk->chunk_id());
       mem_block->set_chunk_offset(chunk->mem_size());
       chunk->set_mem_size(chunk->mem_size() + mem_block->mem_size());
+      chunk->set_need_zero_init(chunk->need_zero_init() || mem_block->need_zero_init());
     }
   };
 
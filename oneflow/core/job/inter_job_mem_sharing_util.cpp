@@ -201,6 +201,7 @@ void MergeReusedChunk(HashMap<int64_t, ChunkProto>* chunk_id2chunk,
     }
     chunk_l->add_job_id(chunk_r->job_id(0));
     chunk_l->set_mem_size(std::max(chunk_l->mem_size(), chunk_r->mem_size()));
+    chunk_l->set_need_zero_init(chunk_l->need_zero_init() || chunk_r->need_zero_init());
     chunk_id2chunk->erase(chunk_id2chunk->find(right_chunk_id));
   };
   auto InitMzuid2JobIdsInJobGroup =
@@ -251,6 +252,8 @@ void MergeSharedMemBlockR2L(RegstDescProto* lhs, RegstDescProto* rhs,
     CHECK_EQ(erased_block->job_id_size(), 1);
     CHECK_EQ(merged_block->mem_size(), erased_block->mem_size());
     merged_block->add_job_id(erased_block->job_id(0));
+    merged_block->set_need_zero_init(merged_block->need_zero_init()
+                                     || erased_block->need_zero_init());
     CHECK_EQ(mem_block_id2mem_block->erase(erased_block->mem_block_id()), 1);
   };
 
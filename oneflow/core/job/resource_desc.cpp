@@ -50,4 +50,36 @@ CollectiveBoxingConf ResourceDesc::collective_boxing_conf() const {
   }
 }
 
+HostMemoryPoolConf ResourceDesc::host_memory_pool_conf() const {
+  if (resource_.has_host_memory_pool_conf()) {
+    return resource_.host_memory_pool_conf();
+  } else {
+    return HostMemoryPoolConf();
+  }
+}
+
+RegstMemInitConf ResourceDesc::regst_mem_init_conf() const {
+  if (resource_.has_regst_mem_init_conf()) {
+    return resource_.regst_mem_init_conf();
+  } else {
+    return RegstMemInitConf();
+  }
+}
+
+ThreadPlacementConf ResourceDesc::thread_placement_conf() const {
+  if (resource_.has_thread_placement_conf()) {
+    return resource_.thread_placement_conf();
+  } else {
+    return ThreadPlacementConf();
+  }
+}
+
+EpollCommNetConf ResourceDesc::epoll_comm_net_conf() const {
+  if (resource_.has_epoll_comm_net_conf()) {
+    return resource_.epoll_comm_net_conf();
+  } else {
+    return EpollCommNetConf();
+  }
+}
+
 }  // namespace oneflow
@@ -53,6 +53,10 @@ class ResourceDesc final {
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
   CollectiveBoxingConf collective_boxing_conf() const;
+  HostMemoryPoolConf host_memory_pool_conf() const;
+  RegstMemInitConf regst_mem_init_conf() const;
+  ThreadPlacementConf thread_placement_conf() const;
+  EpollCommNetConf epoll_comm_net_conf() const;
 
   void SetMachineNum(int32_t val) { resource_.set_machine_num(val); }
   void SetCpuDeviceNum(int32_t val) { resource_.set_cpu_device_num(val); }
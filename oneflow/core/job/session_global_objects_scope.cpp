@@ -24,6 +24,7 @@ limitations under the License.
 #include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/job/profiler.h"
 #include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 #include "oneflow/core/common/buffer_manager.h"
 #include "oneflow/core/job/foreign_job_instance.h"
 #include "oneflow/core/job/inter_user_job_info.pb.h"
@@ -35,6 +36,9 @@ limitations under the License.
 #include "oneflow/core/framework/load_library.h"
 #include "oneflow/core/job/version.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/memory/host_memory_pool.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/thread/thread_placement.h"
 
 namespace oneflow {
 
@@ -65,6 +69,33 @@ AvailableMemDesc PullAvailableMemDesc() {
   return ret;
 }
 
+void LogAndReleaseHostMemoryPool() {
+  HostMemoryPool* pool = HostMemoryPool::Singleton();
+  const HostMemoryPoolStats stats = pool->GetStats();
+  LOG(INFO) << "host memory pool hit: " << stats.hit_cnt << " miss: " << stats.miss_cnt
+            << " cached_bytes: " << stats.cached_bytes << " in_use_bytes: " << stats.in_use_bytes
+            << " peak_in_use_bytes: " << stats.peak_in_use_bytes
+            << " arena_bytes: " << stats.arena_bytes;
+  pool->ReleaseCachedMemory();
+}
+
+// the compute thread pool outlives sessions, so it is pinned and unpinned by each of them
+void PlaceComputeThreadPool(bool unpin) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const ThreadPlacement placement(Global<ResourceDesc, ForSession>::Get()->thread_placement_conf());
+  if (thread_pool == nullptr || !placement.pin_thread_pool()) { return; }
+  FOR_RANGE(int32_t, i, 0, thread_pool->thread_num()) {
+    if (unpin) {
+      SetThreadCpuAffinity(thread_pool->worker_native_handle(i), ProcessUsableCpus());
+    } else {
+      const std::vector<int32_t> cpus = placement.Cpus4PoolWorkerId(i);
+      SetThreadCpuAffinity(thread_pool->worker_native_handle(i), cpus);
+      LOG(INFO) << "compute thread pool worker " << i << " pinned to cpus "
+                << CpuListToString(cpus) << " of numa node " << placement.NumaNode4ThreadIndex(i);
+    }
+  }
+}
+
 }  // namespace
 
 SessionGlobalObjectsScope::SessionGlobalObjectsScope() {}
@@ -74,8 +105,14 @@ Maybe<void> SessionGlobalObjectsScope::Init(const ConfigProto& config_proto) {
   Global<ResourceDesc, ForSession>::Delete();
   DumpVersionInfo();
   Global<ResourceDesc, ForSession>::New(config_proto.resource());
+  HostMemoryPool::Singleton()->Configure(
+      Global<ResourceDesc, ForSession>::Get()->host_memory_pool_conf());
+  PlaceComputeThreadPool(false);
   Global<const IOConf>::New(config_proto.io_conf());
   Global<const IOConf>::SessionNew(config_proto.session_id(), config_proto.io_conf());
+  if (config_proto.io_conf().enable_async_snapshot_writer()) {
+    Global<AsyncSnapshotWriter>::New(config_proto.io_conf().async_snapshot_writer_thread_num());
+  }
   Global<const ProfilerConf>::New(config_proto.profiler_conf());
   Global<IDMgr>::New();
   if (Global<MachineCtx>::Get()->IsThisMachineMaster()
@@ -109,7 +146,11 @@ SessionGlobalObjectsScope::~SessionGlobalObjectsScope() {
   }
   if (Global<Profiler>::Get() != nullptr) { Global<Profiler>::Delete(); }
   Global<IDMgr>::Delete();
+  LogAndReleaseHostMemoryPool();
+  PlaceComputeThreadPool(true);
   Global<const ProfilerConf>::Delete();
+  // waits for the snapshots being written, which need the IOConf
+  if (Global<AsyncSnapshotWriter>::Get() != nullptr) { Global<AsyncSnapshotWriter>::Delete(); }
   Global<const IOConf>::Delete();
   Global<const IOConf>::SessionDelete(session_id_);
   Global<ResourceDesc, ForSession>::Delete();
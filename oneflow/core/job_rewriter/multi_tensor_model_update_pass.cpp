@@ -0,0 +1,137 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// the inputs of every variable, and the op updating many variables at once
+struct MultiTensorUpdateOpDesc {
+  std::string multi_tensor_op_type_name;
+  std::vector<std::string> variable_arg_names;
+};
+
+const HashMap<std::string, MultiTensorUpdateOpDesc>& MultiTensorUpdateOpDescs() {
+  static const HashMap<std::string, MultiTensorUpdateOpDesc> op_type_name2desc = {
+      {"sgd_update", {"multi_tensor_sgd_update", {"model", "model_diff"}}},
+      {"momentum_update", {"multi_tensor_momentum_update", {"model", "model_diff", "momentum"}}},
+      {"adam_update", {"multi_tensor_adam_update", {"model", "model_diff", "m", "v"}}},
+  };
+  return op_type_name2desc;
+}
+
+// Groups the cpu sgd, momentum and adam updates of the same type, learning rate, attrs, data types
+// and placement, and replaces every group by one multi-tensor update, so that a model of many small
+// variables pays one actor act and one thread pool split per group rather than one per variable.
+// The gpu updates are left alone, there being no batched gpu kernel to launch once per group
+class MultiTensorModelUpdatePass final : public JobPass {
+ public:
+  MultiTensorModelUpdatePass() = default;
+  ~MultiTensorModelUpdatePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().job_conf().enable_multi_tensor_model_update();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> MultiTensorModelUpdatePass::Apply(const OpGraph& op_graph,
+                                              JobBuilder* job_builder) const {
+  HashSet<std::string> ctrl_in_op_names;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    for (const std::string& ctrl_in_op_name : op_node->op().op_conf().ctrl_in_op_name()) {
+      ctrl_in_op_names.insert(ctrl_in_op_name);
+    }
+  });
+  // ordered, so that every rank builds the same ops
+  std::map<std::string, std::vector<const OpNode*>> key2op_nodes;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    const OperatorConf& op_conf = op_node->op().op_conf();
+    if (!op_conf.has_user_conf()) { return; }
+    const auto desc_it = MultiTensorUpdateOpDescs().find(op_conf.user_conf().op_type_name());
+    if (desc_it == MultiTensorUpdateOpDescs().end()) { return; }
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    if (!op_conf.ctrl_in_op_name().empty()
+        || ctrl_in_op_names.find(op_conf.name()) != ctrl_in_op_names.end()) {
+      return;
+    }
+    // the multi-tensor updates have the broadcast signature only
+    if (op_node->parallel_desc().parallel_num() > 1) {
+      for (const std::string& ibn : op_node->op().input_bns()) {
+        if (!op_node->SbpParallel4BnInOp(ibn).has_broadcast_parallel()) { return; }
+      }
+    }
+    const user_op::UserOpConfWrapper user_op_conf(op_conf);
+    UserOpConf shared_conf = op_conf.user_conf();
+    for (const std::string& arg_name : desc_it->second.variable_arg_names) {
+      shared_conf.mutable_input()->erase(arg_name);
+    }
+    const DataType model_data_type =
+        op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(user_op_conf.input("model", 0))).data_type();
+    const DataType model_diff_data_type =
+        op_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(user_op_conf.input("model_diff", 0)))
+            .data_type();
+    const std::string key = PbMessage2TxtString(op_node->parallel_desc().parallel_conf())
+                            + PbMessage2TxtString(shared_conf) + std::to_string(model_data_type)
+                            + "," + std::to_string(model_diff_data_type);
+    key2op_nodes[key].push_back(op_node);
+  });
+
+  std::vector<OperatorConf> update_op_confs;
+  std::vector<std::pair<ParallelConf, OperatorConf>> multi_tensor_op_confs;
+  for (const auto& pair : key2op_nodes) {
+    const std::vector<const OpNode*>& op_nodes = pair.second;
+    if (op_nodes.size() < 2) { continue; }
+    const OperatorConf& first_op_conf = op_nodes.front()->op().op_conf();
+    const MultiTensorUpdateOpDesc& desc =
+        MultiTensorUpdateOpDescs().at(first_op_conf.user_conf().op_type_name());
+    OperatorConf multi_tensor_op_conf = first_op_conf;
+    multi_tensor_op_conf.set_name("System-MultiTensorModelUpdate-" + NewUniqueId());
+    UserOpConf* user_conf = multi_tensor_op_conf.mutable_user_conf();
+    user_conf->set_op_type_name(desc.multi_tensor_op_type_name);
+    for (const std::string& arg_name : desc.variable_arg_names) {
+      user_conf->mutable_input()->erase(arg_name);
+    }
+    for (const OpNode* op_node : op_nodes) {
+      const user_op::UserOpConfWrapper user_op_conf(op_node->op().op_conf());
+      for (const std::string& arg_name : desc.variable_arg_names) {
+        (*user_conf->mutable_input())[arg_name].add_s(user_op_conf.input(arg_name, 0));
+      }
+      update_op_confs.push_back(op_node->op().op_conf());
+    }
+    multi_tensor_op_confs.emplace_back(op_nodes.front()->parallel_desc().parallel_conf(),
+                                       multi_tensor_op_conf);
+  }
+  if (update_op_confs.empty()) { return Maybe<void>::Ok(); }
+  job_builder->DelOps(update_op_confs);
+  for (const auto& pair : multi_tensor_op_confs) { job_builder->AddOps(pair.first, {pair.second}); }
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("MultiTensorModelUpdatePass", MultiTensorModelUpdatePass);
+
+}  // namespace oneflow
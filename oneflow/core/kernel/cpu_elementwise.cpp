@@ -0,0 +1,54 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_elementwise.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+constexpr int64_t kCpuElementwiseGrainSize = 32 * 1024;
+
+}  // namespace
+
+namespace cpu_elementwise_internal {
+
+CpuIsa GetCpuIsa() {
+#ifdef OF_CPU_ELEMENTWISE_MULTI_ISA
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+      && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")) {
+    return CpuIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return CpuIsa::kAvx2; }
+#endif
+  return CpuIsa::kBaseline;
+}
+
+}  // namespace cpu_elementwise_internal
+
+void CpuElementwiseParallelFor(int64_t n,
+                               const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  if (n <= 0) { return; }
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  if (thread_pool == nullptr || n <= kCpuElementwiseGrainSize) {
+    Handler(0, n);
+  } else {
+    thread_pool->ParallelFor(0, n, kCpuElementwiseGrainSize, Handler);
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,114 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
+#define ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace cpu_elementwise_internal {
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define OF_CPU_ELEMENTWISE_MULTI_ISA
+#endif
+
+// the widest instruction set the loops are compiled for that the cpu supports
+enum class CpuIsa { kBaseline, kAvx2, kAvx512 };
+
+CpuIsa GetCpuIsa();
+
+// f(i) for i in [begin, end). Every instruction set gets its own copy of the loop, into which f is
+// inlined and vectorized by the compiler. f is copied in, so that its state is known to be local
+#define OF_CPU_ELEMENTWISE_DEFINE_LOOP(func_name, target_attr)  \
+  template<typename F>                                          \
+  target_attr void func_name(int64_t begin, int64_t end, F f) { \
+    for (int64_t i = begin; i < end; ++i) { f(i); }             \
+  }
+
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(BaselineLoop, )
+#ifdef OF_CPU_ELEMENTWISE_MULTI_ISA
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(Avx2Loop, __attribute__((target("avx2,fma"))))
+OF_CPU_ELEMENTWISE_DEFINE_LOOP(Avx512Loop,
+                               __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl"))))
+#endif
+
+#undef OF_CPU_ELEMENTWISE_DEFINE_LOOP
+
+template<typename F>
+void Loop(int64_t begin, int64_t end, const F& f) {
+#ifdef OF_CPU_ELEMENTWISE_MULTI_ISA
+  static const CpuIsa isa = GetCpuIsa();
+  if (isa == CpuIsa::kAvx512) {
+    Avx512Loop(begin, end, f);
+  } else if (isa == CpuIsa::kAvx2) {
+    Avx2Loop(begin, end, f);
+  } else {
+    BaselineLoop(begin, end, f);
+  }
+#else
+  BaselineLoop(begin, end, f);
+#endif
+}
+
+template<typename F, typename T, typename... In>
+void Loop(int64_t begin, int64_t end, const F& f, T* y, const In*... in) {
+  Loop(begin, end, [&](int64_t i) { y[i] = f(in[i]...); });
+}
+
+}  // namespace cpu_elementwise_internal
+
+// Calls Handler on chunks of [0, n) of at least 32K elements, which run on the compute thread
+// pool if there is more than one chunk, and on the calling thread otherwise
+void CpuElementwiseParallelFor(int64_t n,
+                               const std::function<void(int64_t begin, int64_t end)>& Handler);
+
+// Applies f elementwise, y[i] = f(in[i]...) for i in [0, n). The loop is vectorized for the widest
+// of avx512, avx2 and the baseline instruction set the cpu supports, and large n is split across
+// the compute thread pool. y may be one of in.
+template<typename F, typename T, typename... In>
+void CpuElementwiseApply(int64_t n, const F& f, T* y, const In*... in) {
+  CpuElementwiseParallelFor(n, [&](int64_t begin, int64_t end) {
+    cpu_elementwise_internal::Loop(begin, end, f, y, in...);
+  });
+}
+
+// y[i] = f(in[i]...) for i in [begin, end) on the calling thread, for callers splitting the work
+// themselves
+template<typename F, typename T, typename... In>
+void CpuElementwiseApplyRange(int64_t begin, int64_t end, const F& f, T* y, const In*... in) {
+  cpu_elementwise_internal::Loop(begin, end, f, y, in...);
+}
+
+// Calls f(i) for i in [0, n), split and vectorized like CpuElementwiseApply, for updates writing
+// more than one output, e.g. f(i) { m[i] = ...; v[i] = ...; }. A lambda f should capture by value,
+// or the compiler cannot tell the captured scalars from the outputs and does not vectorize the loop
+template<typename F>
+void CpuElementwiseForEach(int64_t n, const F& f) {
+  CpuElementwiseParallelFor(n, [&](int64_t begin, int64_t end) {
+    cpu_elementwise_internal::Loop(begin, end, f);
+  });
+}
+
+// f(i) for i in [begin, end) on the calling thread
+template<typename F>
+void CpuElementwiseForEachRange(int64_t begin, int64_t end, const F& f) {
+  cpu_elementwise_internal::Loop(begin, end, f);
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_ELEMENTWISE_H_
@@ -0,0 +1,134 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_VECTORIZABLE_MATH_H_
+#define ONEFLOW_CORE_KERNEL_CPU_VECTORIZABLE_MATH_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Math functions without branches or library calls, so that the compiler vectorizes the loops
+// calling them, which it does not do for the std ones unless math errno and exact IEEE semantics
+// are given up for the whole build.
+
+namespace vectorizable_math_internal {
+
+// The keys order floating point numbers like the integers, so that they are clamped by integer
+// min and max. Float compares may trap, and the compiler turns their branches into vector selects
+// only if the arms are cheap, which they are not once the clamped value is propagated into them.
+inline int32_t OrderKey(int32_t bits) { return bits ^ ((bits >> 31) & 0x7fffffff); }
+inline int64_t OrderKey(int64_t bits) { return bits ^ ((bits >> 63) & 0x7fffffffffffffffLL); }
+
+template<typename T, typename I>
+T ClampByOrderKey(I bits, I min_key, I max_key) {
+  const I clamped_bits = OrderKey(std::min(std::max(OrderKey(bits), min_key), max_key));
+  T clamped;
+  std::memcpy(&clamped, &clamped_bits, sizeof(T));
+  return clamped;
+}
+
+}  // namespace vectorizable_math_internal
+
+// exp(x) after Cephes: x = n * ln2 + r with |r| <= ln2 / 2, exp(r) from a polynomial (a rational
+// function for double) and 2^n put into the exponent bits. Results of 2^-125 and above are within
+// 1 ulp for float, those of 2^-1021 and above within 2 ulp for double. x is clamped and the biased
+// exponent saturated, so results below about 2^-125.5 (2^-1021.5 for double) are flushed to 0 and
+// those above the max become inf. nan stays nan and exp(-0) is 1.
+inline float VectorizableExp(float x) {
+  using namespace vectorizable_math_internal;
+  constexpr int32_t kMinKey = -1118896129;  // OrderKey of -88.5f
+  constexpr int32_t kMaxKey = 1118961664;   // OrderKey of 89.0f
+  constexpr float kLog2e = 1.44269504088896341f;
+  constexpr float kLn2Hi = 0.693359375f;
+  constexpr float kLn2Lo = -2.12194440e-4f;
+  // adding 1.5 * 2^23 rounds to an integer, which is then in the low bits of the mantissa
+  constexpr float kRoundMagic = 12582912.0f;
+  int32_t x_bits;
+  std::memcpy(&x_bits, &x, sizeof(float));
+  const float clamped = ClampByOrderKey<float>(x_bits, kMinKey, kMaxKey);
+  const float rounded = clamped * kLog2e + kRoundMagic;
+  const float n = rounded - kRoundMagic;
+  const float r = clamped - n * kLn2Hi - n * kLn2Lo;
+  float p = 1.9875691500e-4f;
+  p = p * r + 1.3981999507e-3f;
+  p = p * r + 8.3334519073e-3f;
+  p = p * r + 4.1665795894e-2f;
+  p = p * r + 1.6666665459e-1f;
+  p = p * r + 5.0000001201e-1f;
+  p = p * r * r + r + 1.0f;
+  // 2^(n - 1) * 2, as 2^128 has no exponent bits. The biased exponent 0 gives 0 and 255 gives inf
+  int32_t rounded_bits;
+  int32_t magic_bits;
+  std::memcpy(&rounded_bits, &rounded, sizeof(float));
+  std::memcpy(&magic_bits, &kRoundMagic, sizeof(float));
+  const int32_t biased = std::min(std::max(rounded_bits - magic_bits + 126, 0), 255);
+  const int32_t scale_bits = biased << 23;
+  float scale;
+  std::memcpy(&scale, &scale_bits, sizeof(float));
+  const float y = p * scale * 2.0f;
+  // all bits set, a nan, if x is nan
+  int32_t y_bits;
+  std::memcpy(&y_bits, &y, sizeof(float));
+  y_bits |= -static_cast<int32_t>((x_bits & 0x7fffffff) > 0x7f800000);
+  float ret;
+  std::memcpy(&ret, &y_bits, sizeof(float));
+  return ret;
+}
+
+inline double VectorizableExp(double x) {
+  using namespace vectorizable_math_internal;
+  constexpr int64_t kMinKey = -4649452043818237953LL;  // OrderKey of -709.5
+  constexpr int64_t kMaxKey = 4649456441864749056LL;   // OrderKey of 710.0
+  constexpr double kLog2e = 1.4426950408889634;
+  constexpr double kLn2Hi = 6.93145751953125e-1;
+  constexpr double kLn2Lo = 1.42860682030941723212e-6;
+  constexpr double kRoundMagic = 6755399441055744.0;  // 1.5 * 2^52
+  int64_t x_bits;
+  std::memcpy(&x_bits, &x, sizeof(double));
+  const double clamped = ClampByOrderKey<double>(x_bits, kMinKey, kMaxKey);
+  const double rounded = clamped * kLog2e + kRoundMagic;
+  const double n = rounded - kRoundMagic;
+  const double r = clamped - n * kLn2Hi - n * kLn2Lo;
+  const double rr = r * r;
+  const double px = r
+                    * ((1.26177193074810590878e-4 * rr + 3.02994407707441961300e-2) * rr
+                       + 9.99999999999999999910e-1);
+  const double qx = ((3.00198505138664455042e-6 * rr + 2.52448340349684104192e-3) * rr
+                     + 2.27265548208155028766e-1)
+                        * rr
+                    + 2.00000000000000000009e0;
+  const double p = 1.0 + 2.0 * px / (qx - px);
+  int64_t rounded_bits;
+  int64_t magic_bits;
+  std::memcpy(&rounded_bits, &rounded, sizeof(double));
+  std::memcpy(&magic_bits, &kRoundMagic, sizeof(double));
+  const int64_t biased =
+      std::min<int64_t>(std::max<int64_t>(rounded_bits - magic_bits + 1022, 0), 2047);
+  const int64_t scale_bits = biased << 52;
+  double scale;
+  std::memcpy(&scale, &scale_bits, sizeof(double));
+  const double y = p * scale * 2.0;
+  int64_t y_bits;
+  std::memcpy(&y_bits, &y, sizeof(double));
+  y_bits |= -static_cast<int64_t>((x_bits & 0x7fffffffffffffffLL) > 0x7ff0000000000000LL);
+  double ret;
+  std::memcpy(&ret, &y_bits, sizeof(double));
+  return ret;
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_VECTORIZABLE_MATH_H_
@@ -0,0 +1,106 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include <random>
+#include "oneflow/core/kernel/cpu_vectorizable_math.h"
+
+namespace oneflow {
+
+namespace {
+
+// the error of y in ulps of the float or double nearest to ref
+template<typename T>
+double UlpError(T y, long double ref) {
+  const int exponent =
+      std::max(std::ilogb(static_cast<T>(ref)), std::numeric_limits<T>::min_exponent - 1);
+  return static_cast<double>(std::fabs(static_cast<long double>(y) - ref)
+                             / std::ldexp(1.0L, exponent - std::numeric_limits<T>::digits + 1));
+}
+
+}  // namespace
+
+TEST(VectorizableExp, float_ulp_error) {
+  const double min_accurate = std::ldexp(1.0, -125);
+  double max_error = 0;
+  double max_error_below_min_accurate = 0;
+  // every 61st float, the nans and infs skipped
+  for (uint64_t bits = 0; bits <= 0xffffffffULL; bits += 61) {
+    const uint32_t x_bits = static_cast<uint32_t>(bits);
+    float x;
+    std::memcpy(&x, &x_bits, sizeof(float));
+    if (!std::isfinite(x)) { continue; }
+    const double ref = std::exp(static_cast<double>(x));
+    const float y = VectorizableExp(x);
+    if (ref > std::numeric_limits<float>::max()) {
+      ASSERT_EQ(y, std::numeric_limits<float>::infinity()) << "x: " << x;
+    } else if (ref >= min_accurate) {
+      max_error = std::max(max_error, UlpError(y, ref));
+      ASSERT_LE(max_error, 1.0) << "x: " << x;
+    } else if (y != 0) {
+      max_error_below_min_accurate = std::max(max_error_below_min_accurate, UlpError(y, ref));
+      ASSERT_LE(max_error_below_min_accurate, 1.5) << "x: " << x;
+    }
+  }
+}
+
+TEST(VectorizableExp, double_ulp_error) {
+  const long double min_accurate = std::ldexp(1.0L, -1021);
+  std::mt19937_64 gen(0);
+  for (double bound : {1.0, 50.0, 709.7}) {
+    std::uniform_real_distribution<double> dis(-bound, bound);
+    FOR_RANGE(int64_t, i, 0, 1000000) {
+      const double x = dis(gen);
+      const long double ref = std::exp(static_cast<long double>(x));
+      if (ref < min_accurate) { continue; }
+      ASSERT_LE(UlpError(VectorizableExp(x), ref), 2.0) << "x: " << x;
+    }
+  }
+}
+
+TEST(VectorizableExp, float_edges) {
+  const float inf = std::numeric_limits<float>::infinity();
+  // flushed to 0 below about 2^-125.5, not below the normal min yet
+  ASSERT_GT(VectorizableExp(-86.9f), 0.0f);
+  ASSERT_EQ(VectorizableExp(-87.0f), 0.0f);
+  ASSERT_EQ(VectorizableExp(-88.0f), 0.0f);
+  ASSERT_EQ(VectorizableExp(-100.0f), 0.0f);
+  ASSERT_EQ(VectorizableExp(-inf), 0.0f);
+  ASSERT_EQ(VectorizableExp(-std::numeric_limits<float>::max()), 0.0f);
+  ASSERT_LT(VectorizableExp(88.7f), inf);
+  ASSERT_EQ(VectorizableExp(88.73f), inf);
+  ASSERT_EQ(VectorizableExp(1000.0f), inf);
+  ASSERT_EQ(VectorizableExp(inf), inf);
+  ASSERT_EQ(VectorizableExp(std::numeric_limits<float>::max()), inf);
+  ASSERT_TRUE(std::isnan(VectorizableExp(std::numeric_limits<float>::quiet_NaN())));
+  ASSERT_TRUE(std::isnan(VectorizableExp(-std::numeric_limits<float>::quiet_NaN())));
+  ASSERT_EQ(VectorizableExp(0.0f), 1.0f);
+  ASSERT_EQ(VectorizableExp(-0.0f), 1.0f);
+}
+
+TEST(VectorizableExp, double_edges) {
+  const double inf = std::numeric_limits<double>::infinity();
+  ASSERT_EQ(VectorizableExp(-709.0), 0.0);
+  ASSERT_EQ(VectorizableExp(-1000.0), 0.0);
+  ASSERT_EQ(VectorizableExp(-inf), 0.0);
+  ASSERT_LT(VectorizableExp(709.7), inf);
+  ASSERT_EQ(VectorizableExp(709.8), inf);
+  ASSERT_EQ(VectorizableExp(inf), inf);
+  ASSERT_TRUE(std::isnan(VectorizableExp(std::numeric_limits<double>::quiet_NaN())));
+  ASSERT_EQ(VectorizableExp(0.0), 1.0);
+  ASSERT_EQ(VectorizableExp(-0.0), 1.0);
+}
+
+}  // namespace oneflow
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/common/channel.h"
 #include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include "oneflow/user/image/random_crop_generator.h"
 #include <opencv2/opencv.hpp>
 
@@ -92,6 +93,9 @@ class CpuDecodeHandle final : public DecodeHandle {
   void Synchronize() override {
     // do nothing
   }
+
+ private:
+  std::vector<unsigned char> roi_image_;
 };
 
 void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t length,
@@ -99,20 +103,40 @@ void CpuDecodeHandle::DecodeRandomCropResize(const unsigned char* data, size_t l
                                              unsigned char* workspace, size_t workspace_size,
                                              unsigned char* dst, int target_width,
                                              int target_height) {
+  cv::Mat dst_mat(target_height, target_width, CV_8UC3, dst, cv::Mat::AUTO_STEP);
+  int width = 0;
+  int height = 0;
+  cv::Rect roi;
+  const bool is_jpeg = JpegGetImageSize(data, length, &width, &height);
+  if (is_jpeg) {
+    // decode only the crop window of a JPEG image, downscaled towards the target size
+    if (crop_generator) {
+      GenerateRandomCropRoi(crop_generator, width, height, &roi.x, &roi.y, &roi.width,
+                            &roi.height);
+    } else {
+      roi = cv::Rect(0, 0, width, height);
+    }
+    if (JpegDecodeRoi(data, length, "RGB", roi.x, roi.y, roi.width, roi.height, target_width,
+                      target_height, &roi_image_, &width, &height)) {
+      cv::Mat roi_mat(height, width, CV_8UC3, roi_image_.data(), cv::Mat::AUTO_STEP);
+      cv::resize(roi_mat, dst_mat, cv::Size(target_width, target_height), 0, 0, cv::INTER_LINEAR);
+      return;
+    }
+  }
   cv::Mat image =
       cv::imdecode(cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)), cv::IMREAD_COLOR);
   cv::Mat cropped;
   if (crop_generator) {
-    cv::Rect roi;
-    GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
-                          &roi.height);
+    if (!is_jpeg) {
+      GenerateRandomCropRoi(crop_generator, image.cols, image.rows, &roi.x, &roi.y, &roi.width,
+                            &roi.height);
+    }
     image(roi).copyTo(cropped);
   } else {
     cropped = image;
   }
   cv::Mat resized;
   cv::resize(cropped, resized, cv::Size(target_width, target_height), 0, 0, cv::INTER_LINEAR);
-  cv::Mat dst_mat(target_height, target_width, CV_8UC3, dst, cv::Mat::AUTO_STEP);
   cv::cvtColor(resized, dst_mat, cv::COLOR_BGR2RGB);
 }
 
@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 
 namespace oneflow {
 
@@ -37,7 +38,7 @@ void ModelSaveKernel::ForwardDataContent(
   const ModelSaveOpConf& conf = this->op_conf().model_save_conf();
   const Blob* path_blob = BnInOp2Blob("path");
   const std::string path(path_blob->dptr<char>(), path_blob->shape_view().elem_cnt());
-  SnapshotWriter writer(path);
+  SnapshotWriter writer(path, Global<AsyncSnapshotWriter>::Get() != nullptr);
   FOR_RANGE(int64_t, i, 0, conf.in_size()) {
     const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
     writer.Write(conf.key(i), in_i);
@@ -0,0 +1,278 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/memory/host_memory_pool.h"
+#include <sys/mman.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int32_t kDirectSizeClass = -1;
+constexpr size_t kMinSizeClassShift = 6;
+constexpr size_t kArenaChunkSize = 256 << 20;
+constexpr size_t kHugePageSize = 2 << 20;
+
+struct BlockHeader {
+  int32_t size_class;
+  bool from_arena;
+  size_t size;
+};
+static_assert(sizeof(BlockHeader) <= HostMemoryPool::kAlignSize, "");
+
+BlockHeader* Header4Block(void* block) {
+  return reinterpret_cast<BlockHeader*>(static_cast<char*>(block) - HostMemoryPool::kAlignSize);
+}
+
+// stays valid after the thread cache is destroyed at thread exit
+thread_local bool tls_thread_cache_destroyed = false;
+
+}  // namespace
+
+class HostMemoryPoolThreadCache final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HostMemoryPoolThreadCache);
+  explicit HostMemoryPoolThreadCache(HostMemoryPool* pool)
+      : pool_(pool), cached_bytes_(0), free_lists_(HostMemoryPool::kSizeClassNum) {}
+  ~HostMemoryPoolThreadCache() {
+    Flush();
+    tls_thread_cache_destroyed = true;
+  }
+
+  void* Pop(int32_t size_class) {
+    std::vector<void*>* free_list = &free_lists_.at(size_class);
+    if (free_list->empty()) { return nullptr; }
+    void* block = free_list->back();
+    free_list->pop_back();
+    cached_bytes_ -= HostMemoryPool::Size4SizeClass(size_class);
+    return block;
+  }
+
+  bool TryPush(int32_t size_class, void* block) {
+    const int64_t size = HostMemoryPool::Size4SizeClass(size_class);
+    if (cached_bytes_ + size > pool_->thread_cache_bytes_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    free_lists_.at(size_class).push_back(block);
+    cached_bytes_ += size;
+    return true;
+  }
+
+  void Flush() {
+    FOR_RANGE(int32_t, size_class, 0, HostMemoryPool::kSizeClassNum) {
+      for (void* block : free_lists_.at(size_class)) { pool_->PushCentral(size_class, block); }
+      free_lists_.at(size_class).clear();
+    }
+    cached_bytes_ = 0;
+  }
+
+ private:
+  HostMemoryPool* pool_;
+  int64_t cached_bytes_;
+  std::vector<std::vector<void*>> free_lists_;
+};
+
+namespace {
+
+HostMemoryPoolThreadCache* ThreadCache4Pool(HostMemoryPool* pool) {
+  if (tls_thread_cache_destroyed) { return nullptr; }
+  static thread_local HostMemoryPoolThreadCache thread_cache(pool);
+  return &thread_cache;
+}
+
+}  // namespace
+
+HostMemoryPool* HostMemoryPool::Singleton() {
+  static HostMemoryPool* pool = new HostMemoryPool();
+  return pool;
+}
+
+HostMemoryPool::HostMemoryPool()
+    : central_free_lists_(kSizeClassNum),
+      arena_cur_(nullptr),
+      arena_end_(nullptr),
+      hit_cnt_(0),
+      miss_cnt_(0),
+      cached_bytes_(0),
+      in_use_bytes_(0),
+      peak_in_use_bytes_(0),
+      arena_bytes_(0) {
+  Configure(HostMemoryPoolConf());
+}
+
+void HostMemoryPool::Configure(const HostMemoryPoolConf& conf) {
+  enable_.store(conf.enable());
+  max_cached_bytes_.store(conf.max_cached_mbyte() << 20);
+  thread_cache_bytes_.store(conf.thread_cache_mbyte() << 20);
+  use_huge_page_arena_.store(conf.use_huge_page_arena());
+}
+
+// size classes are 64 bytes and then 4 classes per power of two: 80, 96, 112, 128, 160, ...
+size_t HostMemoryPool::SizeClass4Size(size_t size) {
+  if (size <= (1 << kMinSizeClassShift)) { return 0; }
+  size_t shift = 0;
+  while ((size - 1) >> (shift + 1)) { ++shift; }
+  const size_t step = 1 << (shift - 2);
+  return (shift - kMinSizeClassShift) * 4 + (size + step - 1) / step - 4;
+}
+
+size_t HostMemoryPool::Size4SizeClass(size_t size_class) {
+  if (size_class == 0) { return 1 << kMinSizeClassShift; }
+  const size_t shift = kMinSizeClassShift + (size_class - 1) / 4;
+  return (5 + (size_class - 1) % 4) << (shift - 2);
+}
+
+void* HostMemoryPool::Allocate(size_t size) {
+  const size_t max_class_size = Size4SizeClass(kSizeClassNum - 1);
+  if (!enable_.load(std::memory_order_relaxed) || size > max_class_size) {
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    UpdatePeakInUseBytes(in_use_bytes_.fetch_add(size) + size);
+    return AllocateBlock(kDirectSizeClass, size);
+  }
+  const int32_t size_class = SizeClass4Size(size);
+  const int64_t class_size = Size4SizeClass(size_class);
+  void* block = nullptr;
+  HostMemoryPoolThreadCache* thread_cache = ThreadCache4Pool(this);
+  if (thread_cache != nullptr) { block = thread_cache->Pop(size_class); }
+  if (block == nullptr) { block = PopCentral(size_class); }
+  if (block != nullptr) {
+    hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+    cached_bytes_.fetch_sub(class_size, std::memory_order_relaxed);
+  } else {
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    block = AllocateBlock(size_class, class_size);
+  }
+  UpdatePeakInUseBytes(in_use_bytes_.fetch_add(class_size) + class_size);
+  return block;
+}
+
+void HostMemoryPool::Deallocate(void* ptr) {
+  if (ptr == nullptr) { return; }
+  BlockHeader* header = Header4Block(ptr);
+  in_use_bytes_.fetch_sub(header->size);
+  if (header->size_class == kDirectSizeClass) {
+    FreeBlock(ptr);
+    return;
+  }
+  cached_bytes_.fetch_add(header->size, std::memory_order_relaxed);
+  HostMemoryPoolThreadCache* thread_cache = ThreadCache4Pool(this);
+  if (thread_cache != nullptr && thread_cache->TryPush(header->size_class, ptr)) { return; }
+  PushCentral(header->size_class, ptr);
+}
+
+void HostMemoryPool::ReleaseCachedMemory() {
+  HostMemoryPoolThreadCache* thread_cache = ThreadCache4Pool(this);
+  if (thread_cache != nullptr) { thread_cache->Flush(); }
+  for (CentralFreeList& free_list : central_free_lists_) {
+    std::unique_lock<std::mutex> lock(free_list.mutex);
+    auto it = std::partition(free_list.blocks.begin(), free_list.blocks.end(),
+                             [](void* block) { return Header4Block(block)->from_arena; });
+    for (auto free_it = it; free_it != free_list.blocks.end(); ++free_it) {
+      cached_bytes_.fetch_sub(Header4Block(*free_it)->size, std::memory_order_relaxed);
+      FreeBlock(*free_it);
+    }
+    free_list.blocks.erase(it, free_list.blocks.end());
+  }
+}
+
+HostMemoryPoolStats HostMemoryPool::GetStats() const {
+  HostMemoryPoolStats stats;
+  stats.hit_cnt = hit_cnt_.load();
+  stats.miss_cnt = miss_cnt_.load();
+  stats.cached_bytes = cached_bytes_.load();
+  stats.in_use_bytes = in_use_bytes_.load();
+  stats.peak_in_use_bytes = peak_in_use_bytes_.load();
+  stats.arena_bytes = arena_bytes_.load();
+  return stats;
+}
+
+void* HostMemoryPool::AllocateBlock(int32_t size_class, size_t size) {
+  char* base = nullptr;
+  const bool from_arena =
+      size_class != kDirectSizeClass && use_huge_page_arena_.load(std::memory_order_relaxed);
+  if (from_arena) {
+    base = static_cast<char*>(AllocateFromArena(kAlignSize + size));
+  } else {
+    void* mem = nullptr;
+    CHECK_EQ(posix_memalign(&mem, kAlignSize, kAlignSize + size), 0);
+    base = static_cast<char*>(mem);
+  }
+  BlockHeader* header = reinterpret_cast<BlockHeader*>(base);
+  header->size_class = size_class;
+  header->from_arena = from_arena;
+  header->size = size;
+  return base + kAlignSize;
+}
+
+void* HostMemoryPool::AllocateFromArena(size_t size) {
+  size = RoundUp(size, kAlignSize);
+  std::unique_lock<std::mutex> lock(arena_mutex_);
+  if (arena_cur_ + size > arena_end_) {
+    // the tail of the previous chunk is wasted, chunks are much larger than any size class
+    const size_t chunk_size = std::max(kArenaChunkSize, RoundUp(size, kHugePageSize));
+    void* mem = mmap(nullptr, chunk_size + kHugePageSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    PCHECK(mem != MAP_FAILED);
+    char* chunk = reinterpret_cast<char*>(RoundUp(reinterpret_cast<size_t>(mem), kHugePageSize));
+#ifdef MADV_HUGEPAGE
+    // best effort, transparent huge pages may be disabled on this host
+    madvise(chunk, chunk_size, MADV_HUGEPAGE);
+#endif
+    arena_cur_ = chunk;
+    arena_end_ = chunk + chunk_size;
+    arena_bytes_.fetch_add(chunk_size);
+  }
+  char* ptr = arena_cur_;
+  arena_cur_ += size;
+  return ptr;
+}
+
+void HostMemoryPool::FreeBlock(void* block) {
+  BlockHeader* header = Header4Block(block);
+  CHECK(!header->from_arena);
+  free(header);
+}
+
+void* HostMemoryPool::PopCentral(int32_t size_class) {
+  CentralFreeList* free_list = &central_free_lists_.at(size_class);
+  std::unique_lock<std::mutex> lock(free_list->mutex);
+  if (free_list->blocks.empty()) { return nullptr; }
+  void* block = free_list->blocks.back();
+  free_list->blocks.pop_back();
+  return block;
+}
+
+void HostMemoryPool::PushCentral(int32_t size_class, void* block) {
+  BlockHeader* header = Header4Block(block);
+  if (!header->from_arena
+      && cached_bytes_.load(std::memory_order_relaxed)
+             > max_cached_bytes_.load(std::memory_order_relaxed)) {
+    cached_bytes_.fetch_sub(header->size, std::memory_order_relaxed);
+    FreeBlock(block);
+    return;
+  }
+  CentralFreeList* free_list = &central_free_lists_.at(size_class);
+  std::unique_lock<std::mutex> lock(free_list->mutex);
+  free_list->blocks.push_back(block);
+}
+
+void HostMemoryPool::UpdatePeakInUseBytes(int64_t in_use_bytes) {
+  int64_t peak = peak_in_use_bytes_.load(std::memory_order_relaxed);
+  while (in_use_bytes > peak
+         && !peak_in_use_bytes_.compare_exchange_weak(peak, in_use_bytes,
+                                                      std::memory_order_relaxed)) {}
+}
+
+}  // namespace oneflow
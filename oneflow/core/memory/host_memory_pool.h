@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_MEMORY_HOST_MEMORY_POOL_H_
+#define ONEFLOW_CORE_MEMORY_HOST_MEMORY_POOL_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/resource.pb.h"
+
+namespace oneflow {
+
+struct HostMemoryPoolStats {
+  int64_t hit_cnt;
+  int64_t miss_cnt;
+  int64_t cached_bytes;
+  int64_t in_use_bytes;
+  int64_t peak_in_use_bytes;
+  int64_t arena_bytes;
+};
+
+// A size-classed pool of unpinned host memory. Freed blocks are kept in a lock-free per-thread
+// cache first and in a per-size-class central cache next, so that the steady-state allocations of
+// the data pipeline never reach malloc. Every block carries a small header recording its size
+// class, so Deallocate needs no size. Blocks larger than the biggest size class bypass the pool.
+class HostMemoryPool final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HostMemoryPool);
+  ~HostMemoryPool() = delete;
+
+  // the pool is process-wide and never destroyed, blocks may outlive any session
+  static HostMemoryPool* Singleton();
+
+  void Configure(const HostMemoryPoolConf& conf);
+  void* Allocate(size_t size);
+  void Deallocate(void* ptr);
+  // returns the free blocks of the central cache and of the calling thread to the system
+  void ReleaseCachedMemory();
+  HostMemoryPoolStats GetStats() const;
+
+  static constexpr size_t kAlignSize = 64;
+  static constexpr int32_t kSizeClassNum = 81;
+  static size_t SizeClass4Size(size_t size);
+  static size_t Size4SizeClass(size_t size_class);
+
+ private:
+  friend class HostMemoryPoolThreadCache;
+  struct CentralFreeList {
+    std::mutex mutex;
+    std::vector<void*> blocks;
+  };
+
+  HostMemoryPool();
+  void* AllocateBlock(int32_t size_class, size_t size);
+  void* AllocateFromArena(size_t size);
+  void FreeBlock(void* block);
+  void* PopCentral(int32_t size_class);
+  void PushCentral(int32_t size_class, void* block);
+  void UpdatePeakInUseBytes(int64_t in_use_bytes);
+
+  std::atomic<bool> enable_;
+  std::atomic<int64_t> max_cached_bytes_;
+  std::atomic<int64_t> thread_cache_bytes_;
+  std::atomic<bool> use_huge_page_arena_;
+
+  std::vector<CentralFreeList> central_free_lists_;
+
+  std::mutex arena_mutex_;
+  char* arena_cur_;
+  char* arena_end_;
+
+  std::atomic<int64_t> hit_cnt_;
+  std::atomic<int64_t> miss_cnt_;
+  std::atomic<int64_t> cached_bytes_;
+  std::atomic<int64_t> in_use_bytes_;
+  std::atomic<int64_t> peak_in_use_bytes_;
+  std::atomic<int64_t> arena_bytes_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_MEMORY_HOST_MEMORY_POOL_H_
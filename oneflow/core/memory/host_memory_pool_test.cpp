@@ -0,0 +1,64 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/memory/host_memory_pool.h"
+
+namespace oneflow {
+
+TEST(HostMemoryPool, size_class) {
+  size_t last_size = 0;
+  FOR_RANGE(int32_t, size_class, 0, HostMemoryPool::kSizeClassNum) {
+    const size_t size = HostMemoryPool::Size4SizeClass(size_class);
+    ASSERT_GT(size, last_size);
+    ASSERT_EQ(HostMemoryPool::SizeClass4Size(size), size_class);
+    ASSERT_EQ(HostMemoryPool::SizeClass4Size(last_size + 1), size_class);
+    last_size = size;
+  }
+}
+
+TEST(HostMemoryPool, reuse_freed_block) {
+  HostMemoryPool* pool = HostMemoryPool::Singleton();
+  pool->Configure(HostMemoryPoolConf());
+  void* ptr = pool->Allocate(1000);
+  ASSERT_EQ(reinterpret_cast<size_t>(ptr) % HostMemoryPool::kAlignSize, 0);
+  memset(ptr, 1, 1000);
+  const HostMemoryPoolStats before = pool->GetStats();
+  pool->Deallocate(ptr);
+  void* reused = pool->Allocate(900);
+  const HostMemoryPoolStats after = pool->GetStats();
+  ASSERT_EQ(reused, ptr);
+  ASSERT_EQ(after.hit_cnt, before.hit_cnt + 1);
+  ASSERT_EQ(after.miss_cnt, before.miss_cnt);
+  ASSERT_GE(after.peak_in_use_bytes, after.in_use_bytes);
+  pool->Deallocate(reused);
+  pool->ReleaseCachedMemory();
+}
+
+TEST(HostMemoryPool, cross_thread_free) {
+  HostMemoryPool* pool = HostMemoryPool::Singleton();
+  std::vector<void*> ptrs;
+  FOR_RANGE(int32_t, i, 0, 100) { ptrs.push_back(pool->Allocate(i * 4096 + 1)); }
+  std::thread([&]() {
+    for (void* ptr : ptrs) { pool->Deallocate(ptr); }
+  }).join();
+  // the freeing thread flushed its cache to the central lists when it exited
+  const int64_t hit_cnt = pool->GetStats().hit_cnt;
+  FOR_RANGE(int32_t, i, 0, 100) { ptrs.at(i) = pool->Allocate(i * 4096 + 1); }
+  ASSERT_EQ(pool->GetStats().hit_cnt, hit_cnt + 100);
+  for (void* ptr : ptrs) { pool->Deallocate(ptr); }
+  pool->ReleaseCachedMemory();
+}
+
+}  // namespace oneflow
@@ -14,16 +14,44 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/memory/host_memory_pool.h"
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/device/cuda_util.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
+#include "oneflow/core/thread/thread_pool.h"
 #include "oneflow/core/register/blob.h"
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/record/record.pb.h"
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kParallelMemsetMinSize = 64 << 20;
+constexpr size_t kParallelMemsetGrainSize = 4 << 20;
+
+void MemsetHostMem(char* dptr, int value, size_t size) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const ResourceDesc* resource_desc = Global<ResourceDesc, ForSession>::Get();
+  // pages are placed on the numa node of the thread which touches them first. Under a thread
+  // placement the workers are pinned to nodes unrelated to the memory, so the calling thread,
+  // which may be bound to the cpus of its user, fills it alone.
+  if (size < kParallelMemsetMinSize || thread_pool == nullptr
+      || !resource_desc->regst_mem_init_conf().parallel_host_zero_init()
+      || resource_desc->thread_placement_conf().policy() != kThreadPlacementNone) {
+    memset(dptr, value, size);
+    return;
+  }
+  const int64_t grain_num = RoundUp(size, kParallelMemsetGrainSize) / kParallelMemsetGrainSize;
+  thread_pool->ParallelFor(0, grain_num, 1, [&](int64_t begin, int64_t end) {
+    const size_t offset = begin * kParallelMemsetGrainSize;
+    memset(dptr + offset, value, std::min(end * kParallelMemsetGrainSize, size) - offset);
+  });
+}
+
+}  // namespace
+
 void* MemoryAllocatorImpl::Allocate(MemoryCase mem_case, size_t size) {
   void* ptr = nullptr;
   if (mem_case.has_host_mem()) {
@@ -38,8 +66,7 @@ void* MemoryAllocatorImpl::Allocate(MemoryCase mem_case, size_t size) {
       UNIMPLEMENTED();
 #endif
     } else {
-      ptr = malloc(size);
-      CHECK_NOTNULL(ptr);
+      ptr = AllocateUnPinnedHostMem(size);
     }
   } else if (mem_case.has_device_cuda_mem()) {
 #ifdef WITH_CUDA
@@ -63,7 +90,7 @@ void MemoryAllocatorImpl::Deallocate(void* ptr, MemoryCase mem_case) {
       UNIMPLEMENTED();
 #endif
     } else {
-      free(ptr);
+      DeallocateUnPinnedHostMem(ptr);
     }
   } else if (mem_case.has_device_cuda_mem()) {
 #ifdef WITH_CUDA
@@ -78,22 +105,26 @@ void MemoryAllocatorImpl::Deallocate(void* ptr, MemoryCase mem_case) {
 }
 
 void* MemoryAllocatorImpl::AllocateUnPinnedHostMem(size_t size) {
-  void* ptr = malloc(size);
+  void* ptr = HostMemoryPool::Singleton()->Allocate(size);
   CHECK_NOTNULL(ptr);
   return ptr;
 }
 
-void MemoryAllocatorImpl::DeallocateUnPinnedHostMem(void* ptr) { free(ptr); }
+void MemoryAllocatorImpl::DeallocateUnPinnedHostMem(void* ptr) {
+  HostMemoryPool::Singleton()->Deallocate(ptr);
+}
 
 MemoryAllocator::~MemoryAllocator() {
   for (std::function<void()> deleter : deleters_) { deleter(); }
 }
 
-char* MemoryAllocator::Allocate(MemoryCase mem_case, std::size_t size) {
+char* MemoryAllocator::Allocate(MemoryCase mem_case, std::size_t size, bool zero_init) {
   const int memset_val = 0;
   char* dptr = static_cast<char*>(MemoryAllocatorImpl::Allocate(mem_case, size));
-  if (mem_case.has_host_mem()) {
-    memset(dptr, memset_val, size);
+  if (!zero_init) {
+    // do nothing
+  } else if (mem_case.has_host_mem()) {
+    MemsetHostMem(dptr, memset_val, size);
   } else if (mem_case.has_device_cuda_mem()) {
 #ifdef WITH_CUDA
     CudaCurrentDeviceGuard guard(mem_case.device_cuda_mem().device_id());
@@ -27,7 +27,9 @@ class MemoryAllocator final {
   MemoryAllocator() = default;
   ~MemoryAllocator();
 
-  char* Allocate(MemoryCase mem_case, std::size_t size);
+  char* Allocate(MemoryCase mem_case, std::size_t size) { return Allocate(mem_case, size, true); }
+  // the content of the returned memory is undefined when zero_init is false
+  char* Allocate(MemoryCase mem_case, std::size_t size, bool zero_init);
   template<typename T>
   T* PlacementNew(T* mem_ptr);
 
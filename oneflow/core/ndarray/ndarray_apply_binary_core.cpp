@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/ndarray/ndarray_apply_binary_core.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
@@ -23,11 +24,13 @@ struct NdarrayApplyBinaryCoreWrapper<DeviceType::kCPU, T, binary_func> final {
   static void Apply(DeviceCtx* ctx,
                     const XpuVarNdarray<typename BinaryFuncTrait<binary_func, T>::return_type>& y,
                     const XpuVarNdarray<const T>& a, const XpuVarNdarray<const T>& b) {
-    NdarrayApplyBinaryCore<T, binary_func>::Apply(y.shape().ElemNum(), y.ptr(), a.ptr(), b.ptr());
+    auto Invoke = [](const T a_val, const T b_val) { return binary_func<T>::Invoke(a_val, b_val); };
+    CpuElementwiseApply(y.shape().ElemNum(), Invoke, y.ptr(), a.ptr(), b.ptr());
   }
   static void InplaceApply(DeviceCtx* ctx, const XpuVarNdarray<T>& y,
                            const XpuVarNdarray<const T>& x) {
-    NdarrayApplyBinaryCore<T, binary_func>::InplaceApply(y.shape().ElemNum(), y.ptr(), x.ptr());
+    auto Invoke = [](const T y_val, const T x_val) { return binary_func<T>::Invoke(y_val, x_val); };
+    CpuElementwiseApply(y.shape().ElemNum(), Invoke, y.ptr(), y.ptr(), x.ptr());
   }
 };
 
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_apply_broadcast_binary.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+template<typename F>
+double AverageMillis(int64_t iter_num, const F& Run) {
+  Run();
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, iter_num) { Run(); }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+         / iter_num;
+}
+
+// the serial loop the elementwise kernels used to run against CpuElementwiseApply
+template<typename T, typename F>
+void BenchmarkElementwise(const std::string& name, int64_t n, const F& f, int64_t iter_num) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<T> dis(0.1, 2);
+  std::vector<T> x(n), y(n), ref_y(n);
+  for (T& v : x) { v = dis(gen); }
+  const double ref_ms = AverageMillis(iter_num, [&]() {
+    FOR_RANGE(int64_t, i, 0, n) { ref_y[i] = f(x[i]); }
+  });
+  const double ms =
+      AverageMillis(iter_num, [&]() { CpuElementwiseApply(n, f, y.data(), x.data()); });
+  std::cout << name << " " << DataType_Name(GetDataType<T>::value) << " " << n
+            << " ms: " << ref_ms << " -> " << ms << (y == ref_y ? "" : " MISMATCH") << std::endl;
+}
+
+// NdarrayApplyBroadcastBinaryCore, which computes the coordinates of every element, against the
+// row by row broadcast
+template<typename T>
+void BenchmarkBroadcastAdd(const Shape& a_shape, const Shape& b_shape, int64_t iter_num) {
+  DimVector y_dim_vec(a_shape.NumAxes());
+  FOR_RANGE(int64_t, i, 0, a_shape.NumAxes()) {
+    y_dim_vec.at(i) = std::max(a_shape.At(i), b_shape.At(i));
+  }
+  const Shape y_shape(y_dim_vec);
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<T> dis(-1, 1);
+  std::vector<T> a(a_shape.elem_cnt()), b(b_shape.elem_cnt());
+  for (T& v : a) { v = dis(gen); }
+  for (T& v : b) { v = dis(gen); }
+  std::vector<T> y(y_shape.elem_cnt()), ref_y(y_shape.elem_cnt());
+  CpuDeviceCtx ctx;
+  XpuVarNdarray<const T> a_ndarray(a_shape, a.data());
+  XpuVarNdarray<const T> b_ndarray(b_shape, b.data());
+  const double ref_ms = AverageMillis(iter_num, [&]() {
+    NdarrayApplyBroadcastBinaryCore<T, 4, BinaryFuncAdd>::Apply(
+        XpuVarNdarray<T>(y_shape, ref_y.data()), a_ndarray, b_ndarray);
+  });
+  const double ms = AverageMillis(iter_num, [&]() {
+    NdarrayApplyBroadcastBinary<DeviceType::kCPU, T, BinaryFuncAdd>::Apply(
+        &ctx, XpuVarNdarray<T>(y_shape, y.data()), a_ndarray, b_ndarray);
+  });
+  std::cout << "broadcast add " << DataType_Name(GetDataType<T>::value) << " " << a_shape.ToString()
+            << " " << b_shape.ToString() << " ms: " << ref_ms << " -> " << ms
+            << (y == ref_y ? "" : " MISMATCH") << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(thread_num, 8, "number of threads of the compute thread pool");
+DEFINE_int64(iter_num, 20, "number of iterations every case is timed over");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(3);
+  Global<ThreadPool>::New(FLAGS_thread_num);
+  for (int64_t n : {1 << 16, 1 << 22, 1 << 25}) {
+    BenchmarkElementwise<float>("square", n, [](float x) { return x * x; }, FLAGS_iter_num);
+    BenchmarkElementwise<float>("sqrt", n, [](float x) { return std::sqrt(x); }, FLAGS_iter_num);
+    BenchmarkElementwise<double>("floor", n, [](double x) { return std::floor(x); },
+                                 FLAGS_iter_num);
+    BenchmarkElementwise<float>("exp", n, [](float x) { return std::exp(x); }, FLAGS_iter_num);
+  }
+  // bias of nchw and nhwc, and an outer product
+  BenchmarkBroadcastAdd<float>(Shape({32, 64, 56, 56}), Shape({1, 64, 1, 1}), FLAGS_iter_num);
+  BenchmarkBroadcastAdd<float>(Shape({32, 56, 56, 64}), Shape({1, 1, 1, 64}), FLAGS_iter_num);
+  BenchmarkBroadcastAdd<float>(Shape({1, 1, 4096, 1}), Shape({1, 1, 1, 4096}), FLAGS_iter_num);
+  Global<ThreadPool>::Delete();
+  return 0;
+}
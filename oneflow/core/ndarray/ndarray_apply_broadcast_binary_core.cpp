@@ -14,15 +14,78 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/ndarray/ndarray_apply_broadcast_binary_core.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
+namespace {
+
+// The broadcast shapes are simplified, so the last axis of a and b is either the one of y, and
+// contiguous, or 1. y is walked row by row, every row being a contiguous loop over y and the
+// operands that are not broadcast along it, while the broadcast ones are scalars of the row.
+template<typename T, typename RetT, int NDIMS, template<typename> class binary_func>
+void ApplyBroadcastByRows(const XpuShape& y_shape, RetT* y, const XpuShape& a_shape, const T* a,
+                          const XpuShape& b_shape, const T* b) {
+  const int64_t row_size = y_shape.At(NDIMS - 1);
+  const bool is_a_row_broadcast = a_shape.At(NDIMS - 1) != row_size;
+  const bool is_b_row_broadcast = b_shape.At(NDIMS - 1) != row_size;
+  int64_t a_strides[NDIMS];
+  int64_t b_strides[NDIMS];
+  FOR_RANGE(int64_t, i, 0, NDIMS) {
+    a_strides[i] = a_shape.At(i) == 1 ? 0 : a_shape.DimElemNum(i);
+    b_strides[i] = b_shape.At(i) == 1 ? 0 : b_shape.DimElemNum(i);
+  }
+  CpuElementwiseParallelFor(y_shape.ElemNum(), [&](int64_t begin, int64_t end) {
+    int64_t coord[NDIMS];
+    y_shape.template Offset2Coordinate<NDIMS>(begin, coord);
+    int64_t offset = begin;
+    while (offset < end) {
+      const int64_t col = coord[NDIMS - 1];
+      const int64_t size = std::min(row_size - col, end - offset);
+      int64_t a_offset = 0;
+      int64_t b_offset = 0;
+      FOR_RANGE(int64_t, i, 0, NDIMS) {
+        a_offset += coord[i] * a_strides[i];
+        b_offset += coord[i] * b_strides[i];
+      }
+      RetT* y_row = y + offset;
+      const T* a_row = a + a_offset;
+      const T* b_row = b + b_offset;
+      if (is_a_row_broadcast && !is_b_row_broadcast) {
+        const T a_val = *a_row;
+        auto Invoke = [a_val](const T b_val) { return binary_func<T>::Invoke(a_val, b_val); };
+        CpuElementwiseApplyRange(0, size, Invoke, y_row, b_row);
+      } else if (!is_a_row_broadcast && is_b_row_broadcast) {
+        const T b_val = *b_row;
+        auto Invoke = [b_val](const T a_val) { return binary_func<T>::Invoke(a_val, b_val); };
+        CpuElementwiseApplyRange(0, size, Invoke, y_row, a_row);
+      } else {
+        auto Invoke = [](const T a_val, const T b_val) {
+          return binary_func<T>::Invoke(a_val, b_val);
+        };
+        CpuElementwiseApplyRange(0, size, Invoke, y_row, a_row, b_row);
+      }
+      offset += size;
+      // the next row
+      coord[NDIMS - 1] = 0;
+      for (int64_t i = NDIMS - 2; i >= 0; --i) {
+        coord[i] += 1;
+        if (coord[i] < y_shape.At(i)) { break; }
+        coord[i] = 0;
+      }
+    }
+  });
+}
+
+}  // namespace
+
 template<typename T, int NDIMS, template<typename> class binary_func>
 struct NdarrayApplyBroadcastBinaryCoreWrapper<DeviceType::kCPU, T, NDIMS, binary_func> final {
   static void Apply(DeviceCtx* ctx,
                     const XpuVarNdarray<typename BinaryFuncTrait<binary_func, T>::return_type>& y,
                     const XpuVarNdarray<const T>& a, const XpuVarNdarray<const T>& b) {
-    NdarrayApplyBroadcastBinaryCore<T, NDIMS, binary_func>::Apply(y, a, b);
+    ApplyBroadcastByRows<T, typename BinaryFuncTrait<binary_func, T>::return_type, NDIMS,
+                         binary_func>(y.shape(), y.ptr(), a.shape(), a.ptr(), b.shape(), b.ptr());
   }
 };
 
@@ -31,7 +94,8 @@ struct NdarrayApplyBroadcastInplaceBinaryCoreWrapper<DeviceType::kCPU, T, NDIMS,
     final {
   static void InplaceApply(DeviceCtx* ctx, const XpuVarNdarray<T>& y,
                            const XpuVarNdarray<const T>& x) {
-    NdarrayApplyBroadcastBinaryCore<T, NDIMS, binary_func>::InplaceApply(y, x);
+    ApplyBroadcastByRows<T, T, NDIMS, binary_func>(y.shape(), y.ptr(), y.shape(), y.ptr(),
+                                                   x.shape(), x.ptr());
   }
 };
 
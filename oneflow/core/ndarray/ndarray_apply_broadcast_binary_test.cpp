@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_apply_broadcast_binary.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+int64_t BroadcastOffset(const Shape& y_shape, const Shape& x_shape, int64_t y_offset) {
+  int64_t x_offset = 0;
+  FOR_RANGE(int64_t, i, 0, y_shape.NumAxes()) {
+    const int64_t coord = (y_offset / y_shape.Count(i + 1)) % y_shape.At(i);
+    if (x_shape.At(i) != 1) { x_offset += coord * x_shape.Count(i + 1); }
+  }
+  return x_offset;
+}
+
+// Applies binary_func on a and b broadcast to y_shape, and in place on a if a_shape is y_shape,
+// on a thread pool if thread_num > 0
+template<typename T, template<typename> class binary_func>
+void TestBroadcastBinary(const Shape& a_shape, const Shape& b_shape, int32_t thread_num) {
+  using RetT = typename BinaryFuncTrait<binary_func, T>::return_type;
+  if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+  DimVector y_dim_vec(a_shape.NumAxes());
+  FOR_RANGE(int64_t, i, 0, a_shape.NumAxes()) {
+    y_dim_vec.at(i) = std::max(a_shape.At(i), b_shape.At(i));
+  }
+  const Shape y_shape(y_dim_vec);
+  std::mt19937 gen(y_shape.elem_cnt());
+  std::vector<T> a(a_shape.elem_cnt());
+  std::vector<T> b(b_shape.elem_cnt());
+  for (T& val : a) { val = static_cast<T>(static_cast<int32_t>(gen() % 11) - 5); }
+  for (T& val : b) { val = static_cast<T>(static_cast<int32_t>(gen() % 11) - 5); }
+  std::vector<RetT> y(y_shape.elem_cnt());
+  CpuDeviceCtx ctx;
+  NdarrayApplyBroadcastBinary<DeviceType::kCPU, T, binary_func>::Apply(
+      &ctx, XpuVarNdarray<RetT>(y_shape, y.data()), XpuVarNdarray<const T>(a_shape, a.data()),
+      XpuVarNdarray<const T>(b_shape, b.data()));
+  FOR_RANGE(int64_t, i, 0, y_shape.elem_cnt()) {
+    const RetT expected = binary_func<T>::Invoke(a.at(BroadcastOffset(y_shape, a_shape, i)),
+                                                 b.at(BroadcastOffset(y_shape, b_shape, i)));
+    ASSERT_EQ(y.at(i), expected);
+  }
+  if (a_shape == y_shape) {
+    std::vector<T> inplace_y(a);
+    NdarrayApplyBroadcastBinary<DeviceType::kCPU, T, binary_func>::InplaceApply(
+        &ctx, XpuVarNdarray<T>(y_shape, inplace_y.data()),
+        XpuVarNdarray<const T>(b_shape, b.data()));
+    FOR_RANGE(int64_t, i, 0, y_shape.elem_cnt()) {
+      ASSERT_EQ(inplace_y.at(i), static_cast<T>(y.at(i)));
+    }
+  }
+  if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+}
+
+template<typename T, template<typename> class binary_func>
+void TestBroadcastBinaryOfAllShapes(int32_t thread_num) {
+  // same shape
+  TestBroadcastBinary<T, binary_func>(Shape({100003}), Shape({100003}), thread_num);
+  // scalar
+  TestBroadcastBinary<T, binary_func>(Shape({100003}), Shape({1}), thread_num);
+  TestBroadcastBinary<T, binary_func>(Shape({1}), Shape({100003}), thread_num);
+  // row and col vectors
+  TestBroadcastBinary<T, binary_func>(Shape({300, 1000}), Shape({1, 1000}), thread_num);
+  TestBroadcastBinary<T, binary_func>(Shape({300, 1000}), Shape({300, 1}), thread_num);
+  TestBroadcastBinary<T, binary_func>(Shape({3, 70001}), Shape({3, 1}), thread_num);
+  // outer product
+  TestBroadcastBinary<T, binary_func>(Shape({300, 1}), Shape({1, 1000}), thread_num);
+  // bias of nchw and nhwc
+  TestBroadcastBinary<T, binary_func>(Shape({8, 64, 17, 19}), Shape({1, 64, 1, 1}), thread_num);
+  TestBroadcastBinary<T, binary_func>(Shape({8, 17, 19, 64}), Shape({1, 1, 1, 64}), thread_num);
+  // both broadcast on different axes
+  TestBroadcastBinary<T, binary_func>(Shape({7, 1, 33, 1}), Shape({1, 50, 1, 3}), thread_num);
+}
+
+}  // namespace
+
+TEST(NdarrayApplyBroadcastBinary, sub) {
+  TestBroadcastBinaryOfAllShapes<float, BinaryFuncSub>(0);
+  TestBroadcastBinaryOfAllShapes<double, BinaryFuncSub>(0);
+  TestBroadcastBinaryOfAllShapes<int32_t, BinaryFuncSub>(0);
+}
+
+TEST(NdarrayApplyBroadcastBinary, sub_multi_thread) {
+  TestBroadcastBinaryOfAllShapes<float, BinaryFuncSub>(4);
+  TestBroadcastBinaryOfAllShapes<int64_t, BinaryFuncSub>(4);
+}
+
+TEST(NdarrayApplyBroadcastBinary, max) {
+  TestBroadcastBinaryOfAllShapes<float, BinaryFuncMax>(0);
+  TestBroadcastBinaryOfAllShapes<float, BinaryFuncMax>(4);
+}
+
+// the in-place logical funcs are only instantiated for int8_t
+TEST(NdarrayApplyBroadcastBinary, logical) {
+  TestBroadcastBinaryOfAllShapes<int8_t, BinaryFuncGT>(0);
+  TestBroadcastBinaryOfAllShapes<int8_t, BinaryFuncEQ>(4);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
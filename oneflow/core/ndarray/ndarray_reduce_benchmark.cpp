@@ -0,0 +1,99 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_reduce.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+template<typename F>
+double AverageMillis(int64_t iter_num, const F& Run) {
+  Run();
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, iter_num) { Run(); }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+         / iter_num;
+}
+
+// NdarrayReduce, which takes the fast paths, against the default reduce every shape used to take
+template<typename T, template<typename> class binary_func>
+void BenchmarkReduce(const std::string& name, const Shape& x_shape, const Shape& y_shape,
+                     int64_t iter_num) {
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<T> dis(-1, 1);
+  std::vector<T> x(x_shape.elem_cnt());
+  for (T& val : x) { val = dis(gen); }
+  std::vector<T> y(y_shape.elem_cnt());
+  std::vector<T> default_y(y_shape.elem_cnt());
+  std::vector<T> tmp(x_shape.elem_cnt());
+  CpuDeviceCtx ctx;
+  XpuVarNdarray<const T> x_ndarray(x_shape, x.data());
+  XpuVarNdarray<T> tmp_ndarray(x_shape, tmp.data());
+  const double default_ms = AverageMillis(iter_num, [&]() {
+    NdarrayDefaultReduce<DeviceType::kCPU, T, binary_func>::Reduce(
+        &ctx, XpuVarNdarray<T>(y_shape, default_y.data()), x_ndarray, tmp_ndarray);
+  });
+  const double ms = AverageMillis(iter_num, [&]() {
+    NdarrayReduce<DeviceType::kCPU, T, binary_func>::Reduce(
+        &ctx, XpuVarNdarray<T>(y_shape, y.data()), x_ndarray, tmp_ndarray);
+  });
+  double max_diff = 0;
+  FOR_RANGE(int64_t, i, 0, y_shape.elem_cnt()) {
+    max_diff = std::max<double>(max_diff, std::abs(y.at(i) - default_y.at(i)));
+  }
+  std::cout << name << " " << x_shape.ToString() << " -> " << y_shape.ToString()
+            << " default ms: " << default_ms << " -> " << ms << " max diff: " << max_diff
+            << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(thread_num, 8, "number of threads of the compute thread pool");
+DEFINE_int64(iter_num, 20, "number of iterations every case is timed over");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(3);
+  Global<ThreadPool>::New(FLAGS_thread_num);
+  const int64_t iter_num = FLAGS_iter_num;
+  // reduce_sum of a whole tensor, e.g. a loss
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({1 << 24}), Shape({1}), iter_num);
+  // softmax over classes
+  BenchmarkReduce<float, BinaryFuncMax>("max", Shape({4096, 1000}), Shape({4096, 1}), iter_num);
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({4096, 1000}), Shape({4096, 1}), iter_num);
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({8, 1 << 20}), Shape({8, 1}), iter_num);
+  // bias grad of a dense layer
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({65536, 1024}), Shape({1, 1024}), iter_num);
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({65536, 64}), Shape({1, 64}), iter_num);
+  // reduce over the middle axis, e.g. of NHWC images over H
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({64, 224, 672}), Shape({64, 1, 672}),
+                                        iter_num);
+  // bias grad of an NCHW convolution
+  BenchmarkReduce<float, BinaryFuncSum>("sum", Shape({64, 256, 3136}), Shape({1, 256, 1}),
+                                        iter_num);
+  BenchmarkReduce<double, BinaryFuncSum>("sum", Shape({64, 256, 3136}), Shape({1, 256, 1}),
+                                         iter_num);
+  Global<ThreadPool>::Delete();
+  return 0;
+}
@@ -17,26 +17,300 @@ limitations under the License.
 #include "oneflow/core/common/preprocessor.h"
 #include "oneflow/core/ndarray/ndarray_reduce_impl.h"
 #include "oneflow/core/ndarray/binary_func.h"
+#include "oneflow/core/thread/thread_pool.h"
 
 namespace oneflow {
 
-#define SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(struct_name)                                            \
-  template<typename T, template<typename> class binary_func>                                       \
-  struct struct_name<DeviceType::kCPU, T, binary_func> final {                                     \
-    static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {              \
-      return false;                                                                                \
-    }                                                                                              \
-    static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x, \
-                       const XpuVarNdarray<T>& tmp_storage) {                                      \
-      UNIMPLEMENTED();                                                                             \
-    }                                                                                              \
-  }
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayScalarReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixRowReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayMatrixColReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeYReduce);
-SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL(NdarrayXYZCubeXZReduce);
-#undef SPECIALIZE_CPU_NDARRAY_REDUCE_IMPL
+namespace {
+
+// float16 is reduced in float
+template<typename T>
+struct ReduceAccType {
+  using type = T;
+};
+template<>
+struct ReduceAccType<float16> {
+  using type = float;
+};
+
+// elements are reduced kLaneNum at a time into as many accumulators, so that the loops vectorize
+constexpr int64_t kLaneNum = 8;
+// the leaves of the pairwise reductions: kRowLeafSize elements of a row, or kColLeafRowNum rows of
+// kColBlockSize columns, which are accumulated in the l1 cache
+constexpr int64_t kRowLeafSize = 1024;
+constexpr int64_t kColLeafRowNum = 64;
+constexpr int64_t kColBlockSize = 512;
+// the work handed to a thread is at least kParallelGrainElemCnt elements
+constexpr int64_t kParallelGrainElemCnt = 32 * 1024;
+
+int64_t CeilDiv(int64_t n, int64_t d) { return (n + d - 1) / d; }
+
+int64_t ComputeThreadNum() {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  return thread_pool == nullptr ? 1 : thread_pool->thread_num();
+}
+
+void ParallelForTasks(int64_t task_num, int64_t task_elem_cnt,
+                      const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const int64_t grain_size =
+      std::max<int64_t>(kParallelGrainElemCnt / std::max<int64_t>(task_elem_cnt, 1), 1);
+  if (thread_pool == nullptr || task_num <= grain_size) {
+    Handler(0, task_num);
+  } else {
+    thread_pool->ParallelFor(0, task_num, grain_size, Handler);
+  }
+}
+
+// Reductions of contiguous rows and of columns. Sums are accumulated pairwise, whose rounding error
+// grows with the log of the number of elements instead of the number itself.
+template<typename T, template<typename> class binary_func>
+struct CpuReduceUtil final {
+  using AccT = typename ReduceAccType<T>::type;
+
+  static AccT Invoke(AccT x, AccT y) { return binary_func<AccT>::Invoke(x, y); }
+  static AccT Unit() { return UnitOfBinaryFunc<AccT, binary_func>::Val(); }
+
+  // y[i] = reduce(x[i][0, m)) for i in [0, n). Few long rows are split into segments, which are
+  // reduced in parallel and then together.
+  template<typename In>
+  static void RowReduce(int64_t n, int64_t m, const In* x, AccT* y) {
+    int64_t seg_num = 1;
+    const int64_t thread_num = ComputeThreadNum();
+    if (n < thread_num && m > kParallelGrainElemCnt) {
+      seg_num = std::min(CeilDiv(thread_num, n), CeilDiv(m, kParallelGrainElemCnt));
+    }
+    if (seg_num == 1) {
+      ParallelForTasks(n, m, [&](int64_t begin, int64_t end) {
+        FOR_RANGE(int64_t, i, begin, end) { y[i] = PairwiseReduce(x + i * m, m); }
+      });
+      return;
+    }
+    const int64_t seg_size = CeilDiv(CeilDiv(m, seg_num), kRowLeafSize) * kRowLeafSize;
+    seg_num = CeilDiv(m, seg_size);
+    std::vector<AccT> seg_reduced(n * seg_num);
+    ParallelForTasks(n * seg_num, seg_size, [&](int64_t begin, int64_t end) {
+      FOR_RANGE(int64_t, task, begin, end) {
+        const int64_t seg_begin = (task % seg_num) * seg_size;
+        seg_reduced.at(task) = PairwiseReduce(x + (task / seg_num) * m + seg_begin,
+                                              std::min(seg_size, m - seg_begin));
+      }
+    });
+    FOR_RANGE(int64_t, i, 0, n) {
+      y[i] = PairwiseReduce(seg_reduced.data() + i * seg_num, seg_num);
+    }
+  }
+
+  // y[b][j] = reduce(x[b][0, n)[j]) for b in [0, batch) and j in [0, m). The columns are reduced
+  // in blocks of kColBlockSize, and the rows are split into parts when there are fewer blocks than
+  // threads.
+  template<typename In>
+  static void ColReduce(int64_t batch, int64_t n, int64_t m, const In* x, AccT* y) {
+    if (n == 0) {
+      std::fill(y, y + batch * m, Unit());
+      return;
+    }
+    const int64_t col_block_num = CeilDiv(m, kColBlockSize);
+    int64_t part_num = 1;
+    const int64_t thread_num = ComputeThreadNum();
+    if (batch * col_block_num < thread_num && batch * n * m > kParallelGrainElemCnt) {
+      part_num = std::min(CeilDiv(thread_num, batch * col_block_num), CeilDiv(n, kColLeafRowNum));
+    }
+    const int64_t part_row_num = CeilDiv(n, part_num);
+    part_num = CeilDiv(n, part_row_num);
+    std::vector<AccT> part_reduced;
+    if (part_num > 1) { part_reduced.resize(part_num * batch * m); }
+    AccT* part_y = part_num > 1 ? part_reduced.data() : y;
+    const int64_t task_num = batch * part_num * col_block_num;
+    const int64_t task_elem_cnt = part_row_num * std::min(m, kColBlockSize);
+    ParallelForTasks(task_num, task_elem_cnt, [&](int64_t begin, int64_t end) {
+      std::vector<AccT> buf;
+      FOR_RANGE(int64_t, task, begin, end) {
+        const int64_t col_begin = (task % col_block_num) * kColBlockSize;
+        const int64_t col_num = std::min(kColBlockSize, m - col_begin);
+        const int64_t part = task / col_block_num % part_num;
+        const int64_t b = task / col_block_num / part_num;
+        const int64_t row_begin = part * part_row_num;
+        const int64_t row_num = std::min(part_row_num, n - row_begin);
+        buf.resize(PairwiseDepth(row_num) * col_num);
+        PairwiseColReduce(x + (b * n + row_begin) * m + col_begin, m, row_num, col_num,
+                          part_y + (part * batch + b) * m + col_begin, buf.data());
+      }
+    });
+    if (part_num == 1) { return; }
+    const int64_t y_elem_cnt = batch * m;
+    FOR_RANGE(int64_t, i, 0, y_elem_cnt) { y[i] = part_reduced.at(i); }
+    FOR_RANGE(int64_t, part, 1, part_num) {
+      const AccT* reduced = part_reduced.data() + part * y_elem_cnt;
+      FOR_RANGE(int64_t, i, 0, y_elem_cnt) { y[i] = Invoke(y[i], reduced[i]); }
+    }
+  }
+
+  // Calls Reduce with a buffer of n AccT, which is y itself when T is AccT, and stores it to y
+  static void ReduceTo(int64_t n, T* y, const std::function<void(AccT* acc_y)>& Reduce) {
+    if (std::is_same<T, AccT>::value) {
+      Reduce(reinterpret_cast<AccT*>(y));
+    } else {
+      std::vector<AccT> acc_y(n);
+      Reduce(acc_y.data());
+      FOR_RANGE(int64_t, i, 0, n) { y[i] = static_cast<T>(acc_y.at(i)); }
+    }
+  }
+
+ private:
+  template<typename In>
+  static AccT LaneReduce(const In* x, int64_t n) {
+    AccT lane_reduced[kLaneNum];
+    std::fill(lane_reduced, lane_reduced + kLaneNum, Unit());
+    const int64_t step_num = n / kLaneNum;
+    FOR_RANGE(int64_t, i, 0, step_num) {
+      FOR_RANGE(int64_t, l, 0, kLaneNum) {
+        lane_reduced[l] = Invoke(lane_reduced[l], static_cast<AccT>(x[i * kLaneNum + l]));
+      }
+    }
+    AccT reduced = Unit();
+    FOR_RANGE(int64_t, l, 0, kLaneNum) { reduced = Invoke(reduced, lane_reduced[l]); }
+    FOR_RANGE(int64_t, i, step_num * kLaneNum, n) {
+      reduced = Invoke(reduced, static_cast<AccT>(x[i]));
+    }
+    return reduced;
+  }
+
+  template<typename In>
+  static AccT PairwiseReduce(const In* x, int64_t n) {
+    if (n <= kRowLeafSize) { return LaneReduce(x, n); }
+    const int64_t left_n = (n / kRowLeafSize + 1) / 2 * kRowLeafSize;
+    return Invoke(PairwiseReduce(x, left_n), PairwiseReduce(x + left_n, n - left_n));
+  }
+
+  // the number of levels of PairwiseColReduce, each of which needs col_num elements of buf
+  static int64_t PairwiseDepth(int64_t row_num) {
+    int64_t depth = 0;
+    while (row_num > kColLeafRowNum) {
+      row_num = CeilDiv(row_num, 2);
+      depth += 1;
+    }
+    return depth;
+  }
+
+  // y[j] = reduce(x[0, row_num)[j]) for j in [0, col_num), the rows being row_stride apart
+  template<typename In>
+  static void PairwiseColReduce(const In* x, int64_t row_stride, int64_t row_num,
+                                int64_t col_num, AccT* y, AccT* buf) {
+    if (row_num <= kColLeafRowNum) {
+      std::fill(y, y + col_num, Unit());
+      FOR_RANGE(int64_t, i, 0, row_num) {
+        const In* row = x + i * row_stride;
+        FOR_RANGE(int64_t, j, 0, col_num) { y[j] = Invoke(y[j], static_cast<AccT>(row[j])); }
+      }
+      return;
+    }
+    const int64_t left_row_num = CeilDiv(row_num, 2);
+    PairwiseColReduce(x, row_stride, left_row_num, col_num, y, buf);
+    PairwiseColReduce(x + left_row_num * row_stride, row_stride, row_num - left_row_num, col_num,
+                      buf, buf + col_num);
+    FOR_RANGE(int64_t, j, 0, col_num) { y[j] = Invoke(y[j], buf[j]); }
+  }
+};
+
+}  // namespace
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayScalarReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    return y.shape().ElemNum() == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    using Util = CpuReduceUtil<T, binary_func>;
+    Util::ReduceTo(1, y.ptr(), [&](typename Util::AccT* acc_y) {
+      Util::RowReduce(1, x.shape().ElemNum(), x.ptr(), acc_y);
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixRowReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1;
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    using Util = CpuReduceUtil<T, binary_func>;
+    const int64_t num_rows = x.shape().At(0);
+    Util::ReduceTo(num_rows, y.ptr(), [&](typename Util::AccT* acc_y) {
+      Util::RowReduce(num_rows, x.shape().At(1), x.ptr(), acc_y);
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayMatrixColReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 2) { return false; }
+    if (y.shape().NumAxes() != 2) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1);
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    using Util = CpuReduceUtil<T, binary_func>;
+    const int64_t num_cols = x.shape().At(1);
+    Util::ReduceTo(num_cols, y.ptr(), [&](typename Util::AccT* acc_y) {
+      Util::ColReduce(1, x.shape().At(0), num_cols, x.ptr(), acc_y);
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeYReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return x.shape().At(0) == y.shape().At(0) && y.shape().At(1) == 1
+           && x.shape().At(2) == y.shape().At(2);
+  }
+
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    using Util = CpuReduceUtil<T, binary_func>;
+    Util::ReduceTo(y.shape().ElemNum(), y.ptr(), [&](typename Util::AccT* acc_y) {
+      Util::ColReduce(x.shape().At(0), x.shape().At(1), x.shape().At(2), x.ptr(), acc_y);
+    });
+  }
+};
+
+template<typename T, template<typename> class binary_func>
+struct NdarrayXYZCubeXZReduce<DeviceType::kCPU, T, binary_func> final {
+  static bool Matched(const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x) {
+    if (x.shape().NumAxes() != 3) { return false; }
+    if (y.shape().NumAxes() != 3) { return false; }
+    return y.shape().At(0) == 1 && x.shape().At(1) == y.shape().At(1) && y.shape().At(2) == 1;
+  }
+
+  // z is reduced first, then x
+  static void Reduce(DeviceCtx* ctx, const XpuVarNdarray<T>& y, const XpuVarNdarray<const T>& x,
+                     const XpuVarNdarray<T>& tmp_storage) {
+    CHECK(Matched(y, x));
+    using Util = CpuReduceUtil<T, binary_func>;
+    const int64_t dim_x = x.shape().At(0);
+    const int64_t dim_y = x.shape().At(1);
+    const int64_t dim_z = x.shape().At(2);
+    Util::ReduceTo(dim_y, y.ptr(), [&](typename Util::AccT* acc_y) {
+      std::vector<typename Util::AccT> xy_reduced(dim_x * dim_y);
+      Util::RowReduce(dim_x * dim_y, dim_z, x.ptr(), xy_reduced.data());
+      Util::ColReduce(1, dim_x, dim_y, xy_reduced.data(), acc_y);
+    });
+  }
+};
 
 #define INSTANTIATE_NDARRAY_REDUCE_IMPL(dtype, binary_func)                                       \
   template struct NdarrayScalarReduce<DeviceType::kCPU, OF_PP_PAIR_FIRST(dtype), binary_func>;    \
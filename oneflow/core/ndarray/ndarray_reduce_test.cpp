@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/ndarray/ndarray_reduce.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// Reduces x of x_shape to y_shape with NdarrayReduce and with the default reduce, on a thread
+// pool if thread_num > 0. The elements are small integers, so that the sums are exact.
+template<typename T, template<typename> class binary_func>
+void TestReduce(const Shape& x_shape, const Shape& y_shape, int32_t thread_num) {
+  if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+  std::mt19937 gen(x_shape.elem_cnt());
+  std::vector<T> x(x_shape.elem_cnt());
+  for (T& val : x) { val = static_cast<T>(static_cast<int32_t>(gen() % 11) - 5); }
+  std::vector<T> y(y_shape.elem_cnt());
+  std::vector<T> expected_y(y_shape.elem_cnt());
+  std::vector<T> tmp(x_shape.elem_cnt());
+  CpuDeviceCtx ctx;
+  NdarrayReduce<DeviceType::kCPU, T, binary_func>::Reduce(
+      &ctx, XpuVarNdarray<T>(y_shape, y.data()), XpuVarNdarray<const T>(x_shape, x.data()),
+      XpuVarNdarray<T>(x_shape, tmp.data()));
+  NdarrayDefaultReduce<DeviceType::kCPU, T, binary_func>::Reduce(
+      &ctx, XpuVarNdarray<T>(y_shape, expected_y.data()),
+      XpuVarNdarray<const T>(x_shape, x.data()), XpuVarNdarray<T>(x_shape, tmp.data()));
+  FOR_RANGE(int64_t, i, 0, y_shape.elem_cnt()) { ASSERT_EQ(y.at(i), expected_y.at(i)); }
+  if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+}
+
+template<typename T, template<typename> class binary_func>
+void TestReduceOfAllShapes(int32_t thread_num) {
+  // scalar
+  TestReduce<T, binary_func>(Shape({100003}), Shape({1}), thread_num);
+  // matrix row
+  TestReduce<T, binary_func>(Shape({37, 1500}), Shape({37, 1}), thread_num);
+  TestReduce<T, binary_func>(Shape({3, 70001}), Shape({3, 1}), thread_num);
+  // matrix col
+  TestReduce<T, binary_func>(Shape({3000, 70}), Shape({1, 70}), thread_num);
+  TestReduce<T, binary_func>(Shape({129, 1500}), Shape({1, 1500}), thread_num);
+  // xyz cube y
+  TestReduce<T, binary_func>(Shape({5, 300, 9}), Shape({5, 1, 9}), thread_num);
+  // xyz cube xz
+  TestReduce<T, binary_func>(Shape({6, 40, 130}), Shape({1, 40, 1}), thread_num);
+}
+
+}  // namespace
+
+TEST(NdarrayReduce, cpu_sum) {
+  TestReduceOfAllShapes<float, BinaryFuncSum>(0);
+  TestReduceOfAllShapes<double, BinaryFuncSum>(4);
+  TestReduceOfAllShapes<int32_t, BinaryFuncSum>(4);
+}
+
+TEST(NdarrayReduce, cpu_max) {
+  TestReduceOfAllShapes<float, BinaryFuncMax>(0);
+  TestReduceOfAllShapes<float, BinaryFuncMax>(4);
+}
+
+TEST(NdarrayReduce, cpu_any) { TestReduceOfAllShapes<int8_t, BinaryFuncAny>(4); }
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -0,0 +1,207 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+// the alignment O_DIRECT asks of the buffers, offsets and sizes
+constexpr size_t kDirectIoAlignment = 4096;
+constexpr size_t kWriteChunkByte = 8 * 1024 * 1024;
+constexpr size_t kMaxInFlightSnapshotNum = 2;
+
+// buffer holds at least RoundUp(size, kDirectIoAlignment) bytes, so that with O_DIRECT the tail is
+// written as a whole aligned block and then truncated
+void WriteLocalFile(const std::string& path, const char* buffer, size_t size) {
+  const std::string translated_path = LocalFS()->TranslateName(path);
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+  bool is_direct_io = false;
+  int fd = -1;
+#ifdef O_DIRECT
+  fd = open(translated_path.c_str(), flags | O_DIRECT, 0644);
+  is_direct_io = fd >= 0;
+  // file systems like tmpfs do not support O_DIRECT
+  if (fd < 0 && errno == EINVAL) { fd = open(translated_path.c_str(), flags, 0644); }
+#else
+  fd = open(translated_path.c_str(), flags, 0644);
+#endif
+  PCHECK(fd >= 0) << "Fail to open file " << path;
+  const size_t write_size = is_direct_io ? RoundUp(size, kDirectIoAlignment) : size;
+  size_t offset = 0;
+  while (offset < write_size) {
+    const ssize_t n = write(fd, buffer + offset, std::min(kWriteChunkByte, write_size - offset));
+    if (n < 0 && errno == EINTR) { continue; }
+    PCHECK(n > 0) << "Fail to write file " << path;
+    offset += n;
+  }
+  if (write_size != size) { PCHECK(ftruncate(fd, size) == 0) << "Fail to truncate file " << path; }
+  PCHECK(fsync(fd) == 0) << "Fail to sync file " << path;
+  PCHECK(close(fd) == 0) << "Fail to close file " << path;
+}
+
+}  // namespace
+
+AsyncSnapshotWriter::AsyncSnapshotWriter(int64_t io_thread_num) : io_thread_pool_(io_thread_num) {
+  CHECK_GT(io_thread_num, 0);
+}
+
+AsyncSnapshotWriter::~AsyncSnapshotWriter() {
+  WaitUntilAllDone();
+  for (const auto& snapshot : snapshots_) {
+    LOG(WARNING) << "snapshot staged but not committed is dropped, path: " << snapshot->root_path;
+  }
+}
+
+AsyncSnapshotWriter::Snapshot* AsyncSnapshotWriter::FindSnapshot(const std::string& root_path,
+                                                                 bool is_committed) {
+  for (const auto& snapshot : snapshots_) {
+    if (snapshot->root_path == root_path && snapshot->is_committed == is_committed) {
+      return snapshot.get();
+    }
+  }
+  return nullptr;
+}
+
+AsyncSnapshotWriter::StagingBuffer AsyncSnapshotWriter::AcquireBuffer(size_t size) {
+  const size_t capacity = RoundUp(std::max<size_t>(size, 1), kDirectIoAlignment);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // the smallest free buffer large enough
+    auto best_it = free_buffers_.end();
+    for (auto it = free_buffers_.begin(); it != free_buffers_.end(); ++it) {
+      if (it->capacity >= capacity
+          && (best_it == free_buffers_.end() || it->capacity < best_it->capacity)) {
+        best_it = it;
+      }
+    }
+    if (best_it != free_buffers_.end()) {
+      StagingBuffer buffer = std::move(*best_it);
+      free_buffers_.erase(best_it);
+      return buffer;
+    }
+  }
+  void* ptr = nullptr;
+  CHECK_EQ(posix_memalign(&ptr, kDirectIoAlignment, capacity), 0);
+  return StagingBuffer{std::unique_ptr<char, decltype(&free)>(static_cast<char*>(ptr), &free),
+                       capacity};
+}
+
+AsyncSnapshotWriter::Snapshot* AsyncSnapshotWriter::WaitUntilStageable(
+    std::unique_lock<std::mutex>* lock, const std::string& root_path) {
+  Snapshot* snapshot = nullptr;
+  cond_.wait(*lock, [&]() {
+    // the files of a committed snapshot may still be written, which must not overwrite the files
+    // staged again for the same path
+    if (FindSnapshot(root_path, true) != nullptr) { return false; }
+    snapshot = FindSnapshot(root_path, false);
+    return snapshot != nullptr || snapshots_.size() < kMaxInFlightSnapshotNum;
+  });
+  return snapshot;
+}
+
+void AsyncSnapshotWriter::Stage(const std::string& root_path, const std::string& key,
+                                const char* data, size_t size) {
+  {
+    // no buffer is taken for a third snapshot before the earliest one is written
+    std::unique_lock<std::mutex> lock(mutex_);
+    WaitUntilStageable(&lock, root_path);
+  }
+  StagingBuffer buffer = AcquireBuffer(size);
+  if (size > 0) { memcpy(buffer.data.get(), data, size); }
+  // the snapshot is found and appended to under one lock, so that a file is either staged before
+  // the snapshot is committed or into a new one after it is written
+  std::unique_lock<std::mutex> lock(mutex_);
+  Snapshot* snapshot = WaitUntilStageable(&lock, root_path);
+  if (snapshot == nullptr) {
+    snapshots_.emplace_back(new Snapshot{root_path, SnapshotFS() == LocalFS(), {}, false, 0});
+    snapshot = snapshots_.back().get();
+  }
+  snapshot->files.push_back(StagedFile{JoinPath(root_path, key), std::move(buffer), size});
+}
+
+void AsyncSnapshotWriter::Commit(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  Snapshot* snapshot = FindSnapshot(root_path, false);
+  CHECK(snapshot != nullptr) << "no snapshot staged, path: " << root_path;
+  snapshot->is_committed = true;
+  snapshot->remaining_file_num = snapshot->files.size();
+  if (snapshot->files.empty()) {
+    io_thread_pool_.AddWork([this, snapshot]() { Finish(snapshot); });
+    return;
+  }
+  for (const StagedFile& file : snapshot->files) {
+    io_thread_pool_.AddWork([this, snapshot, &file]() {
+      WriteFile(*snapshot, file);
+      bool is_last = false;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        snapshot->remaining_file_num -= 1;
+        is_last = snapshot->remaining_file_num == 0;
+      }
+      if (is_last) { Finish(snapshot); }
+    });
+  }
+}
+
+void AsyncSnapshotWriter::WriteFile(const Snapshot& snapshot, const StagedFile& file) {
+  if (snapshot.use_direct_io) {
+    WriteLocalFile(file.path, file.buffer.data.get(), file.size);
+  } else {
+    std::unique_ptr<fs::WritableFile> out;
+    SnapshotFS()->NewWritableFile(file.path, &out);
+    if (file.size > 0) { out->Append(file.buffer.data.get(), file.size); }
+    out->Close();
+  }
+}
+
+void AsyncSnapshotWriter::Finish(Snapshot* snapshot) {
+  PublishSnapshotDone(snapshot->root_path);
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (StagedFile& file : snapshot->files) { free_buffers_.push_back(std::move(file.buffer)); }
+  snapshots_.remove_if(
+      [snapshot](const std::unique_ptr<Snapshot>& ptr) { return ptr.get() == snapshot; });
+  cond_.notify_all();
+}
+
+void AsyncSnapshotWriter::WaitUntilDone(const std::string& root_path) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [&]() { return FindSnapshot(root_path, true) == nullptr; });
+}
+
+void AsyncSnapshotWriter::WaitUntilAllDone() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() {
+    return std::none_of(snapshots_.begin(), snapshots_.end(),
+                        [](const std::unique_ptr<Snapshot>& snapshot) {
+                          return snapshot->is_committed;
+                        });
+  });
+}
+
+void PublishSnapshotDone(const std::string& snapshot_root_path) {
+  const std::string tmp_path = JoinPath(snapshot_root_path, "snapshot_done.tmp");
+  std::unique_ptr<fs::WritableFile> out;
+  SnapshotFS()->NewWritableFile(tmp_path, &out);
+  out->Close();
+  SnapshotFS()->RenameFile(tmp_path, JoinPath(snapshot_root_path, "snapshot_done"));
+}
+
+}  // namespace oneflow
@@ -0,0 +1,91 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+#define ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+// Writes snapshots on background io threads. The files of a snapshot are staged by copying their
+// data into staging buffers, which is all the caller waits for, and are written in parallel once
+// the snapshot is committed. Files on the local file system are written with O_DIRECT in large
+// aligned writes. snapshot_done is renamed into place after all the files are written, so a
+// snapshot with snapshot_done is complete.
+//
+// The staging buffers are double-buffered: up to two snapshots are staged or being written at a
+// time, and staging a third one waits until the earliest one is written. The buffers of a written
+// snapshot are reused by the following ones.
+class AsyncSnapshotWriter final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(AsyncSnapshotWriter);
+  AsyncSnapshotWriter() = delete;
+  explicit AsyncSnapshotWriter(int64_t io_thread_num);
+  // waits until the committed snapshots are written
+  ~AsyncSnapshotWriter();
+
+  // Stages a file into the snapshot of root_path. If the snapshot of root_path is committed, e.g.
+  // by an earlier save to the same path, the file is staged into a new one after it is written.
+  // It is safe to stage files of a snapshot from multiple threads.
+  void Stage(const std::string& root_path, const std::string& key, const char* data, size_t size);
+  // The files staged are final after the snapshot is committed
+  void Commit(const std::string& root_path);
+  // Waits until the snapshot of root_path is written if it is committed
+  void WaitUntilDone(const std::string& root_path);
+  void WaitUntilAllDone();
+
+ private:
+  struct StagingBuffer {
+    std::unique_ptr<char, decltype(&free)> data;
+    size_t capacity;
+  };
+  struct StagedFile {
+    std::string path;
+    StagingBuffer buffer;
+    size_t size;
+  };
+  struct Snapshot {
+    std::string root_path;
+    bool use_direct_io;
+    std::vector<StagedFile> files;
+    bool is_committed;
+    int64_t remaining_file_num;
+  };
+
+  Snapshot* FindSnapshot(const std::string& root_path, bool is_committed);
+  // Waits until the snapshot of root_path is being staged, which is returned, or another one can
+  // be, then nullptr is returned. A committed snapshot of root_path is waited for until written.
+  Snapshot* WaitUntilStageable(std::unique_lock<std::mutex>* lock, const std::string& root_path);
+  StagingBuffer AcquireBuffer(size_t size);
+  void WriteFile(const Snapshot& snapshot, const StagedFile& file);
+  // publishes the snapshot after its files are written and releases its buffers
+  void Finish(Snapshot* snapshot);
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::list<std::unique_ptr<Snapshot>> snapshots_;
+  std::vector<StagingBuffer> free_buffers_;
+  ThreadPool io_thread_pool_;
+};
+
+// Publishes a snapshot whose files are all written, by renaming a written snapshot_done.tmp to
+// snapshot_done
+void PublishSnapshotDone(const std::string& snapshot_root_path);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_ASYNC_SNAPSHOT_WRITER_H_
@@ -0,0 +1,148 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+TEST(AsyncSnapshotWriter, write) {
+  IOConf io_conf;
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  // sizes around the direct io alignment and larger than a write chunk
+  std::vector<std::string> contents;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis('a', 'z');
+  for (size_t size : {0, 1, 4095, 4096, 4097, 9 << 20}) {
+    std::string content(size, 'a');
+    for (char& c : content) { c = static_cast<char>(dis(gen)); }
+    contents.push_back(content);
+  }
+  std::vector<std::string> root_paths;
+  FOR_RANGE(int, i, 0, 3) {
+    root_paths.push_back(JoinPath(current_dir, "tmp_async_snapshot_" + std::to_string(i)));
+    LocalFS()->CreateDirIfNotExist(root_paths.back());
+  }
+  {
+    AsyncSnapshotWriter writer(2);
+    // the third snapshot is staged after the first one is written
+    for (const std::string& root_path : root_paths) {
+      FOR_RANGE(size_t, i, 0, contents.size()) {
+        writer.Stage(root_path, "key_" + std::to_string(i), contents.at(i).data(),
+                     contents.at(i).size());
+      }
+      writer.Commit(root_path);
+    }
+    writer.WaitUntilDone(root_paths.front());
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root_paths.front(), "snapshot_done")));
+  }
+  for (const std::string& root_path : root_paths) {
+    ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root_path, "snapshot_done")));
+    ASSERT_FALSE(LocalFS()->FileExists(JoinPath(root_path, "snapshot_done.tmp")));
+    FOR_RANGE(size_t, i, 0, contents.size()) {
+      ASSERT_EQ(ReadFile(JoinPath(root_path, "key_" + std::to_string(i))), contents.at(i));
+    }
+    LocalFS()->RecursivelyDeleteDir(root_path);
+  }
+  Global<const IOConf>::Delete();
+}
+
+TEST(AsyncSnapshotWriter, stage_from_multiple_threads) {
+  IOConf io_conf;
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  const std::string root_path = JoinPath(current_dir, "tmp_async_snapshot_multi_thread");
+  LocalFS()->CreateDirIfNotExist(root_path);
+  const int64_t thread_num = 4;
+  const int64_t file_num_per_thread = 64;
+  {
+    AsyncSnapshotWriter writer(2);
+    std::vector<std::thread> threads;
+    FOR_RANGE(int64_t, i, 0, thread_num) {
+      threads.emplace_back([&writer, &root_path, i]() {
+        FOR_RANGE(int64_t, j, 0, file_num_per_thread) {
+          const std::string key = std::to_string(i) + "_" + std::to_string(j);
+          writer.Stage(root_path, key, key.data(), key.size());
+        }
+      });
+    }
+    for (std::thread& thread : threads) { thread.join(); }
+    writer.Commit(root_path);
+    writer.WaitUntilDone(root_path);
+  }
+  ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root_path, "snapshot_done")));
+  FOR_RANGE(int64_t, i, 0, thread_num) {
+    FOR_RANGE(int64_t, j, 0, file_num_per_thread) {
+      const std::string key = std::to_string(i) + "_" + std::to_string(j);
+      ASSERT_EQ(ReadFile(JoinPath(root_path, key)), key);
+    }
+  }
+  LocalFS()->RecursivelyDeleteDir(root_path);
+  Global<const IOConf>::Delete();
+}
+
+TEST(AsyncSnapshotWriter, save_again_to_the_same_path) {
+  IOConf io_conf;
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  const std::string root_path = JoinPath(current_dir, "tmp_async_snapshot_save_again");
+  LocalFS()->CreateDirIfNotExist(root_path);
+  const int64_t save_num = 3;
+  const int64_t file_num = 4;
+  auto Content = [](int64_t save, int64_t i) {
+    return std::string((9 << 20) + i, static_cast<char>('a' + save));
+  };
+  {
+    AsyncSnapshotWriter writer(2);
+    // every save is staged while the files of the one before are likely still written
+    FOR_RANGE(int64_t, save, 0, save_num) {
+      FOR_RANGE(int64_t, i, 0, file_num) {
+        const std::string content = Content(save, i);
+        writer.Stage(root_path, "key_" + std::to_string(i), content.data(), content.size());
+      }
+      writer.Commit(root_path);
+    }
+    writer.WaitUntilDone(root_path);
+  }
+  ASSERT_TRUE(LocalFS()->FileExists(JoinPath(root_path, "snapshot_done")));
+  FOR_RANGE(int64_t, i, 0, file_num) {
+    ASSERT_TRUE(ReadFile(JoinPath(root_path, "key_" + std::to_string(i)))
+                == Content(save_num - 1, i));
+  }
+  LocalFS()->RecursivelyDeleteDir(root_path);
+  Global<const IOConf>::Delete();
+}
+
+}  // namespace oneflow
@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/persistence/mapped_in_stream.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace oneflow {
+
+namespace {
+
+// how far ahead of the reading position the pages are advised to be read
+constexpr size_t kWillNeedByteSize = 32 << 20;
+
+}  // namespace
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) { PCHECK(munmap(data_, size_) == 0); }
+}
+
+MappedFile::MappedFile(const std::string& file_path) : data_(nullptr), size_(0) {
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  PCHECK(fd != -1) << file_path;
+  struct stat st;
+  PCHECK(fstat(fd, &st) == 0) << file_path;
+  size_ = st.st_size;
+  if (size_ > 0) {
+    // private, so that the readers may write to the views like to any other buffer
+    void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    PCHECK(ptr != MAP_FAILED) << file_path;
+    data_ = static_cast<char*>(ptr);
+    PCHECK(madvise(data_, size_, MADV_SEQUENTIAL) == 0);
+  }
+  PCHECK(close(fd) == 0);
+}
+
+void MappedFile::WillNeed(size_t offset, size_t size) const {
+  CHECK_LE(offset + size, size_);
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t aligned_offset = offset / page_size * page_size;
+  PCHECK(madvise(data_ + aligned_offset, offset + size - aligned_offset, MADV_WILLNEED) == 0);
+}
+
+MappedInStream::MappedInStream(const std::vector<std::string>& file_paths, bool cyclic)
+    : file_paths_(file_paths), cyclic_(cyclic) {
+  CHECK(!file_paths_.empty());
+  OpenFile(0);
+}
+
+int32_t MappedInStream::ReadFully(char* s, size_t n) {
+  CHECK(s != nullptr);
+  return Read(s, n);
+}
+
+int32_t MappedInStream::ReadView(size_t n, char** ptr,
+                                 std::shared_ptr<const MappedFile>* mapped_file) {
+  if (IsEof()) { return -1; }
+  CHECK_LE(cur_pos_ + n, cur_file_->size()) << file_paths_.at(cur_file_idx_) << " ends in a view";
+  *ptr = cur_file_->data() + cur_pos_;
+  *mapped_file = cur_file_;
+  AdvanceBy(n);
+  return 0;
+}
+
+int32_t MappedInStream::Skip(size_t n) { return Read(nullptr, n); }
+
+int32_t MappedInStream::Read(char* s, size_t n) {
+  if (IsEof()) { return -1; }
+  while (n > 0) {
+    CHECK(!IsEof());
+    const size_t copy_size = std::min(n, cur_file_->size() - cur_pos_);
+    if (s != nullptr) {
+      memcpy(s, cur_file_->data() + cur_pos_, copy_size);
+      s += copy_size;
+    }
+    AdvanceBy(copy_size);
+    n -= copy_size;
+  }
+  return 0;
+}
+
+bool MappedInStream::IsEof() {
+  // moves on to the next file with anything left to read
+  FOR_RANGE(size_t, i, 0, file_paths_.size() + 1) {
+    if (cur_pos_ < cur_file_->size()) { return false; }
+    if (cur_file_idx_ + 1 < static_cast<int64_t>(file_paths_.size())) {
+      OpenFile(cur_file_idx_ + 1);
+    } else if (cyclic_) {
+      OpenFile(0);
+    } else {
+      return true;
+    }
+  }
+  LOG(FATAL) << "all the files are empty";
+  return true;
+}
+
+void MappedInStream::OpenFile(int64_t file_idx) {
+  cur_file_idx_ = file_idx;
+  cur_file_.reset(new MappedFile(file_paths_.at(file_idx)));
+  cur_pos_ = 0;
+  will_need_end_ = 0;
+  AdvanceBy(0);
+}
+
+void MappedInStream::AdvanceBy(size_t n) {
+  cur_pos_ += n;
+  CHECK_LE(cur_pos_, cur_file_->size());
+  // advise the next window once half of the advised pages ahead are read
+  if (will_need_end_ < cur_file_->size() && cur_pos_ + kWillNeedByteSize / 2 >= will_need_end_) {
+    const size_t will_need_end = std::min(cur_file_->size(), cur_pos_ + kWillNeedByteSize);
+    cur_file_->WillNeed(will_need_end_, will_need_end - will_need_end_);
+    will_need_end_ = will_need_end;
+  }
+}
+
+}  // namespace oneflow
@@ -0,0 +1,77 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_PERSISTENCE_MAPPED_IN_STREAM_H_
+#define ONEFLOW_CORE_PERSISTENCE_MAPPED_IN_STREAM_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A whole local file mapped copy-on-write, writing to it never reaches the file.
+class MappedFile final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MappedFile);
+  MappedFile() = delete;
+  ~MappedFile();
+
+  explicit MappedFile(const std::string& file_path);
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+  // madvise(MADV_WILLNEED) on the pages of [offset, offset + size)
+  void WillNeed(size_t offset, size_t size) const;
+
+ private:
+  char* data_;
+  size_t size_;
+};
+
+// Reads local files one after another like PersistentInStream, but through mappings. ReadView
+// hands out a pointer into the mapping instead of copying, together with the mapping it points
+// into, which stays mapped as long as anybody holds it. A view never spans two files.
+class MappedInStream final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MappedInStream);
+  MappedInStream() = delete;
+  ~MappedInStream() = default;
+
+  MappedInStream(const std::vector<std::string>& file_paths, bool cyclic);
+
+  // 0: success
+  // -1: eof
+  int32_t ReadFully(char* s, size_t n);
+  int32_t ReadView(size_t n, char** ptr, std::shared_ptr<const MappedFile>* mapped_file);
+  int32_t Skip(size_t n);
+
+ private:
+  bool IsEof();
+  void OpenFile(int64_t file_idx);
+  // copies the next n bytes to s unless it is nullptr
+  int32_t Read(char* s, size_t n);
+  void AdvanceBy(size_t n);
+
+  std::vector<std::string> file_paths_;
+  bool cyclic_;
+  int64_t cur_file_idx_;
+  std::shared_ptr<const MappedFile> cur_file_;
+  size_t cur_pos_;
+  // the pages before are advised to be read ahead
+  size_t will_need_end_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_PERSISTENCE_MAPPED_IN_STREAM_H_
@@ -0,0 +1,87 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/persistence/mapped_in_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// records of an int64 size followed by the record, one file is empty
+std::vector<std::string> WriteTestFiles(std::vector<std::string>* records) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  std::vector<std::string> file_paths;
+  const std::vector<int64_t> record_nums = {100, 0, 7};
+  FOR_RANGE(size_t, i, 0, record_nums.size()) {
+    file_paths.push_back(JoinPath(current_dir, "/tmp_mapped_in_stream_" + std::to_string(i)));
+    std::unique_ptr<fs::WritableFile> file;
+    LocalFS()->NewWritableFile(file_paths.back(), &file);
+    FOR_RANGE(int64_t, j, 0, record_nums.at(i)) {
+      records->push_back(std::string(j * 37 % 5000, static_cast<char>('a' + j % 26)));
+      const int64_t size = records->back().size();
+      file->Append(reinterpret_cast<const char*>(&size), sizeof(size));
+      file->Append(records->back().data(), size);
+    }
+    file->Close();
+  }
+  return file_paths;
+}
+
+}  // namespace
+
+TEST(MappedInStream, read_view) {
+  std::vector<std::string> records;
+  const std::vector<std::string> file_paths = WriteTestFiles(&records);
+  std::vector<char*> views;
+  std::vector<std::shared_ptr<const MappedFile>> mapped_files;
+  {
+    MappedInStream in_stream(file_paths, false);
+    int64_t size = 0;
+    while (in_stream.ReadFully(reinterpret_cast<char*>(&size), sizeof(size)) == 0) {
+      char* view = nullptr;
+      std::shared_ptr<const MappedFile> mapped_file;
+      ASSERT_EQ(in_stream.ReadView(size, &view, &mapped_file), 0);
+      views.push_back(view);
+      mapped_files.push_back(mapped_file);
+    }
+    ASSERT_EQ(in_stream.Skip(1), -1);
+  }
+  // the views outlive the stream
+  ASSERT_EQ(views.size(), records.size());
+  FOR_RANGE(size_t, i, 0, records.size()) {
+    ASSERT_EQ(std::string(views.at(i), records.at(i).size()), records.at(i));
+  }
+  // writing to a view never reaches the file
+  if (!records.back().empty()) { views.back()[0] = '#'; }
+  mapped_files.clear();
+  {
+    MappedInStream in_stream(file_paths, true);
+    FOR_RANGE(size_t, i, 0, 2 * records.size()) {
+      int64_t size = 0;
+      ASSERT_EQ(in_stream.ReadFully(reinterpret_cast<char*>(&size), sizeof(size)), 0);
+      std::string record(size, '\0');
+      ASSERT_EQ(in_stream.ReadFully(&record[0], size), 0);
+      ASSERT_EQ(record, records.at(i % records.size()));
+    }
+  }
+  for (const std::string& file_path : file_paths) { LocalFS()->DelFile(file_path); }
+}
+
+}  // namespace oneflow
@@ -39,6 +39,18 @@ size_t GetBufferSize(int64_t session_id) {
 
 }  // namespace
 
+PersistentInStream::~PersistentInStream() {
+  if (!read_ahead_thread_.joinable()) { return; }
+  // the read-ahead thread stops once it can not hand over its buffer
+  filled_buffers_.Close();
+  free_buffers_.Close();
+  read_ahead_thread_.join();
+  LOG(INFO) << "PersistentInStream read bytes: " << stats_.byte_cnt
+            << " buffer updates: " << stats_.buffer_update_cnt
+            << " stall ms: " << stats_.stall_nanos / 1000000 << " average queue depth: "
+            << stats_.queue_depth_sum / std::max<double>(stats_.buffer_update_cnt, 1);
+}
+
 PersistentInStream::PersistentInStream(fs::FileSystem* fs,
                                        const std::vector<std::string>& file_paths, uint64_t offset,
                                        bool cyclic, bool with_local_copy)
@@ -61,7 +73,26 @@ PersistentInStream::PersistentInStream(int64_t session_id, fs::FileSystem* fs,
   } else {
     stream_scanner_.reset(new AcyclicStreamScanner(fs, streams, offset));
   }
-  buffer_.resize(GetBufferSize(session_id) + 1);
+  memset(&stats_, 0, sizeof(stats_));
+  filled_buffer_cnt_ = 0;
+  cur_read_ahead_buffer_ = nullptr;
+  read_ahead_eof_ = false;
+  const auto& io_conf = *Global<const IOConf>::Get(session_id);
+  const int64_t read_ahead_buffer_num = io_conf.persistence_read_ahead_buffer_num();
+  CHECK_GE(read_ahead_buffer_num, 0);
+  if (read_ahead_buffer_num > 0) {
+    CHECK_GT(io_conf.persistence_read_ahead_buf_byte(), 0);
+    FOR_RANGE(int64_t, i, 0, read_ahead_buffer_num) {
+      read_ahead_buffers_.emplace_back(new ReadAheadBuffer);
+      read_ahead_buffers_.back()->data.resize(io_conf.persistence_read_ahead_buf_byte() + 1);
+      CHECK_EQ(free_buffers_.Send(read_ahead_buffers_.back().get()), kChannelStatusSuccess);
+    }
+    read_ahead_thread_ = std::thread(&PersistentInStream::ReadAhead, this);
+    // the read-ahead buffers take its place
+    buffer_.resize(1);
+  } else {
+    buffer_.resize(GetBufferSize(session_id) + 1);
+  }
   cur_buf_begin_ = buffer_.data();
   cur_buf_end_ = buffer_.data();
   *cur_buf_end_ = '\0';
@@ -122,13 +153,54 @@ int32_t PersistentInStream::ReadFully(char* s, size_t n) {
 
 void PersistentInStream::UpdateBuffer() {
   CHECK_EQ(cur_buf_begin_, cur_buf_end_);
-  uint64_t n = stream_scanner_->UpdateBuffer(&buffer_);
-  cur_buf_begin_ = buffer_.data();
-  cur_buf_end_ = buffer_.data() + n;
+  if (read_ahead_thread_.joinable()) {
+    if (read_ahead_eof_) { return; }
+    UpdateReadAheadBuffer();
+  } else {
+    const double start = GetCurTime();
+    uint64_t n = stream_scanner_->UpdateBuffer(&buffer_);
+    stats_.stall_nanos += GetCurTime() - start;
+    cur_buf_begin_ = buffer_.data();
+    cur_buf_end_ = buffer_.data() + n;
+    *cur_buf_end_ = '\0';
+  }
+  stats_.byte_cnt += cur_buf_end_ - cur_buf_begin_;
+  stats_.buffer_update_cnt += 1;
+}
+
+void PersistentInStream::UpdateReadAheadBuffer() {
+  if (cur_read_ahead_buffer_ != nullptr) {
+    CHECK_EQ(free_buffers_.Send(cur_read_ahead_buffer_), kChannelStatusSuccess);
+  }
+  stats_.queue_depth_sum += filled_buffer_cnt_.load();
+  const double start = GetCurTime();
+  CHECK_EQ(filled_buffers_.Receive(&cur_read_ahead_buffer_), kChannelStatusSuccess);
+  stats_.stall_nanos += GetCurTime() - start;
+  filled_buffer_cnt_ -= 1;
+  read_ahead_eof_ = cur_read_ahead_buffer_->is_last;
+  cur_buf_begin_ = cur_read_ahead_buffer_->data.data();
+  cur_buf_end_ = cur_buf_begin_ + cur_read_ahead_buffer_->size;
   *cur_buf_end_ = '\0';
 }
 
-bool PersistentInStream::IsEof() const {
-  return cur_buf_begin_ == cur_buf_end_ && stream_scanner_->IsEof();
+void PersistentInStream::ReadAhead() {
+  ReadAheadBuffer* buffer = nullptr;
+  while (free_buffers_.Receive(&buffer) == kChannelStatusSuccess) {
+    buffer->size = stream_scanner_->UpdateBuffer(&buffer->data);
+    buffer->is_last = stream_scanner_->IsEof();
+    filled_buffer_cnt_ += 1;
+    if (filled_buffers_.Send(buffer) != kChannelStatusSuccess) { return; }
+    if (buffer->is_last) { return; }
+  }
+}
+
+bool PersistentInStream::IsEof() {
+  if (cur_buf_begin_ != cur_buf_end_) { return false; }
+  if (read_ahead_thread_.joinable()) {
+    // the stream scanner belongs to the read-ahead thread, the next buffer tells
+    UpdateBuffer();
+    return cur_buf_begin_ == cur_buf_end_ && read_ahead_eof_;
+  }
+  return stream_scanner_->IsEof();
 }
 }  // namespace oneflow
@@ -18,12 +18,23 @@ limitations under the License.
 
 #include "oneflow/core/persistence/file_system.h"
 #include "oneflow/core/persistence/stream_scanner.h"
+#include "oneflow/core/common/channel.h"
 
 namespace oneflow {
 
+struct PersistentInStreamStats {
+  int64_t byte_cnt;
+  int64_t buffer_update_cnt;
+  // time the reader waited for the next buffer
+  int64_t stall_nanos;
+  // sum of the filled buffers waiting at each buffer update, always 0 without read-ahead
+  int64_t queue_depth_sum;
+};
+
 class PersistentInStream {
  public:
   OF_DISALLOW_COPY_AND_MOVE(PersistentInStream);
+  ~PersistentInStream();
 
   PersistentInStream(fs::FileSystem* fs, const std::vector<std::string>& file_paths,
                      uint64_t offset, bool cyclic, bool with_local_copy);
@@ -44,15 +55,37 @@ class PersistentInStream {
   int32_t ReadLine(std::string* l);
   int32_t ReadFully(char* s, size_t n);
 
+  const PersistentInStreamStats& stats() const { return stats_; }
+
  private:
-  bool IsEof() const;
+  struct ReadAheadBuffer {
+    std::vector<char> data;
+    size_t size;
+    // the stream scanner is at eof after this buffer
+    bool is_last;
+  };
+
+  bool IsEof();
   void UpdateBuffer();
+  void UpdateReadAheadBuffer();
+  void ReadAhead();
 
   std::unique_ptr<StreamScanner> stream_scanner_;
 
   std::vector<char> buffer_;
   char* cur_buf_begin_;
   char* cur_buf_end_;
+
+  // the stream scanner belongs to read_ahead_thread_ if there are read-ahead buffers
+  std::vector<std::unique_ptr<ReadAheadBuffer>> read_ahead_buffers_;
+  Channel<ReadAheadBuffer*> free_buffers_;
+  Channel<ReadAheadBuffer*> filled_buffers_;
+  std::atomic<int64_t> filled_buffer_cnt_;
+  ReadAheadBuffer* cur_read_ahead_buffer_;
+  bool read_ahead_eof_;
+  std::thread read_ahead_thread_;
+
+  PersistentInStreamStats stats_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,120 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+
+#include <fcntl.h>
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+// a shard of OFRecord chunks, an int64 size followed by the serialized record
+std::string WriteShard(int64_t shard_mbyte, int64_t record_kbyte) {
+  const std::string shard_path = "/tmp/persistent_in_stream_benchmark_shard";
+  std::unique_ptr<fs::WritableFile> file;
+  LocalFS()->NewWritableFile(shard_path, &file);
+  std::vector<char> record(record_kbyte << 10);
+  std::mt19937 gen(0);
+  for (char& c : record) { c = static_cast<char>(gen()); }
+  const int64_t record_size = record.size();
+  FOR_RANGE(int64_t, i, 0, (shard_mbyte << 20) / (record_size + sizeof(int64_t))) {
+    file->Append(reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+    file->Append(record.data(), record.size());
+  }
+  file->Close();
+  return shard_path;
+}
+
+// so that every run reads from the disk, as far as the kernel allows
+void DropPageCache(const std::vector<std::string>& file_paths) {
+  for (const std::string& file_path : file_paths) {
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    PCHECK(fd != -1);
+    PCHECK(fdatasync(fd) == 0);
+    CHECK_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), 0);
+    PCHECK(close(fd) == 0);
+  }
+}
+
+void BusyWait(int64_t micros) {
+  const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+  while (std::chrono::steady_clock::now() < end) {}
+}
+
+// reads the records like ReadChunk of the OFRecord reader and spends decode_us on each of them
+void BenchmarkReadAhead(const std::vector<std::string>& file_paths, int64_t read_ahead_buffer_num,
+                        int64_t read_ahead_buf_kbyte, int64_t decode_us) {
+  IOConf io_conf;
+  io_conf.set_persistence_read_ahead_buffer_num(read_ahead_buffer_num);
+  io_conf.set_persistence_read_ahead_buf_byte(read_ahead_buf_kbyte << 10);
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+  DropPageCache(file_paths);
+  const auto start = std::chrono::steady_clock::now();
+  int64_t record_num = 0;
+  PersistentInStreamStats stats;
+  {
+    PersistentInStream in_stream(LocalFS(), file_paths, false, false);
+    int64_t record_size = 0;
+    std::vector<char> record;
+    while (in_stream.ReadFully(reinterpret_cast<char*>(&record_size), sizeof(record_size)) == 0) {
+      record.resize(record_size);
+      CHECK_EQ(in_stream.ReadFully(record.data(), record_size), 0);
+      BusyWait(decode_us);
+      ++record_num;
+    }
+    stats = in_stream.stats();
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  Global<const IOConf>::Delete();
+  std::cout << "read_ahead_buffer_num: " << read_ahead_buffer_num
+            << " records/s: " << record_num / seconds
+            << " MB/s: " << stats.byte_cnt / seconds / (1 << 20)
+            << " stall ms: " << stats.stall_nanos / 1e6 << " average queue depth: "
+            << stats.queue_depth_sum / std::max<double>(stats.buffer_update_cnt, 1) << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_string(data_paths, "", "comma separated OFRecord shards, a shard is generated if empty");
+DEFINE_int64(shard_mbyte, 512, "size of the generated shard");
+DEFINE_int64(record_kbyte, 110, "size of the records in the generated shard");
+DEFINE_int64(decode_us, 200, "time spent on every record after it is read");
+DEFINE_int64(read_ahead_buffer_num, 4, "number of read-ahead buffers");
+DEFINE_int64(read_ahead_buf_kbyte, 4096, "size of every read-ahead buffer");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(2);
+  std::vector<std::string> file_paths;
+  if (FLAGS_data_paths.empty()) {
+    file_paths.push_back(WriteShard(FLAGS_shard_mbyte, FLAGS_record_kbyte));
+  } else {
+    Split(FLAGS_data_paths, ",", [&](std::string&& path) { file_paths.push_back(path); });
+  }
+  BenchmarkReadAhead(file_paths, 0, FLAGS_read_ahead_buf_kbyte, FLAGS_decode_us);
+  BenchmarkReadAhead(file_paths, FLAGS_read_ahead_buffer_num, FLAGS_read_ahead_buf_kbyte,
+                     FLAGS_decode_us);
+  if (FLAGS_data_paths.empty()) { LocalFS()->DelFile(file_paths.front()); }
+  return 0;
+}
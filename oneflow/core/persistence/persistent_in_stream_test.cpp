@@ -0,0 +1,106 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+
+namespace oneflow {
+
+namespace {
+
+// files of lines, the last one without a trailing newline
+std::vector<std::string> WriteTestFiles(fs::FileSystem* file_system, std::string* content) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  std::vector<std::string> file_paths;
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis('a', 'z');
+  const std::vector<int64_t> line_nums = {1000, 1, 3, 777};
+  FOR_RANGE(size_t, i, 0, line_nums.size()) {
+    std::string file_content;
+    FOR_RANGE(int64_t, j, 0, line_nums.at(i)) {
+      file_content += std::string(j % 97, static_cast<char>(dis(gen))) + "\n";
+    }
+    if (i + 1 == line_nums.size()) { file_content += "last"; }
+    file_paths.push_back(JoinPath(current_dir, "/tmp_persistent_in_stream_" + std::to_string(i)));
+    std::unique_ptr<fs::WritableFile> file;
+    file_system->NewWritableFile(file_paths.back(), &file);
+    file->Append(file_content.data(), file_content.size());
+    file->Close();
+    *content += file_content;
+  }
+  return file_paths;
+}
+
+void SetIOConf(int64_t read_ahead_buffer_num) {
+  IOConf io_conf;
+  io_conf.set_persistence_buf_byte(1000);
+  io_conf.set_persistence_read_ahead_buffer_num(read_ahead_buffer_num);
+  io_conf.set_persistence_read_ahead_buf_byte(3000);
+  Global<const IOConf>::Delete();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+}
+
+}  // namespace
+
+TEST(PersistentInStream, read_ahead) {
+  fs::FileSystem* file_system = LocalFS();
+  std::string content;
+  const std::vector<std::string> file_paths = WriteTestFiles(file_system, &content);
+  for (int64_t read_ahead_buffer_num : {0, 1, 4}) {
+    SetIOConf(read_ahead_buffer_num);
+    {
+      PersistentInStream in_stream(file_system, file_paths, false, false);
+      std::string read_content;
+      std::vector<char> buffer(13);
+      while (read_content.size() + buffer.size() <= content.size()) {
+        ASSERT_EQ(in_stream.ReadFully(buffer.data(), buffer.size()), 0);
+        read_content.append(buffer.data(), buffer.size());
+      }
+      const size_t rest_size = content.size() - read_content.size();
+      if (rest_size > 0) {
+        ASSERT_EQ(in_stream.ReadFully(buffer.data(), rest_size), 0);
+        read_content.append(buffer.data(), rest_size);
+      }
+      ASSERT_EQ(read_content, content);
+      ASSERT_EQ(in_stream.ReadFully(buffer.data(), 1), -1);
+      ASSERT_EQ(in_stream.stats().byte_cnt, static_cast<int64_t>(content.size()));
+    }
+    {
+      PersistentInStream in_stream(file_system, file_paths, false, false);
+      std::string read_content;
+      std::string line;
+      while (in_stream.ReadLine(&line) == 0) { read_content += line + "\n"; }
+      ASSERT_EQ(read_content, content + "\n");
+    }
+    {
+      // a cyclic stream wraps around and stops reading ahead when it is destroyed mid-way
+      PersistentInStream in_stream(file_system, file_paths, true, false);
+      std::vector<char> buffer(content.size());
+      FOR_RANGE(int, i, 0, 2) {
+        ASSERT_EQ(in_stream.ReadFully(buffer.data(), buffer.size()), 0);
+        ASSERT_EQ(std::string(buffer.data(), buffer.size()), content);
+      }
+      ASSERT_EQ(in_stream.ReadFully(buffer.data(), 5), 0);
+    }
+  }
+  Global<const IOConf>::Delete();
+  for (const std::string& file_path : file_paths) { file_system->DelFile(file_path); }
+}
+
+}  // namespace oneflow
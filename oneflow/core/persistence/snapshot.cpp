@@ -14,24 +14,102 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/persistence/async_snapshot_writer.h"
 #include "oneflow/core/common/str_util.h"
-#include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
-#include "oneflow/core/register/tensor_slice_copier.h"
-#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/thread/thread_manager.h"
 
 namespace oneflow {
 
 namespace {
 
+// a blob is read in chunks of up to kReadChunkByte in parallel
+constexpr int64_t kReadChunkByte = 4 * 1024 * 1024;
+// a chunk reads over a gap of up to kMaxReadGapByte between two runs rather than being split
+constexpr int64_t kMaxReadGapByte = 64 * 1024;
+
 std::string GenDataFilePath(const std::string& root, const std::string& key) {
   return JoinPath(root, key);
 }
 
+// bytes of a slice contiguous in the file of the blob, and their offset in the slice
+struct SliceRun {
+  int64_t file_offset;
+  int64_t dst_offset;
+  int64_t size;
+};
+
+// runs of a chunk, read together from [file_offset, file_offset + size) of the file
+struct ReadChunk {
+  int64_t file_offset;
+  int64_t size;
+  size_t run_begin;
+  size_t run_end;
+};
+
+// The runs of the slice of a row-major blob in the order of the slice, none larger than a chunk
+std::vector<SliceRun> GetSliceRuns(const Shape& logical_blob_shape, const TensorSliceView& slice,
+                                   int64_t elem_size) {
+  const int64_t num_axes = slice.NumAxes();
+  // a scalar is one run of one element
+  if (num_axes == 0) { return {SliceRun{0, 0, elem_size}}; }
+  // the axes after run_axis are covered by the slice, so a run spans the range of run_axis
+  int64_t run_axis = num_axes - 1;
+  while (run_axis > 0 && slice.At(run_axis).size() == logical_blob_shape.At(run_axis)) {
+    run_axis -= 1;
+  }
+  const int64_t run_size =
+      slice.At(run_axis).size() * logical_blob_shape.Count(run_axis + 1) * elem_size;
+  const int64_t run_num = slice.shape().Count(0, run_axis);
+  std::vector<SliceRun> runs;
+  std::vector<int64_t> index(run_axis, 0);
+  FOR_RANGE(int64_t, i, 0, run_num) {
+    int64_t file_elem_offset = slice.At(run_axis).begin() * logical_blob_shape.Count(run_axis + 1);
+    FOR_RANGE(int64_t, axis, 0, run_axis) {
+      file_elem_offset +=
+          (slice.At(axis).begin() + index.at(axis)) * logical_blob_shape.Count(axis + 1);
+    }
+    for (int64_t offset = 0; offset < run_size; offset += kReadChunkByte) {
+      runs.push_back(SliceRun{file_elem_offset * elem_size + offset, i * run_size + offset,
+                              std::min(kReadChunkByte, run_size - offset)});
+    }
+    for (int64_t axis = run_axis - 1; axis >= 0; --axis) {
+      index.at(axis) += 1;
+      if (index.at(axis) < slice.At(axis).size()) { break; }
+      index.at(axis) = 0;
+    }
+  }
+  return runs;
+}
+
+std::vector<ReadChunk> GroupSliceRuns(const std::vector<SliceRun>& runs) {
+  std::vector<ReadChunk> chunks;
+  FOR_RANGE(size_t, i, 0, runs.size()) {
+    const SliceRun& run = runs.at(i);
+    if (!chunks.empty()) {
+      ReadChunk* chunk = &chunks.back();
+      const int64_t chunk_end = chunk->file_offset + chunk->size;
+      if (run.file_offset >= chunk_end && run.file_offset - chunk_end <= kMaxReadGapByte
+          && run.file_offset + run.size - chunk->file_offset <= kReadChunkByte) {
+        chunk->size = run.file_offset + run.size - chunk->file_offset;
+        chunk->run_end = i + 1;
+        continue;
+      }
+    }
+    chunks.push_back(ReadChunk{run.file_offset, run.size, i, i + 1});
+  }
+  return chunks;
+}
+
 }  // namespace
 
 SnapshotReader::SnapshotReader(const std::string& snapshot_root_path)
-    : root_path_(snapshot_root_path) {}
+    : root_path_(snapshot_root_path) {
+  // the snapshot may still be being written in the background
+  if (Global<AsyncSnapshotWriter>::Get() != nullptr) {
+    Global<AsyncSnapshotWriter>::Get()->WaitUntilDone(snapshot_root_path);
+  }
+}
 
 bool SnapshotReader::HasKey(const std::string& key) const {
   const std::string path = GenDataFilePath(root_path_, key);
@@ -49,23 +127,32 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
   const TensorSliceView logical_blob_slice(logical_blob_shape);
   CHECK(logical_blob_slice.Contains(slice));
   const std::string path = GenDataFilePath(root_path_, key);
-  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * GetSizeOfDataType(data_type);
-  CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_size)
+  const int64_t elem_size = GetSizeOfDataType(data_type);
+  CHECK_EQ(SnapshotFS()->GetFileSize(path), logical_blob_shape.elem_cnt() * elem_size)
       << "unexpected model snapshot size, path: " << path;
-  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
-    PersistentInStream in_stream(
-        SnapshotFS(), path,
-        slice.At(0).begin() * slice.shape().Count(1) * GetSizeOfDataType(data_type));
-    in_stream.ReadFully(dst, slice.shape().elem_cnt() * GetSizeOfDataType(data_type));
-  } else {
-    std::vector<char> buffer(logical_blob_size);
-    PersistentInStream in_stream(SnapshotFS(), path);
-    in_stream.ReadFully(buffer.data(), logical_blob_size);
-    TensorSliceCopier copier(slice, logical_blob_slice, data_type);
-    CpuDeviceCtx device_ctx;
-    std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
-    copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
-  }
+  if (slice.shape().elem_cnt() == 0) { return; }
+  // only the bytes of the slice are read, by chunks in parallel
+  const std::vector<SliceRun> runs = GetSliceRuns(logical_blob_shape, slice, elem_size);
+  const std::vector<ReadChunk> chunks = GroupSliceRuns(runs);
+  std::unique_ptr<fs::RandomAccessFile> file;
+  SnapshotFS()->NewRandomAccessFile(path, &file);
+  MultiThreadLoop(chunks.size(), [&](size_t i) {
+    const ReadChunk& chunk = chunks.at(i);
+    const SliceRun& first_run = runs.at(chunk.run_begin);
+    const SliceRun& last_run = runs.at(chunk.run_end - 1);
+    // the runs of a chunk are consecutive in the slice, so without gaps they are read in place
+    if (last_run.dst_offset + last_run.size - first_run.dst_offset == chunk.size) {
+      file->Read(chunk.file_offset, chunk.size, dst + first_run.dst_offset);
+      return;
+    }
+    thread_local std::vector<char> buffer;
+    buffer.resize(chunk.size);
+    file->Read(chunk.file_offset, chunk.size, buffer.data());
+    FOR_RANGE(size_t, j, chunk.run_begin, chunk.run_end) {
+      const SliceRun& run = runs.at(j);
+      memcpy(dst + run.dst_offset, buffer.data() + run.file_offset - chunk.file_offset, run.size);
+    }
+  });
 }
 
 void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shape,
@@ -76,8 +163,9 @@ void SnapshotReader::Read(const std::string& key, const Shape& logical_blob_shap
 
 void SnapshotReader::Close() {}
 
-SnapshotWriter::SnapshotWriter(const std::string& snapshot_root_path)
-    : root_path_(snapshot_root_path) {
+SnapshotWriter::SnapshotWriter(const std::string& snapshot_root_path, bool async)
+    : root_path_(snapshot_root_path), async_(async) {
+  if (async_) { CHECK_NOTNULL(Global<AsyncSnapshotWriter>::Get()); }
   OfCallOnce("SnapshotWriteCheckRootPath-" + snapshot_root_path, [&]() {
     if (SnapshotFS()->FileExists(snapshot_root_path)) {
       CHECK(SnapshotFS()->IsDirectory(snapshot_root_path))
@@ -95,8 +183,12 @@ void SnapshotWriter::Write(const std::string& key, const char* data, size_t size
   const std::string dir_path = Dirname(path);
   SnapshotFS()->CreateDirIfNotExist(dir_path);
   CHECK(!SnapshotFS()->FileExists(path));
-  PersistentOutStream out_stream(SnapshotFS(), path);
-  out_stream.Write(data, size);
+  if (async_) {
+    Global<AsyncSnapshotWriter>::Get()->Stage(root_path_, key, data, size);
+  } else {
+    PersistentOutStream out_stream(SnapshotFS(), path);
+    out_stream.Write(data, size);
+  }
 }
 
 void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
@@ -104,7 +196,11 @@ void SnapshotWriter::Write(const std::string& key, const Blob* blob) {
 }
 
 void SnapshotWriter::Close() {
-  PersistentOutStream out_stream(SnapshotFS(), JoinPath(root_path_, "snapshot_done"));
+  if (async_) {
+    Global<AsyncSnapshotWriter>::Get()->Commit(root_path_);
+  } else {
+    PublishSnapshotDone(root_path_);
+  }
 }
 
 }  // namespace oneflow
@@ -47,7 +47,11 @@ class SnapshotWriter final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(SnapshotWriter);
   SnapshotWriter() = delete;
-  explicit SnapshotWriter(const std::string& snapshot_root_path);
+  // An async writer stages the data with Global<AsyncSnapshotWriter> and returns, Close() commits
+  // the snapshot to be written in the background
+  SnapshotWriter(const std::string& snapshot_root_path, bool async);
+  explicit SnapshotWriter(const std::string& snapshot_root_path)
+      : SnapshotWriter(snapshot_root_path, false) {}
   ~SnapshotWriter() = default;
 
   void Write(const std::string& key, const char* data, size_t size);
@@ -56,6 +60,7 @@ class SnapshotWriter final {
 
  private:
   const std::string root_path_;
+  const bool async_;
 };
 
 }  // namespace oneflow
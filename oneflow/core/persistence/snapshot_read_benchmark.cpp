@@ -0,0 +1,135 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/register/tensor_slice_copier.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+#include <fcntl.h>
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+// so that every run reads from the disk, as far as the kernel allows
+void DropPageCache(const std::string& file_path) {
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  PCHECK(fd != -1);
+  PCHECK(fdatasync(fd) == 0);
+  CHECK_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), 0);
+  PCHECK(close(fd) == 0);
+}
+
+// how a slice was loaded before: a range of rows is streamed, any other slice is copied out of
+// the whole blob
+void ReadByStream(const std::string& path, const Shape& logical_blob_shape,
+                  const TensorSliceView& slice, char* dst) {
+  if (slice.shape().Count(1) == logical_blob_shape.Count(1)) {
+    PersistentInStream in_stream(SnapshotFS(), path,
+                                 slice.At(0).begin() * slice.shape().Count(1) * sizeof(float));
+    in_stream.ReadFully(dst, slice.shape().elem_cnt() * sizeof(float));
+    return;
+  }
+  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * sizeof(float);
+  std::vector<char> buffer(logical_blob_size);
+  PersistentInStream in_stream(SnapshotFS(), path);
+  in_stream.ReadFully(buffer.data(), logical_blob_size);
+  TensorSliceCopier copier(slice, TensorSliceView(logical_blob_shape), DataType::kFloat);
+  CpuDeviceCtx device_ctx;
+  std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  copier.Copy(&device_ctx, *host_memory_copier, dst, buffer.data());
+}
+
+// the slices of parallel_num ranks splitting the blob on axis
+std::vector<TensorSliceView> SplitSlices(const Shape& shape, int64_t axis, int64_t parallel_num) {
+  std::vector<TensorSliceView> slices;
+  FOR_RANGE(int64_t, i, 0, parallel_num) {
+    std::vector<Range> ranges;
+    FOR_RANGE(int64_t, j, 0, shape.NumAxes()) { ranges.emplace_back(0, shape.At(j)); }
+    const int64_t part_size = shape.At(axis) / parallel_num;
+    ranges.at(axis) = Range(i * part_size, (i + 1) * part_size);
+    slices.emplace_back(ranges);
+  }
+  return slices;
+}
+
+// every rank loads its slice in turn, as the ranks of a machine share its disk
+void BenchmarkSlicedLoad(const std::string& root_path, const std::string& key, const Shape& shape,
+                         int64_t axis, int64_t parallel_num) {
+  const std::vector<TensorSliceView> slices = SplitSlices(shape, axis, parallel_num);
+  const std::string path = JoinPath(root_path, key);
+  SnapshotReader reader(root_path);
+  for (bool by_stream : {true, false}) {
+    DropPageCache(path);
+    const auto start = std::chrono::steady_clock::now();
+    for (const TensorSliceView& slice : slices) {
+      std::vector<char> dst(slice.shape().elem_cnt() * sizeof(float));
+      if (by_stream) {
+        ReadByStream(path, shape, slice, dst.data());
+      } else {
+        reader.Read(key, shape, DataType::kFloat, slice, dst.data());
+      }
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (by_stream ? "stream" : "chunked pread") << " split axis: " << axis
+              << " parallel_num: " << parallel_num << " load ms: " << seconds * 1e3
+              << " logical MB/s: " << shape.elem_cnt() * sizeof(float) / seconds / (1 << 20)
+              << std::endl;
+  }
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(rows, 1 << 16, "rows of the float blob");
+DEFINE_int64(cols, 4096, "cols of the float blob");
+DEFINE_int64(parallel_num, 8, "number of ranks the blob is split to");
+DEFINE_int64(thread_num, 8, "number of threads reading in parallel");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(2);
+  IOConf io_conf;
+  io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  io_conf.set_persistence_buf_byte(4 << 20);
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+  Global<ThreadPool>::New(FLAGS_thread_num);
+  const std::string root_path = "/tmp/snapshot_read_benchmark";
+  if (LocalFS()->IsDirectory(root_path)) { LocalFS()->RecursivelyDeleteDir(root_path); }
+  const Shape shape({FLAGS_rows, FLAGS_cols});
+  {
+    std::vector<float> blob(shape.elem_cnt());
+    std::mt19937 gen(0);
+    for (float& x : blob) { x = static_cast<float>(gen()); }
+    SnapshotWriter writer(root_path);
+    writer.Write("weight", reinterpret_cast<const char*>(blob.data()), blob.size() * sizeof(float));
+    writer.Close();
+  }
+  BenchmarkSlicedLoad(root_path, "weight", shape, 0, FLAGS_parallel_num);
+  BenchmarkSlicedLoad(root_path, "weight", shape, 1, FLAGS_parallel_num);
+  LocalFS()->RecursivelyDeleteDir(root_path);
+  Global<ThreadPool>::Delete();
+  Global<const IOConf>::Delete();
+  return 0;
+}
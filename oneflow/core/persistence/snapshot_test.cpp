@@ -0,0 +1,157 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/persistence/persistent_in_stream.h"
+#include "oneflow/core/persistence/snapshot.h"
+#include "oneflow/core/register/tensor_slice_copier.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+// the chunk and gap sizes of the slice reads in snapshot.cpp, in floats
+constexpr int64_t kReadChunkElemCnt = 4 * 1024 * 1024 / sizeof(float);
+constexpr int64_t kMaxReadGapElemCnt = 64 * 1024 / sizeof(float);
+
+// how a slice was loaded before: the whole blob is read and the slice copied out of it
+std::vector<char> ReadSliceOfWholeBlob(const std::string& path, const Shape& logical_blob_shape,
+                                       const TensorSliceView& slice) {
+  const int64_t logical_blob_size = logical_blob_shape.elem_cnt() * sizeof(float);
+  std::vector<char> buffer(logical_blob_size);
+  PersistentInStream in_stream(SnapshotFS(), path);
+  in_stream.ReadFully(buffer.data(), logical_blob_size);
+  if (logical_blob_shape.NumAxes() == 0) { return buffer; }
+  std::vector<char> ret(slice.shape().elem_cnt() * sizeof(float));
+  TensorSliceCopier copier(slice, TensorSliceView(logical_blob_shape), DataType::kFloat);
+  CpuDeviceCtx device_ctx;
+  std::unique_ptr<MemoryCopier> host_memory_copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  copier.Copy(&device_ctx, *host_memory_copier, ret.data(), buffer.data());
+  return ret;
+}
+
+class SnapshotReaderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    IOConf io_conf;
+    io_conf.mutable_snapshot_fs_conf()->mutable_localfs_conf();
+    io_conf.set_persistence_buf_byte(1 << 20);
+    Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+    Global<ThreadPool>::New(4);
+    std::string current_dir = GetCwd();
+    StringReplace(&current_dir, '\\', '/');
+    root_path_ = JoinPath(current_dir, "tmp_snapshot_reader");
+    if (LocalFS()->IsDirectory(root_path_)) { LocalFS()->RecursivelyDeleteDir(root_path_); }
+    LocalFS()->CreateDir(root_path_);
+  }
+
+  void TearDown() override {
+    LocalFS()->RecursivelyDeleteDir(root_path_);
+    Global<ThreadPool>::Delete();
+    Global<const IOConf>::Delete();
+  }
+
+  // Writes a float blob of logical_blob_shape as key, then checks that the slices read from it are
+  // the same as those copied out of the whole blob
+  void TestReadSlices(const std::string& key, const Shape& logical_blob_shape,
+                      const std::vector<TensorSliceView>& slices) {
+    // the blob file is written as SnapshotWriter does, which needs a ctrl client
+    const std::string path = JoinPath(root_path_, key);
+    {
+      std::vector<float> blob(logical_blob_shape.elem_cnt());
+      std::mt19937 gen(blob.size());
+      for (float& x : blob) { x = static_cast<float>(gen()); }
+      std::unique_ptr<fs::WritableFile> file;
+      SnapshotFS()->NewWritableFile(path, &file);
+      file->Append(reinterpret_cast<const char*>(blob.data()), blob.size() * sizeof(float));
+      file->Close();
+    }
+    SnapshotReader reader(root_path_);
+    for (const TensorSliceView& slice : slices) {
+      const std::vector<char> expected = ReadSliceOfWholeBlob(path, logical_blob_shape, slice);
+      std::vector<char> actual(expected.size());
+      reader.Read(key, logical_blob_shape, DataType::kFloat, slice, actual.data());
+      ASSERT_TRUE(actual == expected) << "key: " << key << " slice: " << slice.shape().DebugStr();
+    }
+  }
+
+  std::string root_path_;
+};
+
+// the slices of parallel_num ranks splitting the blob on axis
+std::vector<TensorSliceView> SplitSlices(const Shape& shape, int64_t axis, int64_t parallel_num) {
+  std::vector<TensorSliceView> slices;
+  FOR_RANGE(int64_t, i, 0, parallel_num) {
+    std::vector<Range> ranges;
+    FOR_RANGE(int64_t, j, 0, shape.NumAxes()) { ranges.emplace_back(0, shape.At(j)); }
+    ranges.at(axis) = Range(i * shape.At(axis) / parallel_num,
+                            (i + 1) * shape.At(axis) / parallel_num);
+    slices.emplace_back(ranges);
+  }
+  return slices;
+}
+
+}  // namespace
+
+TEST_F(SnapshotReaderTest, scalar) {
+  TestReadSlices("scalar", Shape(DimVector{}), {TensorSliceView(Shape(DimVector{}))});
+}
+
+TEST_F(SnapshotReaderTest, vector) {
+  const Shape shape({1000});
+  TestReadSlices("vector", shape,
+                 {TensorSliceView(shape), TensorSliceView({Range(100, 900)}),
+                  TensorSliceView({Range(999, 1000)})});
+}
+
+TEST_F(SnapshotReaderTest, matrix_split_on_either_axis) {
+  const Shape shape({64, 1000});
+  TestReadSlices("matrix_axis_0", shape, SplitSlices(shape, 0, 3));
+  TestReadSlices("matrix_axis_1", shape, SplitSlices(shape, 1, 3));
+  TestReadSlices("matrix_block", shape, {TensorSliceView({Range(5, 40), Range(250, 500)})});
+}
+
+TEST_F(SnapshotReaderTest, cube) {
+  const Shape shape({6, 20, 30});
+  TestReadSlices("cube", shape,
+                 {TensorSliceView({Range(1, 5), Range(3, 17), Range(4, 25)}),
+                  TensorSliceView({Range(2, 4), Range(0, 20), Range(0, 30)}),
+                  TensorSliceView({Range(0, 6), Range(5, 6), Range(0, 30)})});
+}
+
+TEST_F(SnapshotReaderTest, runs_larger_than_a_chunk) {
+  const Shape shape({3, kReadChunkElemCnt + kReadChunkElemCnt / 2});
+  TestReadSlices("large_runs", shape,
+                 {TensorSliceView({Range(1, 3), Range(0, shape.At(1))}),
+                  TensorSliceView({Range(0, 3), Range(100, kReadChunkElemCnt + 200)})});
+}
+
+TEST_F(SnapshotReaderTest, gaps_around_the_max_gap) {
+  // rows of 100 elements, separated by gaps just under, at and just over the max read gap
+  const int64_t width = 100;
+  for (int64_t gap : {kMaxReadGapElemCnt - 1, kMaxReadGapElemCnt, kMaxReadGapElemCnt + 1}) {
+    const Shape shape({8, width + gap});
+    TestReadSlices("gap_" + std::to_string(gap), shape,
+                   {TensorSliceView({Range(0, 8), Range(10, 10 + width)}),
+                    TensorSliceView({Range(3, 7), Range(gap, gap + width)})});
+  }
+}
+
+}  // namespace oneflow
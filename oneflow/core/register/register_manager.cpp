@@ -20,8 +20,11 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/comm_network/comm_network.h"
 #include "oneflow/core/job/machine_context.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
 #include "oneflow/core/memory/memory_case.pb.h"
 #include "oneflow/core/memory/memory_allocator.h"
+#include "oneflow/core/thread/thread_placement.h"
 
 namespace oneflow {
 
@@ -37,11 +40,47 @@ void CheckBlobInRegstNotDisabled(const RegstDescProto& regst_desc) {
 
 RegstMgr::RegstMgr(const Plan& plan) {
   int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
+  const bool force_zero_init =
+      Global<ResourceDesc, ForSession>::Get()->regst_mem_init_conf().force_zero_init();
+  int64_t zero_init_size = 0;
+  int64_t skipped_zero_init_size = 0;
+  auto Allocate = [&](const MemoryCase& mem_case, int64_t mem_size, bool need_zero_init,
+                      const std::vector<int32_t>& writer_cpus) -> char* {
+    const bool zero_init = force_zero_init || need_zero_init;
+    (zero_init ? zero_init_size : skipped_zero_init_size) += mem_size;
+    if (writer_cpus.empty()) {
+      return Global<MemoryAllocator>::Get()->Allocate(mem_case, mem_size, zero_init);
+    }
+    // pages are placed on the numa node of the thread touching them first, so fill them from the
+    // cpus of the writer. Memory which is not filled is first touched by the writer itself.
+    CpuAffinityGuard guard(writer_cpus);
+    char* ptr = Global<MemoryAllocator>::Get()->Allocate(mem_case, mem_size, false);
+    if (zero_init) { memset(ptr, 0, mem_size); }
+    return ptr;
+  };
+  const ThreadPlacement placement(Global<ResourceDesc, ForSession>::Get()->thread_placement_conf());
+  HashMap<int64_t, int64_t> mem_block_id2writer_thrd_id;
+  for (const TaskProto& task : plan.task()) {
+    if (task.machine_id() != this_machine_id) { continue; }
+    for (const auto& pair : task.produced_regst_desc()) {
+      mem_block_id2writer_thrd_id.emplace(pair.second.mem_block_id(), task.thrd_id());
+    }
+  }
+  auto WriterCpus4MemBlock = [&](const MemBlockProto& mem_block) {
+    const MemoryCase& mem_case = mem_block.mem_case();
+    const auto it = mem_block_id2writer_thrd_id.find(mem_block.mem_block_id());
+    if (!placement.is_enabled() || !mem_case.has_host_mem()
+        || mem_case.host_mem().has_cuda_pinned_mem() || it == mem_block_id2writer_thrd_id.end()) {
+      return std::vector<int32_t>();
+    }
+    return placement.Cpus4ActorThrdId(it->second);
+  };
   HashMap<int64_t, char*> chunk_id2ptr;
   for (const ChunkProto& chunk : plan.block_chunk_list().chunk()) {
     if (chunk.machine_id() != this_machine_id) { continue; }
     if (chunk.mem_size() == 0) { continue; }
-    char* chunk_ptr = Global<MemoryAllocator>::Get()->Allocate(chunk.mem_case(), chunk.mem_size());
+    // a chunk is shared by the mem blocks of many writers
+    char* chunk_ptr = Allocate(chunk.mem_case(), chunk.mem_size(), chunk.need_zero_init(), {});
     CHECK(chunk_id2ptr.emplace(chunk.chunk_id(), chunk_ptr).second);
   }
   for (const MemBlockProto& mem_block : plan.block_chunk_list().mem_block()) {
@@ -53,11 +92,13 @@ RegstMgr::RegstMgr(const Plan& plan) {
       CHECK(chunk_id2ptr.find(mem_block.chunk_id()) != chunk_id2ptr.end());
       mem_block_ptr = chunk_id2ptr.at(mem_block.chunk_id()) + mem_block.chunk_offset();
     } else {
-      mem_block_ptr =
-          Global<MemoryAllocator>::Get()->Allocate(mem_block.mem_case(), mem_block.mem_size());
+      mem_block_ptr = Allocate(mem_block.mem_case(), mem_block.mem_size(),
+                               mem_block.need_zero_init(), WriterCpus4MemBlock(mem_block));
     }
     CHECK(mem_block_id2ptr_.emplace(mem_block.mem_block_id(), mem_block_ptr).second);
   }
+  LOG(INFO) << "regst memory zero-filled: " << zero_init_size
+            << " bytes, not zero-filled: " << skipped_zero_init_size << " bytes";
   for (const TaskProto& task : plan.task()) {
     if (task.machine_id() != this_machine_id) { continue; }
     for (const auto& pair : task.produced_regst_desc()) {
@@ -104,6 +145,24 @@ void RegstMgr::NewRegsts(const RegstDescProto& regst_desc_proto,
         CheckBlobInRegstNotDisabled(regst_desc_proto);
         regst->comm_net_token_ = Global<CommNet>::Get()->RegisterMemory(
             main_mem_ptr, rt_regst_desc->MainByteSize4OneRegst());
+        if (regst_desc_proto.enable_lossy_wire_codec()) {
+          // the bodies follow the headers unless the headers are separated
+          const size_t fp32_offset =
+              rt_regst_desc->SeparatedHeaderByteSize4OneRegst() > 0
+                  ? 0
+                  : rt_regst_desc->packed_blob_desc()->ByteSizeOfBlobHeader();
+          // the bodies are aligned, the padding after each is not gradient
+          std::vector<Range> fp32_ranges;
+          rt_regst_desc->ForEachBlobDescOffsetInOnRegst(
+              [&](int64_t ordinal, const LogicalBlobId& lbi, const RtBlobDesc* blob_desc,
+                  int64_t body_offset, int64_t header_offset) {
+                fp32_ranges.emplace_back(
+                    body_offset / sizeof(float),
+                    (body_offset + blob_desc->ByteSizeOfBlobBody()) / sizeof(float));
+              });
+          Global<CommNet>::Get()->MarkFp32Memory(regst->comm_net_token_, fp32_offset,
+                                                 fp32_ranges);
+        }
       }
       if (main_mem_ptr != nullptr) { main_mem_ptr += rt_regst_desc->MainByteSize4OneRegst(); }
       if (separated_header_mem_ptr != nullptr) {
@@ -0,0 +1,130 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/actor/actor_message.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/mpsc_queue.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+template<typename QueueT>
+std::unique_ptr<QueueT> NewQueue();
+
+template<>
+std::unique_ptr<Channel<ActorMsg>> NewQueue<Channel<ActorMsg>>() {
+  return std::unique_ptr<Channel<ActorMsg>>(new Channel<ActorMsg>());
+}
+
+template<>
+std::unique_ptr<MpscQueue<ActorMsg>> NewQueue<MpscQueue<ActorMsg>>() {
+  return std::unique_ptr<MpscQueue<ActorMsg>>(new MpscQueue<ActorMsg>(1024));
+}
+
+double SecondsSince(const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// many actor threads send to one actor thread which drains its queue like Thread::PollMsgChannel
+template<typename QueueT>
+double ThroughputMsgPerSec(int64_t producer_num, int64_t msg_num_per_producer) {
+  std::unique_ptr<QueueT> queue = NewQueue<QueueT>();
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  FOR_RANGE(int64_t, i, 0, producer_num) {
+    producers.emplace_back([&queue, i, msg_num_per_producer]() {
+      FOR_RANGE(int64_t, j, 0, msg_num_per_producer) {
+        queue->Send(ActorMsg::BuildCommandMsg(i, ActorCmd::kStart));
+      }
+    });
+  }
+  const int64_t total_msg_num = producer_num * msg_num_per_producer;
+  int64_t received_cnt = 0;
+  std::queue<ActorMsg> local_queue;
+  while (received_cnt < total_msg_num) {
+    CHECK_EQ(queue->ReceiveMany(&local_queue), kChannelStatusSuccess);
+    received_cnt += local_queue.size();
+    while (!local_queue.empty()) { local_queue.pop(); }
+  }
+  const double seconds = SecondsSince(start);
+  for (std::thread& producer : producers) { producer.join(); }
+  return total_msg_num / seconds;
+}
+
+// ping-pong between two actor threads, the receiver is idle before every message arrives
+template<typename QueueT>
+double WakeUpLatencyMicroseconds(int64_t round_num, int64_t interval_us) {
+  std::unique_ptr<QueueT> ping = NewQueue<QueueT>();
+  std::unique_ptr<QueueT> pong = NewQueue<QueueT>();
+  std::thread echo([&ping, &pong]() {
+    ActorMsg msg;
+    while (ping->Receive(&msg) == kChannelStatusSuccess) { pong->Send(msg); }
+  });
+  double total_seconds = 0;
+  ActorMsg msg = ActorMsg::BuildCommandMsg(0, ActorCmd::kStart);
+  FOR_RANGE(int64_t, i, 0, round_num) {
+    std::this_thread::sleep_for(std::chrono::microseconds(interval_us));
+    const auto start = std::chrono::steady_clock::now();
+    ping->Send(msg);
+    CHECK_EQ(pong->Receive(&msg), kChannelStatusSuccess);
+    total_seconds += SecondsSince(start);
+  }
+  ping->Close();
+  echo.join();
+  return total_seconds / round_num / 2 * 1e6;
+}
+
+void BenchmarkActorMsgQueue(int64_t msg_num, int64_t round_num, int64_t interval_us) {
+  std::cout << std::fixed << std::setprecision(2);
+  for (int64_t producer_num : {1, 2, 4, 8, 16, 64}) {
+    const int64_t msg_num_per_producer = msg_num / producer_num;
+    const double channel_rate =
+        ThroughputMsgPerSec<Channel<ActorMsg>>(producer_num, msg_num_per_producer);
+    const double mpsc_rate =
+        ThroughputMsgPerSec<MpscQueue<ActorMsg>>(producer_num, msg_num_per_producer);
+    std::cout << "throughput producer_num: " << producer_num
+              << " Channel: " << channel_rate / 1e6 << " Mmsg/s"
+              << " MpscQueue: " << mpsc_rate / 1e6 << " Mmsg/s"
+              << " speedup: " << mpsc_rate / channel_rate << std::endl;
+  }
+  for (int64_t cur_interval_us : {int64_t(0), interval_us}) {
+    const double channel_latency =
+        WakeUpLatencyMicroseconds<Channel<ActorMsg>>(round_num, cur_interval_us);
+    const double mpsc_latency =
+        WakeUpLatencyMicroseconds<MpscQueue<ActorMsg>>(round_num, cur_interval_us);
+    std::cout << "wake-up latency interval: " << cur_interval_us << "us"
+              << " Channel: " << channel_latency << "us"
+              << " MpscQueue: " << mpsc_latency << "us" << std::endl;
+  }
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(msg_num, 10000000, "total number of messages sent in the throughput benchmark");
+DEFINE_int64(round_num, 10000, "number of ping-pong rounds in the latency benchmark");
+DEFINE_int64(interval_us, 200, "idle time of the receiver before each ping-pong round");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  BenchmarkActorMsgQueue(FLAGS_msg_num, FLAGS_round_num, FLAGS_interval_us);
+  return 0;
+}
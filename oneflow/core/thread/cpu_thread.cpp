@@ -15,13 +15,15 @@ limitations under the License.
 */
 #include "oneflow/core/thread/cpu_thread.h"
 #include "oneflow/core/profiler/profiler.h"
+#include "oneflow/core/thread/thread_placement.h"
 
 namespace oneflow {
 
-CpuThread::CpuThread(int64_t thrd_id) {
+CpuThread::CpuThread(int64_t thrd_id, const std::vector<int32_t>& cpus) {
   set_thrd_id(thrd_id);
-  mut_actor_thread() = std::thread([this, thrd_id]() {
+  mut_actor_thread() = std::thread([this, thrd_id, cpus]() {
     OF_PROFILER_NAME_THIS_HOST_THREAD("CPU Actor : (" + std::to_string(thrd_id) + ")");
+    SetCurrentThreadCpuAffinity(cpus);
     ThreadCtx ctx;
 #ifdef WITH_CUDA
     ctx.cb_event_chan = nullptr;
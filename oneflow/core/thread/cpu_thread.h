@@ -26,7 +26,8 @@ class CpuThread final : public Thread {
   CpuThread() = delete;
   ~CpuThread() = default;
 
-  CpuThread(int64_t thrd_id);
+  // the thread is pinned to cpus unless cpus is empty
+  CpuThread(int64_t thrd_id, const std::vector<int32_t>& cpus);
 
  private:
 };
@@ -21,20 +21,22 @@ namespace oneflow {
 
 #ifdef WITH_CUDA
 
-GpuThread::GpuThread(int64_t thrd_id, int64_t dev_id) {
+GpuThread::GpuThread(int64_t thrd_id, int64_t dev_id, bool pin_to_device_cpus) {
   set_thrd_id(thrd_id);
-  mut_actor_thread() = std::thread([this, dev_id, thrd_id]() {
+  mut_actor_thread() = std::thread([this, dev_id, thrd_id, pin_to_device_cpus]() {
     OF_PROFILER_NAME_THIS_HOST_THREAD("GPU " + std::to_string(dev_id) + " Actor : ("
                                       + std::to_string(thrd_id) + ")");
+    if (pin_to_device_cpus) { CudaDeviceSetCpuAffinity(dev_id); }
     OF_CUDA_CHECK(cudaSetDevice(dev_id));
     ThreadCtx ctx;
     ctx.g_cuda_stream.reset(new CudaStreamHandle(&cb_event_chan_));
     ctx.cb_event_chan = &cb_event_chan_;
     PollMsgChannel(ctx);
   });
-  cb_event_poller_ = std::thread([this, dev_id, thrd_id]() {
+  cb_event_poller_ = std::thread([this, dev_id, thrd_id, pin_to_device_cpus]() {
     OF_PROFILER_NAME_THIS_HOST_THREAD("GPU " + std::to_string(dev_id) + " Poller : ("
                                       + std::to_string(thrd_id) + ")");
+    if (pin_to_device_cpus) { CudaDeviceSetCpuAffinity(dev_id); }
     OF_CUDA_CHECK(cudaSetDevice(dev_id));
     CudaCBEvent cb_event;
     while (cb_event_chan_.Receive(&cb_event) == kChannelStatusSuccess) {
@@ -28,7 +28,8 @@ class GpuThread final : public Thread {
   GpuThread() = delete;
   ~GpuThread();
 
-  GpuThread(int64_t thrd_id, int64_t dev_id);
+  // pin_to_device_cpus pins the actor and the poller thread to the cpus closest to the device
+  GpuThread(int64_t thrd_id, int64_t dev_id, bool pin_to_device_cpus);
 
  private:
   Channel<CudaCBEvent> cb_event_chan_;
@@ -21,6 +21,14 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+constexpr size_t kThreadMsgQueueCapacity = 1024;
+
+}  // namespace
+
+Thread::Thread() : msg_channel_(kThreadMsgQueueCapacity) {}
+
 Thread::~Thread() {
   actor_thread_.join();
   CHECK(id2task_.empty());
@@ -41,6 +49,15 @@ void Thread::EnqueueActorMsg(const ActorMsg& msg) {
   }
 }
 
+void Thread::EnqueueActorMsgs(const std::vector<ActorMsg>& msgs) {
+  if (Global<ResourceDesc, ForSession>::Get()->thread_enable_local_message_queue()
+      && std::this_thread::get_id() == actor_thread_.get_id()) {
+    for (const ActorMsg& msg : msgs) { local_msg_queue_.push(msg); }
+  } else {
+    msg_channel_.SendMany(msgs.begin(), msgs.end());
+  }
+}
+
 void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
   while (true) {
     if (local_msg_queue_.empty()) {
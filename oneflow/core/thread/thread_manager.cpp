@@ -18,8 +18,7 @@ limitations under the License.
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/cpu_thread.h"
 #include "oneflow/core/thread/gpu_thread.h"
-#include "oneflow/core/common/balanced_splitter.h"
-#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/thread/thread_placement.h"
 #include "oneflow/core/job/machine_context.h"
 #include "oneflow/core/job/global_for.h"
 
@@ -38,22 +37,36 @@ Thread* ThreadMgr::GetThrd(int64_t thrd_id) { return threads_.at(thrd_id); }
 
 ThreadMgr::ThreadMgr(const Plan& plan) {
   int64_t thrd_id = 0;
+  const ThreadPlacement placement(Global<ResourceDesc, ForSession>::Get()->thread_placement_conf());
 
 #ifdef WITH_CUDA
   FOR_RANGE(int64_t, i, 0, GetCudaWorkTypeSize()) {
     FOR_RANGE(int64_t, dev_phy_id, 0, (Global<ResourceDesc, ForSession>::Get()->GpuDeviceNum())) {
-      threads_.push_back(new GpuThread(thrd_id++, dev_phy_id));
+      if (placement.is_enabled()) {
+        LOG(INFO) << "actor thread " << thrd_id << " pinned to the cpus of gpu " << dev_phy_id;
+      }
+      threads_.push_back(new GpuThread(thrd_id++, dev_phy_id, placement.is_enabled()));
     }
   }
 #endif
   FOR_RANGE(int64_t, i, 0, (Global<ResourceDesc, ForSession>::Get()->CpuDeviceNum())) {
-    threads_.push_back(new CpuThread(thrd_id++));
+    NewCpuThrd(placement, thrd_id++);
   }
-  threads_.push_back(new CpuThread(thrd_id++));  // comm_net
-  CreatePersistenceThrd(plan, thrd_id);
+  NewCpuThrd(placement, thrd_id++);  // comm_net
+  CreatePersistenceThrd(plan, placement, thrd_id);
 }
 
-void ThreadMgr::CreatePersistenceThrd(const Plan& plan, int64_t thrd_id) {
+void ThreadMgr::NewCpuThrd(const ThreadPlacement& placement, int64_t thrd_id) {
+  const std::vector<int32_t> cpus = placement.Cpus4ActorThrdId(thrd_id);
+  if (!cpus.empty()) {
+    LOG(INFO) << "actor thread " << thrd_id << " pinned to cpus " << CpuListToString(cpus)
+              << " of numa node " << placement.NumaNode4ThreadIndex(thrd_id);
+  }
+  threads_.push_back(new CpuThread(thrd_id, cpus));
+}
+
+void ThreadMgr::CreatePersistenceThrd(const Plan& plan, const ThreadPlacement& placement,
+                                      int64_t thrd_id) {
   const int64_t this_machine_id = Global<MachineCtx>::Get()->this_machine_id();
 
   int64_t max_thrd_id = 0;
@@ -63,7 +76,7 @@ void ThreadMgr::CreatePersistenceThrd(const Plan& plan, int64_t thrd_id) {
     }
   }
 
-  for (int64_t i = thrd_id; i <= max_thrd_id; i++) { threads_.push_back(new CpuThread(i)); }
+  for (int64_t i = thrd_id; i <= max_thrd_id; i++) { NewCpuThrd(placement, i); }
 }
 
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
@@ -71,17 +84,9 @@ void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
 }
 
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
-  size_t thread_num = Global<ThreadPool>::Get()->thread_num();
-  thread_num = std::min(num, thread_num);
-  BalancedSplitter bs(num, thread_num);
-  BlockingCounter bc(thread_num);
-  FOR_RANGE(size_t, range_id, 0, thread_num) {
-    Global<ThreadPool>::Get()->AddWork([&bc, &bs, range_id, Callback] {
-      FOR_RANGE(size_t, i, bs.At(range_id).begin(), bs.At(range_id).end()) { Callback(i); }
-      bc.Decrease();
-    });
-  }
-  bc.WaitUntilCntEqualZero();
+  Global<ThreadPool>::Get()->ParallelFor(0, num, 1, [&Callback](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) { Callback(i); }
+  });
 }
 
 }  // namespace oneflow
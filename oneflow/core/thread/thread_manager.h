@@ -24,6 +24,7 @@ limitations under the License.
 namespace oneflow {
 
 class Plan;
+class ThreadPlacement;
 
 class ThreadMgr final {
  public:
@@ -37,7 +38,8 @@ class ThreadMgr final {
   friend class Global<ThreadMgr>;
   explicit ThreadMgr(const Plan& plan);
 
-  void CreatePersistenceThrd(const Plan& plan, int64_t thrd_id);
+  void NewCpuThrd(const ThreadPlacement& placement, int64_t thrd_id);
+  void CreatePersistenceThrd(const Plan& plan, const ThreadPlacement& placement, int64_t thrd_id);
 
   std::vector<Thread*> threads_;
 };
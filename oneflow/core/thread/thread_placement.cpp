@@ -0,0 +1,175 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_placement.h"
+#include <set>
+#include <sstream>
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+namespace oneflow {
+
+namespace {
+
+bool ReadFirstLine(const std::string& path, std::string* line) {
+  std::ifstream is(path);
+  if (!is.is_open()) { return false; }
+  std::getline(is, *line);
+  return !line->empty();
+}
+
+#ifdef __linux__
+
+void CpuSet4Cpus(const std::vector<int32_t>& cpus, cpu_set_t* cpu_set) {
+  CPU_ZERO(cpu_set);
+  for (int32_t cpu : cpus) {
+    CHECK_LT(cpu, CPU_SETSIZE);
+    CPU_SET(cpu, cpu_set);
+  }
+}
+
+#endif
+
+std::vector<std::vector<int32_t>> ReadNumaNode2UsableCpus() {
+  const std::vector<int32_t> usable_cpus = ProcessUsableCpus();
+  const std::set<int32_t> usable_cpu_set(usable_cpus.begin(), usable_cpus.end());
+  std::vector<std::vector<int32_t>> node2cpus;
+  std::string online_nodes;
+  if (ReadFirstLine("/sys/devices/system/node/online", &online_nodes)) {
+    for (int32_t node : ParseCpuList(online_nodes)) {
+      std::string node_cpus;
+      const std::string path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+      if (!ReadFirstLine(path, &node_cpus)) { continue; }
+      std::vector<int32_t> cpus;
+      for (int32_t cpu : ParseCpuList(node_cpus)) {
+        if (usable_cpu_set.find(cpu) != usable_cpu_set.end()) { cpus.push_back(cpu); }
+      }
+      // nodes without usable cpus, e.g. memory only nodes, can not run any thread
+      if (!cpus.empty()) { node2cpus.push_back(cpus); }
+    }
+  }
+  if (node2cpus.empty()) { node2cpus.push_back(usable_cpus); }
+  return node2cpus;
+}
+
+}  // namespace
+
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int32_t> cpus;
+  std::istringstream ss(cpu_list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") { continue; }
+    const size_t dash_pos = range.find('-');
+    const int32_t first = std::stoi(range.substr(0, dash_pos));
+    const int32_t last =
+        dash_pos == std::string::npos ? first : std::stoi(range.substr(dash_pos + 1));
+    CHECK_LE(first, last) << cpu_list;
+    for (int32_t cpu = first; cpu <= last; ++cpu) { cpus.push_back(cpu); }
+  }
+  return cpus;
+}
+
+std::string CpuListToString(const std::vector<int32_t>& cpus) {
+  std::string ret;
+  size_t i = 0;
+  while (i < cpus.size()) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus.at(j + 1) == cpus.at(j) + 1) { ++j; }
+    if (!ret.empty()) { ret += ","; }
+    ret += std::to_string(cpus.at(i));
+    if (j > i) { ret += "-" + std::to_string(cpus.at(j)); }
+    i = j + 1;
+  }
+  return ret;
+}
+
+const std::vector<std::vector<int32_t>>& NumaNode2UsableCpus() {
+  static const std::vector<std::vector<int32_t>> node2cpus = ReadNumaNode2UsableCpus();
+  return node2cpus;
+}
+
+std::vector<int32_t> ProcessUsableCpus() {
+  std::vector<int32_t> cpus;
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set), 0);
+  FOR_RANGE(int32_t, cpu, 0, CPU_SETSIZE) {
+    if (CPU_ISSET(cpu, &cpu_set)) { cpus.push_back(cpu); }
+  }
+#else
+  FOR_RANGE(int32_t, cpu, 0, std::thread::hardware_concurrency()) { cpus.push_back(cpu); }
+#endif
+  return cpus;
+}
+
+void SetCurrentThreadCpuAffinity(const std::vector<int32_t>& cpus) {
+#ifdef __linux__
+  SetThreadCpuAffinity(pthread_self(), cpus);
+#endif
+}
+
+void SetThreadCpuAffinity(std::thread::native_handle_type thread,
+                          const std::vector<int32_t>& cpus) {
+  if (cpus.empty()) { return; }
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CpuSet4Cpus(cpus, &cpu_set);
+  CHECK_EQ(pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpu_set), 0);
+#endif
+}
+
+CpuAffinityGuard::CpuAffinityGuard(const std::vector<int32_t>& cpus) : is_set_(false) {
+  if (cpus.empty()) { return; }
+#ifdef __linux__
+  CHECK_EQ(sched_getaffinity(0, sizeof(cpu_set_t), &saved_cpu_set_), 0);
+  SetCurrentThreadCpuAffinity(cpus);
+  is_set_ = true;
+#endif
+}
+
+CpuAffinityGuard::~CpuAffinityGuard() {
+#ifdef __linux__
+  if (is_set_) { CHECK_EQ(sched_setaffinity(0, sizeof(cpu_set_t), &saved_cpu_set_), 0); }
+#endif
+}
+
+ThreadPlacement::ThreadPlacement(const ThreadPlacementConf& conf,
+                                 const std::vector<std::vector<int32_t>>& node2cpus)
+    : conf_(conf), node2cpus_(node2cpus) {
+  CHECK(!node2cpus_.empty());
+  for (const auto& cpus : node2cpus_) { CHECK(!cpus.empty()); }
+}
+
+std::vector<int32_t> ThreadPlacement::Cpus4ActorThrdId(int64_t thrd_id) const {
+  return Cpus4ThreadIndex(thrd_id, false);
+}
+
+std::vector<int32_t> ThreadPlacement::Cpus4PoolWorkerId(int64_t worker_id) const {
+  if (!pin_thread_pool()) { return std::vector<int32_t>(); }
+  return Cpus4ThreadIndex(worker_id, true);
+}
+
+std::vector<int32_t> ThreadPlacement::Cpus4ThreadIndex(int64_t index, bool from_back) const {
+  if (conf_.policy() == kThreadPlacementNone) { return std::vector<int32_t>(); }
+  const std::vector<int32_t>& node_cpus = node2cpus_.at(NumaNode4ThreadIndex(index));
+  if (conf_.policy() == kThreadPlacementNumaNode) { return node_cpus; }
+  CHECK_EQ(conf_.policy(), kThreadPlacementCore);
+  const int64_t cpu_index = (index / node2cpus_.size()) % node_cpus.size();
+  return {node_cpus.at(from_back ? node_cpus.size() - 1 - cpu_index : cpu_index)};
+}
+
+}  // namespace oneflow
@@ -0,0 +1,83 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_THREAD_THREAD_PLACEMENT_H_
+#define ONEFLOW_CORE_THREAD_THREAD_PLACEMENT_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/job/resource.pb.h"
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace oneflow {
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}, the format of /sys/devices/system/node/*/cpulist
+std::vector<int32_t> ParseCpuList(const std::string& cpu_list);
+std::string CpuListToString(const std::vector<int32_t>& cpus);
+
+// cpus usable by this process grouped by numa node, one node holding all usable cpus when the
+// host exposes no numa information
+const std::vector<std::vector<int32_t>>& NumaNode2UsableCpus();
+std::vector<int32_t> ProcessUsableCpus();
+
+// empty cpus are ignored
+void SetCurrentThreadCpuAffinity(const std::vector<int32_t>& cpus);
+void SetThreadCpuAffinity(std::thread::native_handle_type thread,
+                          const std::vector<int32_t>& cpus);
+
+// Pins the calling thread to cpus during its lifetime, e.g. to first touch memory on their node.
+class CpuAffinityGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuAffinityGuard);
+  explicit CpuAffinityGuard(const std::vector<int32_t>& cpus);
+  ~CpuAffinityGuard();
+
+ private:
+  bool is_set_;
+#ifdef __linux__
+  cpu_set_t saved_cpu_set_;
+#endif
+};
+
+// Maps actor threads and compute thread pool workers to cpus. Consecutive threads go to
+// different numa nodes. Under kThreadPlacementCore actor threads take the cpus of a node from
+// the front and pool workers from the back, so the two only share cpus when a node runs out.
+class ThreadPlacement final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(ThreadPlacement);
+  explicit ThreadPlacement(const ThreadPlacementConf& conf)
+      : ThreadPlacement(conf, NumaNode2UsableCpus()) {}
+  ThreadPlacement(const ThreadPlacementConf& conf,
+                  const std::vector<std::vector<int32_t>>& node2cpus);
+  ~ThreadPlacement() = default;
+
+  bool is_enabled() const { return conf_.policy() != kThreadPlacementNone; }
+  bool pin_thread_pool() const { return is_enabled() && conf_.pin_thread_pool(); }
+  int64_t NumaNode4ThreadIndex(int64_t index) const { return index % node2cpus_.size(); }
+  // empty when the thread is not pinned
+  std::vector<int32_t> Cpus4ActorThrdId(int64_t thrd_id) const;
+  std::vector<int32_t> Cpus4PoolWorkerId(int64_t worker_id) const;
+
+ private:
+  std::vector<int32_t> Cpus4ThreadIndex(int64_t index, bool from_back) const;
+
+  ThreadPlacementConf conf_;
+  std::vector<std::vector<int32_t>> node2cpus_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_THREAD_THREAD_PLACEMENT_H_
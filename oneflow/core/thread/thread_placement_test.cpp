@@ -0,0 +1,73 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_placement.h"
+
+namespace oneflow {
+
+namespace {
+
+ThreadPlacementConf GenConf(ThreadPlacementPolicy policy) {
+  ThreadPlacementConf conf;
+  conf.set_policy(policy);
+  return conf;
+}
+
+}  // namespace
+
+TEST(ThreadPlacement, parse_cpu_list) {
+  ASSERT_EQ(ParseCpuList("0-3,8,10-11\n"), std::vector<int32_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_EQ(ParseCpuList("5"), std::vector<int32_t>({5}));
+  ASSERT_TRUE(ParseCpuList("").empty());
+  ASSERT_EQ(CpuListToString({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+  ASSERT_EQ(CpuListToString({}), "");
+}
+
+TEST(ThreadPlacement, spread_over_numa_nodes) {
+  const std::vector<std::vector<int32_t>> node2cpus{{0, 1, 2}, {3, 4, 5}};
+  ThreadPlacement none(GenConf(kThreadPlacementNone), node2cpus);
+  ASSERT_FALSE(none.is_enabled());
+  ASSERT_TRUE(none.Cpus4ActorThrdId(0).empty());
+  ASSERT_TRUE(none.Cpus4PoolWorkerId(0).empty());
+
+  ThreadPlacement numa_node(GenConf(kThreadPlacementNumaNode), node2cpus);
+  ASSERT_EQ(numa_node.Cpus4ActorThrdId(0), node2cpus.at(0));
+  ASSERT_EQ(numa_node.Cpus4ActorThrdId(1), node2cpus.at(1));
+  ASSERT_EQ(numa_node.Cpus4PoolWorkerId(2), node2cpus.at(0));
+
+  ThreadPlacement core(GenConf(kThreadPlacementCore), node2cpus);
+  std::vector<int32_t> actor_cpus;
+  std::vector<int32_t> worker_cpus;
+  FOR_RANGE(int64_t, i, 0, 4) {
+    actor_cpus.push_back(core.Cpus4ActorThrdId(i).at(0));
+    worker_cpus.push_back(core.Cpus4PoolWorkerId(i).at(0));
+  }
+  ASSERT_EQ(actor_cpus, std::vector<int32_t>({0, 3, 1, 4}));
+  ASSERT_EQ(worker_cpus, std::vector<int32_t>({2, 5, 1, 4}));
+}
+
+TEST(ThreadPlacement, affinity_guard) {
+  const std::vector<int32_t> usable_cpus = ProcessUsableCpus();
+  ASSERT_FALSE(usable_cpus.empty());
+  std::thread([&usable_cpus]() {
+    {
+      CpuAffinityGuard guard({usable_cpus.back()});
+      ASSERT_EQ(ProcessUsableCpus(), std::vector<int32_t>({usable_cpus.back()}));
+    }
+    ASSERT_EQ(ProcessUsableCpus(), usable_cpus);
+  }).join();
+}
+
+}  // namespace oneflow
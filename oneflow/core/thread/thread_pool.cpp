@@ -17,28 +17,174 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+thread_local const ThreadPool* tls_thread_pool = nullptr;
+thread_local int32_t tls_worker_id = -1;
+
+}  // namespace
+
 ThreadPool::ThreadPool(int32_t thread_num)
-    : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
+    : threads_(thread_num),
+      work_cnt_(0),
+      pending_task_cnt_(0),
+      sleeping_worker_cnt_(0),
+      is_closed_(false) {
+  FOR_RANGE(int32_t, i, 0, thread_num) { work_queues_.emplace_back(new WorkQueue()); }
   FOR_RANGE(int32_t, i, 0, thread_num) {
-    Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
-      std::function<void()> work;
-      while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
-    });
+    threads_[i] = std::thread([this, i]() { PollWorkQueue(i); });
   }
 }
 
 ThreadPool::~ThreadPool() {
-  FOR_RANGE(int32_t, i, 0, work_chans_.size()) {
-    work_chans_.at(i).Close();
-    threads_.at(i).join();
+  is_closed_.store(true);
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cond_.notify_all();
+  }
+  for (std::thread& thread : threads_) { thread.join(); }
+}
+
+void ThreadPool::AddWork(const std::function<void()>& work) { Push(Task{work, nullptr}); }
+
+void ThreadPool::ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                             const std::function<void(int64_t begin, int64_t end)>& Callback) {
+  if (begin >= end) { return; }
+  if (grain_size <= 0) {
+    grain_size = std::max<int64_t>((end - begin) / (std::max(thread_num(), 1) * 4), 1);
+  }
+  const int64_t chunk_num = (end - begin + grain_size - 1) / grain_size;
+  if (chunk_num == 1 || thread_num() == 0) {
+    Callback(begin, end);
+    return;
+  }
+  std::atomic<int64_t> next_chunk(0);
+  auto RunChunks = [&]() {
+    for (int64_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed); chunk < chunk_num;
+         chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+      const int64_t chunk_begin = begin + chunk * grain_size;
+      Callback(chunk_begin, std::min(chunk_begin + grain_size, end));
+    }
+  };
+  TaskGroup group(this);
+  FOR_RANGE(int64_t, i, 0, std::min<int64_t>(thread_num(), chunk_num - 1)) {
+    group.Run(RunChunks);
+  }
+  RunChunks();
+  group.Wait();
+}
+
+int32_t ThreadPool::CurrentWorkerId() const { return tls_thread_pool == this ? tls_worker_id : -1; }
+
+void ThreadPool::Push(Task&& task) {
+  const int32_t worker_id = CurrentWorkerId();
+  WorkQueue* queue = &injection_queue_;
+  if (worker_id >= 0 && task.group != nullptr) {
+    queue = work_queues_.at(worker_id).get();
+  } else {
+    work_cnt_.fetch_add(1, std::memory_order_relaxed);
+  }
+  pending_task_cnt_.fetch_add(1);
+  {
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    queue->tasks.push_back(std::move(task));
+  }
+  // pairs with the increment of sleeping_worker_cnt_ before a worker re-checks pending tasks
+  if (sleeping_worker_cnt_.load() > 0) {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle_cond_.notify_one();
+  }
+}
+
+bool ThreadPool::TryPopFront(WorkQueue* queue, const TaskGroup* only_group, Task* task) {
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  auto it = queue->tasks.begin();
+  if (only_group != nullptr) {
+    it = std::find_if(queue->tasks.begin(), queue->tasks.end(),
+                      [only_group](const Task& t) { return t.group == only_group; });
+  }
+  if (it == queue->tasks.end()) { return false; }
+  *task = std::move(*it);
+  queue->tasks.erase(it);
+  pending_task_cnt_.fetch_sub(1);
+  return true;
+}
+
+bool ThreadPool::TryPop(const TaskGroup* only_group, Task* task) {
+  const int32_t queue_num = work_queues_.size();
+  const int32_t worker_id = CurrentWorkerId();
+  if (worker_id >= 0) {
+    WorkQueue* queue = work_queues_.at(worker_id).get();
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    auto it = queue->tasks.rbegin();
+    if (only_group != nullptr) {
+      it = std::find_if(queue->tasks.rbegin(), queue->tasks.rend(),
+                        [only_group](const Task& t) { return t.group == only_group; });
+    }
+    if (it != queue->tasks.rend()) {
+      *task = std::move(*it);
+      queue->tasks.erase(std::next(it).base());
+      pending_task_cnt_.fetch_sub(1);
+      return true;
+    }
+  }
+  if (TryPopFront(&injection_queue_, only_group, task)) { return true; }
+  const size_t start = worker_id >= 0 ? worker_id + 1 : work_cnt_.load(std::memory_order_relaxed);
+  FOR_RANGE(int32_t, i, 0, queue_num) {
+    if (TryPopFront(work_queues_.at((start + i) % queue_num).get(), only_group, task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::RunTask(Task* task) {
+  task->work();
+  if (task->group != nullptr) { task->group->Done(); }
+}
+
+void ThreadPool::PollWorkQueue(int32_t worker_id) {
+  tls_thread_pool = this;
+  tls_worker_id = worker_id;
+  Task task;
+  while (true) {
+    if (TryPop(nullptr, &task)) {
+      RunTask(&task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    sleeping_worker_cnt_.fetch_add(1);
+    idle_cond_.wait(lock, [this]() { return pending_task_cnt_.load() > 0 || is_closed_.load(); });
+    sleeping_worker_cnt_.fetch_sub(1);
+    if (pending_task_cnt_.load() == 0 && is_closed_.load()) { break; }
+  }
+}
+
+void TaskGroup::Run(const std::function<void()>& work) {
+  pending_cnt_.fetch_add(1);
+  thread_pool_->Push(ThreadPool::Task{work, this});
+}
+
+void TaskGroup::Wait() {
+  // only the tasks of this group are helped with, an unrelated task, e.g. a long or blocking
+  // AddWork one, would stall the waiting thread or even wait for it
+  ThreadPool::Task task;
+  while (pending_cnt_.load() > 0) {
+    if (thread_pool_->TryPop(this, &task)) {
+      thread_pool_->RunTask(&task);
+    } else {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cond_.wait_for(lock, std::chrono::microseconds(100),
+                     [this]() { return pending_cnt_.load() == 0; });
+    }
   }
+  // make sure the last Done() has released mutex_ before the group can be destroyed
+  std::unique_lock<std::mutex> lock(mutex_);
 }
 
-void ThreadPool::AddWork(const std::function<void()>& work) {
-  const size_t cur_chan_idx =
-      work_cnt_.fetch_add(1, std::memory_order_relaxed) % work_chans_.size();
-  work_chans_.at(cur_chan_idx).Send(work);
+void TaskGroup::Done() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (pending_cnt_.fetch_sub(1) == 1) { cond_.notify_all(); }
 }
 
 }  // namespace oneflow
@@ -16,11 +16,17 @@ limitations under the License.
 #ifndef ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 #define ONEFLOW_CORE_THREAD_THREAD_POOL_H_
 
+#include <deque>
 #include "oneflow/core/common/util.h"
-#include "oneflow/core/common/channel.h"
 
 namespace oneflow {
 
+class TaskGroup;
+
+// Work-stealing thread pool. AddWork tasks go to a shared injection queue and run in FIFO order.
+// Every worker also owns a deque for the group tasks it spawns itself, e.g. the chunks of a
+// ParallelFor: it pops them LIFO, so nested parallelism stays local, and steals from the other
+// workers FIFO when both its deque and the injection queue run dry.
 class ThreadPool final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(ThreadPool);
@@ -29,13 +35,69 @@ class ThreadPool final {
   ~ThreadPool();
 
   int32_t thread_num() const { return threads_.size(); }
+  std::thread::native_handle_type worker_native_handle(int32_t worker_id) {
+    return threads_.at(worker_id).native_handle();
+  }
   void AddWork(const std::function<void()>& work);
 
+  // Calls Callback on consecutive [begin, end) chunks of about grain_size elements. Chunks are
+  // handed out dynamically so that skewed work keeps every worker busy, and the calling thread
+  // runs chunks too. grain_size <= 0 picks a chunk size from the range size and thread_num.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                   const std::function<void(int64_t begin, int64_t end)>& Callback);
+
  private:
-  std::vector<Channel<std::function<void()>>> work_chans_;
+  friend class TaskGroup;
+  struct Task {
+    std::function<void()> work;
+    TaskGroup* group;
+  };
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  // group tasks pushed from a worker go to its own deque, everything else to injection_queue_
+  void Push(Task&& task);
+  // only_group != nullptr restricts popping, from the own deque too, to tasks of that group
+  bool TryPop(const TaskGroup* only_group, Task* task);
+  bool TryPopFront(WorkQueue* queue, const TaskGroup* only_group, Task* task);
+  void RunTask(Task* task);
+  void PollWorkQueue(int32_t worker_id);
+  int32_t CurrentWorkerId() const;
+
+  WorkQueue injection_queue_;
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
   std::vector<std::thread> threads_;
 
   std::atomic<size_t> work_cnt_;
+  std::atomic<int64_t> pending_task_cnt_;
+  std::atomic<int64_t> sleeping_worker_cnt_;
+  std::atomic<bool> is_closed_;
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cond_;
+};
+
+// A set of tasks that can be waited for together. Wait() runs pending tasks of the group on the
+// calling thread instead of only blocking, so nested groups inside pool tasks can not starve the
+// pool. It never runs tasks of other groups or AddWork ones.
+class TaskGroup final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TaskGroup);
+  explicit TaskGroup(ThreadPool* thread_pool) : thread_pool_(thread_pool), pending_cnt_(0) {}
+  ~TaskGroup() { Wait(); }
+
+  void Run(const std::function<void()>& work);
+  void Wait();
+
+ private:
+  friend class ThreadPool;
+  void Done();
+
+  ThreadPool* thread_pool_;
+  std::atomic<int64_t> pending_cnt_;
+  std::mutex mutex_;
+  std::condition_variable cond_;
 };
 
 }  // namespace oneflow
@@ -0,0 +1,130 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+TEST(ThreadPool, parallel_for_visits_each_index_once) {
+  ThreadPool thread_pool(4);
+  for (int64_t grain_size : {-1, 1, 7, 1000}) {
+    std::vector<std::atomic<int32_t>> visits(1000);
+    for (auto& visit : visits) { visit.store(0); }
+    thread_pool.ParallelFor(0, visits.size(), grain_size, [&](int64_t begin, int64_t end) {
+      ASSERT_LT(begin, end);
+      FOR_RANGE(int64_t, i, begin, end) { visits.at(i).fetch_add(1); }
+    });
+    for (const auto& visit : visits) { ASSERT_EQ(visit.load(), 1); }
+  }
+}
+
+TEST(ThreadPool, nested_task_group) {
+  ThreadPool thread_pool(2);
+  std::atomic<int64_t> sum(0);
+  TaskGroup outer(&thread_pool);
+  FOR_RANGE(int64_t, i, 0, 16) {
+    outer.Run([&thread_pool, &sum, i]() {
+      // waiting inside a worker must not deadlock even if every worker is waiting
+      TaskGroup inner(&thread_pool);
+      FOR_RANGE(int64_t, j, 0, 16) {
+        inner.Run([&sum, i, j]() { sum.fetch_add(i * 16 + j); });
+      }
+      inner.Wait();
+    });
+  }
+  outer.Wait();
+  ASSERT_EQ(sum.load(), 256 * 255 / 2);
+}
+
+TEST(ThreadPool, wait_in_a_worker_runs_no_add_work) {
+  std::atomic<bool> is_waiting(false);
+  std::atomic<bool> ran_while_waiting(false);
+  {
+    ThreadPool thread_pool(2);
+    thread_pool.AddWork([&]() {
+      std::atomic<bool> started(false);
+      TaskGroup group(&thread_pool);
+      group.Run([&started]() {
+        started.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      });
+      // the other worker is busy with the group task, so this one is the only one left for
+      // the AddWork task while it waits
+      while (!started.load()) {}
+      const std::thread::id waiting_thread_id = std::this_thread::get_id();
+      thread_pool.AddWork([&is_waiting, &ran_while_waiting, waiting_thread_id]() {
+        if (std::this_thread::get_id() == waiting_thread_id && is_waiting.load()) {
+          ran_while_waiting.store(true);
+        }
+      });
+      is_waiting.store(true);
+      group.Wait();
+      is_waiting.store(false);
+    });
+  }
+  ASSERT_FALSE(ran_while_waiting.load());
+}
+
+TEST(ThreadPool, add_work_is_drained_before_destruction) {
+  std::atomic<int64_t> cnt(0);
+  {
+    ThreadPool thread_pool(3);
+    FOR_RANGE(int64_t, i, 0, 100) {
+      thread_pool.AddWork([&cnt]() { cnt.fetch_add(1); });
+    }
+  }
+  ASSERT_EQ(cnt.load(), 100);
+}
+
+TEST(ThreadPool, add_work_runs_in_fifo_order) {
+  std::vector<int64_t> order;
+  {
+    ThreadPool thread_pool(1);
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool released = false;
+    // hold the only worker, so that all the following tasks are queued behind it
+    thread_pool.AddWork([&]() {
+      std::unique_lock<std::mutex> lock(mutex);
+      cond.wait(lock, [&]() { return released; });
+    });
+    FOR_RANGE(int64_t, i, 0, 100) {
+      thread_pool.AddWork([&order, i]() { order.push_back(i); });
+    }
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      released = true;
+    }
+    cond.notify_one();
+  }
+  ASSERT_EQ(order.size(), 100);
+  FOR_RANGE(int64_t, i, 0, 100) { ASSERT_EQ(order.at(i), i); }
+}
+
+TEST(ThreadPool, add_work_from_a_worker_runs_in_fifo_order) {
+  std::vector<int64_t> order;
+  {
+    ThreadPool thread_pool(1);
+    thread_pool.AddWork([&thread_pool, &order]() {
+      FOR_RANGE(int64_t, i, 0, 100) {
+        thread_pool.AddWork([&order, i]() { order.push_back(i); });
+      }
+    });
+  }
+  ASSERT_EQ(order.size(), 100);
+  FOR_RANGE(int64_t, i, 0, 100) { ASSERT_EQ(order.at(i), i); }
+}
+
+}  // namespace oneflow
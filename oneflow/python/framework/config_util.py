@@ -15,6 +15,7 @@ limitations under the License.
 """
 from __future__ import absolute_import, print_function
 
+import oneflow.core.job.resource_pb2 as resource_util
 import oneflow.python.framework.hob as hob
 import oneflow.python.framework.session_context as session_ctx
 import oneflow.python.lib.core.enable_if as enable_if
@@ -340,6 +341,154 @@ def persistence_buf_byte(val):
     sess.config_proto.io_conf.persistence_buf_byte = val
 
 
+@oneflow_export("config.persistence_read_ahead_buffer_num")
+def api_persistence_read_ahead_buffer_num(val: int) -> None:
+    r"""Set up the number of buffers a background thread fills ahead of every persistence
+    input stream, 0 reads on demand.
+
+    Args:
+        val (int): e.g. 4
+    """
+    return enable_if.unique([persistence_read_ahead_buffer_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def persistence_read_ahead_buffer_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    assert val >= 0
+    sess.config_proto.io_conf.persistence_read_ahead_buffer_num = val
+
+
+@oneflow_export("config.persistence_read_ahead_buf_byte")
+def api_persistence_read_ahead_buf_byte(val: int) -> None:
+    r"""Set up the size of every read-ahead buffer for persistence.
+
+    Args:
+        val (int): e.g. 4194304(bytes)
+    """
+    return enable_if.unique([persistence_read_ahead_buf_byte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def persistence_read_ahead_buf_byte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    assert val > 0
+    sess.config_proto.io_conf.persistence_read_ahead_buf_byte = val
+
+
+@oneflow_export("config.enable_mmap_data_reader")
+def api_enable_mmap_data_reader(val: bool = True) -> None:
+    r"""Whether or not read local OneRec and OFRecord files through memory mappings,
+    handing out the payloads without copying them.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_mmap_data_reader, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_mmap_data_reader(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_mmap_data_reader = val
+
+
+@oneflow_export("config.data_reader_load_thread_num")
+def api_data_reader_load_thread_num(val: int) -> None:
+    r"""Set up the number of threads a data reader loads batches with, each of which reads
+    its own data parts.
+
+    Args:
+        val (int): e.g. 4. Defaults to 1.
+    """
+    return enable_if.unique([data_reader_load_thread_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_load_thread_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    assert val > 0
+    sess.config_proto.io_conf.data_reader_load_thread_num = val
+
+
+@oneflow_export("config.data_reader_batch_buffer_size")
+def api_data_reader_batch_buffer_size(val: int) -> None:
+    r"""Set up the number of loaded batches a data reader keeps.
+
+    Args:
+        val (int): e.g. 4. Defaults to 4.
+    """
+    return enable_if.unique([data_reader_batch_buffer_size, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_batch_buffer_size(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    assert val > 0
+    sess.config_proto.io_conf.data_reader_batch_buffer_size = val
+
+
+@oneflow_export("config.data_reader_deterministic_interleave")
+def api_data_reader_deterministic_interleave(val: bool = True) -> None:
+    r"""Whether or not a data reader takes the batches from its load threads in turn. If not,
+    whichever batch is loaded first is taken.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([data_reader_deterministic_interleave, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def data_reader_deterministic_interleave(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.data_reader_deterministic_interleave = val
+
+
+
+@oneflow_export("config.enable_async_snapshot_writer")
+def api_enable_async_snapshot_writer(val: bool = True) -> None:
+    r"""Whether or not to write model snapshots in the background. Saving a model then only
+    copies the variables into staging buffers, and a snapshot is complete once its
+    snapshot_done file exists.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_async_snapshot_writer, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_async_snapshot_writer(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.io_conf.enable_async_snapshot_writer = val
+
+
+@oneflow_export("config.async_snapshot_writer_thread_num")
+def api_async_snapshot_writer_thread_num(val: int) -> None:
+    r"""Set up the number of io threads writing model snapshots in the background.
+
+    Args:
+        val (int): e.g. 8. Defaults to 4.
+    """
+    return enable_if.unique([async_snapshot_writer_thread_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def async_snapshot_writer_thread_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    assert val > 0
+    sess.config_proto.io_conf.async_snapshot_writer_thread_num = val
+
+
 @oneflow_export("config.legacy_model_io_enabled")
 def api_legacy_model_io_enabled():
     sess = session_ctx.GetDefaultSession()
@@ -638,6 +787,382 @@ def nccl_enable_mixed_fusion(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_enable_mixed_fusion = val
 
 
+@oneflow_export("config.host_memory_pool.enable")
+def api_enable_host_memory_pool(val: bool = True) -> None:
+    r"""Whether or not to serve unpinned host memory from a size-classed, thread-caching pool
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_host_memory_pool, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_host_memory_pool(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.host_memory_pool_conf.enable = val
+
+
+@oneflow_export("config.host_memory_pool.max_cached_mbyte")
+def api_host_memory_pool_max_cached_mbyte(val: int) -> None:
+    r"""Set up the upper bound of free memory kept by the host memory pool
+
+    Args:
+        val (int): size in MiB
+    """
+    return enable_if.unique([host_memory_pool_max_cached_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def host_memory_pool_max_cached_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.host_memory_pool_conf.max_cached_mbyte = val
+
+
+@oneflow_export("config.host_memory_pool.thread_cache_mbyte")
+def api_host_memory_pool_thread_cache_mbyte(val: int) -> None:
+    r"""Set up the upper bound of free memory each thread keeps in its own host memory pool cache
+
+    Args:
+        val (int): size in MiB
+    """
+    return enable_if.unique([host_memory_pool_thread_cache_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def host_memory_pool_thread_cache_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.host_memory_pool_conf.thread_cache_mbyte = val
+
+
+@oneflow_export("config.host_memory_pool.use_huge_page_arena")
+def api_host_memory_pool_use_huge_page_arena(val: bool = True) -> None:
+    r"""Whether or not to carve host memory pool blocks out of transparent huge page backed arenas
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([host_memory_pool_use_huge_page_arena, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def host_memory_pool_use_huge_page_arena(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.host_memory_pool_conf.use_huge_page_arena = val
+
+
+@oneflow_export("config.regst_mem_init.force_zero_init")
+def api_regst_mem_init_force_zero_init(val: bool = True) -> None:
+    r"""Whether to zero-fill all register memory at session start, including the memory
+    that the plan proves to be overwritten before it is read
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([regst_mem_init_force_zero_init, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def regst_mem_init_force_zero_init(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.regst_mem_init_conf.force_zero_init = val
+
+
+@oneflow_export("config.regst_mem_init.parallel_host_zero_init")
+def api_regst_mem_init_parallel_host_zero_init(val: bool = True) -> None:
+    r"""Whether to zero-fill large host register memory with the compute thread pool. It is
+    ignored under a thread placement, which keeps the memory on the numa node of its user.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([regst_mem_init_parallel_host_zero_init, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def regst_mem_init_parallel_host_zero_init(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.regst_mem_init_conf.parallel_host_zero_init = val
+
+
+@oneflow_export("config.thread_placement.policy")
+def api_thread_placement_policy(val: str) -> None:
+    r"""Set how actor threads and compute thread pool workers are pinned to cpus
+
+    Args:
+        val (str): "none" leaves scheduling to the os, "numa_node" pins every thread to all cpus
+            of one numa node and "core" pins every thread to a single cpu. Threads are spread
+            over numa nodes round robin.
+    """
+    return enable_if.unique([thread_placement_policy, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_placement_policy(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    policies = {
+        "none": resource_util.kThreadPlacementNone,
+        "numa_node": resource_util.kThreadPlacementNumaNode,
+        "core": resource_util.kThreadPlacementCore,
+    }
+    assert val in policies, "unknown thread placement policy: " + val
+    sess.config_proto.resource.thread_placement_conf.policy = policies[val]
+
+
+@oneflow_export("config.thread_placement.pin_thread_pool")
+def api_thread_placement_pin_thread_pool(val: bool = True) -> None:
+    r"""Whether to pin the compute thread pool workers as well when a thread placement policy is set
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([thread_placement_pin_thread_pool, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def thread_placement_pin_thread_pool(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.thread_placement_conf.pin_thread_pool = val
+
+
+@oneflow_export("config.epoll_comm_net.max_write_batch_msg_num")
+def api_epoll_comm_net_max_write_batch_msg_num(val: int) -> None:
+    r"""Set the maximum number of messages coalesced into one socket write in epoll mode network
+
+    Args:
+        val (int): number of messages.
+    """
+    return enable_if.unique([epoll_comm_net_max_write_batch_msg_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_max_write_batch_msg_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.max_write_batch_msg_num = val
+
+
+@oneflow_export("config.epoll_comm_net.max_write_batch_kbyte")
+def api_epoll_comm_net_max_write_batch_kbyte(val: int) -> None:
+    r"""Set the maximum number of kilobytes coalesced into one socket write in epoll mode network
+
+    Args:
+        val (int): size in KB.
+    """
+    return enable_if.unique([epoll_comm_net_max_write_batch_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_max_write_batch_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.max_write_batch_kbyte = val
+
+
+@oneflow_export("config.epoll_comm_net.enable_zerocopy")
+def api_enable_epoll_comm_net_zerocopy(val: bool = True) -> None:
+    r"""Whether to send large regst bodies with MSG_ZEROCOPY in epoll mode network
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_epoll_comm_net_zerocopy, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_epoll_comm_net_zerocopy(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.epoll_comm_net_conf.enable_zerocopy = val
+
+
+@oneflow_export("config.epoll_comm_net.zerocopy_threshold_kbyte")
+def api_epoll_comm_net_zerocopy_threshold_kbyte(val: int) -> None:
+    r"""Set the minimum size of regst bodies sent with MSG_ZEROCOPY in epoll mode network
+
+    Args:
+        val (int): size in KB.
+    """
+    return enable_if.unique([epoll_comm_net_zerocopy_threshold_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_zerocopy_threshold_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.zerocopy_threshold_kbyte = val
+
+
+@oneflow_export("config.epoll_comm_net.stripe_socket_num")
+def api_epoll_comm_net_stripe_socket_num(val: int) -> None:
+    r"""Set the number of sockets regst bodies to a peer are striped over in epoll mode network
+
+    Args:
+        val (int): number of sockets.
+    """
+    return enable_if.unique([epoll_comm_net_stripe_socket_num, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_stripe_socket_num(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.stripe_socket_num = val
+
+
+@oneflow_export("config.epoll_comm_net.stripe_chunk_kbyte")
+def api_epoll_comm_net_stripe_chunk_kbyte(val: int) -> None:
+    r"""Set the chunk size large regst bodies are split into when striped in epoll mode network
+
+    Args:
+        val (int): chunk size in kilobytes.
+    """
+    return enable_if.unique([epoll_comm_net_stripe_chunk_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_stripe_chunk_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.stripe_chunk_kbyte = val
+
+
+@oneflow_export("config.epoll_comm_net.enable_low_latency_lane")
+def api_enable_epoll_comm_net_low_latency_lane(val: bool = True) -> None:
+    r"""Whether to send actor messages through a socket of their own in epoll mode network
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_epoll_comm_net_low_latency_lane, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_epoll_comm_net_low_latency_lane(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.epoll_comm_net_conf.enable_low_latency_lane = val
+
+
+@oneflow_export("config.epoll_comm_net.enable_shm_transport")
+def api_enable_epoll_comm_net_shm_transport(val: bool = True) -> None:
+    r"""Whether to send regst bodies to processes on the same host through shared memory
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_epoll_comm_net_shm_transport, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_epoll_comm_net_shm_transport(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.epoll_comm_net_conf.enable_shm_transport = val
+
+
+@oneflow_export("config.epoll_comm_net.shm_ring_mbyte")
+def api_epoll_comm_net_shm_ring_mbyte(val: int) -> None:
+    r"""Set the size of the shared memory rings between processes on the same host
+
+    Args:
+        val (int): ring size in megabytes.
+    """
+    return enable_if.unique([epoll_comm_net_shm_ring_mbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_shm_ring_mbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.shm_ring_mbyte = val
+
+
+@oneflow_export("config.epoll_comm_net.enable_lz4_wire_codec")
+def api_enable_epoll_comm_net_lz4_wire_codec(val: bool = True) -> None:
+    r"""Whether to compress regst bodies with LZ4 before sending them in epoll mode network
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_epoll_comm_net_lz4_wire_codec, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_epoll_comm_net_lz4_wire_codec(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.epoll_comm_net_conf.enable_lz4_wire_codec = val
+
+
+@oneflow_export("config.epoll_comm_net.fp32_wire_codec")
+def api_epoll_comm_net_fp32_wire_codec(val: str) -> None:
+    r"""Set the lossy codec for regst bodies holding only fp32 gradients in epoll mode network
+
+    Args:
+        val (str): "none", "fp16", "bf16" or "topk", which sends only the values of the largest
+            magnitude, see topk_ratio, and the dropped ones in later steps.
+    """
+    return enable_if.unique([epoll_comm_net_fp32_wire_codec, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_fp32_wire_codec(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is str
+    codecs = {
+        "none": resource_util.kWireCodecNone,
+        "fp16": resource_util.kWireCodecFp16,
+        "bf16": resource_util.kWireCodecBf16,
+        "topk": resource_util.kWireCodecTopK,
+    }
+    assert val in codecs, "unknown fp32 wire codec: " + val
+    sess.config_proto.resource.epoll_comm_net_conf.fp32_wire_codec = codecs[val]
+
+
+@oneflow_export("config.epoll_comm_net.wire_codec_min_kbyte")
+def api_epoll_comm_net_wire_codec_min_kbyte(val: int) -> None:
+    r"""Set the minimum size of the regst bodies which are compressed in epoll mode network
+
+    Args:
+        val (int): size in kilobytes.
+    """
+    return enable_if.unique([epoll_comm_net_wire_codec_min_kbyte, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_wire_codec_min_kbyte(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.epoll_comm_net_conf.wire_codec_min_kbyte = val
+
+
+@oneflow_export("config.epoll_comm_net.topk_ratio")
+def api_epoll_comm_net_topk_ratio(val: float) -> None:
+    r"""Set the ratio of the fp32 values kept by the topk wire codec in epoll mode network
+
+    Args:
+        val (float): ratio in (0, 1].
+    """
+    return enable_if.unique([epoll_comm_net_topk_ratio, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def epoll_comm_net_topk_ratio(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is float
+    assert val > 0 and val <= 1
+    sess.config_proto.resource.epoll_comm_net_conf.topk_ratio = val
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
@@ -807,6 +807,18 @@ def set_enable_fuse_model_update_ops(func_desc, value=True):
     func_desc.job_config_proto.set_enable_fuse_model_update_ops(value)
 
 
+@oneflow_function_config("enable_multi_tensor_model_update")
+def set_enable_multi_tensor_model_update(func_desc, value=True):
+    r"""Whether enable multi_tensor_model_update.
+            If enabled, the cpu sgd, momentum and adam updates of the variables sharing a learning rate, attrs and placement are grouped into one op, which updates them all in one launch. The gpu updates are not grouped.
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_enable_multi_tensor_model_update(value)
+
+
 @oneflow_function_config("enable_gradients_stats_aggregation")
 def set_enable_gradients_stats_aggregation(func_desc, value=True):
     r"""Whether enable gradients_stats_aggregation.
@@ -28,6 +28,8 @@ import oneflow.python.framework.interpret_util as interpret_util
 import oneflow.python.framework.remote_blob as remote_blob_util
 from oneflow.python.oneflow_export import oneflow_export, oneflow_deprecate
 import oneflow_api
+import os
+import struct
 import traceback
 
 
@@ -290,6 +292,7 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    global_shuffle: bool = False,
     name: Optional[str] = None,
 ) -> oneflow_api.BlobDesc:
     r"""Get ofrecord object from ofrecord dataset.
@@ -303,6 +306,7 @@ def ofrecord_reader(
         random_shuffle (bool, optional): Determines records shuffled or not. Defaults to False.
         shuffle_buffer_size (int, optional): Shuffle buffer size. Defaults to 1024.
         shuffle_after_epoch (bool, optional): Shuffled or not after each epoch. Defaults to False.
+        global_shuffle (bool, optional): Read all the records in a new global permutation every epoch, which needs the index files built by `flow.data.build_record_index`. `random_shuffle` and `shuffle_after_epoch` are ignored then. Defaults to False.
         name (Optional[str], optional): Optional name. Defaults to None.
         
     Returns:
@@ -365,6 +369,7 @@ def ofrecord_reader(
         .Attr("random_shuffle", random_shuffle)
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
+        .Attr("global_shuffle", global_shuffle)
         .Attr("part_name_suffix_length", part_name_suffix_length)
         .Build()
         .InferAndTryRun()
@@ -478,9 +483,18 @@ def onerec_reader(
     shuffle_buffer_size=1024,
     shuffle_after_epoch=False,
     verify_example=True,
+    checksum_policy="always",
+    checksum_sample_interval=100,
     name=None,
 ):
+    r"""Read OneRec files.
+
+    `checksum_policy` decides which payload digests are verified: "always", "sampled" (one in
+    every `checksum_sample_interval` samples), "first_epoch" or "off". Header digests are always
+    verified.
+    """
     assert isinstance(files, (list, tuple))
+    assert checksum_policy in ("always", "sampled", "first_epoch", "off")
 
     if name is None:
         name = id_util.UniqueStr("OneRecReader_")
@@ -496,7 +510,56 @@ def onerec_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("verify_example", verify_example)
+        .Attr("checksum_policy", checksum_policy)
+        .Attr("checksum_sample_interval", checksum_sample_interval)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
     )
+
+
+_record_index_magic = b"OFRECIDX"
+_onerec_magic = b"^ONEREC$"
+
+
+@oneflow_export("data.build_record_index")
+def build_record_index(files: Sequence[str], record_format: str = "ofrecord") -> None:
+    r"""Write the index file of every local OFRecord or OneRec data file next to it, e.g.
+    `part-0.idx` of `part-0`, with which readers can read the records in any order.
+
+    Args:
+        files (Sequence[str]): Paths to the data files.
+        record_format (str, optional): "ofrecord" or "onerec". Defaults to "ofrecord".
+    """
+    assert record_format in ("ofrecord", "onerec")
+    for path in files:
+        entries = []
+        with open(path, "rb") as f:
+            offset = 0
+            while True:
+                if record_format == "ofrecord":
+                    head = f.read(8)
+                    if len(head) == 0:
+                        break
+                    assert len(head) == 8, path
+                    (length,) = struct.unpack("<q", head)
+                    record_offset = offset + 8
+                    frame_size = 8 + length
+                else:
+                    head = f.read(24)
+                    if len(head) == 0:
+                        break
+                    assert len(head) == 24 and head[:8] == _onerec_magic, path
+                    (length,) = struct.unpack("<i", head[12:16])
+                    record_offset = offset + 24
+                    frame_size = 24 + (length + 7) // 8 * 8 + 8
+                assert length > 0, path
+                entries.append((record_offset, length))
+                offset += frame_size
+                f.seek(offset)
+            assert offset == os.path.getsize(path), path
+        with open(path + ".idx", "wb") as f:
+            f.write(_record_index_magic)
+            f.write(struct.pack("<q", len(entries)))
+            for entry in entries:
+                f.write(struct.pack("<qq", *entry))
@@ -1083,6 +1083,183 @@ def image_decode(
     return op.InferAndTryRun().SoleOutputBlob()
 
 
+@oneflow_export("image.decode_crop_resize_normalize")
+def api_image_decode_crop_resize_normalize(
+    images_bytes_buffer: oneflow_api.BlobDesc,
+    target_width: int,
+    target_height: int,
+    mirror_blob: Optional[oneflow_api.BlobDesc] = None,
+    color_space: str = "BGR",
+    interpolation_type: str = "bilinear",
+    random_crop: bool = True,
+    num_attempts: int = 10,
+    seed: Optional[int] = None,
+    random_area: Sequence[float] = [0.08, 1.0],
+    random_aspect_ratio: Sequence[float] = [0.75, 1.333333],
+    mean: Sequence[float] = [0.0],
+    std: Sequence[float] = [1.0],
+    output_layout: str = "NCHW",
+    output_dtype: dtype_util.dtype = dtype_util.float,
+    name: str = "ImageDecodeCropResizeNormalize",
+) -> oneflow_api.BlobDesc:
+    """This operator decodes the images, crops them randomly, resizes them to the target size, flips
+    and normalizes them, all in one pass over every image, and writes them into one Blob.
+    It does what `flow.image.decode`, `flow.image.random_crop`, `flow.image.resize` and
+    `flow.image.crop_mirror_normalize` do together, without the images in between. Only the
+    crop window of a JPEG image is decoded.
+
+    Args:
+        images_bytes_buffer (oneflow_api.BlobDesc): The encoded images, a Blob of type `kTensorBuffer`, e.g. the output of `flow.data.OFRecordBytesDecoder`.
+        target_width (int): The width of the output images.
+        target_height (int): The height of the output images.
+        mirror_blob (Optional[oneflow_api.BlobDesc], optional): Whether to flip every image horizontally, the images are not flipped if it is `None`. Defaults to None.
+        color_space (str, optional): The color space, "BGR", "RGB" or "GRAY". Defaults to "BGR".
+        interpolation_type (str, optional): The interpolation of the resizing. Defaults to "bilinear".
+        random_crop (bool, optional): Whether to crop the images randomly, the whole images are resized if it is False. Defaults to True.
+        num_attempts (int, optional): The maximum number of random cropping attempts. Defaults to 10.
+        seed (Optional[int], optional): The random seed. Defaults to None.
+        random_area (Sequence[float], optional): The random cropping area. Defaults to [0.08, 1.0].
+        random_aspect_ratio (Sequence[float], optional): The random scaled ratio. Defaults to [0.75, 1.333333].
+        mean (Sequence[float], optional): The mean value for normalization. Defaults to [0.0].
+        std (Sequence[float], optional): The standard deviation values for normalization. Defaults to [1.0].
+        output_layout (str, optional): The output format, "NCHW" or "NHWC". Defaults to "NCHW".
+        output_dtype (dtype_util.dtype, optional): The datatype of output Blob, `flow.float` or `flow.float16`. Defaults to dtype_util.float.
+        name (str, optional): The name for the operation. Defaults to "ImageDecodeCropResizeNormalize".
+
+    Returns:
+        oneflow_api.BlobDesc: The result Blob
+
+    For example:
+
+    .. code-block:: python
+
+        import oneflow as flow
+        import oneflow.typing as tp
+        from typing import Tuple
+
+
+        @flow.global_function(type="predict")
+        def train_data_job() -> Tuple[tp.Numpy, tp.Numpy]:
+            batch_size = 16
+            ofrecord = flow.data.ofrecord_reader(
+                "./imgdataset",
+                batch_size=batch_size,
+                data_part_num=1,
+                part_name_suffix_length=-1,
+                part_name_prefix='part-',
+                random_shuffle=True,
+                shuffle_after_epoch=True,
+            )
+            encoded = flow.data.OFRecordBytesDecoder(ofrecord, "encoded")
+            rng = flow.random.CoinFlip(batch_size=batch_size)
+            image = flow.image.decode_crop_resize_normalize(
+                encoded,
+                target_width=224,
+                target_height=224,
+                mirror_blob=rng,
+                color_space="RGB",
+                mean=[123.68, 116.779, 103.939],
+                std=[58.393, 57.12, 57.375],
+            )
+            label = flow.data.OFRecordRawDecoder(
+                ofrecord, "class/label", shape=(), dtype=flow.int32
+            )
+
+            return image, label
+
+        if __name__ == "__main__":
+            images, labels = train_data_job()
+            # images.shape (16, 3, 224, 224)
+
+    """
+    assert isinstance(name, str)
+    if seed is not None:
+        assert name is not None
+    module = flow.find_or_create_module(
+        name,
+        lambda: ImageDecodeCropResizeNormalizeModule(
+            target_width=target_width,
+            target_height=target_height,
+            has_mirror=mirror_blob is not None,
+            color_space=color_space,
+            interpolation_type=interpolation_type,
+            random_crop=random_crop,
+            num_attempts=num_attempts,
+            random_seed=seed,
+            random_area=random_area,
+            random_aspect_ratio=random_aspect_ratio,
+            mean=mean,
+            std=std,
+            output_layout=output_layout,
+            output_dtype=output_dtype,
+            name=name,
+        ),
+    )
+    return module(images_bytes_buffer, mirror_blob)
+
+
+class ImageDecodeCropResizeNormalizeModule(module_util.Module):
+    def __init__(
+        self,
+        target_width: int,
+        target_height: int,
+        has_mirror: bool,
+        color_space: str,
+        interpolation_type: str,
+        random_crop: bool,
+        num_attempts: int,
+        random_seed: Optional[int],
+        random_area: Sequence[float],
+        random_aspect_ratio: Sequence[float],
+        mean: Sequence[float],
+        std: Sequence[float],
+        output_layout: str,
+        output_dtype: dtype_util.dtype,
+        name: str,
+    ):
+        module_util.Module.__init__(self, name)
+        seed, has_seed = flow.random.gen_seed(random_seed)
+        self.op_module_builder = flow.user_op_module_builder(
+            "image_decode_crop_resize_normalize"
+        ).InputSize("in", 1)
+        if has_mirror:
+            self.op_module_builder = self.op_module_builder.InputSize("mirror", 1)
+        self.op_module_builder = (
+            self.op_module_builder.Output("out")
+            .Attr("color_space", color_space)
+            .Attr("target_width", target_width)
+            .Attr("target_height", target_height)
+            .Attr("interpolation_type", interpolation_type)
+            .Attr("random_crop", random_crop)
+            .Attr("num_attempts", num_attempts)
+            .Attr("random_area", random_area)
+            .Attr("random_aspect_ratio", random_aspect_ratio)
+            .Attr("has_seed", has_seed)
+            .Attr("seed", seed)
+            .Attr("mean", mean)
+            .Attr("std", std)
+            .Attr("output_layout", output_layout)
+            .Attr("output_dtype", output_dtype)
+            .CheckAndComplete()
+        )
+        self.op_module_builder.user_op_module.InitOpKernel()
+
+    def forward(
+        self,
+        input: oneflow_api.BlobDesc,
+        mirror: Optional[oneflow_api.BlobDesc] = None,
+    ):
+        if self.call_seq_no == 0:
+            name = self.module_name
+        else:
+            name = id_util.UniqueStr("ImageDecodeCropResizeNormalize_")
+
+        op = self.op_module_builder.OpName(name).Input("in", [input])
+        if mirror is not None:
+            op = op.Input("mirror", [mirror])
+        return op.Build().InferAndTryRun().SoleOutputBlob()
+
+
 @oneflow_export("image.batch_align", "image_batch_align")
 def image_batch_align(
     images: oneflow_api.BlobDesc,
@@ -2221,6 +2398,9 @@ def ofrecord_image_classification_reader(
     color_space: str = "BGR",
     decode_buffer_size_per_thread: int = 32,
     num_decode_threads_per_machine: Optional[int] = None,
+    cache_memory_size_mb: int = 0,
+    cache_spill_file_path: str = "",
+    cache_spill_size_mb: int = 0,
     name: Optional[str] = None,
 ) -> oneflow_api.BlobDesc:
     """This operator creates a reader for image classification tasks. 
@@ -2239,6 +2419,9 @@ def ofrecord_image_classification_reader(
         color_space (str, optional): The color space. Defaults to "BGR".
         decode_buffer_size_per_thread (int, optional): The decode buffer size for per thread. Defaults to 32.
         num_decode_threads_per_machine (Optional[int], optional): The amounts of decode threads for each machine. Defaults to None.
+        cache_memory_size_mb (int, optional): The memory size in MB of the cache of the decoded images and labels. The later epochs read the cached samples instead of reading and decoding them again. The cache needs the index files built by `flow.data.build_record_index`, and shuffles the samples of every rank every epoch if `random_shuffle`. 0 disables the cache unless there is a spill file. Defaults to 0.
+        cache_spill_file_path (str, optional): The local file the cache spills the samples evicted from memory to, suffixed with the rank. No sample is spilled if it is empty. Defaults to "".
+        cache_spill_size_mb (int, optional): The maximum size in MB of the spill file. Defaults to 0.
         name (Optional[str], optional): The name for the operation. Defaults to None.
 
     Returns:
@@ -2299,6 +2482,9 @@ def ofrecord_image_classification_reader(
         .Attr("label_feature_name", label_feature_name)
         .Attr("decode_buffer_size_per_thread", decode_buffer_size_per_thread)
         .Attr("num_decode_threads_per_machine", num_decode_threads_per_machine or 0)
+        .Attr("cache_memory_size_mb", cache_memory_size_mb)
+        .Attr("cache_spill_file_path", cache_spill_file_path)
+        .Attr("cache_spill_size_mb", cache_spill_size_mb)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()
@@ -0,0 +1,168 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _of_fused_and_unfused(
+    images,
+    target_width,
+    target_height,
+    color_space,
+    random_area,
+    mean,
+    std,
+    output_layout,
+    seed,
+):
+    image_files = [open(im, "rb") for im in images]
+    images_bytes = [imf.read() for imf in image_files]
+    static_shape = (len(images_bytes), max([len(bys) for bys in images_bytes]))
+    for imf in image_files:
+        imf.close()
+
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.mirrored_view())
+
+    @flow.global_function(function_config=func_config)
+    def image_decode_crop_resize_normalize_job(
+        images_def: oft.ListListNumpy.Placeholder(shape=static_shape, dtype=flow.int8),
+        mirror_def: oft.ListNumpy.Placeholder(shape=(len(images),), dtype=flow.int8),
+    ):
+        images_buffer = flow.tensor_list_to_tensor_buffer(images_def)
+        fused = flow.image.decode_crop_resize_normalize(
+            images_buffer,
+            target_width=target_width,
+            target_height=target_height,
+            mirror_blob=mirror_def,
+            color_space=color_space,
+            interpolation_type="bilinear",
+            seed=seed,
+            random_area=random_area,
+            mean=mean,
+            std=std,
+            output_layout=output_layout,
+            name="FusedImageDecodeCropResizeNormalize",
+        )
+        decoded = flow.image.decode(images_buffer, color_space=color_space)
+        cropped = flow.image.random_crop(
+            decoded,
+            seed=seed,
+            random_area=random_area,
+            random_aspect_ratio=[0.75, 1.333333],
+        )
+        resized, _, _ = flow.image.resize(
+            cropped,
+            target_size=(target_width, target_height),
+            channels=3 if color_space != "GRAY" else 1,
+            interpolation_type="bilinear",
+        )
+        unfused = flow.image.crop_mirror_normalize(
+            resized,
+            mirror_blob=mirror_def,
+            color_space=color_space,
+            output_layout=output_layout,
+            mean=mean,
+            std=std,
+            output_dtype=flow.float,
+        )
+        return fused, unfused
+
+    images_np_arr = [
+        np.frombuffer(bys, dtype=np.byte).reshape(1, -1) for bys in images_bytes
+    ]
+    mirror = np.array([i % 2 for i in range(len(images))], dtype=np.int8)
+    fused, unfused = image_decode_crop_resize_normalize_job(
+        [images_np_arr], [mirror]
+    ).get()
+    return fused.numpy_list()[0], unfused.numpy_list()[0]
+
+
+def _compare_with_unfused(
+    test_case,
+    images,
+    target_width,
+    target_height,
+    random_area,
+    max_mean_abs_diff,
+    **kwargs
+):
+    for color_space in ["BGR", "RGB"]:
+        for output_layout in ["NCHW", "NHWC"]:
+            fused, unfused = _of_fused_and_unfused(
+                images,
+                target_width,
+                target_height,
+                color_space,
+                random_area,
+                output_layout=output_layout,
+                seed=1234,
+                **kwargs
+            )
+            test_case.assertEqual(fused.shape, unfused.shape)
+            mean_abs_diff = np.mean(np.abs(fused - unfused))
+            test_case.assertTrue(
+                mean_abs_diff <= max_mean_abs_diff,
+                "{} {}: mean abs diff {}".format(
+                    color_space, output_layout, mean_abs_diff
+                ),
+            )
+
+
+_images = [
+    "/dataset/mscoco_2017/val2017/000000000139.jpg",
+    "/dataset/mscoco_2017/val2017/000000000632.jpg",
+]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestImageDecodeCropResizeNormalize(flow.unittest.TestCase):
+    def test_same_as_unfused_without_downscaling(test_case):
+        # crops of at least 90% of a 640 pixel wide image are never downscaled in the
+        # DCT domain for a width of 600, then the roi decode and the normalization
+        # match the unfused ops up to float rounding
+        _compare_with_unfused(
+            test_case,
+            _images,
+            target_width=600,
+            target_height=400,
+            random_area=[0.9, 1.0],
+            max_mean_abs_diff=1e-4,
+            mean=[123.68, 116.779, 103.939],
+            std=[58.393, 57.12, 57.375],
+        )
+
+    def test_close_to_unfused_with_downscaling(test_case):
+        # libjpeg downscales the crop windows towards 112x112, which the unfused ops
+        # resize from the full resolution, so the pixels differ by a few gray levels
+        _compare_with_unfused(
+            test_case,
+            _images,
+            target_width=112,
+            target_height=112,
+            random_area=[0.08, 1.0],
+            max_mean_abs_diff=4.0,
+            mean=[0.0],
+            std=[1.0],
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -21,6 +21,7 @@ import numpy as np
 import oneflow as flow
 import tensorflow as tf
 import test_global_storage
+from oneflow.python.framework import c_api_util
 from test_util import GenArgList
 
 
@@ -980,6 +981,94 @@ def compare_with_flow_job_fused_adam_model_update(
     assert np.allclose(var1.flatten(), var2.flatten(), rtol=1e-4, atol=1e-4,)
 
 
+def compare_with_flow_job_multi_tensor_model_update(
+    device_type, optimizer_type, x_shape, learning_rate, train_iters
+):
+    assert device_type in ["gpu", "cpu"]
+    assert optimizer_type in ["sgd", "momentum", "adam"]
+    flow.clear_default_session()
+
+    def make_optimizer():
+        lr_scheduler = flow.optimizer.PiecewiseConstantScheduler([], [learning_rate])
+        if optimizer_type == "sgd":
+            return flow.optimizer.SGD(lr_scheduler, momentum=0.0)
+        if optimizer_type == "momentum":
+            return flow.optimizer.SGD(lr_scheduler, momentum=0.9)
+        return flow.optimizer.Adam(lr_scheduler, do_bias_correction=True)
+
+    def flow_net(var_name_prefix, random_mask):
+        with flow.scope.placement(device_type, "0:0-0"):
+            xs = []
+            for i in range(3):
+                x = flow.get_variable(
+                    name="{}_{}".format(var_name_prefix, i),
+                    shape=x_shape,
+                    dtype=flow.float32,
+                    initializer=flow.ones_initializer(),
+                    trainable=True,
+                )
+                xs.append(x * (i + 1.0))
+            x = flow.math.add_n(xs)
+            loss = flow.math.reduce_mean(x * random_mask)
+            make_optimizer().minimize(loss)
+            return x
+
+    def make_job():
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float32)
+
+        @flow.global_function(type="train", function_config=func_config)
+        def testModelUpdate(
+            random_mask: flow.typing.Numpy.Placeholder(x_shape, dtype=flow.float32)
+        ) -> flow.typing.Numpy:
+            return flow_net("x1", random_mask)
+
+        return testModelUpdate
+
+    def make_multi_tensor_job():
+        func_config = flow.FunctionConfig()
+        func_config.default_data_type(flow.float32)
+        func_config.enable_multi_tensor_model_update(True)
+
+        @flow.global_function(type="train", function_config=func_config)
+        def testMultiTensorModelUpdate(
+            random_mask: flow.typing.Numpy.Placeholder(x_shape, dtype=flow.float32)
+        ) -> flow.typing.Numpy:
+            return flow_net("x2", random_mask)
+
+        return testMultiTensorModelUpdate
+
+    job = make_job()
+    multi_tensor_job = make_multi_tensor_job()
+    checkpoint = flow.train.CheckPoint()
+    checkpoint.init()
+
+    # generate random number sequences
+    random_masks_seq = []
+    for i in range(train_iters + 1):
+        random_masks_seq.append(np.random.uniform(size=x_shape).astype(np.float32))
+
+    for i in range(train_iters + 1):
+        var1 = job(random_masks_seq[i])
+
+    for i in range(train_iters + 1):
+        var2 = multi_tensor_job(random_masks_seq[i])
+    assert np.allclose(var1.flatten(), var2.flatten(), rtol=1e-4, atol=1e-4,)
+
+    # the updates of the variables are grouped in the multi tensor job only
+    multi_tensor_op_type_name = "multi_tensor_{}_update".format(optimizer_type)
+    job_name2op_type_names = {}
+    for job_proto in c_api_util.GetJobSet().job:
+        job_name2op_type_names[job_proto.job_conf.job_name] = [
+            op_conf.user_conf.op_type_name
+            for op_conf in job_proto.net.op
+            if op_conf.HasField("user_conf")
+        ]
+    assert multi_tensor_op_type_name not in job_name2op_type_names["testModelUpdate"]
+    op_type_names = job_name2op_type_names["testMultiTensorModelUpdate"]
+    assert op_type_names.count(multi_tensor_op_type_name) == 1
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestOptimizers(flow.unittest.TestCase):
     def test_rmsprop(test_case):
@@ -1132,6 +1221,17 @@ class TestOptimizers(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_flow_job_fused_adam_model_update(*arg)
 
+    def test_multi_tensor_model_update(test_case):
+        arg_dict = OrderedDict()
+        # the pass groups the cpu updates only
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["optimizer_type"] = ["sgd", "momentum", "adam"]
+        arg_dict["x_shape"] = [(10,)]
+        arg_dict["learning_rate"] = [1]
+        arg_dict["train_iters"] = [10]
+        for arg in GenArgList(arg_dict):
+            compare_with_flow_job_multi_tensor_model_update(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
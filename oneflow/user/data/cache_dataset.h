@@ -0,0 +1,275 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_CACHE_DATASET_H_
+#define ONEFLOW_USER_DATA_CACHE_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+namespace data {
+
+// Samples by their indices in a dataset, a sample being a list of tensor buffers. The samples are
+// kept in memory up to memory_byte_size, beyond which the least recently used ones are evicted.
+// An evicted sample is appended to the local spill file if spill_file_path is not empty and the
+// file has not grown to spill_byte_size yet, or else dropped.
+class SampleCache final {
+ public:
+  using Sample = std::vector<std::shared_ptr<TensorBuffer>>;
+  OF_DISALLOW_COPY_AND_MOVE(SampleCache);
+  SampleCache(int64_t memory_byte_size, const std::string& spill_file_path,
+              int64_t spill_byte_size)
+      : memory_byte_size_(memory_byte_size),
+        cur_memory_byte_size_(0),
+        spill_file_path_(spill_file_path),
+        spill_byte_size_(spill_byte_size),
+        cur_spill_byte_size_(0),
+        memory_hit_num_(0),
+        spill_hit_num_(0),
+        miss_num_(0) {
+    CHECK_GE(memory_byte_size_, 0);
+    if (!spill_file_path_.empty()) {
+      CHECK_GT(spill_byte_size_, 0);
+      LocalFS()->NewWritableFile(spill_file_path_, &spill_out_);
+      LocalFS()->NewRandomAccessFile(spill_file_path_, &spill_in_);
+    }
+  }
+  ~SampleCache() {
+    const int64_t lookup_num = memory_hit_num_ + spill_hit_num_ + miss_num_;
+    LOG(INFO) << "sample cache: " << lookup_num << " lookups, " << memory_hit_num_
+              << " memory hits, " << spill_hit_num_ << " spill hits, hit rate "
+              << (lookup_num > 0 ? static_cast<double>(lookup_num - miss_num_) / lookup_num : 0.0);
+    if (spill_out_) {
+      spill_out_->Close();
+      LocalFS()->DelFile(spill_file_path_);
+    }
+  }
+
+  // The cached sample of index, nullptr if it is not cached
+  std::shared_ptr<const Sample> Get(int64_t index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(index);
+    if (it != entries_.end()) {
+      memory_hit_num_ += 1;
+      lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+      return it->second.sample;
+    }
+    auto spilled_it = spilled_.find(index);
+    if (spilled_it == spilled_.end()) {
+      miss_num_ += 1;
+      return nullptr;
+    }
+    spill_hit_num_ += 1;
+    std::vector<char> buffer(spilled_it->second.second);
+    spill_in_->Read(spilled_it->second.first, buffer.size(), buffer.data());
+    std::shared_ptr<const Sample> sample = Deserialize(buffer);
+    Insert(index, sample);
+    return sample;
+  }
+
+  void Put(int64_t index, std::shared_ptr<const Sample> sample) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Insert(index, std::move(sample));
+  }
+
+  int64_t memory_hit_num() const { return memory_hit_num_; }
+  int64_t spill_hit_num() const { return spill_hit_num_; }
+  int64_t miss_num() const { return miss_num_; }
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Sample> sample;
+    int64_t byte_size;
+    std::list<int64_t>::iterator lru_it;
+  };
+
+  static int64_t ByteSize(const Sample& sample) {
+    int64_t byte_size = 0;
+    for (const auto& buffer : sample) { byte_size += buffer->nbytes(); }
+    return byte_size;
+  }
+
+  void Insert(int64_t index, std::shared_ptr<const Sample> sample) {
+    Erase(index);
+    const int64_t byte_size = ByteSize(*sample);
+    if (byte_size > memory_byte_size_) {
+      Spill(index, *sample);
+      return;
+    }
+    lru_.push_front(index);
+    entries_[index] = Entry{std::move(sample), byte_size, lru_.begin()};
+    cur_memory_byte_size_ += byte_size;
+    while (cur_memory_byte_size_ > memory_byte_size_) {
+      const int64_t evicted_index = lru_.back();
+      Spill(evicted_index, *entries_.at(evicted_index).sample);
+      Erase(evicted_index);
+    }
+  }
+
+  void Erase(int64_t index) {
+    auto it = entries_.find(index);
+    if (it == entries_.end()) { return; }
+    cur_memory_byte_size_ -= it->second.byte_size;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+  }
+
+  // A sample is spilled only once, the spilled one stays valid after it is read back
+  void Spill(int64_t index, const Sample& sample) {
+    if (!spill_out_ || spilled_.find(index) != spilled_.end()) { return; }
+    const std::vector<char> buffer = Serialize(sample);
+    if (cur_spill_byte_size_ + static_cast<int64_t>(buffer.size()) > spill_byte_size_) { return; }
+    spill_out_->Append(buffer.data(), buffer.size());
+    spill_out_->Flush();
+    spilled_[index] = std::make_pair(cur_spill_byte_size_, static_cast<int64_t>(buffer.size()));
+    cur_spill_byte_size_ += buffer.size();
+  }
+
+  // an int64 buffer num, then the data type, the axis num, the dims and the data of every buffer
+  static std::vector<char> Serialize(const Sample& sample) {
+    std::vector<char> ret;
+    auto AppendInt64 = [&](int64_t val) {
+      const char* ptr = reinterpret_cast<const char*>(&val);
+      ret.insert(ret.end(), ptr, ptr + sizeof(val));
+    };
+    AppendInt64(sample.size());
+    for (const auto& buffer : sample) {
+      AppendInt64(buffer->data_type());
+      AppendInt64(buffer->shape().NumAxes());
+      for (int64_t dim : buffer->shape().dim_vec()) { AppendInt64(dim); }
+      const char* data = static_cast<const char*>(buffer->data());
+      ret.insert(ret.end(), data, data + buffer->nbytes());
+    }
+    return ret;
+  }
+
+  static std::shared_ptr<const Sample> Deserialize(const std::vector<char>& buffer) {
+    size_t offset = 0;
+    auto ReadInt64 = [&]() {
+      int64_t val = 0;
+      CHECK_LE(offset + sizeof(val), buffer.size());
+      memcpy(&val, buffer.data() + offset, sizeof(val));
+      offset += sizeof(val);
+      return val;
+    };
+    std::shared_ptr<Sample> sample(new Sample(ReadInt64()));
+    for (auto& tensor_buffer : *sample) {
+      const DataType data_type = static_cast<DataType>(ReadInt64());
+      DimVector dim_vec(ReadInt64());
+      for (int64_t& dim : dim_vec) { dim = ReadInt64(); }
+      tensor_buffer.reset(new TensorBuffer());
+      tensor_buffer->Resize(Shape(dim_vec), data_type);
+      CHECK_LE(offset + tensor_buffer->nbytes(), buffer.size());
+      memcpy(tensor_buffer->mut_data(), buffer.data() + offset, tensor_buffer->nbytes());
+      offset += tensor_buffer->nbytes();
+    }
+    CHECK_EQ(offset, buffer.size());
+    return sample;
+  }
+
+  std::mutex mutex_;
+  // the most recently used first
+  std::list<int64_t> lru_;
+  HashMap<int64_t, Entry> entries_;
+  int64_t memory_byte_size_;
+  int64_t cur_memory_byte_size_;
+  std::string spill_file_path_;
+  std::unique_ptr<fs::WritableFile> spill_out_;
+  std::unique_ptr<fs::RandomAccessFile> spill_in_;
+  // the offset and the length in the spill file
+  HashMap<int64_t, std::pair<int64_t, int64_t>> spilled_;
+  int64_t spill_byte_size_;
+  int64_t cur_spill_byte_size_;
+  std::atomic<int64_t> memory_hit_num_;
+  std::atomic<int64_t> spill_hit_num_;
+  std::atomic<int64_t> miss_num_;
+};
+
+// Decodes the records of a random access dataset into samples and caches them, so that a sample
+// read again, e.g. in a later epoch, is neither read nor decoded. The samples handed out are
+// read-only views into the cached ones.
+class CacheDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  using LoadTargetShdPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  using Decoder = std::function<void(const TensorBuffer& record, SampleCache::Sample* sample)>;
+  OF_DISALLOW_COPY_AND_MOVE(CacheDataset);
+  CacheDataset(std::unique_ptr<RandomAccessDataset<TensorBuffer>>&& record_dataset,
+               const Decoder& decoder, std::unique_ptr<SampleCache>&& cache)
+      : record_dataset_(std::move(record_dataset)), decoder_(decoder), cache_(std::move(cache)) {}
+  ~CacheDataset() = default;
+
+  size_t Size() const override { return record_dataset_->Size(); }
+
+  LoadTargetShdPtrVec At(int64_t index) const override { return AtIndices({index}).front(); }
+
+  // Reads the missed records together, and decodes them in parallel
+  std::vector<LoadTargetShdPtrVec> AtIndices(const std::vector<int64_t>& indices) const override {
+    std::vector<LoadTargetShdPtrVec> ret(indices.size());
+    std::vector<int64_t> miss_indices;
+    std::vector<size_t> miss_positions;
+    FOR_RANGE(size_t, i, 0, indices.size()) {
+      std::shared_ptr<const SampleCache::Sample> sample = cache_->Get(indices.at(i));
+      if (sample) {
+        ret.at(i) = MakeViews(sample);
+      } else {
+        miss_indices.push_back(indices.at(i));
+        miss_positions.push_back(i);
+      }
+    }
+    if (miss_indices.empty()) { return ret; }
+    const std::vector<LoadTargetShdPtrVec> records = record_dataset_->AtIndices(miss_indices);
+    std::vector<std::shared_ptr<SampleCache::Sample>> samples(miss_indices.size());
+    MultiThreadLoop(miss_indices.size(), [&](size_t i) {
+      CHECK_EQ(records.at(i).size(), 1);
+      samples.at(i).reset(new SampleCache::Sample());
+      decoder_(*records.at(i).front(), samples.at(i).get());
+    });
+    FOR_RANGE(size_t, i, 0, miss_indices.size()) {
+      cache_->Put(miss_indices.at(i), samples.at(i));
+      ret.at(miss_positions.at(i)) = MakeViews(samples.at(i));
+    }
+    return ret;
+  }
+
+ private:
+  // the views keep the cached sample alive after it is evicted, and are read-only as the sample is
+  // shared with the cache
+  static LoadTargetShdPtrVec MakeViews(const std::shared_ptr<const SampleCache::Sample>& sample) {
+    LoadTargetShdPtrVec ret;
+    for (const auto& buffer : *sample) {
+      LoadTargetShdPtr view(new TensorBuffer());
+      if (buffer->nbytes() > 0) {
+        view->ResetToReadOnlyView(buffer->shape(), buffer->data_type(), buffer->data(), sample);
+      } else {
+        view->Resize(buffer->shape(), buffer->data_type());
+      }
+      ret.push_back(std::move(view));
+    }
+    return ret;
+  }
+
+  std::unique_ptr<RandomAccessDataset<TensorBuffer>> record_dataset_;
+  Decoder decoder_;
+  std::unique_ptr<SampleCache> cache_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_CACHE_DATASET_H_
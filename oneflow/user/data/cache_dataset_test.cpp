@@ -0,0 +1,191 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/user/data/cache_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// an int32 buffer of 80 bytes and an uint8 buffer of 20 bytes, filled by the index
+constexpr int64_t kSampleByteSize = 100;
+// the buffer num, then the data type, the axis num, the dims and the data of both buffers
+constexpr int64_t kSpilledSampleByteSize = 8 + (8 + 8 + 2 * 8 + 80) + (8 + 8 + 8 + 20);
+
+std::shared_ptr<const SampleCache::Sample> MakeSample(int64_t index) {
+  std::shared_ptr<SampleCache::Sample> sample(new SampleCache::Sample());
+  sample->emplace_back(new TensorBuffer());
+  sample->back()->Resize(Shape({5, 4}), DataType::kInt32);
+  int32_t* int32_data = sample->back()->mut_data<int32_t>();
+  FOR_RANGE(int32_t, i, 0, 20) { int32_data[i] = index * 100 + i; }
+  sample->emplace_back(new TensorBuffer());
+  sample->back()->Resize(Shape({20}), DataType::kUInt8);
+  uint8_t* uint8_data = sample->back()->mut_data<uint8_t>();
+  FOR_RANGE(uint8_t, i, 0, 20) { uint8_data[i] = static_cast<uint8_t>(index + i); }
+  return sample;
+}
+
+void CheckSample(int64_t index, const std::shared_ptr<const SampleCache::Sample>& sample) {
+  ASSERT_TRUE(sample) << "index: " << index;
+  const std::shared_ptr<const SampleCache::Sample> expected = MakeSample(index);
+  ASSERT_EQ(sample->size(), expected->size());
+  FOR_RANGE(size_t, i, 0, sample->size()) {
+    const TensorBuffer& buffer = *sample->at(i);
+    const TensorBuffer& expected_buffer = *expected->at(i);
+    ASSERT_EQ(buffer.data_type(), expected_buffer.data_type());
+    ASSERT_TRUE(buffer.shape() == expected_buffer.shape());
+    ASSERT_EQ(buffer.nbytes(), expected_buffer.nbytes());
+    ASSERT_EQ(memcmp(buffer.data(), expected_buffer.data(), buffer.nbytes()), 0)
+        << "index: " << index << " buffer: " << i;
+  }
+}
+
+// records of their own index, which are decoded into the samples of MakeSample
+class IndexRecordDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  size_t Size() const override { return 10; }
+
+  LoadTargetShdPtrVec At(int64_t index) const override {
+    LoadTargetShdPtr record(new TensorBuffer());
+    record->Resize(Shape({1}), DataType::kInt32);
+    record->mut_data<int32_t>()[0] = index;
+    return {record};
+  }
+};
+
+void DecodeIndexRecord(const TensorBuffer& record, SampleCache::Sample* sample) {
+  *sample = *MakeSample(record.data<int32_t>()[0]);
+}
+
+std::string SpillFilePath(const std::string& name) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  return JoinPath(current_dir, "tmp_sample_cache_" + name);
+}
+
+}  // namespace
+
+TEST(SampleCache, evicts_least_recently_used) {
+  SampleCache cache(3 * kSampleByteSize, "", 0);
+  FOR_RANGE(int64_t, i, 0, 3) { cache.Put(i, MakeSample(i)); }
+  // 0 becomes more recently used than 1 and 2
+  CheckSample(0, cache.Get(0));
+  cache.Put(3, MakeSample(3));
+  ASSERT_FALSE(cache.Get(1));
+  // then 2 is the least recently used one
+  cache.Put(4, MakeSample(4));
+  ASSERT_FALSE(cache.Get(2));
+  for (int64_t i : {0, 3, 4}) { CheckSample(i, cache.Get(i)); }
+  ASSERT_EQ(cache.memory_hit_num(), 4);
+  ASSERT_EQ(cache.spill_hit_num(), 0);
+  ASSERT_EQ(cache.miss_num(), 2);
+  // putting a cached index again replaces the sample without evicting any other one
+  cache.Put(3, MakeSample(3));
+  for (int64_t i : {0, 3, 4}) { CheckSample(i, cache.Get(i)); }
+  // a sample larger than the memory is not kept
+  SampleCache small_cache(kSampleByteSize - 1, "", 0);
+  small_cache.Put(0, MakeSample(0));
+  ASSERT_FALSE(small_cache.Get(0));
+}
+
+TEST(SampleCache, spills_evicted_and_reloads) {
+  const std::string spill_file_path = SpillFilePath("reload");
+  {
+    SampleCache cache(2 * kSampleByteSize, spill_file_path, 100 * kSpilledSampleByteSize);
+    FOR_RANGE(int64_t, i, 0, 4) { cache.Put(i, MakeSample(i)); }
+    // 0 and 1 are evicted to the spill file
+    ASSERT_TRUE(LocalFS()->FileExists(spill_file_path));
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 2 * kSpilledSampleByteSize);
+    CheckSample(0, cache.Get(0));
+    ASSERT_EQ(cache.spill_hit_num(), 1);
+    // reloading 0 brings it back to the memory, evicting 2 to the spill file
+    CheckSample(0, cache.Get(0));
+    ASSERT_EQ(cache.memory_hit_num(), 1);
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 3 * kSpilledSampleByteSize);
+    CheckSample(3, cache.Get(3));
+    ASSERT_EQ(cache.memory_hit_num(), 2);
+    // reloading 1 evicts 0 again, which is not spilled twice
+    CheckSample(1, cache.Get(1));
+    ASSERT_EQ(cache.spill_hit_num(), 2);
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 3 * kSpilledSampleByteSize);
+    // reloading 2 evicts 3 to the spill file
+    CheckSample(2, cache.Get(2));
+    ASSERT_EQ(cache.spill_hit_num(), 3);
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 4 * kSpilledSampleByteSize);
+    CheckSample(0, cache.Get(0));
+    CheckSample(3, cache.Get(3));
+    ASSERT_EQ(cache.spill_hit_num(), 5);
+    ASSERT_EQ(cache.miss_num(), 0);
+  }
+  // the spill file is deleted with the cache
+  ASSERT_FALSE(LocalFS()->FileExists(spill_file_path));
+}
+
+TEST(SampleCache, drops_evicted_beyond_spill_size) {
+  const std::string spill_file_path = SpillFilePath("drop");
+  {
+    SampleCache cache(2 * kSampleByteSize, spill_file_path, 2 * kSpilledSampleByteSize);
+    FOR_RANGE(int64_t, i, 0, 5) { cache.Put(i, MakeSample(i)); }
+    // 0 and 1 fill the spill file, so 2 is dropped
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 2 * kSpilledSampleByteSize);
+    ASSERT_FALSE(cache.Get(2));
+    ASSERT_EQ(cache.miss_num(), 1);
+    CheckSample(1, cache.Get(1));
+    CheckSample(0, cache.Get(0));
+    ASSERT_EQ(cache.spill_hit_num(), 2);
+    // the reloaded samples evicted 3 and 4, which are dropped as well
+    ASSERT_FALSE(cache.Get(3));
+    ASSERT_FALSE(cache.Get(4));
+    ASSERT_EQ(cache.miss_num(), 3);
+    ASSERT_EQ(LocalFS()->GetFileSize(spill_file_path), 2 * kSpilledSampleByteSize);
+  }
+  ASSERT_FALSE(LocalFS()->FileExists(spill_file_path));
+}
+
+TEST(CacheDataset, hands_out_read_only_views) {
+  Global<ThreadPool>::New(2);
+  CacheDataset dataset(std::unique_ptr<RandomAccessDataset<TensorBuffer>>(new IndexRecordDataset()),
+                       DecodeIndexRecord,
+                       std::unique_ptr<SampleCache>(new SampleCache(10 * kSampleByteSize, "", 0)));
+  // decoded, then cached
+  FOR_RANGE(int64_t, i, 0, 2) {
+    const std::vector<int64_t> indices = {3, 1, 3};
+    const std::vector<CacheDataset::LoadTargetShdPtrVec> samples = dataset.AtIndices(indices);
+    FOR_RANGE(size_t, j, 0, indices.size()) {
+      CheckSample(indices.at(j), std::make_shared<const SampleCache::Sample>(samples.at(j)));
+    }
+  }
+  Global<ThreadPool>::Delete();
+  CacheDataset::LoadTargetShdPtrVec sample = dataset.At(3);
+  TensorBuffer* view = sample.front().get();
+  ASSERT_TRUE(view->is_view());
+  EXPECT_DEATH(view->mut_data<int32_t>(), "read-only view");
+  // writing a copy, or the view once it is resized to a buffer of its own, leaves the cache alone
+  TensorBuffer copy;
+  copy.CopyFrom(*view);
+  copy.mut_data<int32_t>()[0] = -1;
+  view->Resize(view->shape());
+  ASSERT_FALSE(view->is_view());
+  view->mut_data<int32_t>()[0] = -1;
+  CheckSample(3, std::make_shared<const SampleCache::Sample>(dataset.At(3)));
+}
+
+}  // namespace data
+}  // namespace oneflow
@@ -16,73 +16,109 @@ limitations under the License.
 #ifndef ONEFLOW_USER_DATA_DATA_READER_H_
 #define ONEFLOW_USER_DATA_DATA_READER_H_
 
+#include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/buffer.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/user/data/dataset.h"
 #include "oneflow/user/data/parser.h"
 
 namespace oneflow {
 namespace data {
 
-static const int32_t kDataReaderBatchBufferSize = 4;
-
 template<typename LoadTarget>
 class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
-  DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+  using BatchBuffer = Buffer<std::shared_ptr<LoadTargetPtrList>>;
+  DataReader(user_op::KernelInitContext* ctx) : is_closed_(false), next_batch_buffer_idx_(0) {}
   virtual ~DataReader() {
     Close();
-    if (load_thrd_.joinable()) { load_thrd_.join(); }
+    for (std::thread& load_thrd : load_thrds_) { load_thrd.join(); }
   }
 
   void Read(user_op::KernelComputeContext* ctx) {
-    CHECK(load_thrd_.joinable()) << "You should call StartLoadThread before read data";
+    CHECK(!load_thrds_.empty()) << "You should call StartLoadThread before read data";
     auto batch_data = FetchBatchData();
     parser_->Parse(batch_data, ctx);
   }
 
   void Close() {
     is_closed_.store(true);
-    bool buffer_drained = false;
-    while (!buffer_drained) {
-      std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
-      auto status = batch_buffer_.TryReceive(&abandoned_batch_data);
-      CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
-      buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+    for (const auto& batch_buffer : batch_buffers_) {
+      bool buffer_drained = false;
+      while (!buffer_drained) {
+        std::shared_ptr<LoadTargetPtrList> abandoned_batch_data(nullptr);
+        auto status = batch_buffer->TryReceive(&abandoned_batch_data);
+        CHECK_NE(status, BufferStatus::kBufferStatusErrorClosed);
+        buffer_drained = (status == BufferStatus::kBufferStatusEmpty);
+      }
+      batch_buffer->Close();
     }
-    batch_buffer_.Close();
   }
 
  protected:
+  // Starts a load thread for every one of loaders_, or one for loader_ if loaders_ is empty.
+  // Every loader moves to its next epoch when its own data parts run out, so loaders of parts of
+  // different sizes drift into different epochs, and each keeps its part of the shuffle buffer.
   void StartLoadThread() {
-    if (load_thrd_.joinable()) { return; }
-    load_thrd_ = std::thread([this] {
-      while (!is_closed_.load() && LoadBatch()) {}
-    });
+    if (!load_thrds_.empty()) { return; }
+    if (loaders_.empty()) { loaders_.push_back(std::move(loader_)); }
+    const int64_t batch_buffer_size = Global<const IOConf>::Get()->data_reader_batch_buffer_size();
+    CHECK_GT(batch_buffer_size, 0);
+    if (Global<const IOConf>::Get()->data_reader_deterministic_interleave()) {
+      const int64_t size = std::max<int64_t>(batch_buffer_size / loaders_.size(), 1);
+      FOR_RANGE(size_t, i, 0, loaders_.size()) {
+        batch_buffers_.emplace_back(new BatchBuffer(size));
+      }
+    } else {
+      batch_buffers_.emplace_back(new BatchBuffer(batch_buffer_size));
+    }
+    FOR_RANGE(size_t, i, 0, loaders_.size()) {
+      Dataset<LoadTarget>* loader = loaders_.at(i).get();
+      BatchBuffer* batch_buffer = batch_buffers_.at(i % batch_buffers_.size()).get();
+      load_thrds_.emplace_back([this, loader, batch_buffer] {
+        while (!is_closed_.load() && LoadBatch(loader, batch_buffer)) {}
+      });
+    }
+  }
+
+  // The number of load threads of a reader, each of which reads its own part of the data parts
+  // of this rank
+  static int32_t GetLoadThreadNum(user_op::KernelInitContext* ctx, int64_t data_part_num) {
+    const int64_t local_data_part_num =
+        BalancedSplitter(data_part_num, ctx->parallel_ctx().parallel_num())
+            .At(ctx->parallel_ctx().parallel_id())
+            .size();
+    const int64_t load_thread_num = Global<const IOConf>::Get()->data_reader_load_thread_num();
+    CHECK_GT(load_thread_num, 0);
+    return std::max<int64_t>(std::min(load_thread_num, local_data_part_num), 1);
   }
 
   std::unique_ptr<Dataset<LoadTarget>> loader_;
+  std::vector<std::unique_ptr<Dataset<LoadTarget>>> loaders_;
   std::unique_ptr<Parser<LoadTarget>> parser_;
 
  private:
   std::shared_ptr<LoadTargetPtrList> FetchBatchData() {
     std::shared_ptr<LoadTargetPtrList> batch_data(nullptr);
-    CHECK_EQ(batch_buffer_.Receive(&batch_data), BufferStatus::kBufferStatusSuccess);
+    CHECK_EQ(batch_buffers_.at(next_batch_buffer_idx_)->Receive(&batch_data),
+             BufferStatus::kBufferStatusSuccess);
+    next_batch_buffer_idx_ = (next_batch_buffer_idx_ + 1) % batch_buffers_.size();
     return batch_data;
   }
 
-  bool LoadBatch() {
+  bool LoadBatch(Dataset<LoadTarget>* loader, BatchBuffer* batch_buffer) {
     std::shared_ptr<LoadTargetPtrList> batch_data =
-        std::make_shared<LoadTargetPtrList>(std::move(loader_->Next()));
-    return batch_buffer_.Send(batch_data) == BufferStatus::kBufferStatusSuccess;
+        std::make_shared<LoadTargetPtrList>(std::move(loader->Next()));
+    return batch_buffer->Send(batch_data) == BufferStatus::kBufferStatusSuccess;
   }
 
   std::atomic<bool> is_closed_;
-  Buffer<std::shared_ptr<LoadTargetPtrList>> batch_buffer_;
-  std::thread load_thrd_;
+  std::vector<std::unique_ptr<BatchBuffer>> batch_buffers_;
+  size_t next_batch_buffer_idx_;
+  std::vector<std::thread> load_thrds_;
 };
 
 }  // namespace data
@@ -0,0 +1,140 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/user/data/data_reader.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// the loader and the number of a batch
+using BatchId = std::pair<int32_t, int32_t>;
+
+// Batches of one sample of the loader id and the batch number, taking random times to load
+class TestDataset final : public Dataset<TensorBuffer> {
+ public:
+  explicit TestDataset(int32_t loader_id) : loader_id_(loader_id), batch_cnt_(0), gen_(loader_id) {}
+  ~TestDataset() = default;
+
+  LoadTargetPtrList Next() override {
+    std::uniform_int_distribution<int32_t> dis(0, 200);
+    std::this_thread::sleep_for(std::chrono::microseconds(dis(gen_)));
+    LoadTargetPtr sample(new TensorBuffer());
+    sample->Resize(Shape({2}), DataType::kInt32);
+    sample->mut_data<int32_t>()[0] = loader_id_;
+    sample->mut_data<int32_t>()[1] = batch_cnt_;
+    batch_cnt_ += 1;
+    return {sample};
+  }
+
+ private:
+  int32_t loader_id_;
+  int32_t batch_cnt_;
+  std::mt19937 gen_;
+};
+
+class TestParser final : public Parser<TensorBuffer> {
+ public:
+  explicit TestParser(std::vector<BatchId>* batch_ids) : batch_ids_(batch_ids) {}
+  ~TestParser() = default;
+
+  void Parse(std::shared_ptr<LoadTargetPtrList> batch_data,
+             user_op::KernelComputeContext* ctx) override {
+    CHECK_EQ(batch_data->size(), 1);
+    const int32_t* data = batch_data->front()->data<int32_t>();
+    batch_ids_->emplace_back(data[0], data[1]);
+  }
+
+ private:
+  std::vector<BatchId>* batch_ids_;
+};
+
+class TestDataReader final : public DataReader<TensorBuffer> {
+ public:
+  TestDataReader(int32_t load_thread_num, std::vector<BatchId>* batch_ids)
+      : DataReader<TensorBuffer>(nullptr) {
+    parser_.reset(new TestParser(batch_ids));
+    FOR_RANGE(int32_t, i, 0, load_thread_num) { loaders_.emplace_back(new TestDataset(i)); }
+    StartLoadThread();
+  }
+  ~TestDataReader() = default;
+};
+
+void SetIOConf(int64_t batch_buffer_size, bool deterministic_interleave) {
+  IOConf io_conf;
+  io_conf.set_data_reader_batch_buffer_size(batch_buffer_size);
+  io_conf.set_data_reader_deterministic_interleave(deterministic_interleave);
+  Global<const IOConf>::Delete();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+}
+
+std::vector<BatchId> ReadBatches(int32_t load_thread_num, int64_t batch_num) {
+  std::vector<BatchId> batch_ids;
+  TestDataReader reader(load_thread_num, &batch_ids);
+  FOR_RANGE(int64_t, i, 0, batch_num) { reader.Read(nullptr); }
+  return batch_ids;
+}
+
+// the batches of the loaders taken in turn on a single thread
+std::vector<BatchId> ReadBatchesOnSingleThread(int32_t load_thread_num, int64_t batch_num) {
+  std::vector<std::unique_ptr<TestDataset>> loaders;
+  FOR_RANGE(int32_t, i, 0, load_thread_num) { loaders.emplace_back(new TestDataset(i)); }
+  std::vector<BatchId> batch_ids;
+  TestParser parser(&batch_ids);
+  FOR_RANGE(int64_t, i, 0, batch_num) {
+    std::shared_ptr<TestDataset::LoadTargetPtrList> batch_data(
+        new TestDataset::LoadTargetPtrList(loaders.at(i % load_thread_num)->Next()));
+    parser.Parse(batch_data, nullptr);
+  }
+  return batch_ids;
+}
+
+}  // namespace
+
+TEST(DataReader, deterministic_interleave) {
+  const int64_t batch_num = 500;
+  for (int64_t batch_buffer_size : {1, 4, 16}) {
+    SetIOConf(batch_buffer_size, true);
+    for (int32_t load_thread_num : {1, 2, 3, 8}) {
+      // the same batches in the same order on every run, whichever thread loads faster
+      const std::vector<BatchId> expected = ReadBatchesOnSingleThread(load_thread_num, batch_num);
+      FOR_RANGE(int32_t, i, 0, 3) {
+        ASSERT_TRUE(ReadBatches(load_thread_num, batch_num) == expected)
+            << "load_thread_num: " << load_thread_num
+            << " batch_buffer_size: " << batch_buffer_size;
+      }
+    }
+  }
+  Global<const IOConf>::Delete();
+}
+
+TEST(DataReader, first_come_interleave) {
+  const int64_t batch_num = 500;
+  SetIOConf(4, false);
+  for (int32_t load_thread_num : {1, 3}) {
+    // every loader still has its batches read in its order, none skipped
+    std::vector<int32_t> next_batch_cnts(load_thread_num, 0);
+    for (const BatchId& batch_id : ReadBatches(load_thread_num, batch_num)) {
+      ASSERT_EQ(batch_id.second, next_batch_cnts.at(batch_id.first));
+      next_batch_cnts.at(batch_id.first) += 1;
+    }
+  }
+  Global<const IOConf>::Delete();
+}
+
+}  // namespace data
+}  // namespace oneflow
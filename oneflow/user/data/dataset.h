@@ -17,6 +17,7 @@ limitations under the License.
 #define ONEFLOW_USER_DATA_DATASET_H_
 
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/tensor_buffer.h"
 
 namespace oneflow {
@@ -24,6 +25,15 @@ namespace data {
 
 static constexpr int kOneflowDatasetSeed = 524287;
 
+// The data parts read by one of the load threads of a rank, which split the data parts of the rank
+inline Range GetLoadThreadDataPartRange(int64_t data_part_num, int64_t parallel_num,
+                                        int64_t parallel_id, int64_t load_thread_num,
+                                        int64_t load_thread_id) {
+  const Range range = BalancedSplitter(data_part_num, parallel_num).At(parallel_id);
+  const Range sub_range = BalancedSplitter(range.size(), load_thread_num).At(load_thread_id);
+  return Range(range.begin() + sub_range.begin(), range.begin() + sub_range.end());
+}
+
 template<typename LoadTarget>
 class Dataset {
  public:
@@ -46,6 +56,12 @@ class RandomAccessDataset : public Dataset<LoadTarget> {
 
   virtual LoadTargetShdPtrVec At(int64_t index) const = 0;
   virtual size_t Size() const = 0;
+  // the samples of several indices, which a dataset may read together
+  virtual std::vector<LoadTargetShdPtrVec> AtIndices(const std::vector<int64_t>& indices) const {
+    std::vector<LoadTargetShdPtrVec> ret;
+    for (int64_t index : indices) { ret.push_back(this->At(index)); }
+    return ret;
+  }
 
   LoadTargetShdPtrVec Next() final {
     LoadTargetShdPtrVec ret = this->At(cur_idx_);
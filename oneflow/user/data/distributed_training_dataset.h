@@ -30,7 +30,8 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
   using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
 
   DistributedTrainingDataset(int64_t parallel_num, int64_t parallel_id, bool stride_partition,
-                             bool shuffle, int64_t random_seed, BaseDatasetUnqPtr&& dataset)
+                             bool shuffle, int64_t random_seed, BaseDatasetUnqPtr&& dataset,
+                             int64_t prefetch_num = 1)
       : base_dataset_(std::move(dataset)),
         shuffle_(shuffle),
         stride_partition_(stride_partition),
@@ -38,7 +39,9 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
         num_shards_(parallel_num),
         pos_(0),
         pos_in_shard_(0),
-        epoch_cnt_(0) {
+        epoch_cnt_(0),
+        prefetch_num_(prefetch_num) {
+    CHECK_GT(prefetch_num_, 0);
     shard_size_ = std::ceil(static_cast<float>(base_dataset_->Size()) / num_shards_);
     if (stride_partition) {
       pos_ = parallel_id;
@@ -62,7 +65,24 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
     //       |  part1   |  part2   |  part3   |  part4   |
     // iter0 | 0, 1, 2, | 3, 4, 5, | 6, 7, 8, | 9, 0, 1, |
     // iter1 | 2, 3, 4, | 5, 6, 7, | 8, 9, 0, | 1, 2, 3, |
-    LoadTargetShdPtrVec ret = base_dataset_->At(index_seq_.at(pos_));
+    // The samples of the next prefetch_num indices are got from the base dataset at once
+    if (prefetched_.empty()) {
+      std::vector<int64_t> indices;
+      FOR_RANGE(int64_t, i, 0, prefetch_num_) {
+        indices.push_back(index_seq_.at(pos_));
+        Advance();
+      }
+      for (LoadTargetShdPtrVec& sample : base_dataset_->AtIndices(indices)) {
+        prefetched_.push_back(std::move(sample));
+      }
+    }
+    LoadTargetShdPtrVec ret = std::move(prefetched_.front());
+    prefetched_.pop_front();
+    return ret;
+  }
+
+ private:
+  void Advance() {
     if (stride_partition_) {
       pos_ += num_shards_;
     } else {
@@ -74,10 +94,8 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
       }
     }
     CheckRanOutOfSize();
-    return ret;
   }
 
- private:
   void CheckRanOutOfSize() {
     if (pos_ >= index_seq_.size()) {
       GenNewIndexSequence();
@@ -103,6 +121,8 @@ class DistributedTrainingDataset final : public Dataset<LoadTarget> {
   int64_t pos_in_shard_;
   int64_t epoch_cnt_;
   std::vector<int64_t> index_seq_;
+  int64_t prefetch_num_;
+  std::deque<LoadTargetShdPtrVec> prefetched_;
 };
 
 }  // namespace data
@@ -0,0 +1,171 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_INDEXED_RECORD_DATASET_H_
+#define ONEFLOW_USER_DATA_INDEXED_RECORD_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/user/data/distributed_training_dataset.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// The index sidecar of a data file, written by flow.data.build_record_index, is
+// 'OFRECIDX', an int64 record num, then an int64 offset and an int64 length of every record
+constexpr int64_t kRecordIndexMagicNumber = 0x584449434552464F;  // 'OFRECIDX', little endian
+constexpr int64_t kRecordIndexHeaderSize = 2 * sizeof(int64_t);
+constexpr int64_t kRecordIndexEntrySize = 2 * sizeof(int64_t);
+// records no farther apart are read together
+constexpr int64_t kMaxCoalescedGapByteSize = 64 * 1024;
+constexpr int64_t kMaxCoalescedByteSize = 16 * 1024 * 1024;
+
+}  // namespace
+
+inline std::string RecordIndexFilePath(const std::string& data_file_path) {
+  return data_file_path + ".idx";
+}
+
+// Reads the records of OFRecord or OneRec data files by the index sidecars, so that any record
+// can be read at any time. Only the record itself is read, the OneRec frame digests are not
+// verified.
+class IndexedRecordDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  using LoadTargetShdPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(IndexedRecordDataset);
+  IndexedRecordDataset(fs::FileSystem* file_system,
+                       const std::vector<std::string>& data_file_paths) {
+    FOR_RANGE(int64_t, file_idx, 0, data_file_paths.size()) {
+      const std::string& data_file_path = data_file_paths.at(file_idx);
+      files_.emplace_back();
+      file_system->NewRandomAccessFile(data_file_path, &files_.back());
+      LoadIndex(file_system, file_idx, RecordIndexFilePath(data_file_path),
+                file_system->GetFileSize(data_file_path));
+    }
+    CHECK_GT(records_.size(), 0);
+  }
+  ~IndexedRecordDataset() = default;
+
+  size_t Size() const override { return records_.size(); }
+
+  LoadTargetShdPtrVec At(int64_t index) const override { return AtIndices({index}).front(); }
+
+  // Reads records of one file in the order of offsets, and records close to each other in one go
+  std::vector<LoadTargetShdPtrVec> AtIndices(const std::vector<int64_t>& indices) const override {
+    std::vector<LoadTargetShdPtrVec> ret(indices.size());
+    std::vector<int64_t> order(indices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int64_t lhs, int64_t rhs) {
+      const Record& lhs_record = records_.at(indices.at(lhs));
+      const Record& rhs_record = records_.at(indices.at(rhs));
+      return std::make_pair(lhs_record.file_idx, lhs_record.offset)
+             < std::make_pair(rhs_record.file_idx, rhs_record.offset);
+    });
+    size_t begin = 0;
+    while (begin < order.size()) {
+      const Record& first = records_.at(indices.at(order.at(begin)));
+      int64_t end_offset = first.offset + first.length;
+      size_t end = begin + 1;
+      while (end < order.size()) {
+        const Record& record = records_.at(indices.at(order.at(end)));
+        const int64_t record_end_offset = std::max(end_offset, record.offset + record.length);
+        if (record.file_idx != first.file_idx
+            || record.offset - end_offset > kMaxCoalescedGapByteSize
+            || record_end_offset - first.offset > kMaxCoalescedByteSize) {
+          break;
+        }
+        end_offset = record_end_offset;
+        end += 1;
+      }
+      // the records are views into the buffer of the coalesced read
+      std::shared_ptr<char> buffer(new char[end_offset - first.offset],
+                                   std::default_delete<char[]>());
+      files_.at(first.file_idx)->Read(first.offset, end_offset - first.offset, buffer.get());
+      FOR_RANGE(size_t, i, begin, end) {
+        const Record& record = records_.at(indices.at(order.at(i)));
+        LoadTargetShdPtr tensor(new TensorBuffer());
+        tensor->ResetToView(Shape({record.length}), DataType::kChar,
+                            buffer.get() + record.offset - first.offset, buffer);
+        ret.at(order.at(i)).push_back(std::move(tensor));
+      }
+      begin = end;
+    }
+    return ret;
+  }
+
+ private:
+  struct Record {
+    int64_t file_idx;
+    int64_t offset;
+    int64_t length;
+  };
+
+  void LoadIndex(fs::FileSystem* file_system, int64_t file_idx, const std::string& index_file_path,
+                 int64_t data_file_size) {
+    CHECK(file_system->FileExists(index_file_path))
+        << index_file_path << " not found, build it with flow.data.build_record_index";
+    // a truncated index or one of another data file is rejected before anything is read past the
+    // end of either file
+    const int64_t index_file_size = file_system->GetFileSize(index_file_path);
+    CHECK_GE(index_file_size, kRecordIndexHeaderSize) << "truncated " << index_file_path;
+    std::unique_ptr<fs::RandomAccessFile> index_file;
+    file_system->NewRandomAccessFile(index_file_path, &index_file);
+    int64_t header[2];
+    index_file->Read(0, kRecordIndexHeaderSize, reinterpret_cast<char*>(header));
+    CHECK_EQ(header[0], kRecordIndexMagicNumber) << index_file_path;
+    const int64_t record_num = header[1];
+    const int64_t entries_size = index_file_size - kRecordIndexHeaderSize;
+    CHECK_EQ(entries_size % kRecordIndexEntrySize, 0) << "truncated " << index_file_path;
+    CHECK_EQ(entries_size / kRecordIndexEntrySize, record_num) << "truncated " << index_file_path;
+    std::vector<int64_t> entries(record_num * 2);
+    index_file->Read(kRecordIndexHeaderSize, entries_size,
+                     reinterpret_cast<char*>(entries.data()));
+    FOR_RANGE(int64_t, i, 0, record_num) {
+      Record record{file_idx, entries.at(i * 2), entries.at(i * 2 + 1)};
+      CHECK_GE(record.offset, 0) << index_file_path;
+      CHECK_GT(record.length, 0) << index_file_path;
+      CHECK_LE(record.length, data_file_size - record.offset)
+          << index_file_path << " does not match the data file";
+      records_.push_back(record);
+    }
+  }
+
+  std::vector<std::unique_ptr<fs::RandomAccessFile>> files_;
+  std::vector<Record> records_;
+};
+
+// Every epoch reads all the records of all the data files in a new global permutation, of which
+// each rank reads its part. The ranks must agree on the permutation, so the seed is never random.
+inline std::unique_ptr<Dataset<TensorBuffer>> NewGlobalShuffleDataset(
+    user_op::KernelInitContext* ctx, const std::vector<std::string>& data_file_paths,
+    int64_t prefetch_num) {
+  int64_t seed = ctx->Attr<int64_t>("seed");
+  if (seed == -1) { seed = kOneflowDatasetSeed; }
+  std::unique_ptr<RandomAccessDataset<TensorBuffer>> dataset(
+      new IndexedRecordDataset(DataFS(), data_file_paths));
+  return std::unique_ptr<Dataset<TensorBuffer>>(new DistributedTrainingDataset<TensorBuffer>(
+      ctx->parallel_ctx().parallel_num(), ctx->parallel_ctx().parallel_id(), false, true, seed,
+      std::move(dataset), prefetch_num));
+}
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_INDEXED_RECORD_DATASET_H_
@@ -0,0 +1,215 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/user/data/indexed_record_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr int64_t kGapByteSize = 64 * 1024;
+constexpr int64_t kCoalescedByteSize = 16 * 1024 * 1024;
+// the length prefix of an OFRecord frame
+constexpr int64_t kFrameHeaderSize = sizeof(int64_t);
+
+std::string Payload(int64_t file_idx, int64_t record_idx, int64_t length) {
+  std::string payload(length, '\0');
+  FOR_RANGE(int64_t, i, 0, length) {
+    payload[i] = static_cast<char>((file_idx * 131 + record_idx * 31 + i * 7 + i / 256) & 0xff);
+  }
+  return payload;
+}
+
+std::string TestFilePath(const std::string& name) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  return JoinPath(current_dir, "tmp_indexed_record_dataset_" + name);
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::unique_ptr<fs::WritableFile> file;
+  LocalFS()->NewWritableFile(path, &file);
+  file->Append(content.data(), content.size());
+  file->Close();
+}
+
+// Writes an OFRecord data file of records of lengths and its index as build_record_index does
+void WriteRecordFile(const std::string& path, int64_t file_idx,
+                     const std::vector<int64_t>& lengths) {
+  std::string data;
+  std::string index(reinterpret_cast<const char*>(&kRecordIndexMagicNumber), sizeof(int64_t));
+  const int64_t record_num = lengths.size();
+  index.append(reinterpret_cast<const char*>(&record_num), sizeof(int64_t));
+  FOR_RANGE(int64_t, i, 0, record_num) {
+    const int64_t length = lengths.at(i);
+    data.append(reinterpret_cast<const char*>(&length), sizeof(int64_t));
+    const int64_t offset = data.size();
+    data.append(Payload(file_idx, i, length));
+    index.append(reinterpret_cast<const char*>(&offset), sizeof(int64_t));
+    index.append(reinterpret_cast<const char*>(&length), sizeof(int64_t));
+  }
+  WriteFile(path, data);
+  WriteFile(RecordIndexFilePath(path), index);
+}
+
+void DeleteRecordFile(const std::string& path) {
+  LocalFS()->DelFile(path);
+  LocalFS()->DelFile(RecordIndexFilePath(path));
+}
+
+// the lengths of the records of the data files of the test
+std::vector<std::vector<int64_t>> RecordLengths() {
+  std::vector<std::vector<int64_t>> lengths(3);
+  // small records, then pairs of records apart by the record between them, whose gap is just
+  // under, at and just over the max coalesced gap
+  FOR_RANGE(int64_t, i, 0, 100) { lengths.at(0).push_back(1 + i * 37 % 300); }
+  for (int64_t gap : {kGapByteSize - 1, kGapByteSize, kGapByteSize + 1}) {
+    lengths.at(0).push_back(100);
+    lengths.at(0).push_back(gap - 2 * kFrameHeaderSize);
+    lengths.at(0).push_back(100);
+  }
+  // records filling several max coalesced reads, and one larger than a coalesced read
+  FOR_RANGE(int64_t, i, 0, 5) { lengths.at(1).push_back(kCoalescedByteSize / 4 - 3 + i); }
+  lengths.at(1).push_back(kCoalescedByteSize + 5);
+  FOR_RANGE(int64_t, i, 0, 3) { lengths.at(1).push_back(10 + i); }
+  FOR_RANGE(int64_t, i, 0, 20) { lengths.at(2).push_back(1000 + i); }
+  return lengths;
+}
+
+}  // namespace
+
+class IndexedRecordDatasetTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    lengths_ = RecordLengths();
+    FOR_RANGE(int64_t, file_idx, 0, lengths_.size()) {
+      paths_.push_back(TestFilePath("part_" + std::to_string(file_idx)));
+      WriteRecordFile(paths_.back(), file_idx, lengths_.at(file_idx));
+      FOR_RANGE(int64_t, i, 0, lengths_.at(file_idx).size()) {
+        records_.emplace_back(file_idx, i);
+      }
+    }
+  }
+
+  void TearDown() override {
+    for (const std::string& path : paths_) { DeleteRecordFile(path); }
+  }
+
+  void CheckRecords(const IndexedRecordDataset& dataset, const std::vector<int64_t>& indices) {
+    const std::vector<IndexedRecordDataset::LoadTargetShdPtrVec> samples =
+        dataset.AtIndices(indices);
+    ASSERT_EQ(samples.size(), indices.size());
+    FOR_RANGE(size_t, i, 0, indices.size()) {
+      const int64_t file_idx = records_.at(indices.at(i)).first;
+      const int64_t record_idx = records_.at(indices.at(i)).second;
+      const std::string expected =
+          Payload(file_idx, record_idx, lengths_.at(file_idx).at(record_idx));
+      ASSERT_EQ(samples.at(i).size(), 1U);
+      const TensorBuffer& buffer = *samples.at(i).front();
+      ASSERT_EQ(buffer.data_type(), DataType::kChar);
+      ASSERT_EQ(buffer.nbytes(), expected.size()) << "index: " << indices.at(i);
+      ASSERT_EQ(memcmp(buffer.data(), expected.data(), expected.size()), 0)
+          << "index: " << indices.at(i);
+    }
+  }
+
+  std::vector<std::vector<int64_t>> lengths_;
+  std::vector<std::string> paths_;
+  // the file and the record in the file of every index
+  std::vector<std::pair<int64_t, int64_t>> records_;
+};
+
+TEST_F(IndexedRecordDatasetTest, reads_records_in_request_order) {
+  IndexedRecordDataset dataset(LocalFS(), paths_);
+  ASSERT_EQ(dataset.Size(), records_.size());
+  std::vector<int64_t> all_indices(records_.size());
+  std::iota(all_indices.begin(), all_indices.end(), 0);
+  // in order, which coalesces the most
+  CheckRecords(dataset, all_indices);
+  // shuffled across the files
+  std::mt19937 gen(0);
+  FOR_RANGE(int64_t, i, 0, 3) {
+    std::shuffle(all_indices.begin(), all_indices.end(), gen);
+    CheckRecords(dataset, all_indices);
+  }
+  // duplicated
+  std::uniform_int_distribution<int64_t> dis(0, records_.size() - 1);
+  std::vector<int64_t> duplicated_indices;
+  FOR_RANGE(int64_t, i, 0, 200) { duplicated_indices.push_back(dis(gen)); }
+  duplicated_indices.push_back(duplicated_indices.front());
+  duplicated_indices.push_back(duplicated_indices.front());
+  CheckRecords(dataset, duplicated_indices);
+  // one by one
+  FOR_RANGE(int64_t, index, 0, records_.size()) {
+    const IndexedRecordDataset::LoadTargetShdPtrVec sample = dataset.At(index);
+    ASSERT_EQ(sample.size(), 1U);
+    ASSERT_EQ(static_cast<int64_t>(sample.front()->nbytes()),
+              lengths_.at(records_.at(index).first).at(records_.at(index).second));
+  }
+}
+
+TEST_F(IndexedRecordDatasetTest, reads_across_max_gap_and_size) {
+  IndexedRecordDataset dataset(LocalFS(), paths_);
+  // the pairs of records around the max gap, without the records between them
+  const int64_t first_gap_record = 100;
+  FOR_RANGE(int64_t, i, 0, 3) {
+    const int64_t index = first_gap_record + i * 3;
+    CheckRecords(dataset, {index + 2, index});
+    CheckRecords(dataset, {index, index + 2, index + 1});
+  }
+  CheckRecords(dataset, {first_gap_record, first_gap_record + 2, first_gap_record + 3,
+                         first_gap_record + 5, first_gap_record + 6, first_gap_record + 8});
+  // the records of more than a max coalesced read, and the one larger than it
+  const int64_t first_large_record = lengths_.at(0).size();
+  std::vector<int64_t> large_indices(lengths_.at(1).size());
+  std::iota(large_indices.begin(), large_indices.end(), first_large_record);
+  CheckRecords(dataset, large_indices);
+  std::reverse(large_indices.begin(), large_indices.end());
+  CheckRecords(dataset, large_indices);
+  CheckRecords(dataset, {first_large_record + 5, first_large_record + 4, first_large_record + 6});
+}
+
+TEST_F(IndexedRecordDatasetTest, rejects_mismatched_index) {
+  const std::string& path = paths_.at(2);
+  const std::string index_path = RecordIndexFilePath(path);
+  std::string index(LocalFS()->GetFileSize(index_path), '\0');
+  {
+    std::unique_ptr<fs::RandomAccessFile> file;
+    LocalFS()->NewRandomAccessFile(index_path, &file);
+    file->Read(0, index.size(), &index.front());
+  }
+  const std::vector<std::string> data_file_paths = {path};
+  // truncated within the header and within the entries
+  WriteFile(index_path, index.substr(0, kRecordIndexHeaderSize - 5));
+  EXPECT_DEATH(IndexedRecordDataset(LocalFS(), data_file_paths), "truncated");
+  WriteFile(index_path, index.substr(0, index.size() - 2 * sizeof(int64_t)));
+  EXPECT_DEATH(IndexedRecordDataset(LocalFS(), data_file_paths), "truncated");
+  WriteFile(index_path, index.substr(0, index.size() - 5));
+  EXPECT_DEATH(IndexedRecordDataset(LocalFS(), data_file_paths), "truncated");
+  // the index of another data file, with records past the end of this one
+  const std::vector<std::string> shorter_data_file_paths = {TestFilePath("shorter")};
+  WriteRecordFile(shorter_data_file_paths.front(), 2, {1000, 1001});
+  WriteFile(RecordIndexFilePath(shorter_data_file_paths.front()), index);
+  EXPECT_DEATH(IndexedRecordDataset(LocalFS(), shorter_data_file_paths),
+               "does not match the data file");
+  DeleteRecordFile(shorter_data_file_paths.front());
+}
+
+}  // namespace data
+}  // namespace oneflow
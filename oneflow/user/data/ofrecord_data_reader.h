@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/user/data/data_reader.h"
 #include "oneflow/user/data/ofrecord_dataset.h"
+#include "oneflow/user/data/indexed_record_dataset.h"
 #include "oneflow/user/data/ofrecord_parser.h"
 #include "oneflow/user/data/random_shuffle_dataset.h"
 #include "oneflow/user/data/batch_dataset.h"
@@ -29,19 +30,30 @@ namespace data {
 class OFRecordDataReader final : public DataReader<TensorBuffer> {
  public:
   OFRecordDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
-    loader_.reset(new OFRecordDataset(ctx));
     parser_.reset(new OFRecordParser());
-    if (ctx->Attr<bool>("random_shuffle")) {
-      loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
-    }
     int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
-    loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+    if (ctx->Attr<bool>("global_shuffle")) {
+      loader_ = NewGlobalShuffleDataset(ctx, OFRecordDataset::GetDataFilePaths(ctx), batch_size);
+      loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+    } else {
+      const int32_t load_thread_num = GetLoadThreadNum(ctx, ctx->Attr<int32_t>("data_part_num"));
+      FOR_RANGE(int32_t, i, 0, load_thread_num) {
+        loader_.reset(new OFRecordDataset(ctx, i, load_thread_num));
+        if (ctx->Attr<bool>("random_shuffle")) {
+          loader_.reset(
+              new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_), load_thread_num));
+        }
+        loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+        loaders_.push_back(std::move(loader_));
+      }
+    }
     StartLoadThread();
   }
   ~OFRecordDataReader() = default;
 
  protected:
   using DataReader<TensorBuffer>::loader_;
+  using DataReader<TensorBuffer>::loaders_;
   using DataReader<TensorBuffer>::parser_;
 };
 
@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/persistence/mapped_in_stream.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/job/job_set.pb.h"
 
@@ -31,35 +32,49 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   OF_DISALLOW_COPY_AND_MOVE(OFRecordDataset);
-  OFRecordDataset(user_op::KernelInitContext* ctx) {
+  OFRecordDataset(user_op::KernelInitContext* ctx, int32_t load_thread_id = 0,
+                  int32_t load_thread_num = 1) {
     current_epoch_ = 0;
     shuffle_after_epoch_ = ctx->Attr<bool>("shuffle_after_epoch");
 
     // in stream
     data_part_num_ = ctx->Attr<int32_t>("data_part_num");
+    data_file_paths_ = GetDataFilePaths(ctx);
+
+    parallel_id_ = ctx->parallel_ctx().parallel_id();
+    parallel_num_ = ctx->parallel_ctx().parallel_num();
+    CHECK_LE(parallel_num_, data_part_num_);
+    range_ = GetLoadThreadDataPartRange(data_part_num_, parallel_num_, parallel_id_,
+                                        load_thread_num, load_thread_id);
+    std::vector<std::string> local_file_paths = GetLocalFilePaths();
+    save_to_local_ = Global<const IOConf>::Get()->save_downloaded_file_to_local_fs();
+    use_mapped_in_stream_ = Global<const IOConf>::Get()->enable_mmap_data_reader()
+                            && DataFS() == LocalFS() && !save_to_local_;
+    if (use_mapped_in_stream_) {
+      mapped_in_stream_.reset(new MappedInStream(local_file_paths, !shuffle_after_epoch_));
+    } else {
+      in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_,
+                                              save_to_local_));
+    }
+  }
+  ~OFRecordDataset() = default;
+
+  static std::vector<std::string> GetDataFilePaths(user_op::KernelInitContext* ctx) {
+    std::vector<std::string> data_file_paths;
+    int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
     std::string data_dir = ctx->Attr<std::string>("data_dir");
     std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
     int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
 
-    for (int i = 0; i < data_part_num_; ++i) {
+    for (int i = 0; i < data_part_num; ++i) {
       std::string num = std::to_string(i);
       int32_t zero_count =
           std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
-      data_file_paths_.push_back(
+      data_file_paths.push_back(
           JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
     }
-
-    parallel_id_ = ctx->parallel_ctx().parallel_id();
-    parallel_num_ = ctx->parallel_ctx().parallel_num();
-    CHECK_LE(parallel_num_, data_part_num_);
-    BalancedSplitter bs(data_part_num_, parallel_num_);
-    range_ = bs.At(parallel_id_);
-    std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    save_to_local_ = Global<const IOConf>::Get()->save_downloaded_file_to_local_fs();
-    in_stream_.reset(
-        new PersistentInStream(DataFS(), local_file_paths, !shuffle_after_epoch_, save_to_local_));
+    return data_file_paths;
   }
-  ~OFRecordDataset() = default;
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
@@ -73,22 +88,42 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   void ReadSample(TensorBuffer& tensor) {
     int64_t OFRecord_size = -1;
     char* size_ptr = reinterpret_cast<char*>(&OFRecord_size);
-    if (in_stream_->ReadFully(size_ptr, sizeof(int64_t)) != 0) {
+    if (ReadFully(size_ptr, sizeof(int64_t)) != 0) {
       ShuffleAfterEpoch();
-      CHECK_EQ(in_stream_->ReadFully(size_ptr, sizeof(int64_t)), 0);
+      CHECK_EQ(ReadFully(size_ptr, sizeof(int64_t)), 0);
     }
     CHECK_GT(OFRecord_size, 0);
-    tensor.Resize(Shape({OFRecord_size}), DataType::kChar);
-    CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
+    if (use_mapped_in_stream_) {
+      char* record = nullptr;
+      std::shared_ptr<const MappedFile> mapped_file;
+      CHECK_EQ(mapped_in_stream_->ReadView(OFRecord_size, &record, &mapped_file), 0);
+      tensor.ResetToView(Shape({OFRecord_size}), DataType::kChar, record, std::move(mapped_file));
+    } else {
+      tensor.Resize(Shape({OFRecord_size}), DataType::kChar);
+      CHECK_EQ(in_stream_->ReadFully(tensor.mut_data<char>(), OFRecord_size), 0);
+    }
   }
 
+  int32_t ReadFully(char* s, size_t n) {
+    if (use_mapped_in_stream_) {
+      return mapped_in_stream_->ReadFully(s, n);
+    } else {
+      return in_stream_->ReadFully(s, n);
+    }
+  }
+
+  // the epoch is of the data parts of this load thread, which may differ from that of the others
   void ShuffleAfterEpoch() {
     CHECK(shuffle_after_epoch_);
     current_epoch_++;  // move to next epoch
     std::mt19937 g(kOneflowDatasetSeed + current_epoch_);
     std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
     std::vector<std::string> local_file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, save_to_local_));
+    if (use_mapped_in_stream_) {
+      mapped_in_stream_.reset(new MappedInStream(local_file_paths, false));
+    } else {
+      in_stream_.reset(new PersistentInStream(DataFS(), local_file_paths, false, save_to_local_));
+    }
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -106,7 +141,9 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   Range range_;
   std::vector<std::string> data_file_paths_;
   bool save_to_local_;
+  bool use_mapped_in_stream_;
   std::unique_ptr<PersistentInStream> in_stream_;
+  std::unique_ptr<MappedInStream> mapped_in_stream_;
 };
 
 }  // namespace data
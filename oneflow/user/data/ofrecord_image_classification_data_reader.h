@@ -33,12 +33,17 @@ class OFRecordImageClassificationDataReader final
  public:
   explicit OFRecordImageClassificationDataReader(user_op::KernelInitContext* ctx)
       : DataReader<ImageClassificationDataInstance>(ctx) {
-    std::unique_ptr<Dataset<TensorBuffer>> base(new OFRecordDataset(ctx));
-    if (ctx->Attr<bool>("random_shuffle")) {
-      base.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(base)));
-    }
-    loader_.reset(new OFRecordImageClassificationDataset(ctx, std::move(base)));
     const int64_t batch_size = ctx->TensorDesc4ArgNameAndIndex("image", 0)->shape().elem_cnt();
+    if (ctx->Attr<int64_t>("cache_memory_size_mb") > 0
+        || !ctx->Attr<std::string>("cache_spill_file_path").empty()) {
+      loader_ = NewCachedImageClassificationDataset(ctx, batch_size);
+    } else {
+      std::unique_ptr<Dataset<TensorBuffer>> base(new OFRecordDataset(ctx));
+      if (ctx->Attr<bool>("random_shuffle")) {
+        base.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(base)));
+      }
+      loader_.reset(new OFRecordImageClassificationDataset(ctx, std::move(base)));
+    }
     loader_.reset(
         new BatchDataset<ImageClassificationDataInstance>(batch_size, std::move(loader_)));
     parser_.reset(new OFRecordImageClassificationParser());
@@ -25,6 +25,9 @@ limitations under the License.
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/job/job_set.pb.h"
 #include "oneflow/user/data/ofrecord_dataset.h"
+#include "oneflow/user/data/cache_dataset.h"
+#include "oneflow/user/data/distributed_training_dataset.h"
+#include "oneflow/user/data/indexed_record_dataset.h"
 #include "oneflow/user/image/image_util.h"
 #include "oneflow/core/job/resource_desc.h"
 #include "oneflow/core/job/global_for.h"
@@ -144,6 +147,23 @@ int32_t GetNumLocalDecodeThreads(int32_t num_decode_threads_per_machine,
   return std::max<int32_t>(num_decode_threads_per_machine / parallel_num_on_this_machine, 1);
 }
 
+// The decoded image and label of a serialized OFRecord
+void DecodeImageClassificationSample(const std::string& image_feature_name,
+                                     const std::string& label_feature_name,
+                                     const std::string& color_space,
+                                     const TensorBuffer& serialized_record,
+                                     SampleCache::Sample* sample) {
+  OFRecord record;
+  CHECK(record.ParseFromArray(serialized_record.data<char>(),
+                              serialized_record.shape().elem_cnt()));
+  std::shared_ptr<TensorBuffer> image(new TensorBuffer());
+  DecodeImageFromOFRecord(record, image_feature_name, color_space, image.get());
+  std::shared_ptr<TensorBuffer> label(new TensorBuffer());
+  DecodeLabelFromFromOFRecord(record, label_feature_name, label.get());
+  sample->push_back(std::move(image));
+  sample->push_back(std::move(label));
+}
+
 }  // namespace
 
 class OFRecordImageClassificationDataset final : public Dataset<ImageClassificationDataInstance> {
@@ -200,6 +220,65 @@ class OFRecordImageClassificationDataset final : public Dataset<ImageClassificat
   std::atomic<size_t> out_thread_idx_;
 };
 
+// The image and label of the samples of a dataset of decoded images and labels
+class ImageClassificationSampleDataset final : public Dataset<ImageClassificationDataInstance> {
+ public:
+  using LoadTargetPtr = std::shared_ptr<ImageClassificationDataInstance>;
+  using LoadTargetPtrList = std::vector<LoadTargetPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(ImageClassificationSampleDataset);
+  explicit ImageClassificationSampleDataset(std::unique_ptr<BaseDataset>&& base)
+      : base_(std::move(base)) {}
+  ~ImageClassificationSampleDataset() override = default;
+
+  LoadTargetPtrList Next() override {
+    BaseLoadTargetPtrList sample = base_->Next();
+    CHECK_EQ(sample.size(), 2);
+    LoadTargetPtr instance(new ImageClassificationDataInstance());
+    instance->image = std::move(sample.at(0));
+    instance->label = std::move(sample.at(1));
+    LoadTargetPtrList ret;
+    ret.push_back(std::move(instance));
+    return ret;
+  }
+
+ private:
+  std::unique_ptr<BaseDataset> base_;
+};
+
+// Reads the records of the data parts of this rank by their index sidecars and caches the decoded
+// samples, so that the later epochs neither read nor decode the cached ones. The samples of this
+// rank are handed out in a new order every epoch if random_shuffle.
+inline std::unique_ptr<Dataset<ImageClassificationDataInstance>>
+NewCachedImageClassificationDataset(user_op::KernelInitContext* ctx, int64_t prefetch_num) {
+  const std::vector<std::string> data_file_paths = OFRecordDataset::GetDataFilePaths(ctx);
+  const int64_t parallel_id = ctx->parallel_ctx().parallel_id();
+  const Range range = GetLoadThreadDataPartRange(
+      data_file_paths.size(), ctx->parallel_ctx().parallel_num(), parallel_id, 1, 0);
+  std::unique_ptr<RandomAccessDataset<TensorBuffer>> records(new IndexedRecordDataset(
+      DataFS(), std::vector<std::string>(data_file_paths.begin() + range.begin(),
+                                         data_file_paths.begin() + range.end())));
+
+  std::string spill_file_path = ctx->Attr<std::string>("cache_spill_file_path");
+  if (!spill_file_path.empty()) { spill_file_path += "-" + std::to_string(parallel_id); }
+  std::unique_ptr<SampleCache> cache(
+      new SampleCache(ctx->Attr<int64_t>("cache_memory_size_mb") * 1024 * 1024, spill_file_path,
+                      ctx->Attr<int64_t>("cache_spill_size_mb") * 1024 * 1024));
+  const CacheDataset::Decoder decoder =
+      std::bind(&DecodeImageClassificationSample, ctx->Attr<std::string>("image_feature_name"),
+                ctx->Attr<std::string>("label_feature_name"),
+                ctx->Attr<std::string>("color_space"), std::placeholders::_1,
+                std::placeholders::_2);
+  std::unique_ptr<RandomAccessDataset<TensorBuffer>> samples(
+      new CacheDataset(std::move(records), decoder, std::move(cache)));
+
+  int64_t seed = ctx->Attr<int64_t>("seed");
+  if (seed == -1) { seed = NewRandomSeed(); }
+  std::unique_ptr<BaseDataset> shuffled(new DistributedTrainingDataset<TensorBuffer>(
+      1, 0, false, ctx->Attr<bool>("random_shuffle"), seed, std::move(samples), prefetch_num));
+  return std::unique_ptr<Dataset<ImageClassificationDataInstance>>(
+      new ImageClassificationSampleDataset(std::move(shuffled)));
+}
+
 }  // namespace data
 
 }  // namespace oneflow
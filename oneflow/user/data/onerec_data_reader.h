@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "oneflow/user/data/data_reader.h"
 #include "oneflow/user/data/onerec_dataset.h"
+#include "oneflow/user/data/indexed_record_dataset.h"
 #include "oneflow/user/data/onerec_parser.h"
 #include "oneflow/user/data/random_shuffle_dataset.h"
 #include "oneflow/user/data/batch_random_shuffle_dataset.h"
@@ -30,31 +31,55 @@ namespace data {
 class OneRecDataReader final : public DataReader<TensorBuffer> {
  public:
   OneRecDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
+    parser_.reset(new OneRecParser());
+    // a global shuffle reads all the files in one permutation, which is not split among threads
+    const bool global_shuffle =
+        ctx->Attr<bool>("random_shuffle") && ctx->Attr<std::string>("shuffle_mode") == "global";
+    const int32_t load_thread_num =
+        global_shuffle ? 1
+                       : GetLoadThreadNum(ctx, ctx->Attr<std::vector<std::string>>("files").size());
+    FOR_RANGE(int32_t, i, 0, load_thread_num) {
+      loaders_.push_back(NewLoader(ctx, i, load_thread_num));
+    }
+    StartLoadThread();
+  }
+  ~OneRecDataReader() = default;
+
+ protected:
+  using DataReader<TensorBuffer>::loader_;
+  using DataReader<TensorBuffer>::loaders_;
+  using DataReader<TensorBuffer>::parser_;
+
+ private:
+  std::unique_ptr<Dataset<TensorBuffer>> NewLoader(user_op::KernelInitContext* ctx,
+                                                   int32_t load_thread_id,
+                                                   int32_t load_thread_num) {
     const int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
     const auto random_shuffle = ctx->Attr<bool>("random_shuffle");
-    parser_.reset(new OneRecParser());
+    std::unique_ptr<Dataset<TensorBuffer>> loader;
     if (random_shuffle) {
       const auto mode = ctx->Attr<std::string>("shuffle_mode");
       if (mode == "batch") {
-        loader_.reset(new OneRecDataset(ctx, batch_size));
-        loader_.reset(new BatchRandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
+        loader.reset(new OneRecDataset(ctx, batch_size, load_thread_id, load_thread_num));
+        loader.reset(new BatchRandomShuffleDataset<TensorBuffer>(ctx, std::move(loader),
+                                                                  load_thread_num));
       } else if (mode == "instance") {
-        loader_.reset(new OneRecDataset(ctx, 1));
-        loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
-        loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+        loader.reset(new OneRecDataset(ctx, 1, load_thread_id, load_thread_num));
+        loader.reset(
+            new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader), load_thread_num));
+        loader.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader)));
+      } else if (mode == "global") {
+        loader = NewGlobalShuffleDataset(ctx, ctx->Attr<std::vector<std::string>>("files"),
+                                         batch_size);
+        loader.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader)));
       } else {
         UNIMPLEMENTED();
       }
     } else {
-      loader_.reset(new OneRecDataset(ctx, batch_size));
+      loader.reset(new OneRecDataset(ctx, batch_size, load_thread_id, load_thread_num));
     }
-    StartLoadThread();
+    return loader;
   }
-  ~OneRecDataReader() = default;
-
- protected:
-  using DataReader<TensorBuffer>::loader_;
-  using DataReader<TensorBuffer>::parser_;
 };
 
 }  // namespace data
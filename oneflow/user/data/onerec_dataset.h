@@ -21,6 +21,7 @@ limitations under the License.
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/common/str_util.h"
 #include "oneflow/core/framework/op_kernel.h"
+#include "oneflow/core/persistence/mapped_in_stream.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/job/job_set.pb.h"
 
@@ -76,40 +77,81 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   OF_DISALLOW_COPY_AND_MOVE(OneRecDataset);
-  OneRecDataset(user_op::KernelInitContext* ctx, int32_t batch_size) : batch_size_(batch_size) {
+  OneRecDataset(user_op::KernelInitContext* ctx, int32_t batch_size, int32_t load_thread_id = 0,
+                int32_t load_thread_num = 1)
+      : batch_size_(batch_size) {
     current_epoch_ = 0;
     shuffle_after_epoch_ = ctx->Attr<bool>("shuffle_after_epoch");
     data_file_paths_ = ctx->Attr<std::vector<std::string>>("files");
     parallel_id_ = ctx->parallel_ctx().parallel_id();
     parallel_num_ = ctx->parallel_ctx().parallel_num();
-    BalancedSplitter bs(data_file_paths_.size(), parallel_num_);
-    range_ = bs.At(parallel_id_);
+    range_ = GetLoadThreadDataPartRange(data_file_paths_.size(), parallel_num_, parallel_id_,
+                                        load_thread_num, load_thread_id);
+    use_mapped_in_stream_ =
+        Global<const IOConf>::Get()->enable_mmap_data_reader() && DataFS() == LocalFS();
     ResetInstream();
-    hash_state_ = LZ4_XXH64_createState();
+    const std::string& checksum_policy = ctx->Attr<std::string>("checksum_policy");
+    if (checksum_policy == "always") {
+      checksum_policy_ = kChecksumAlways;
+    } else if (checksum_policy == "sampled") {
+      checksum_policy_ = kChecksumSampled;
+    } else if (checksum_policy == "first_epoch") {
+      checksum_policy_ = kChecksumFirstEpoch;
+    } else if (checksum_policy == "off") {
+      checksum_policy_ = kChecksumOff;
+    } else {
+      UNIMPLEMENTED() << checksum_policy;
+    }
+    checksum_sample_interval_ = ctx->Attr<int32_t>("checksum_sample_interval");
+    CHECK_GT(checksum_sample_interval_, 0);
+    sample_cnt_ = 0;
+    verified_sample_cnt_ = 0;
+    read_nanos_ = 0;
+    checksum_nanos_ = 0;
   }
 
-  ~OneRecDataset() { CHECK_NE(LZ4_XXH64_freeState(hash_state_), XXH_ERROR); }
+  ~OneRecDataset() {
+    LOG(INFO) << "OneRecDataset read samples: " << sample_cnt_
+              << " payload digests verified: " << verified_sample_cnt_
+              << " read ms: " << read_nanos_ / 1000000
+              << " checksum ms: " << checksum_nanos_ / 1000000;
+  }
 
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
     ret.resize(batch_size_);
+    const double start = GetCurTime();
     for (int32_t i = 0; i < batch_size_; ++i) {
       ret.at(i).reset(new TensorBuffer());
       ReadSample(*ret.at(i).get());
     }
+    read_nanos_ += GetCurTime() - start;
     return ret;
   }
 
  private:
+  enum ChecksumPolicy { kChecksumAlways, kChecksumSampled, kChecksumFirstEpoch, kChecksumOff };
+
+  bool ShouldVerifyPayload() const {
+    switch (checksum_policy_) {
+      case kChecksumAlways: return true;
+      case kChecksumSampled: return sample_cnt_ % checksum_sample_interval_ == 0;
+      case kChecksumFirstEpoch: return current_epoch_ == 0;
+      case kChecksumOff: return false;
+      default: UNIMPLEMENTED();
+    }
+    return true;
+  }
+
   void ReadSample(TensorBuffer& tensor) {
     static_assert(sizeof(OneRecFrameHeader) == kHeaderSize, "");
     OneRecFrameHeaderView header_view{};
     static_assert(sizeof(header_view.header) == kHeaderSize, "");
-    int32_t read_status = in_stream_->ReadFully(header_view.raw, kHeaderSize);
+    int32_t read_status = ReadFully(header_view.raw, kHeaderSize);
     if (read_status == -1) {
       ResetInstream();
       current_epoch_++;
-      CHECK_EQ(in_stream_->ReadFully(header_view.raw, kHeaderSize), 0);
+      CHECK_EQ(ReadFully(header_view.raw, kHeaderSize), 0);
     } else {
       CHECK_EQ(read_status, 0);
     }
@@ -119,21 +161,34 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
     CHECK_GE(payload_size, 0);
     CHECK_LE(payload_size, kMaxPayloadSize);
     XXH64_hash_t const seed = 0;
-    CHECK_NE(LZ4_XXH64_reset(hash_state_, seed), XXH_ERROR);
-    CHECK_NE(XXH64_update(hash_state_, header_view.raw, kHeaderSizeWithoutDigest), XXH_ERROR);
-    CHECK_EQ(ByteSwap(header_view.header.digest), LZ4_XXH64_digest(hash_state_));
+    // the header digest is always verified, since a wrong payload size would derail the stream
+    double checksum_start = GetCurTime();
+    CHECK_EQ(ByteSwap(header_view.header.digest),
+             LZ4_XXH64(header_view.raw, kHeaderSizeWithoutDigest, seed));
+    checksum_nanos_ += GetCurTime() - checksum_start;
     const int32_t padded_size = RoundUp(payload_size, kPayloadAlignmentSize) - payload_size;
-    tensor.Resize(Shape({payload_size}), DataType::kChar);
-    char* body = tensor.mut_data<char>();
-    CHECK_EQ(in_stream_->ReadFully(body, payload_size), 0);
+    char* body = nullptr;
+    if (use_mapped_in_stream_) {
+      std::shared_ptr<const MappedFile> mapped_file;
+      CHECK_EQ(mapped_in_stream_->ReadView(payload_size, &body, &mapped_file), 0);
+      tensor.ResetToView(Shape({payload_size}), DataType::kChar, body, std::move(mapped_file));
+    } else {
+      tensor.Resize(Shape({payload_size}), DataType::kChar);
+      body = tensor.mut_data<char>();
+      CHECK_EQ(in_stream_->ReadFully(body, payload_size), 0);
+    }
     char padded[kPayloadAlignmentSize];
-    CHECK_EQ(in_stream_->ReadFully(padded, padded_size), 0);  // read padded
+    CHECK_EQ(ReadFully(padded, padded_size), 0);  // read padded
     static_assert(sizeof(OneRecFrameFooterView) == kDigestFieldSize, "");
     OneRecFrameFooterView footer_view{};
-    CHECK_EQ(in_stream_->ReadFully(footer_view.raw, kDigestFieldSize), 0);  // read footer
-    CHECK_NE(XXH64_reset(hash_state_, seed), XXH_ERROR);
-    CHECK_NE(LZ4_XXH64_update(hash_state_, body, payload_size), XXH_ERROR);
-    CHECK_EQ(ByteSwap(footer_view.digest), LZ4_XXH64_digest(hash_state_));
+    CHECK_EQ(ReadFully(footer_view.raw, kDigestFieldSize), 0);  // read footer
+    if (ShouldVerifyPayload()) {
+      checksum_start = GetCurTime();
+      CHECK_EQ(ByteSwap(footer_view.digest), LZ4_XXH64(body, payload_size, seed));
+      checksum_nanos_ += GetCurTime() - checksum_start;
+      verified_sample_cnt_ += 1;
+    }
+    sample_cnt_ += 1;
   }
 
   void ResetInstream() {
@@ -142,7 +197,19 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
       std::shuffle(data_file_paths_.begin(), data_file_paths_.end(), g);
     }
     std::vector<std::string> file_paths = GetLocalFilePaths();
-    in_stream_.reset(new PersistentInStream(DataFS(), file_paths, false, false));
+    if (use_mapped_in_stream_) {
+      mapped_in_stream_.reset(new MappedInStream(file_paths, false));
+    } else {
+      in_stream_.reset(new PersistentInStream(DataFS(), file_paths, false, false));
+    }
+  }
+
+  int32_t ReadFully(char* s, size_t n) {
+    if (use_mapped_in_stream_) {
+      return mapped_in_stream_->ReadFully(s, n);
+    } else {
+      return in_stream_->ReadFully(s, n);
+    }
   }
 
   std::vector<std::string> GetLocalFilePaths() {
@@ -158,9 +225,16 @@ class OneRecDataset final : public Dataset<TensorBuffer> {
   int32_t parallel_num_;
   Range range_;
   std::vector<std::string> data_file_paths_;
+  bool use_mapped_in_stream_;
   std::unique_ptr<PersistentInStream> in_stream_;
-  XXH64_state_t* hash_state_;
+  std::unique_ptr<MappedInStream> mapped_in_stream_;
   int32_t batch_size_;
+  ChecksumPolicy checksum_policy_;
+  int32_t checksum_sample_interval_;
+  int64_t sample_cnt_;
+  int64_t verified_sample_cnt_;
+  double read_nanos_;
+  double checksum_nanos_;
 };
 
 }  // namespace data
@@ -0,0 +1,189 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/user/data/onerec_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+constexpr int64_t kSampleNum = 12;
+
+// the attrs of a onerec_reader op of a single rank
+class TestKernelInitContext final : public user_op::KernelInitContext {
+ public:
+  explicit TestKernelInitContext(const OperatorConf& op_conf)
+      : user_op::KernelInitContext(user_op::UserOpConfWrapper(op_conf)) {
+    parallel_ctx_.set_parallel_id(0);
+    parallel_ctx_.set_parallel_num(1);
+  }
+  ~TestKernelInitContext() override = default;
+
+  DeviceCtx* device_ctx() override { return nullptr; }
+  DeviceType device_type() const override { return DeviceType::kCPU; }
+  const ParallelContext& parallel_ctx() const override { return parallel_ctx_; }
+  const user_op::TensorDesc* TensorDesc4ArgNameAndIndex(const std::string&,
+                                                        int32_t) const override {
+    return nullptr;
+  }
+  const SbpParallel& SbpParallel4ArgNameAndIndex(const std::string&, int32_t) const override {
+    UNIMPLEMENTED();
+    return sbp_parallel_;
+  }
+  const user_op::TensorDesc* LogicalTensorDesc4ArgNameAndIndex(const std::string&,
+                                                               int32_t) const override {
+    return nullptr;
+  }
+  const ParallelDesc& parallel_desc() const override {
+    UNIMPLEMENTED();
+    return *static_cast<const ParallelDesc*>(nullptr);
+  }
+  const std::vector<std::pair<std::string, int32_t>>& inputs() const override { return args_; }
+  const std::vector<std::pair<std::string, int32_t>>& outputs() const override { return args_; }
+
+ private:
+  ParallelContext parallel_ctx_;
+  SbpParallel sbp_parallel_;
+  std::vector<std::pair<std::string, int32_t>> args_;
+};
+
+OperatorConf MakeOpConf(const std::vector<std::string>& files, const std::string& checksum_policy,
+                        int32_t checksum_sample_interval) {
+  OperatorConf op_conf;
+  op_conf.set_name("onerec_reader");
+  UserOpConf* user_conf = op_conf.mutable_user_conf();
+  user_conf->set_op_type_name("OneRecReader");
+  auto* attr = user_conf->mutable_attr();
+  (*attr)["shuffle_after_epoch"].set_at_bool(false);
+  for (const std::string& file : files) {
+    (*attr)["files"].mutable_at_list_string()->add_val(file);
+  }
+  (*attr)["checksum_policy"].set_at_string(checksum_policy);
+  (*attr)["checksum_sample_interval"].set_at_int32(checksum_sample_interval);
+  return op_conf;
+}
+
+std::string Payload(int64_t sample_idx) {
+  std::string payload(sample_idx * 13 + 1, '\0');
+  FOR_RANGE(size_t, i, 0, payload.size()) {
+    payload[i] = static_cast<char>((sample_idx * 31 + i * 7) & 0xff);
+  }
+  return payload;
+}
+
+// Writes kSampleNum frames, the payload of corrupted_sample_idx changed after its digest
+std::string WriteOneRecFile(const std::string& name, int64_t corrupted_sample_idx) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  const std::string path = JoinPath(current_dir, "tmp_onerec_dataset_" + name);
+  std::string content;
+  FOR_RANGE(int64_t, i, 0, kSampleNum) {
+    const std::string payload = Payload(i);
+    OneRecFrameHeaderView header_view{};
+    header_view.header.magic = kMagicNumber;
+    header_view.header.reserved = kReservedNumber;
+    header_view.header.payload_size = payload.size();
+    header_view.header.digest =
+        ByteSwap(LZ4_XXH64(header_view.raw, kHeaderSizeWithoutDigest, 0));
+    OneRecFrameFooterView footer_view{};
+    footer_view.digest = ByteSwap(LZ4_XXH64(payload.data(), payload.size(), 0));
+    content.append(header_view.raw, kHeaderSize);
+    content.append(payload);
+    if (i == corrupted_sample_idx) { content.back() ^= 1; }
+    content.append(RoundUp(payload.size(), kPayloadAlignmentSize) - payload.size(), '\0');
+    content.append(footer_view.raw, kDigestFieldSize);
+  }
+  std::unique_ptr<fs::WritableFile> file;
+  LocalFS()->NewWritableFile(path, &file);
+  file->Append(content.data(), content.size());
+  file->Close();
+  return path;
+}
+
+// Reads a whole epoch of the file, and checks the payloads as far as they are not corrupted
+void ReadEpoch(const std::string& path, const std::string& checksum_policy,
+               int32_t checksum_sample_interval, int64_t corrupted_sample_idx) {
+  TestKernelInitContext ctx(MakeOpConf({path}, checksum_policy, checksum_sample_interval));
+  OneRecDataset dataset(&ctx, 1);
+  FOR_RANGE(int64_t, i, 0, kSampleNum) {
+    const OneRecDataset::LoadTargetPtrList batch = dataset.Next();
+    CHECK_EQ(batch.size(), 1);
+    std::string expected = Payload(i);
+    if (i == corrupted_sample_idx) { expected.back() ^= 1; }
+    CHECK_EQ(std::string(batch.front()->data<char>(), batch.front()->nbytes()), expected);
+  }
+}
+
+void SetIOConf() {
+  IOConf io_conf;
+  io_conf.mutable_data_fs_conf()->mutable_localfs_conf();
+  io_conf.set_persistence_buf_byte(1024);
+  Global<const IOConf>::Delete();
+  Global<const IOConf>::SetAllocated(new IOConf(io_conf));
+}
+
+}  // namespace
+
+TEST(OneRecDataset, checksum_policy) {
+  SetIOConf();
+  const std::string intact_path = WriteOneRecFile("intact", -1);
+  for (const char* policy : {"always", "sampled", "first_epoch", "off"}) {
+    ReadEpoch(intact_path, policy, 3, -1);
+  }
+  const int64_t corrupted_sample_idx = 7;
+  const std::string corrupted_path = WriteOneRecFile("corrupted", corrupted_sample_idx);
+  // rejected whenever the corrupted sample is verified
+  const std::string digest_mismatch = "footer_view.digest";
+  EXPECT_DEATH(ReadEpoch(corrupted_path, "always", 3, corrupted_sample_idx), digest_mismatch);
+  EXPECT_DEATH(ReadEpoch(corrupted_path, "first_epoch", 3, corrupted_sample_idx), digest_mismatch);
+  EXPECT_DEATH(ReadEpoch(corrupted_path, "sampled", 7, corrupted_sample_idx), digest_mismatch);
+  EXPECT_DEATH(ReadEpoch(corrupted_path, "sampled", 1, corrupted_sample_idx), digest_mismatch);
+  // and accepted as it is otherwise, every interval-th sample being verified
+  ReadEpoch(corrupted_path, "sampled", 3, corrupted_sample_idx);
+  ReadEpoch(corrupted_path, "sampled", 5, corrupted_sample_idx);
+  ReadEpoch(corrupted_path, "off", 3, corrupted_sample_idx);
+  LocalFS()->DelFile(intact_path);
+  LocalFS()->DelFile(corrupted_path);
+  Global<const IOConf>::Delete();
+}
+
+TEST(OneRecDataset, one_shot_digest_equals_streaming_digest) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int32_t> byte_dis(0, 255);
+  for (size_t size : {0, 1, 7, 31, 32, 33, 100, 4096, 100003}) {
+    std::string data(size, '\0');
+    for (char& c : data) { c = static_cast<char>(byte_dis(gen)); }
+    // the payload was digested in pieces before
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset(state, 0);
+    size_t offset = 0;
+    while (offset < size) {
+      const size_t piece_size =
+          std::min<size_t>(std::uniform_int_distribution<size_t>(1, 64)(gen), size - offset);
+      XXH64_update(state, data.data() + offset, piece_size);
+      offset += piece_size;
+    }
+    const XXH64_hash_t streaming_digest = XXH64_digest(state);
+    XXH64_freeState(state);
+    ASSERT_EQ(LZ4_XXH64(data.data(), data.size(), 0), streaming_digest) << "size: " << size;
+  }
+}
+
+}  // namespace data
+}  // namespace oneflow
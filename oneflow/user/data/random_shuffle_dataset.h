@@ -29,7 +29,8 @@ class RandomShuffleDataset final : public Dataset<LoadTarget> {
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   RandomShuffleDataset(user_op::KernelInitContext* ctx,
-                       std::unique_ptr<Dataset<LoadTarget>>&& data_set)
+                       std::unique_ptr<Dataset<LoadTarget>>&& data_set,
+                       int32_t load_thread_num = 1)
       : loader_(std::move(data_set)) {
     // random
     seed_ = ctx->Attr<int64_t>("seed");
@@ -37,8 +38,9 @@ class RandomShuffleDataset final : public Dataset<LoadTarget> {
     std::seed_seq seq({seed_});
     rand_engine_ = std::default_random_engine(seq);
 
-    // fill buffer
-    initial_buffer_fill_ = ctx->Attr<int32_t>("shuffle_buffer_size");
+    // fill buffer, the load threads of a reader sharing its size
+    initial_buffer_fill_ =
+        std::max<int32_t>(ctx->Attr<int32_t>("shuffle_buffer_size") / load_thread_num, 1);
     int32_t remain_cnt = initial_buffer_fill_;
     while (remain_cnt > 0) {
       LoadTargetPtrList sample_list = loader_->Next();
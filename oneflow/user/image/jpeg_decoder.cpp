@@ -0,0 +1,206 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+constexpr int kJpegScaleDenom = 8;
+
+struct JpegErrorMgr {
+  jpeg_error_mgr pub;
+  jmp_buf jmp;
+};
+
+void JpegErrorExit(j_common_ptr cinfo) {
+  longjmp(reinterpret_cast<JpegErrorMgr*>(cinfo->err)->jmp, 1);
+}
+
+// warnings of corrupt data are not errors, libjpeg decodes what it can like cv::imdecode
+void JpegOutputMessage(j_common_ptr cinfo) {}
+
+bool GetJpegColorSpace(const std::string& color_space, J_COLOR_SPACE* jpeg_color_space) {
+  if (color_space == "RGB") {
+    *jpeg_color_space = JCS_RGB;
+  } else if (color_space == "BGR") {
+    *jpeg_color_space = JCS_EXT_BGR;
+  } else if (color_space == "GRAY") {
+    *jpeg_color_space = JCS_GRAYSCALE;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// the smallest n with which the roi scaled by n/8 is no smaller than min_width x min_height
+int GetScaleNum(int roi_width, int roi_height, int min_width, int min_height) {
+  if (min_width <= 0 || min_height <= 0) { return kJpegScaleDenom; }
+  int scale_num = kJpegScaleDenom;
+  while (scale_num > 1
+         && static_cast<int64_t>(roi_width) * (scale_num - 1) / kJpegScaleDenom >= min_width
+         && static_cast<int64_t>(roi_height) * (scale_num - 1) / kJpegScaleDenom >= min_height) {
+    scale_num -= 1;
+  }
+  return scale_num;
+}
+
+// [begin, end) of the scaled image covering [begin, begin + size) of the image
+void ScaleRange(int begin, int size, int scale_num, JDIMENSION scaled_size,
+                JDIMENSION* scaled_begin, JDIMENSION* scaled_end) {
+  *scaled_begin = static_cast<int64_t>(begin) * scale_num / kJpegScaleDenom;
+  *scaled_end = std::min<int64_t>(
+      (static_cast<int64_t>(begin + size) * scale_num + kJpegScaleDenom - 1) / kJpegScaleDenom,
+      scaled_size);
+}
+
+// the orientation in the EXIF of the image, 1 if there is none
+int GetExifOrientation(j_decompress_ptr cinfo) {
+  constexpr uint32_t kExifOrientationTag = 0x0112;
+  for (jpeg_saved_marker_ptr marker = cinfo->marker_list; marker != nullptr;
+       marker = marker->next) {
+    if (marker->marker != JPEG_APP0 + 1 || marker->data_length < 14
+        || memcmp(marker->data, "Exif\0\0", 6) != 0) {
+      continue;
+    }
+    // a TIFF header and IFD0 follow
+    const unsigned char* tiff = marker->data + 6;
+    const size_t tiff_size = marker->data_length - 6;
+    bool little_endian = false;
+    if (tiff[0] == 'I' && tiff[1] == 'I') {
+      little_endian = true;
+    } else if (tiff[0] != 'M' || tiff[1] != 'M') {
+      return 1;
+    }
+    auto Read16 = [&](size_t offset) -> uint32_t {
+      return little_endian ? tiff[offset] | (tiff[offset + 1] << 8)
+                           : (tiff[offset] << 8) | tiff[offset + 1];
+    };
+    auto Read32 = [&](size_t offset) -> uint32_t {
+      return little_endian ? Read16(offset) | (Read16(offset + 2) << 16)
+                           : (Read16(offset) << 16) | Read16(offset + 2);
+    };
+    const size_t ifd_offset = Read32(4);
+    if (ifd_offset + 2 > tiff_size) { return 1; }
+    const uint32_t entry_num = Read16(ifd_offset);
+    FOR_RANGE(uint32_t, i, 0, entry_num) {
+      const size_t entry_offset = ifd_offset + 2 + i * 12;
+      if (entry_offset + 12 > tiff_size) { break; }
+      if (Read16(entry_offset) == kExifOrientationTag) { return Read16(entry_offset + 8); }
+    }
+  }
+  return 1;
+}
+
+// false if the image is to be rotated or flipped by its EXIF, which cv::imdecode does
+bool ReadJpegHeader(j_decompress_ptr cinfo, const unsigned char* data, size_t length) {
+  jpeg_create_decompress(cinfo);
+  jpeg_mem_src(cinfo, const_cast<unsigned char*>(data), length);
+  jpeg_save_markers(cinfo, JPEG_APP0 + 1, 0xFFFF);
+  jpeg_read_header(cinfo, TRUE);
+  return GetExifOrientation(cinfo) == 1;
+}
+
+bool IsJpeg(const unsigned char* data, size_t length) {
+  // SOI marker
+  return length >= 2 && data[0] == 0xFF && data[1] == 0xD8;
+}
+
+}  // namespace
+
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* width, int* height) {
+  if (!IsJpeg(data, length)) { return false; }
+  jpeg_decompress_struct cinfo;
+  JpegErrorMgr err;
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = JpegErrorExit;
+  err.pub.output_message = JpegOutputMessage;
+  if (setjmp(err.jmp)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  const bool ret = ReadJpegHeader(&cinfo, data, length);
+  *width = cinfo.image_width;
+  *height = cinfo.image_height;
+  jpeg_destroy_decompress(&cinfo);
+  return ret;
+}
+
+bool JpegDecodeRoi(const unsigned char* data, size_t length, const std::string& color_space,
+                   int roi_x, int roi_y, int roi_width, int roi_height, int min_width,
+                   int min_height, std::vector<unsigned char>* image, int* width, int* height) {
+  if (!IsJpeg(data, length)) { return false; }
+  J_COLOR_SPACE jpeg_color_space;
+  if (!GetJpegColorSpace(color_space, &jpeg_color_space)) { return false; }
+  jpeg_decompress_struct cinfo;
+  JpegErrorMgr err;
+  cinfo.err = jpeg_std_error(&err.pub);
+  err.pub.error_exit = JpegErrorExit;
+  err.pub.output_message = JpegOutputMessage;
+  if (setjmp(err.jmp)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  if (!ReadJpegHeader(&cinfo, data, length)) {
+    jpeg_destroy_decompress(&cinfo);
+    return false;
+  }
+  CHECK(roi_x >= 0 && roi_width > 0 && roi_x + roi_width <= static_cast<int>(cinfo.image_width));
+  CHECK(roi_y >= 0 && roi_height > 0
+        && roi_y + roi_height <= static_cast<int>(cinfo.image_height));
+  cinfo.out_color_space = jpeg_color_space;
+  const int scale_num = GetScaleNum(roi_width, roi_height, min_width, min_height);
+  cinfo.scale_num = scale_num;
+  cinfo.scale_denom = kJpegScaleDenom;
+  jpeg_start_decompress(&cinfo);
+
+  JDIMENSION x_begin = 0;
+  JDIMENSION x_end = 0;
+  JDIMENSION y_begin = 0;
+  JDIMENSION y_end = 0;
+  ScaleRange(roi_x, roi_width, scale_num, cinfo.output_width, &x_begin, &x_end);
+  ScaleRange(roi_y, roi_height, scale_num, cinfo.output_height, &y_begin, &y_end);
+  // crop_x is moved left to an iMCU boundary and the decoded columns start from there. The column
+  // left of the roi and one more iMCU column on the right are decoded too, or the chroma
+  // upsampling would see an edge at an roi starting on an iMCU boundary or at the right
+  const JDIMENSION imcu_width = cinfo.max_h_samp_factor * cinfo.min_DCT_scaled_size;
+  JDIMENSION crop_x = x_begin > 0 ? x_begin - 1 : 0;
+  JDIMENSION crop_width = std::min(x_end + imcu_width, cinfo.output_width) - crop_x;
+  if (crop_width < cinfo.output_width) { jpeg_crop_scanline(&cinfo, &crop_x, &crop_width); }
+  if (y_begin > 0) { CHECK_EQ(jpeg_skip_scanlines(&cinfo, y_begin), y_begin); }
+
+  const int channels = cinfo.output_components;
+  *width = x_end - x_begin;
+  *height = y_end - y_begin;
+  image->resize(static_cast<size_t>(*width) * *height * channels);
+  JSAMPARRAY row = (*cinfo.mem->alloc_sarray)(reinterpret_cast<j_common_ptr>(&cinfo), JPOOL_IMAGE,
+                                              cinfo.output_width * channels, 1);
+  const size_t row_offset = (x_begin - crop_x) * channels;
+  const size_t row_size = *width * channels;
+  FOR_RANGE(int, i, 0, *height) {
+    CHECK_EQ(jpeg_read_scanlines(&cinfo, row, 1), 1U);
+    memcpy(image->data() + i * row_size, row[0] + row_offset, row_size);
+  }
+  // the rows below the roi are never decoded
+  jpeg_abort_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return true;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,41 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+#define ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Reads the size of a JPEG image from its header. Returns false if the data is not a JPEG image
+// JpegDecodeRoi can decode, e.g. one with an EXIF orientation cv::imdecode would apply, and the
+// caller should then use cv::imdecode.
+bool JpegGetImageSize(const unsigned char* data, size_t length, int* width, int* height);
+
+// Decodes only the region of interest of a JPEG image: the rows above it are skipped and only the
+// iMCU columns it covers are decoded. The image is also downscaled by n/8 in the DCT domain, as
+// far as the region stays no smaller than min_width x min_height, so *width and *height may be
+// smaller than the region. A min_width or min_height of 0 disables the downscaling. The HWC image
+// is stored in *image in color_space, which is "RGB", "BGR" or "GRAY".
+//
+// Returns false if libjpeg fails, and the caller should then use cv::imdecode.
+bool JpegDecodeRoi(const unsigned char* data, size_t length, const std::string& color_space,
+                   int roi_x, int roi_y, int roi_width, int roi_height, int min_width,
+                   int min_height, std::vector<unsigned char>* image, int* width, int* height);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_IMAGE_JPEG_DECODER_H_
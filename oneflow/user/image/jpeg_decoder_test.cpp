@@ -0,0 +1,162 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/image/jpeg_decoder.h"
+#include <array>
+#include <cstdio>
+#include <random>
+#include <jpeglib.h>
+
+namespace oneflow {
+
+namespace {
+
+// neither side is a multiple of the 16x16 iMCU of 4:2:0 images
+constexpr int kWidth = 203;
+constexpr int kHeight = 157;
+
+// smooth gradients with some noise, so that the chroma upsampling has something to smooth
+std::vector<unsigned char> GenRgbImage() {
+  std::vector<unsigned char> image(kWidth * kHeight * 3);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dis(0, 31);
+  FOR_RANGE(int, y, 0, kHeight) {
+    FOR_RANGE(int, x, 0, kWidth) {
+      unsigned char* pixel = image.data() + (y * kWidth + x) * 3;
+      pixel[0] = (x * 255 / kWidth + dis(gen)) % 256;
+      pixel[1] = (y * 255 / kHeight + dis(gen)) % 256;
+      pixel[2] = ((x + y) * 127 / (kWidth + kHeight) + 64 + dis(gen)) % 256;
+    }
+  }
+  return image;
+}
+
+// the fixture images, encoded with the default 4:2:0 subsampling
+std::vector<unsigned char> EncodeJpeg(const std::vector<unsigned char>& rgb, bool progressive) {
+  jpeg_compress_struct cinfo;
+  jpeg_error_mgr err;
+  cinfo.err = jpeg_std_error(&err);
+  jpeg_create_compress(&cinfo);
+  unsigned char* buf = nullptr;
+  unsigned long size = 0;
+  jpeg_mem_dest(&cinfo, &buf, &size);
+  cinfo.image_width = kWidth;
+  cinfo.image_height = kHeight;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 90, TRUE);
+  if (progressive) { jpeg_simple_progression(&cinfo); }
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row = const_cast<unsigned char*>(rgb.data()) + cinfo.next_scanline * kWidth * 3;
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  std::vector<unsigned char> jpeg(buf, buf + size);
+  free(buf);
+  return jpeg;
+}
+
+// the whole image decoded by plain libjpeg, which the roi decode has to match
+std::vector<unsigned char> DecodeFullJpeg(const std::vector<unsigned char>& jpeg,
+                                          J_COLOR_SPACE color_space, int* channels) {
+  jpeg_decompress_struct cinfo;
+  jpeg_error_mgr err;
+  cinfo.err = jpeg_std_error(&err);
+  jpeg_create_decompress(&cinfo);
+  jpeg_mem_src(&cinfo, const_cast<unsigned char*>(jpeg.data()), jpeg.size());
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = color_space;
+  jpeg_start_decompress(&cinfo);
+  *channels = cinfo.output_components;
+  std::vector<unsigned char> image(cinfo.output_width * cinfo.output_height * *channels);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = image.data() + cinfo.output_scanline * cinfo.output_width * *channels;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  return image;
+}
+
+}  // namespace
+
+TEST(JpegDecoder, get_image_size) {
+  const std::vector<unsigned char> jpeg = EncodeJpeg(GenRgbImage(), false);
+  int width = 0;
+  int height = 0;
+  ASSERT_TRUE(JpegGetImageSize(jpeg.data(), jpeg.size(), &width, &height));
+  ASSERT_EQ(width, kWidth);
+  ASSERT_EQ(height, kHeight);
+  const std::vector<unsigned char> png_magic = {0x89, 'P', 'N', 'G'};
+  ASSERT_FALSE(JpegGetImageSize(png_magic.data(), png_magic.size(), &width, &height));
+}
+
+TEST(JpegDecoder, roi_decode_matches_full_decode_and_crop) {
+  const std::vector<unsigned char> rgb = GenRgbImage();
+  // {x, y, width, height}, on and off the 8 and 16 pixel block boundaries, and at the edges
+  const std::vector<std::array<int, 4>> rois = {
+      {0, 0, kWidth, kHeight}, {0, 0, 1, 1},     {1, 1, 17, 9},
+      {15, 7, 33, 40},         {16, 16, 32, 32}, {17, 31, 100, 1},
+      {100, 50, 103, 107},     {kWidth - 5, kHeight - 3, 5, 3},
+      {31, 0, 1, kHeight},     {0, 63, kWidth, 18},
+  };
+  const std::vector<std::pair<std::string, J_COLOR_SPACE>> color_spaces = {
+      {"RGB", JCS_RGB}, {"BGR", JCS_EXT_BGR}, {"GRAY", JCS_GRAYSCALE}};
+  for (bool progressive : {false, true}) {
+    const std::vector<unsigned char> jpeg = EncodeJpeg(rgb, progressive);
+    for (const auto& color_space : color_spaces) {
+      int channels = 0;
+      const std::vector<unsigned char> full =
+          DecodeFullJpeg(jpeg, color_space.second, &channels);
+      for (const auto& roi : rois) {
+        std::vector<unsigned char> image;
+        int width = 0;
+        int height = 0;
+        ASSERT_TRUE(JpegDecodeRoi(jpeg.data(), jpeg.size(), color_space.first, roi[0], roi[1],
+                                  roi[2], roi[3], 0, 0, &image, &width, &height));
+        ASSERT_EQ(width, roi[2]);
+        ASSERT_EQ(height, roi[3]);
+        ASSERT_EQ(image.size(), static_cast<size_t>(width * height * channels));
+        FOR_RANGE(int, y, 0, height) {
+          const unsigned char* expected =
+              full.data() + ((roi[1] + y) * kWidth + roi[0]) * channels;
+          ASSERT_TRUE(std::equal(expected, expected + width * channels,
+                                 image.data() + y * width * channels))
+              << "progressive: " << progressive << " color space: " << color_space.first
+              << " roi: " << roi[0] << "," << roi[1] << "," << roi[2] << "," << roi[3]
+              << " row: " << y;
+        }
+      }
+    }
+  }
+}
+
+TEST(JpegDecoder, roi_decode_downscales_no_smaller_than_min_size) {
+  const std::vector<unsigned char> jpeg = EncodeJpeg(GenRgbImage(), false);
+  std::vector<unsigned char> image;
+  int width = 0;
+  int height = 0;
+  ASSERT_TRUE(JpegDecodeRoi(jpeg.data(), jpeg.size(), "RGB", 8, 20, 160, 120, 40, 30, &image,
+                            &width, &height));
+  // scaled by 2/8
+  ASSERT_EQ(width, 40);
+  ASSERT_EQ(height, 30);
+  ASSERT_EQ(image.size(), static_cast<size_t>(width * height * 3));
+}
+
+}  // namespace oneflow
@@ -0,0 +1,222 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/common/tensor_buffer.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
+#include "oneflow/user/kernels/random_crop_kernel_state.h"
+#include <opencv2/opencv.hpp>
+
+namespace oneflow {
+
+namespace {
+
+class DecodeCropResizeNormalizeKernelState final : public user_op::OpKernelState {
+ public:
+  explicit DecodeCropResizeNormalizeKernelState(user_op::KernelInitContext* ctx) {
+    if (ctx->Attr<bool>("random_crop")) { random_crop_state_ = CreateRandomCropKernelState(ctx); }
+    const std::vector<float>& mean_vec = ctx->Attr<std::vector<float>>("mean");
+    const std::vector<float>& std_vec = ctx->Attr<std::vector<float>>("std");
+    const int64_t C = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+    CHECK(mean_vec.size() == 1 || mean_vec.size() == C);
+    CHECK(std_vec.size() == 1 || std_vec.size() == C);
+    // (x - mean) / std is computed as x * scale + bias
+    FOR_RANGE(int64_t, c, 0, C) {
+      const float mean = mean_vec.at(mean_vec.size() == 1 ? 0 : c);
+      const float inv_std = 1.0f / std_vec.at(std_vec.size() == 1 ? 0 : c);
+      scale_vec_.push_back(inv_std);
+      bias_vec_.push_back(-mean * inv_std);
+    }
+  }
+  ~DecodeCropResizeNormalizeKernelState() override = default;
+
+  RandomCropGenerator* GetGenerator(int32_t idx) {
+    return random_crop_state_ ? random_crop_state_->GetGenerator(idx) : nullptr;
+  }
+  const std::vector<float>& scale_vec() const { return scale_vec_; }
+  const std::vector<float>& bias_vec() const { return bias_vec_; }
+
+ private:
+  std::shared_ptr<RandomCropKernelState> random_crop_state_;
+  std::vector<float> scale_vec_;
+  std::vector<float> bias_vec_;
+};
+
+// Decodes the crop window of the image in color_space. A JPEG image is decoded only in the crop
+// window and downscaled by libjpeg as far as it stays no smaller than the target size, into
+// *buffer, which the returned image then points into.
+cv::Mat DecodeCropWindow(const TensorBuffer& raw_bytes, const std::string& color_space,
+                         int target_width, int target_height, RandomCropGenerator* random_crop_gen,
+                         std::vector<unsigned char>* buffer) {
+  CHECK(raw_bytes.data_type() == DataType::kChar || raw_bytes.data_type() == DataType::kInt8
+        || raw_bytes.data_type() == DataType::kUInt8);
+  const unsigned char* data = static_cast<const unsigned char*>(raw_bytes.data());
+  const size_t length = raw_bytes.nbytes();
+  const int channels = ImageUtil::IsColor(color_space) ? 3 : 1;
+  CropWindow crop;
+  bool has_crop = false;
+  int W = 0;
+  int H = 0;
+  if (JpegGetImageSize(data, length, &W, &H)) {
+    crop.shape = Shape({H, W});
+    if (random_crop_gen != nullptr) { random_crop_gen->GenerateCropWindow({H, W}, &crop); }
+    has_crop = true;
+    if (JpegDecodeRoi(data, length, color_space, crop.anchor.At(1), crop.anchor.At(0),
+                      crop.shape.At(1), crop.shape.At(0), target_width, target_height, buffer, &W,
+                      &H)) {
+      return cv::Mat(H, W, CV_8UC(channels), buffer->data());
+    }
+  }
+
+  cv::Mat image = cv::imdecode(cv::Mat(1, length, CV_8UC1, const_cast<unsigned char*>(data)),
+                               channels == 3 ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+  CHECK(image.data != nullptr);
+  if (random_crop_gen != nullptr) {
+    if (!has_crop) { random_crop_gen->GenerateCropWindow({image.rows, image.cols}, &crop); }
+    CHECK(crop.shape.At(0) > 0 && crop.anchor.At(0) + crop.shape.At(0) <= image.rows);
+    CHECK(crop.shape.At(1) > 0 && crop.anchor.At(1) + crop.shape.At(1) <= image.cols);
+    // a view of the window, which the resize reads from
+    image = image(cv::Rect(crop.anchor.At(1), crop.anchor.At(0), crop.shape.At(1),
+                           crop.shape.At(0)));
+  }
+  if (channels == 3 && color_space != "BGR") {
+    ImageUtil::ConvertColor("BGR", image, color_space, image);
+  }
+  return image;
+}
+
+// out[c][h][w] = image[h][w][c] * scale[c] + bias[c], with w mirrored if mirror
+template<typename T>
+void NormalizeToCHW(const cv::Mat& image, bool mirror, const float* scale, const float* bias,
+                    T* out) {
+  const int64_t H = image.rows;
+  const int64_t W = image.cols;
+  const int64_t C = image.channels();
+  FOR_RANGE(int64_t, h, 0, H) {
+    const uint8_t* in_row = image.ptr<uint8_t>(h);
+    FOR_RANGE(int64_t, c, 0, C) {
+      const uint8_t* in = in_row + c;
+      T* out_row = out + (c * H + h) * W;
+      const float s = scale[c];
+      const float b = bias[c];
+      if (mirror) {
+        FOR_RANGE(int64_t, w, 0, W) {
+          out_row[W - 1 - w] = static_cast<T>(static_cast<float>(in[w * C]) * s + b);
+        }
+      } else {
+        FOR_RANGE(int64_t, w, 0, W) {
+          out_row[w] = static_cast<T>(static_cast<float>(in[w * C]) * s + b);
+        }
+      }
+    }
+  }
+}
+
+// out[h][w][c] = image[h][w][c] * scale[c] + bias[c], with w mirrored if mirror
+template<typename T>
+void NormalizeToHWC(const cv::Mat& image, bool mirror, const float* scale, const float* bias,
+                    T* out) {
+  const int64_t H = image.rows;
+  const int64_t W = image.cols;
+  const int64_t C = image.channels();
+  FOR_RANGE(int64_t, h, 0, H) {
+    const uint8_t* in_row = image.ptr<uint8_t>(h);
+    T* out_row = out + h * W * C;
+    FOR_RANGE(int64_t, w, 0, W) {
+      const uint8_t* in = in_row + (mirror ? W - 1 - w : w) * C;
+      T* out_pixel = out_row + w * C;
+      FOR_RANGE(int64_t, c, 0, C) {
+        out_pixel[c] = static_cast<T>(static_cast<float>(in[c]) * scale[c] + bias[c]);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class ImageDecodeCropResizeNormalizeKernel final : public user_op::OpKernel {
+ public:
+  ImageDecodeCropResizeNormalizeKernel() = default;
+  ~ImageDecodeCropResizeNormalizeKernel() override = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<DecodeCropResizeNormalizeKernelState>(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    auto* kernel_state = dynamic_cast<DecodeCropResizeNormalizeKernelState*>(state);
+    CHECK_NOTNULL(kernel_state);
+    const user_op::Tensor* in_tensor = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* mirror_tensor = ctx->Tensor4ArgNameAndIndex("mirror", 0);
+    user_op::Tensor* out_tensor = ctx->Tensor4ArgNameAndIndex("out", 0);
+    const int64_t record_num = in_tensor->shape().elem_cnt();
+    CHECK_GT(record_num, 0);
+    if (mirror_tensor) { CHECK_EQ(mirror_tensor->shape().elem_cnt(), record_num); }
+    const std::string& color_space = ctx->Attr<std::string>("color_space");
+    const std::string& interp_type = ctx->Attr<std::string>("interpolation_type");
+    const bool is_nchw = ctx->Attr<std::string>("output_layout") == "NCHW";
+    const int W = ctx->Attr<int64_t>("target_width");
+    const int H = ctx->Attr<int64_t>("target_height");
+    const int C = ImageUtil::IsColor(color_space) ? 3 : 1;
+    const ShapeView& out_shape = out_tensor->shape();
+    CHECK_EQ(out_shape.NumAxes(), 4);
+    CHECK_EQ(out_shape.At(0), record_num);
+    CHECK_EQ(out_shape.Count(1), static_cast<int64_t>(H) * W * C);
+    const int64_t out_image_elem_cnt = out_shape.Count(1);
+    const TensorBuffer* in_buffers = in_tensor->dptr<TensorBuffer>();
+    const float* scale = kernel_state->scale_vec().data();
+    const float* bias = kernel_state->bias_vec().data();
+    T* out_dptr = out_tensor->mut_dptr<T>();
+
+    MultiThreadLoop(record_num, [&](size_t i) {
+      // reused by the following images of the thread
+      thread_local std::vector<unsigned char> decode_buffer;
+      thread_local cv::Mat resized;
+      cv::Mat image = DecodeCropWindow(in_buffers[i], color_space, W, H,
+                                       kernel_state->GetGenerator(i), &decode_buffer);
+      CHECK_EQ(image.channels(), C);
+      if (image.cols != W || image.rows != H) {
+        cv::resize(image, resized, cv::Size(W, H), 0, 0,
+                   GetCvInterpolationFlag(interp_type, image.cols, image.rows, W, H));
+        image = resized;
+      }
+      const bool mirror = mirror_tensor && mirror_tensor->dptr<int8_t>()[i];
+      T* out = out_dptr + i * out_image_elem_cnt;
+      if (is_nchw) {
+        NormalizeToCHW<T>(image, mirror, scale, bias, out);
+      } else {
+        NormalizeToHWC<T>(image, mirror, scale, bias, out);
+      }
+    });
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_IMAGE_DECODE_CROP_RESIZE_NORMALIZE_KERNEL(dtype)                          \
+  REGISTER_USER_KERNEL("image_decode_crop_resize_normalize")                               \
+      .SetCreateFn<ImageDecodeCropResizeNormalizeKernel<dtype>>()                          \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                  \
+                       & (user_op::HobDataType("in", 0) == DataType::kTensorBuffer)        \
+                       & (user_op::HobDataType("out", 0) == GetDataType<dtype>::value));
+
+REGISTER_IMAGE_DECODE_CROP_RESIZE_NORMALIZE_KERNEL(float)
+REGISTER_IMAGE_DECODE_CROP_RESIZE_NORMALIZE_KERNEL(float16)
+
+}  // namespace oneflow
@@ -0,0 +1,165 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/user/kernels/layer_norm_cpu_kernel_util.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+// layer norm composed from the ndarray primitives, which take a pass over the data for each step
+template<typename T>
+class NdarrayLayerNorm final {
+ public:
+  NdarrayLayerNorm(int64_t n, int64_t m)
+      : n_(n), m_(m), tmp_(n * m), centered_(n * m), row_sum_(n), row_scalar_(n) {}
+
+  void Forward(double epsilon, const T* x, const T* gamma, const T* beta, T* mean,
+               T* inv_variance, T* normalized, T* y) {
+    using NdUtil = NdarrayUtil<DeviceType::kCPU, T>;
+    auto Val = NdUtil::GetValNdarrayBuilder();
+    auto Var = NdUtil::GetVarNdarrayBuilder();
+    const T inv_m = static_cast<T>(1) / static_cast<T>(m_);
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, mean), Val({n_, m_}, x), Var({n_, m_}, tmp_.data()));
+    NdUtil::InplaceBroadcastMul(&ctx_, Var({n_, 1}, mean), Val({1, 1}, &inv_m));
+    NdUtil::BroadcastSub(&ctx_, Var({n_, m_}, centered_.data()), Val({n_, m_}, x),
+                         Val({n_, 1}, mean));
+    NdUtil::Mul(&ctx_, Var({n_, m_}, normalized), Val({n_, m_}, centered_.data()),
+                Val({n_, m_}, centered_.data()));
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, inv_variance), Val({n_, m_}, normalized),
+                      Var({n_, m_}, tmp_.data()));
+    FOR_RANGE(int64_t, i, 0, n_) {
+      inv_variance[i] =
+          static_cast<T>(1) / std::sqrt(inv_variance[i] * inv_m + static_cast<T>(epsilon));
+    }
+    NdUtil::BroadcastMul(&ctx_, Var({n_, m_}, normalized), Val({n_, m_}, centered_.data()),
+                         Val({n_, 1}, inv_variance));
+    NdUtil::BroadcastMul(&ctx_, Var({n_, m_}, y), Val({n_, m_}, normalized), Val({1, m_}, gamma));
+    NdUtil::InplaceBroadcastAdd(&ctx_, Var({n_, m_}, y), Val({1, m_}, beta));
+  }
+
+  void Backward(const T* dy, const T* normalized, const T* inv_variance, T* dx) {
+    using NdUtil = NdarrayUtil<DeviceType::kCPU, T>;
+    auto Val = NdUtil::GetValNdarrayBuilder();
+    auto Var = NdUtil::GetVarNdarrayBuilder();
+    const T inv_m = static_cast<T>(1) / static_cast<T>(m_);
+    // dx = inv_variance * (dy - mean(dy) - normalized * mean(dy * normalized))
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, row_sum_.data()), Val({n_, m_}, dy),
+                      Var({n_, m_}, tmp_.data()));
+    NdUtil::InplaceBroadcastMul(&ctx_, Var({n_, 1}, row_sum_.data()), Val({1, 1}, &inv_m));
+    NdUtil::Mul(&ctx_, Var({n_, m_}, centered_.data()), Val({n_, m_}, dy),
+                Val({n_, m_}, normalized));
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, row_scalar_.data()), Val({n_, m_}, centered_.data()),
+                      Var({n_, m_}, tmp_.data()));
+    NdUtil::InplaceBroadcastMul(&ctx_, Var({n_, 1}, row_scalar_.data()), Val({1, 1}, &inv_m));
+    NdUtil::BroadcastSub(&ctx_, Var({n_, m_}, dx), Val({n_, m_}, dy),
+                         Val({n_, 1}, row_sum_.data()));
+    NdUtil::BroadcastMul(&ctx_, Var({n_, m_}, centered_.data()), Val({n_, m_}, normalized),
+                         Val({n_, 1}, row_scalar_.data()));
+    NdUtil::InplaceSub(&ctx_, Var({n_, m_}, dx), Val({n_, m_}, centered_.data()));
+    NdUtil::InplaceBroadcastMul(&ctx_, Var({n_, m_}, dx), Val({n_, 1}, inv_variance));
+  }
+
+ private:
+  CpuDeviceCtx ctx_;
+  int64_t n_;
+  int64_t m_;
+  std::vector<T> tmp_;
+  std::vector<T> centered_;
+  std::vector<T> row_sum_;
+  std::vector<T> row_scalar_;
+};
+
+template<typename T>
+double MaxAbsDiff(const std::vector<T>& a, const std::vector<T>& b) {
+  double ret = 0;
+  FOR_RANGE(size_t, i, 0, a.size()) { ret = std::max<double>(ret, std::abs(a.at(i) - b.at(i))); }
+  return ret;
+}
+
+template<typename F>
+double AverageMillis(int64_t iter_num, const F& Run) {
+  Run();
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, iter_num) { Run(); }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+         / iter_num;
+}
+
+template<typename T>
+void BenchmarkLayerNorm(int64_t n, int64_t m, int64_t iter_num) {
+  const int64_t elem_cnt = n * m;
+  const double epsilon = 1e-5;
+  std::mt19937 gen(0);
+  std::normal_distribution<T> dis(1, 2);
+  std::vector<T> x(elem_cnt), dy(elem_cnt), gamma(m), beta(m);
+  for (T& v : x) { v = dis(gen); }
+  for (T& v : dy) { v = dis(gen); }
+  for (T& v : gamma) { v = dis(gen); }
+  for (T& v : beta) { v = dis(gen); }
+  std::vector<T> mean(n), inv_variance(n), normalized(elem_cnt), y(elem_cnt), dx(elem_cnt);
+  std::vector<T> ref_mean(n), ref_inv_variance(n), ref_normalized(elem_cnt), ref_y(elem_cnt),
+      ref_dx(elem_cnt);
+  NdarrayLayerNorm<T> ref(n, m);
+  const double ref_forward_ms = AverageMillis(iter_num, [&]() {
+    ref.Forward(epsilon, x.data(), gamma.data(), beta.data(), ref_mean.data(),
+                ref_inv_variance.data(), ref_normalized.data(), ref_y.data());
+  });
+  const double forward_ms = AverageMillis(iter_num, [&]() {
+    LayerNormCpuKernelUtil<T>::Forward(n, m, epsilon, x.data(), gamma.data(), beta.data(), m,
+                                       mean.data(), inv_variance.data(), normalized.data(),
+                                       y.data());
+  });
+  const double ref_backward_ms = AverageMillis(iter_num, [&]() {
+    ref.Backward(dy.data(), ref_normalized.data(), ref_inv_variance.data(), ref_dx.data());
+  });
+  const double backward_ms = AverageMillis(iter_num, [&]() {
+    LayerNormCpuKernelUtil<T>::Backward(n, m, dy.data(), x.data(), mean.data(),
+                                        inv_variance.data(), nullptr, dx.data());
+  });
+  std::cout << DataType_Name(GetDataType<T>::value) << " " << n << "x" << m
+            << " forward ms: " << ref_forward_ms << " -> " << forward_ms
+            << " backward ms: " << ref_backward_ms << " -> " << backward_ms
+            << " max diff y: " << MaxAbsDiff(y, ref_y) << " dx: " << MaxAbsDiff(dx, ref_dx)
+            << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(thread_num, 8, "number of threads of the compute thread pool");
+DEFINE_int64(iter_num, 20, "number of iterations every case is timed over");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::fixed << std::setprecision(3);
+  Global<ThreadPool>::New(FLAGS_thread_num);
+  // rows x hidden sizes of transformers, and a few long rows
+  for (const auto& shape : std::vector<std::pair<int64_t, int64_t>>{
+           {4096, 768}, {4096, 1024}, {8192, 4096}, {64, 65536}}) {
+    BenchmarkLayerNorm<float>(shape.first, shape.second, FLAGS_iter_num);
+    BenchmarkLayerNorm<double>(shape.first, shape.second, FLAGS_iter_num);
+  }
+  Global<ThreadPool>::Delete();
+  return 0;
+}
@@ -0,0 +1,301 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/layer_norm_cpu_kernel_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+// rows are handed to the workers in chunks of at least kParallelGrainElemCnt elements
+constexpr int64_t kParallelGrainElemCnt = 32 * 1024;
+// a row is processed as kLaneNum interleaved lanes, each with its own accumulators, so that the
+// loops vectorize without reassociating floating point sums
+constexpr int64_t kLaneNum = 8;
+
+void ParallelForRows(int64_t row_num, int64_t row_size,
+                     const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const int64_t grain_size =
+      std::max<int64_t>(kParallelGrainElemCnt / std::max<int64_t>(row_size, 1), 1);
+  if (thread_pool == nullptr || row_num <= grain_size) {
+    Handler(0, row_num);
+  } else {
+    thread_pool->ParallelFor(0, row_num, grain_size, Handler);
+  }
+}
+
+// the statistics of a row are gathered over blocks of kMomentsBlockSize elements, which stay in
+// cache while they are read twice
+constexpr int64_t kMomentsBlockSize = 256;
+
+template<typename T>
+T LaneSum(const T* x, int64_t n) {
+  T lane_sum[kLaneNum] = {0};
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    FOR_RANGE(int64_t, l, 0, kLaneNum) { lane_sum[l] += x[i * kLaneNum + l]; }
+  }
+  T sum = 0;
+  FOR_RANGE(int64_t, l, 0, kLaneNum) { sum += lane_sum[l]; }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) { sum += x[i]; }
+  return sum;
+}
+
+template<typename T>
+T LaneSquaredDeviationSum(const T* x, int64_t n, T mean) {
+  T lane_sum[kLaneNum] = {0};
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    FOR_RANGE(int64_t, l, 0, kLaneNum) {
+      const T deviation = x[i * kLaneNum + l] - mean;
+      lane_sum[l] += deviation * deviation;
+    }
+  }
+  T sum = 0;
+  FOR_RANGE(int64_t, l, 0, kLaneNum) { sum += lane_sum[l]; }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) { sum += (x[i] - mean) * (x[i] - mean); }
+  return sum;
+}
+
+// The mean and the population variance of x[0, n). The mean and the squared deviations of every
+// block are computed exactly and merged into those of the row by Welford's update for batches
+// (Chan et al.), which keeps the accuracy of Welford's algorithm while the loops vectorize.
+template<typename T>
+void RowMoments(const T* x, int64_t n, T* mean, T* variance) {
+  T count = 0;
+  T row_mean = 0;
+  T row_m2 = 0;
+  for (int64_t begin = 0; begin < n; begin += kMomentsBlockSize) {
+    const int64_t block_size = std::min(kMomentsBlockSize, n - begin);
+    const T block_count = static_cast<T>(block_size);
+    const T block_mean = LaneSum(x + begin, block_size) / block_count;
+    const T block_m2 = LaneSquaredDeviationSum(x + begin, block_size, block_mean);
+    const T new_count = count + block_count;
+    const T delta = block_mean - row_mean;
+    row_mean += delta * block_count / new_count;
+    row_m2 += block_m2 + delta * delta * count * block_count / new_count;
+    count = new_count;
+  }
+  *mean = row_mean;
+  *variance = row_m2 / count;
+}
+
+// sum(dy) and sum(dy * x_hat) of a row, x_hat = (x - mean) * inv_variance
+template<typename T>
+void RowGradSums(const T* dy, const T* x, int64_t n, T mean, T inv_variance, T* sum_dy,
+                 T* sum_dy_x_hat) {
+  T lane_sum_dy[kLaneNum] = {0};
+  T lane_sum_dy_x_hat[kLaneNum] = {0};
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    const T* dy_step = dy + i * kLaneNum;
+    const T* x_step = x + i * kLaneNum;
+    FOR_RANGE(int64_t, l, 0, kLaneNum) {
+      lane_sum_dy[l] += dy_step[l];
+      lane_sum_dy_x_hat[l] += dy_step[l] * (x_step[l] - mean) * inv_variance;
+    }
+  }
+  *sum_dy = 0;
+  *sum_dy_x_hat = 0;
+  FOR_RANGE(int64_t, l, 0, kLaneNum) {
+    *sum_dy += lane_sum_dy[l];
+    *sum_dy_x_hat += lane_sum_dy_x_hat[l];
+  }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) {
+    *sum_dy += dy[i];
+    *sum_dy_x_hat += dy[i] * (x[i] - mean) * inv_variance;
+  }
+}
+
+template<typename T, bool do_scale, bool do_center>
+void NormalizeRow(const T* x, int64_t n, T mean, T inv_variance, const T* gamma, const T* beta,
+                  T* normalized, T* y) {
+  FOR_RANGE(int64_t, i, 0, n) {
+    T v = (x[i] - mean) * inv_variance;
+    if (do_scale) {
+      normalized[i] = v;
+      v *= gamma[i];
+    }
+    if (do_center) { v += beta[i]; }
+    y[i] = v;
+  }
+}
+
+template<typename T>
+void NormalizeRow(const T* x, int64_t n, T mean, T inv_variance, const T* gamma, const T* beta,
+                  T* normalized, T* y) {
+  if (gamma != nullptr && beta != nullptr) {
+    NormalizeRow<T, true, true>(x, n, mean, inv_variance, gamma, beta, normalized, y);
+  } else if (gamma != nullptr) {
+    NormalizeRow<T, true, false>(x, n, mean, inv_variance, gamma, beta, normalized, y);
+  } else if (beta != nullptr) {
+    NormalizeRow<T, false, true>(x, n, mean, inv_variance, gamma, beta, normalized, y);
+  } else {
+    NormalizeRow<T, false, false>(x, n, mean, inv_variance, gamma, beta, normalized, y);
+  }
+}
+
+// Sums rows [begin, end) of dy into beta_sum and of dy * normalized into gamma_sum, and writes the
+// rows of normalized_diff, for the outputs which are not nullptr
+template<typename T>
+void ParamGradRows(int64_t begin, int64_t end, int64_t m, const T* dy, const T* normalized,
+                   const T* gamma, T* gamma_sum, T* beta_sum, T* normalized_diff) {
+  if (gamma_sum != nullptr) { std::fill(gamma_sum, gamma_sum + m, static_cast<T>(0)); }
+  if (beta_sum != nullptr) { std::fill(beta_sum, beta_sum + m, static_cast<T>(0)); }
+  FOR_RANGE(int64_t, i, begin, end) {
+    const T* dy_row = dy + i * m;
+    if (gamma_sum != nullptr) {
+      const T* normalized_row = normalized + i * m;
+      FOR_RANGE(int64_t, j, 0, m) { gamma_sum[j] += dy_row[j] * normalized_row[j]; }
+    }
+    if (beta_sum != nullptr) {
+      FOR_RANGE(int64_t, j, 0, m) { beta_sum[j] += dy_row[j]; }
+    }
+    if (normalized_diff != nullptr) {
+      T* normalized_diff_row = normalized_diff + i * m;
+      if (gamma != nullptr) {
+        FOR_RANGE(int64_t, j, 0, m) { normalized_diff_row[j] = dy_row[j] * gamma[j]; }
+      } else {
+        std::copy(dy_row, dy_row + m, normalized_diff_row);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template<typename T>
+void LayerNormCpuKernelUtil<T>::Forward(const int64_t num_instances, const int64_t norm_size,
+                                        const double epsilon, const T* x, const T* gamma,
+                                        const T* beta, const int64_t param_size, T* mean,
+                                        T* inv_variance, T* normalized, T* y) {
+  CHECK_GT(norm_size, 0);
+  if (gamma != nullptr || beta != nullptr) { CHECK_GT(param_size, 0); }
+  ParallelForRows(num_instances, norm_size, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const int64_t offset = i * norm_size;
+      T row_mean = 0;
+      T row_variance = 0;
+      RowMoments(x + offset, norm_size, &row_mean, &row_variance);
+      const T row_inv_variance =
+          static_cast<T>(1) / std::sqrt(row_variance + static_cast<T>(epsilon));
+      mean[i] = row_mean;
+      inv_variance[i] = row_inv_variance;
+      if (gamma == nullptr && beta == nullptr) {
+        NormalizeRow<T>(x + offset, norm_size, row_mean, row_inv_variance, nullptr, nullptr,
+                        nullptr, y + offset);
+        continue;
+      }
+      // the params need not start at the row, so the row goes in segments of contiguous params
+      int64_t param_offset = offset % param_size;
+      int64_t col = 0;
+      while (col < norm_size) {
+        const int64_t segment_size = std::min(norm_size - col, param_size - param_offset);
+        NormalizeRow<T>(x + offset + col, segment_size, row_mean, row_inv_variance,
+                        gamma == nullptr ? nullptr : gamma + param_offset,
+                        beta == nullptr ? nullptr : beta + param_offset,
+                        normalized + offset + col, y + offset + col);
+        col += segment_size;
+        param_offset = 0;
+      }
+    }
+  });
+}
+
+template<typename T>
+void LayerNormCpuKernelUtil<T>::Backward(const int64_t num_instances, const int64_t norm_size,
+                                         const T* dy, const T* x, const T* mean,
+                                         const T* inv_variance, const T* add_to_output, T* dx) {
+  CHECK_GT(norm_size, 0);
+  const T inv_norm_size = static_cast<T>(1) / static_cast<T>(norm_size);
+  ParallelForRows(num_instances, norm_size, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const int64_t offset = i * norm_size;
+      const T* dy_row = dy + offset;
+      const T* x_row = x + offset;
+      T* dx_row = dx + offset;
+      const T row_mean = mean[i];
+      const T row_inv_variance = inv_variance[i];
+      T sum_dy = 0;
+      T sum_dy_x_hat = 0;
+      RowGradSums(dy_row, x_row, norm_size, row_mean, row_inv_variance, &sum_dy, &sum_dy_x_hat);
+      const T mean_dy = sum_dy * inv_norm_size;
+      const T mean_dy_x_hat = sum_dy_x_hat * inv_norm_size;
+      // dx = inv_variance * (dy - mean(dy) - x_hat * mean(dy * x_hat))
+      if (add_to_output == nullptr) {
+        FOR_RANGE(int64_t, j, 0, norm_size) {
+          const T x_hat = (x_row[j] - row_mean) * row_inv_variance;
+          dx_row[j] = (dy_row[j] - mean_dy - x_hat * mean_dy_x_hat) * row_inv_variance;
+        }
+      } else {
+        const T* add_to_output_row = add_to_output + offset;
+        FOR_RANGE(int64_t, j, 0, norm_size) {
+          const T x_hat = (x_row[j] - row_mean) * row_inv_variance;
+          dx_row[j] = add_to_output_row[j]
+                      + (dy_row[j] - mean_dy - x_hat * mean_dy_x_hat) * row_inv_variance;
+        }
+      }
+    }
+  });
+}
+
+template<typename T>
+void LayerNormCpuKernelUtil<T>::ParamBackward(const int64_t n, const int64_t m, const T* dy,
+                                              const T* normalized, const T* gamma, T* gamma_diff,
+                                              T* beta_diff, T* normalized_diff, T* reduce_buf) {
+  if (gamma_diff == nullptr && beta_diff == nullptr) {
+    ParallelForRows(n, m, [&](int64_t begin, int64_t end) {
+      ParamGradRows<T>(begin, end, m, dy, normalized, gamma, nullptr, nullptr, normalized_diff);
+    });
+    return;
+  }
+  // the rows are split into blocks, summed into rows of reduce_buf by the threads and then summed
+  // up, 2 * block_num rows of reduce_buf being used
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  int64_t block_num = 1;
+  if (thread_pool != nullptr && reduce_buf != nullptr) {
+    block_num =
+        std::min<int64_t>({thread_pool->thread_num(), n / 2, n * m / kParallelGrainElemCnt});
+  }
+  if (block_num <= 1) {
+    ParamGradRows<T>(0, n, m, dy, normalized, gamma, gamma_diff, beta_diff, normalized_diff);
+    return;
+  }
+  T* gamma_sums = reduce_buf;
+  T* beta_sums = reduce_buf + block_num * m;
+  thread_pool->ParallelFor(0, block_num, 1, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, b, begin, end) {
+      ParamGradRows<T>(b * n / block_num, (b + 1) * n / block_num, m, dy, normalized, gamma,
+                       gamma_diff == nullptr ? nullptr : gamma_sums + b * m,
+                       beta_diff == nullptr ? nullptr : beta_sums + b * m, normalized_diff);
+    }
+  });
+  auto SumBlocks = [&](const T* sums, T* out) {
+    std::copy(sums, sums + m, out);
+    FOR_RANGE(int64_t, b, 1, block_num) {
+      const T* block_sum = sums + b * m;
+      FOR_RANGE(int64_t, j, 0, m) { out[j] += block_sum[j]; }
+    }
+  };
+  if (gamma_diff != nullptr) { SumBlocks(gamma_sums, gamma_diff); }
+  if (beta_diff != nullptr) { SumBlocks(beta_sums, beta_diff); }
+}
+
+template struct LayerNormCpuKernelUtil<float>;
+template struct LayerNormCpuKernelUtil<double>;
+
+}  // namespace oneflow
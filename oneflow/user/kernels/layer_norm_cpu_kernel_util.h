@@ -0,0 +1,46 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Layer norm on CPU over num_instances rows of norm_size elements. Every row is handled in one
+// pass over its elements for the statistics and one more while the row is still in cache, and the
+// rows are spread over the compute thread pool.
+template<typename T>
+struct LayerNormCpuKernelUtil final {
+  // gamma and beta, either of which may be nullptr, repeat every param_size elements of x.
+  // normalized is only written if gamma is not nullptr
+  static void Forward(int64_t num_instances, int64_t norm_size, double epsilon, const T* x,
+                      const T* gamma, const T* beta, int64_t param_size, T* mean,
+                      T* inv_variance, T* normalized, T* y);
+  // dx = add_to_output + the gradient of normalized, add_to_output may be nullptr or dx
+  static void Backward(int64_t num_instances, int64_t norm_size, const T* dy, const T* x,
+                       const T* mean, const T* inv_variance, const T* add_to_output, T* dx);
+  // Over n rows of m elements, beta_diff = sum(dy), gamma_diff = sum(dy * normalized) and
+  // normalized_diff = dy * gamma, any of the outputs being nullptr if not wanted. reduce_buf of
+  // n * m elements holds the partial sums of the threads
+  static void ParamBackward(int64_t n, int64_t m, const T* dy, const T* normalized,
+                            const T* gamma, T* gamma_diff, T* beta_diff, T* normalized_diff,
+                            T* reduce_buf);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_LAYER_NORM_CPU_KERNEL_UTIL_H_
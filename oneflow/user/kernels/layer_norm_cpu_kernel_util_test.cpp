@@ -0,0 +1,171 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/layer_norm_cpu_kernel_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+constexpr double kEpsilon = 1e-5;
+
+template<typename T>
+void ExpectNear(const std::vector<T>& actual, const std::vector<double>& expected,
+                double tolerance, const std::string& name) {
+  ASSERT_EQ(actual.size(), expected.size());
+  FOR_RANGE(size_t, i, 0, actual.size()) {
+    ASSERT_LE(std::abs(actual.at(i) - expected.at(i)), tolerance * (1 + std::abs(expected.at(i))))
+        << name << " at " << i << ": " << actual.at(i) << " vs " << expected.at(i);
+  }
+}
+
+// Checks the layer norm of n rows of m elements, gamma and beta repeating every param_size
+// elements, against a naive one in double, on a thread pool if thread_num > 0. x is offset from
+// zero, which a one pass variance would suffer from.
+template<typename T>
+void TestLayerNorm(int64_t n, int64_t m, int64_t param_size, bool has_gamma, bool has_beta,
+                   int32_t thread_num, double tolerance) {
+  if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+  const int64_t elem_cnt = n * m;
+  std::mt19937 gen(elem_cnt + param_size);
+  std::normal_distribution<double> dis(0, 1);
+  auto RandVec = [&](int64_t size, double offset) {
+    std::vector<T> ret(size);
+    for (T& val : ret) { val = static_cast<T>(offset + dis(gen)); }
+    return ret;
+  };
+  const std::vector<T> x = RandVec(elem_cnt, 100);
+  const std::vector<T> dy = RandVec(elem_cnt, 0);
+  const std::vector<T> add_to_output = RandVec(elem_cnt, 0);
+  const std::vector<T> gamma = RandVec(param_size, 1);
+  const std::vector<T> beta = RandVec(param_size, 0);
+
+  // the naive layer norm in double
+  std::vector<double> expected_mean(n), expected_inv_variance(n), expected_normalized(elem_cnt),
+      expected_y(elem_cnt), expected_dx(elem_cnt);
+  FOR_RANGE(int64_t, i, 0, n) {
+    double sum = 0;
+    FOR_RANGE(int64_t, j, 0, m) { sum += x.at(i * m + j); }
+    const double mean = sum / m;
+    double squared_deviation_sum = 0;
+    FOR_RANGE(int64_t, j, 0, m) {
+      squared_deviation_sum += (x.at(i * m + j) - mean) * (x.at(i * m + j) - mean);
+    }
+    const double inv_variance = 1 / std::sqrt(squared_deviation_sum / m + kEpsilon);
+    expected_mean.at(i) = mean;
+    expected_inv_variance.at(i) = inv_variance;
+    double sum_dy = 0;
+    double sum_dy_normalized = 0;
+    FOR_RANGE(int64_t, j, 0, m) {
+      const int64_t k = i * m + j;
+      const double normalized = (x.at(k) - mean) * inv_variance;
+      expected_normalized.at(k) = normalized;
+      expected_y.at(k) = normalized * (has_gamma ? gamma.at(k % param_size) : 1)
+                         + (has_beta ? beta.at(k % param_size) : 0);
+      sum_dy += dy.at(k);
+      sum_dy_normalized += dy.at(k) * normalized;
+    }
+    FOR_RANGE(int64_t, j, 0, m) {
+      const int64_t k = i * m + j;
+      const double normalized_dy_diff =
+          dy.at(k) - sum_dy / m - expected_normalized.at(k) * sum_dy_normalized / m;
+      expected_dx.at(k) = add_to_output.at(k) + normalized_dy_diff * inv_variance;
+    }
+  }
+
+  std::vector<T> mean(n), inv_variance(n), normalized(elem_cnt), y(elem_cnt), dx(elem_cnt);
+  LayerNormCpuKernelUtil<T>::Forward(n, m, kEpsilon, x.data(),
+                                     has_gamma ? gamma.data() : nullptr,
+                                     has_beta ? beta.data() : nullptr, param_size, mean.data(),
+                                     inv_variance.data(), normalized.data(), y.data());
+  ExpectNear(mean, expected_mean, tolerance, "mean");
+  ExpectNear(inv_variance, expected_inv_variance, tolerance, "inv_variance");
+  if (has_gamma) { ExpectNear(normalized, expected_normalized, tolerance, "normalized"); }
+  ExpectNear(y, expected_y, tolerance, "y");
+  LayerNormCpuKernelUtil<T>::Backward(n, m, dy.data(), x.data(), mean.data(),
+                                      inv_variance.data(), add_to_output.data(), dx.data());
+  ExpectNear(dx, expected_dx, tolerance, "dx");
+  if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+}
+
+// Checks the param grads of n rows of m elements against naive sums in double
+template<typename T>
+void TestLayerNormParamBackward(int64_t n, int64_t m, int32_t thread_num, double tolerance) {
+  if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+  std::mt19937 gen(n * m);
+  std::normal_distribution<T> dis(0, 1);
+  std::vector<T> dy(n * m), normalized(n * m), gamma(m);
+  for (T& val : dy) { val = dis(gen); }
+  for (T& val : normalized) { val = dis(gen); }
+  for (T& val : gamma) { val = dis(gen); }
+  std::vector<double> expected_gamma_diff(m, 0), expected_beta_diff(m, 0),
+      expected_normalized_diff(n * m);
+  FOR_RANGE(int64_t, i, 0, n) {
+    FOR_RANGE(int64_t, j, 0, m) {
+      const int64_t k = i * m + j;
+      expected_gamma_diff.at(j) += static_cast<double>(dy.at(k)) * normalized.at(k);
+      expected_beta_diff.at(j) += dy.at(k);
+      expected_normalized_diff.at(k) = static_cast<double>(dy.at(k)) * gamma.at(j);
+    }
+  }
+  std::vector<T> gamma_diff(m), beta_diff(m), normalized_diff(n * m), reduce_buf(n * m);
+  LayerNormCpuKernelUtil<T>::ParamBackward(n, m, dy.data(), normalized.data(), gamma.data(),
+                                           gamma_diff.data(), beta_diff.data(),
+                                           normalized_diff.data(), reduce_buf.data());
+  // a sum of n products of standard normal values is in the order of sqrt(n)
+  const double sum_tolerance = tolerance * std::sqrt(static_cast<double>(n));
+  ExpectNear(gamma_diff, expected_gamma_diff, sum_tolerance, "gamma_diff");
+  ExpectNear(beta_diff, expected_beta_diff, sum_tolerance, "beta_diff");
+  ExpectNear(normalized_diff, expected_normalized_diff, tolerance, "normalized_diff");
+  if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+}
+
+template<typename T>
+void TestLayerNormOfAllSizes(int32_t thread_num, double tolerance) {
+  // norm sizes below, around and not a multiple of the 8 lanes and the 256 element blocks of the
+  // statistics, and enough rows of the larger ones to be split over the threads
+  for (int64_t m : {1, 7, 8, 33, 255, 257, 1000}) {
+    for (int64_t n : {1, 5, 67}) {
+      TestLayerNorm<T>(n, m, m, true, true, thread_num, tolerance);
+      TestLayerNormParamBackward<T>(n, m, thread_num, tolerance);
+    }
+    TestLayerNorm<T>(5, m, m, true, false, thread_num, tolerance);
+    TestLayerNorm<T>(5, m, m, false, true, thread_num, tolerance);
+    TestLayerNorm<T>(5, m, m, false, false, thread_num, tolerance);
+  }
+  // params spanning several rows, and starting within a row
+  TestLayerNorm<T>(6, 7, 21, true, true, thread_num, tolerance);
+  TestLayerNorm<T>(6, 10, 15, true, true, thread_num, tolerance);
+}
+
+}  // namespace
+
+TEST(LayerNormCpuKernelUtil, float) {
+  TestLayerNormOfAllSizes<float>(0, 1e-4);
+  TestLayerNormOfAllSizes<float>(4, 1e-4);
+}
+
+TEST(LayerNormCpuKernelUtil, double) {
+  TestLayerNormOfAllSizes<double>(0, 1e-10);
+  TestLayerNormOfAllSizes<double>(4, 1e-10);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
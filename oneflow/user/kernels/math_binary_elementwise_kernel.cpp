@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/math_binary_elementwise_func.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
@@ -32,9 +33,11 @@ class MathBinaryElementwiseCpuKernel final : public user_op::OpKernel {
     const T* x = tensor_x->dptr<T>();
     const T* y = tensor_y->dptr<T>();
     T* z = tensor_z->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { z[i] = BinaryFunctor<T>::Forward(x[i], y[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    auto Forward = [](const T x_val, const T y_val) {
+      return BinaryFunctor<T>::Forward(x_val, y_val);
+    };
+    CpuElementwiseApply(n, Forward, z, x, y);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -56,9 +59,11 @@ class MathBinaryElementwiseXGradCpuKernel final : public user_op::OpKernel {
     const T* y = tensor_y->dptr<T>();
     const T* dz = tensor_dz->dptr<T>();
     T* dx = tensor_dx->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dx[i] = BinaryFunctor<T>::BackwardXGrad(x[i], y[i], dz[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    auto BackwardXGrad = [](const T x_val, const T y_val, const T dz_val) {
+      return BinaryFunctor<T>::BackwardXGrad(x_val, y_val, dz_val);
+    };
+    CpuElementwiseApply(n, BackwardXGrad, dx, x, y, dz);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -80,9 +85,11 @@ class MathBinaryElementwiseYGradCpuKernel final : public user_op::OpKernel {
     const T* y = tensor_y->dptr<T>();
     const T* dz = tensor_dz->dptr<T>();
     T* dy = tensor_dy->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dy[i] = BinaryFunctor<T>::BackwardYGrad(x[i], y[i], dz[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    auto BackwardYGrad = [](const T x_val, const T y_val, const T dz_val) {
+      return BinaryFunctor<T>::BackwardYGrad(x_val, y_val, dz_val);
+    };
+    CpuElementwiseApply(n, BackwardYGrad, dy, x, y, dz);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/math_unary_elementwise_func.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
@@ -30,9 +31,9 @@ class MathUnaryElementwiseCpuKernel final : public user_op::OpKernel {
     user_op::Tensor* tensor_y = ctx->Tensor4ArgNameAndIndex("y", 0);
     const T* x = tensor_x->dptr<T>();
     T* y = tensor_y->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { y[i] = UnaryFunctor<T>::Forward(x[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    auto Forward = [](const T x_val) { return UnaryFunctor<T>::Forward(x_val); };
+    CpuElementwiseApply(n, Forward, y, x);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
@@ -52,9 +53,11 @@ class MathUnaryElementwiseGradCpuKernel final : public user_op::OpKernel {
     const T* x = tensor_x->dptr<T>();
     const T* dy = tensor_dy->dptr<T>();
     T* dx = tensor_dx->mut_dptr<T>();
-    int64_t n = tensor_x->shape().elem_cnt();
-    CHECK_LE(n, GetMaxVal<int32_t>() / 2);
-    for (int32_t i = 0; i < n; ++i) { dx[i] = UnaryFunctor<T>::Backward(x[i], dy[i]); }
+    const int64_t n = tensor_x->shape().elem_cnt();
+    auto Backward = [](const T x_val, const T dy_val) {
+      return UnaryFunctor<T>::Backward(x_val, dy_val);
+    };
+    CpuElementwiseApply(n, Backward, dx, x, dy);
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
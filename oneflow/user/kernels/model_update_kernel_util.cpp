@@ -15,9 +15,41 @@ limitations under the License.
 */
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/core/kernel/cpu_elementwise.h"
 
 namespace oneflow {
 
+namespace {
+
+// Calls Handler(value_offset, model_offset, begin, end) on the columns [begin, end) of the rows of
+// the indexed slices whose instances are in [lower_bound, upper_bound), the row starting at
+// value_offset in the values and its instance at model_offset in the model. The indices are
+// unique, so the rows update disjoint parts of the model and are split across the thread pool
+template<typename K, typename Handler>
+void ForEachIndexedSlicesRow(int64_t num_rows, int64_t feature_size, int64_t lower_bound,
+                             int64_t upper_bound, const K* indices, const Handler& handler) {
+  CpuElementwiseParallelFor(num_rows * feature_size, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin / feature_size; row * feature_size < end; ++row) {
+      const int64_t instance_id = indices[row];
+      if (instance_id < lower_bound || instance_id >= upper_bound) { continue; }
+      const int64_t value_offset = row * feature_size;
+      handler(value_offset, (instance_id - lower_bound) * feature_size,
+              std::max(begin - value_offset, int64_t(0)),
+              std::min(end - value_offset, feature_size));
+    }
+  });
+}
+
+template<typename Param>
+std::vector<int64_t> MultiTensorSizes(const std::vector<Param>& params) {
+  std::vector<int64_t> sizes;
+  sizes.reserve(params.size());
+  for (const Param& param : params) { sizes.push_back(param.n); }
+  return sizes;
+}
+
+}  // namespace
+
 template<typename T, typename G>
 struct SGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
   static void Update(DeviceCtx* ctx, int64_t n, T scale, float l1, float l2, float weight_decay,
@@ -35,9 +67,9 @@ void SGDUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(DeviceCtx* ctx, int64_t
   if (skip_if != nullptr && *skip_if != 0) { return; }
   const T lr = *learning_rate;
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  for (int64_t i = 0; i != n; ++i) {
+  CpuElementwiseForEach(n, [=](int64_t i) {
     SGDUpdateFunctor<T, G>()(model_diff + i, model + i, scale, l1, l2, weight_decay, lr);
-  }
+  });
 }
 
 template struct SGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -55,18 +87,17 @@ void IndexedSlicesSGDUpdateKernelUtil<DeviceType::kCPU, T, K, IDX>::Update(
     DeviceCtx* ctx, float weight_decay, int64_t num_indices, int64_t feature_size,
     int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
     const float* learning_rate, const K* indices, const T* values, T* model) {
-  const int64_t n = *num_unique_instance * feature_size;
   const T lr = *learning_rate;
-  FOR_RANGE(int64_t, i, 0, n) {
-    const IDX indices_idx = i / feature_size;
-    const IDX inner_idx = i - indices_idx * feature_size;
-    const IDX instance_id = indices[indices_idx];
-    if (instance_id >= lower_bound && instance_id < upper_bound) {
-      const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-      SGDUpdateFunctor<T, T>()(values + i, model + model_idx, static_cast<T>(1), 0.0, 0.0,
-                               weight_decay, lr);
-    }
-  }
+  ForEachIndexedSlicesRow(
+      *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+      [=](int64_t value_offset, int64_t model_offset, int64_t begin, int64_t end) {
+        const T* row_values = values + value_offset;
+        T* row_model = model + model_offset;
+        CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+          SGDUpdateFunctor<T, T>()(row_values + i, row_model + i, static_cast<T>(1), 0.0, 0.0,
+                                   weight_decay, lr);
+        });
+      });
 }
 
 #define INITIATE_INDEXED_SLICES_SGD_UPDATE_KERNEL_UTIL_CPU(val_type_pair, key_type_pair,  \
@@ -93,10 +124,10 @@ void MomentumUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (skip_if != nullptr && *skip_if != 0) { return; }
   const T lr = *learning_rate;
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  for (int64_t i = 0; i != n; ++i) {
+  CpuElementwiseForEach(n, [=](int64_t i) {
     MomentumUpdateFunctor<T, G>()(model_diff + i, model + i, momentum + i, scale, l1, l2, beta,
                                   weight_decay, lr);
-  }
+  });
 }
 
 template struct MomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -115,18 +146,18 @@ void IndexedSlicesMomentumMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX>::Updat
     DeviceCtx* ctx, T beta, float weight_decay, int64_t num_instance, int64_t feature_size,
     int64_t lower_bound, int64_t upper_bound, const IDX* num_unique_instance,
     const float* learning_rate, const K* indices, const T* values, T* model, T* momentum) {
-  const int64_t n = *num_unique_instance * feature_size;
   const T lr = *learning_rate;
-  for (int64_t i = 0; i != n; ++i) {
-    const IDX indices_idx = i / feature_size;
-    const IDX inner_idx = i - indices_idx * feature_size;
-    const IDX instance_id = indices[indices_idx];
-    if (instance_id >= lower_bound && instance_id < upper_bound) {
-      const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-      MomentumUpdateFunctor<T, T>()(values + i, model + model_idx, momentum + model_idx, 1.0, 0.0,
-                                    0.0, beta, weight_decay, lr);
-    }
-  }
+  ForEachIndexedSlicesRow(
+      *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+      [=](int64_t value_offset, int64_t model_offset, int64_t begin, int64_t end) {
+        const T* row_values = values + value_offset;
+        T* row_model = model + model_offset;
+        T* row_momentum = momentum + model_offset;
+        CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+          MomentumUpdateFunctor<T, T>()(row_values + i, row_model + i, row_momentum + i, 1.0, 0.0,
+                                        0.0, beta, weight_decay, lr);
+        });
+      });
 }
 
 #define INSTANTIATE_INDEXED_SLICES_MOMENTUM_MODEL_UPDATE_KERNEL_UTIL_CPU(                 \
@@ -154,10 +185,10 @@ void AdamUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (skip_if != nullptr && *skip_if != 0) { return; }
   const float lr = *learning_rate;
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  FOR_RANGE(int64_t, i, 0, n) {
+  CpuElementwiseForEach(n, [=](int64_t i) {
     AdamUpdateFunctor<T, G>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1, beta2,
                               epsilon, weight_decay, lr);
-  }
+  });
 }
 
 template struct AdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -171,17 +202,18 @@ struct IndexedSlicesAdamMdUpdateKernelUtil<DeviceType::kCPU, T, K, IDX> {
                      const float* learning_rate, const K* indices, const T* values, T* model, T* m,
                      T* v) {
     const float lr = *learning_rate;
-    const int64_t n = *num_unique_instance * feature_size;
-    FOR_RANGE(int64_t, i, 0, n) {
-      const IDX indices_idx = i / feature_size;
-      const IDX inner_idx = i - indices_idx * feature_size;
-      const IDX instance_id = indices[indices_idx];
-      if (instance_id >= lower_bound && instance_id < upper_bound) {
-        const IDX model_idx = (instance_id - lower_bound) * feature_size + inner_idx;
-        AdamUpdateFunctor<T, T>()(values + i, model + model_idx, m + model_idx, v + model_idx, 1, 0,
-                                  0, beta1, beta2, epsilon, weight_decay, lr);
-      }
-    }
+    ForEachIndexedSlicesRow(
+        *num_unique_instance, feature_size, lower_bound, upper_bound, indices,
+        [=](int64_t value_offset, int64_t model_offset, int64_t begin, int64_t end) {
+          const T* row_values = values + value_offset;
+          T* row_model = model + model_offset;
+          T* row_m = m + model_offset;
+          T* row_v = v + model_offset;
+          CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+            AdamUpdateFunctor<T, T>()(row_values + i, row_model + i, row_m + i, row_v + i, 1, 0, 0,
+                                      beta1, beta2, epsilon, weight_decay, lr);
+          });
+        });
   }
 };
 
@@ -212,19 +244,21 @@ void LambUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   *beta1_t *= beta1;
   *beta2_t *= beta2;
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
-  FOR_RANGE(int64_t, i, 0, n) {
-    LambGradFunctor<T, G>()(beta1_t, beta2_t, model_diff + i, adam_diff + i, model + i, m + i,
-                            v + i, scale, l1, l2, beta1, beta2, epsilon);
-  }
+  // the bias corrections are read from copies, which the loop does not write
+  const T beta1_t_val = *beta1_t;
+  const T beta2_t_val = *beta2_t;
+  CpuElementwiseForEach(n, [=](int64_t i) {
+    LambGradFunctor<T, G>()(&beta1_t_val, &beta2_t_val, model_diff + i, adam_diff + i, model + i,
+                            m + i, v + i, scale, l1, l2, beta1, beta2, epsilon);
+  });
   T* w_norm = norm_buffer;
   T* g_norm = norm_buffer + 1;
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model, 1, model, 1, w_norm);
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, adam_diff, 1, adam_diff, 1, g_norm);
   KernelUtil<DeviceType::kCPU, T>::Sqrt(ctx, 2, norm_buffer, norm_buffer);
   const float lr = LambLRFunctor<T>()(*learning_rate, w_norm, g_norm);
-  FOR_RANGE(int64_t, i, 0, n) {
-    LambUpdateFunctor<T>()(lr, weight_decay, adam_diff + i, model + i);
-  }
+  CpuElementwiseForEach(
+      n, [=](int64_t i) { LambUpdateFunctor<T>()(lr, weight_decay, adam_diff + i, model + i); });
 }
 
 template struct LambUpdateKernelUtil<DeviceType::kCPU, float, float>;
@@ -261,18 +295,19 @@ void RmsPropUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
     const int64_t* skip_if, const G* model_diff, T* model, T* mean_square, T* mean_gradient) {
   if (skip_if != nullptr && *skip_if != 0) { return; }
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  const float lr = *learning_rate;
   if (centered) {
-    FOR_RANGE(int64_t, i, 0, n) {
+    CpuElementwiseForEach(n, [=](int64_t i) {
       RmsPropUpdateFunctor<T, G, true>()(model_diff + i, model + i, n, scale, l1, l2,
                                          mean_square + i, mean_gradient + i, epsilon, weight_decay,
-                                         decay_rate, *learning_rate);
-    }
+                                         decay_rate, lr);
+    });
   } else {
-    FOR_RANGE(int64_t, i, 0, n) {
+    CpuElementwiseForEach(n, [=](int64_t i) {
       RmsPropUpdateFunctor<T, G, false>()(model_diff + i, model + i, n, scale, l1, l2,
                                           mean_square + i, nullptr, epsilon, weight_decay,
-                                          decay_rate, *learning_rate);
-    }
+                                          decay_rate, lr);
+    });
   }
 }
 
@@ -298,10 +333,10 @@ void LarsUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
   if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
   T model_norm = data_tmp[0];
   T model_diff_norm = data_tmp[1];
-  FOR_RANGE(int64_t, i, 0, n) {
+  CpuElementwiseForEach(n, [=](int64_t i) {
     model_diff_tmp[i] =
         CastScaleRegularizeGradientFunctor<T, G>()(model_diff[i], model[i], scale, l1, l2);
-  }
+  });
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model, 1, model, 1, &model_norm);
   KernelUtil<DeviceType::kCPU, T>::Dot(ctx, n, model_diff_tmp, 1, model_diff_tmp, 1,
                                        &model_diff_norm);
@@ -317,13 +352,117 @@ void LarsUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
                           / (epsilon + model_diff_norm + weight_decay * model_norm);
   }
 
-  FOR_RANGE(int64_t, i, 0, n) {
+  CpuElementwiseForEach(n, [=](int64_t i) {
     LarsUpdateFunctor<T>()(model_diff_tmp + i, model + i, momentum_beta, momentum + i, weight_decay,
                            local_learning_rate);
-  }
+  });
 }
 
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, float, float>;
 template struct LarsUpdateKernelUtil<DeviceType::kCPU, double, double>;
 
+void ForEachMultiTensorRange(
+    const std::vector<int64_t>& sizes,
+    const std::function<void(int64_t tensor_id, int64_t begin, int64_t end)>& Handler) {
+  std::vector<int64_t> offsets(sizes.size() + 1, 0);
+  FOR_RANGE(size_t, i, 0, sizes.size()) { offsets.at(i + 1) = offsets.at(i) + sizes.at(i); }
+  CpuElementwiseParallelFor(offsets.back(), [&](int64_t begin, int64_t end) {
+    size_t i = std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin() - 1;
+    for (; i < sizes.size() && offsets.at(i) < end; ++i) {
+      const int64_t range_begin = std::max(begin, offsets.at(i)) - offsets.at(i);
+      const int64_t range_end = std::min(end, offsets.at(i + 1)) - offsets.at(i);
+      if (range_begin < range_end) { Handler(i, range_begin, range_end); }
+    }
+  });
+}
+
+template<typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<SGDUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float weight_decay, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<SGDUpdateParam<T, G>>& params, T scale, float l1, float l2,
+    float weight_decay, const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  const T lr = *learning_rate;
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  const std::vector<int64_t> sizes = MultiTensorSizes(params);
+  ForEachMultiTensorRange(sizes, [&](int64_t tensor_id, int64_t begin, int64_t end) {
+    const G* model_diff = params.at(tensor_id).model_diff;
+    T* model = params.at(tensor_id).model;
+    CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+      SGDUpdateFunctor<T, G>()(model_diff + i, model + i, scale, l1, l2, weight_decay, lr);
+    });
+  });
+}
+
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorSGDUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<MomentumUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float beta, float weight_decay,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<MomentumUpdateParam<T, G>>& params, T scale, float l1,
+    float l2, float beta, float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+    const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  const T lr = *learning_rate;
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  const std::vector<int64_t> sizes = MultiTensorSizes(params);
+  ForEachMultiTensorRange(sizes, [&](int64_t tensor_id, int64_t begin, int64_t end) {
+    const G* model_diff = params.at(tensor_id).model_diff;
+    T* model = params.at(tensor_id).model;
+    T* momentum = params.at(tensor_id).momentum;
+    CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+      MomentumUpdateFunctor<T, G>()(model_diff + i, model + i, momentum + i, scale, l1, l2, beta,
+                                    weight_decay, lr);
+    });
+  });
+}
+
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorMomentumUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
+template<typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G> {
+  static void Update(DeviceCtx* ctx, const std::vector<AdamUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
+template<typename T, typename G>
+void MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, T, G>::Update(
+    DeviceCtx* ctx, const std::vector<AdamUpdateParam<T, G>>& params, T scale, float l1, float l2,
+    float beta1, float beta2, float epsilon, float weight_decay, const float* learning_rate,
+    const T* scale_by_ptr, const int64_t* skip_if) {
+  if (skip_if != nullptr && *skip_if != 0) { return; }
+  const float lr = *learning_rate;
+  if (scale_by_ptr != nullptr) { scale *= *scale_by_ptr; }
+  const std::vector<int64_t> sizes = MultiTensorSizes(params);
+  ForEachMultiTensorRange(sizes, [&](int64_t tensor_id, int64_t begin, int64_t end) {
+    const G* model_diff = params.at(tensor_id).model_diff;
+    T* model = params.at(tensor_id).model;
+    T* m = params.at(tensor_id).m;
+    T* v = params.at(tensor_id).v;
+    CpuElementwiseForEachRange(begin, end, [=](int64_t i) {
+      AdamUpdateFunctor<T, G>()(model_diff + i, model + i, m + i, v + i, scale, l1, l2, beta1,
+                                beta2, epsilon, weight_decay, lr);
+    });
+  });
+}
+
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, float, float>;
+template struct MultiTensorAdamUpdateKernelUtil<DeviceType::kCPU, double, double>;
+
 }  // namespace oneflow
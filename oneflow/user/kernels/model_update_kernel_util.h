@@ -234,6 +234,61 @@ struct LarsUpdateKernelUtil {
                      T* data_tmp, T* model_diff_tmp);
 };
 
+// Calls Handler(tensor_id, begin, end) on the ranges [begin, end) of the tensors of sizes which
+// make up the chunks of their concatenation, so that small tensors share a chunk of the compute
+// thread pool and big ones are split. Every element is in exactly one range
+void ForEachMultiTensorRange(
+    const std::vector<int64_t>& sizes,
+    const std::function<void(int64_t tensor_id, int64_t begin, int64_t end)>& Handler);
+
+// The tensors of one variable in a multi-tensor update, which updates many variables with the same
+// learning rate and attrs at once, on cpu only
+template<typename T, typename G>
+struct SGDUpdateParam {
+  int64_t n;
+  const G* model_diff;
+  T* model;
+};
+
+template<typename T, typename G>
+struct MomentumUpdateParam {
+  int64_t n;
+  const G* model_diff;
+  T* model;
+  T* momentum;
+};
+
+template<typename T, typename G>
+struct AdamUpdateParam {
+  int64_t n;
+  const G* model_diff;
+  T* model;
+  T* m;
+  T* v;
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorSGDUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<SGDUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float weight_decay, const float* learning_rate,
+                     const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorMomentumUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<MomentumUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float beta, float weight_decay,
+                     const float* learning_rate, const T* scale_by_ptr, const int64_t* skip_if);
+};
+
+template<DeviceType device_type, typename T, typename G>
+struct MultiTensorAdamUpdateKernelUtil {
+  static void Update(DeviceCtx* ctx, const std::vector<AdamUpdateParam<T, G>>& params, T scale,
+                     float l1, float l2, float beta1, float beta2, float epsilon,
+                     float weight_decay, const float* learning_rate, const T* scale_by_ptr,
+                     const int64_t* skip_if);
+};
+
 #endif
 
 }  // namespace oneflow
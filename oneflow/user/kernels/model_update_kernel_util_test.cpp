@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/model_update_kernel_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// Checks that the ranges are within their tensors and cover every element exactly once, on a
+// thread pool if thread_num > 0, and returns the number of ranges
+int64_t TestMultiTensorRanges(const std::vector<int64_t>& sizes, int32_t thread_num) {
+  if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+  std::vector<std::unique_ptr<std::atomic<int32_t>[]>> visit_cnts;
+  for (int64_t size : sizes) {
+    visit_cnts.emplace_back(new std::atomic<int32_t>[size]);
+    FOR_RANGE(int64_t, i, 0, size) { visit_cnts.back()[i] = 0; }
+  }
+  std::atomic<int64_t> range_num(0);
+  std::atomic<bool> is_out_of_bounds(false);
+  ForEachMultiTensorRange(sizes, [&](int64_t tensor_id, int64_t begin, int64_t end) {
+    range_num += 1;
+    if (tensor_id < 0 || tensor_id >= static_cast<int64_t>(sizes.size()) || begin < 0
+        || begin >= end || end > sizes.at(tensor_id)) {
+      is_out_of_bounds = true;
+      return;
+    }
+    FOR_RANGE(int64_t, i, begin, end) { visit_cnts.at(tensor_id)[i] += 1; }
+  });
+  if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+  EXPECT_FALSE(is_out_of_bounds);
+  FOR_RANGE(size_t, tensor_id, 0, sizes.size()) {
+    FOR_RANGE(int64_t, i, 0, sizes.at(tensor_id)) {
+      EXPECT_EQ(visit_cnts.at(tensor_id)[i], 1) << "tensor: " << tensor_id << " element: " << i;
+    }
+  }
+  return range_num;
+}
+
+}  // namespace
+
+TEST(ForEachMultiTensorRange, small_tensors) {
+  // one chunk, one range per non-empty tensor
+  const std::vector<int64_t> sizes = {0, 1, 7, 0, 1000, 3, 0};
+  ASSERT_EQ(TestMultiTensorRanges(sizes, 0), 4);
+  ASSERT_EQ(TestMultiTensorRanges(sizes, 4), 4);
+  ASSERT_EQ(TestMultiTensorRanges({}, 4), 0);
+  ASSERT_EQ(TestMultiTensorRanges({0, 0}, 4), 0);
+}
+
+TEST(ForEachMultiTensorRange, chunk_boundaries) {
+  // the chunk boundaries fall within tensors, at their ends and at empty ones
+  const int64_t grain = 32 * 1024;
+  TestMultiTensorRanges({grain - 1, 1, grain, 0, grain + 1, 7, 3 * grain + 5}, 0);
+  TestMultiTensorRanges({grain - 1, 1, grain, 0, grain + 1, 7, 3 * grain + 5}, 4);
+  TestMultiTensorRanges({1, 10 * grain, 1}, 3);
+  std::vector<int64_t> many_small_sizes;
+  FOR_RANGE(int64_t, i, 0, 1000) { many_small_sizes.push_back(i % 200); }
+  TestMultiTensorRanges(many_small_sizes, 4);
+  // a single big tensor is split
+  ASSERT_GT(TestMultiTensorRanges({8 * grain + 3}, 4), 1);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -806,6 +806,129 @@ REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, float, float);
 REGISTER_LARS_UPDATE_KERNEL(DeviceType::kGPU, double, double);
 #endif  // WITH_CUDA
 
+template<typename T>
+const T* GetScaleByPtr(user_op::KernelComputeContext* ctx) {
+  if (!ctx->user_op_conf().has_input("scale_by_tensor", 0)) { return nullptr; }
+  const user_op::Tensor* scale_by_tensor = ctx->Tensor4ArgNameAndIndex("scale_by_tensor", 0);
+  CHECK_EQ(scale_by_tensor->data_type(), GetDataType<T>::value);
+  CHECK_EQ(scale_by_tensor->shape().elem_cnt(), 1);
+  return scale_by_tensor->dptr<T>();
+}
+
+const int64_t* GetSkipIfPtr(user_op::KernelComputeContext* ctx) {
+  if (!ctx->user_op_conf().has_input("skip_if", 0)) { return nullptr; }
+  const user_op::Tensor* skip_if = ctx->Tensor4ArgNameAndIndex("skip_if", 0);
+  CHECK_EQ(skip_if->shape().elem_cnt(), 1);
+  return skip_if->dptr<int64_t>();
+}
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorSGDUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorSGDUpdateKernel() = default;
+  ~MultiTensorSGDUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    std::vector<SGDUpdateParam<T, G>> params(ctx->user_op_conf().input_size("model"));
+    FOR_RANGE(int32_t, i, 0, params.size()) {
+      user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+      params.at(i).n = model->shape().elem_cnt();
+      params.at(i).model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i)->dptr<G>();
+      params.at(i).model = model->mut_dptr<T>();
+    }
+    MultiTensorSGDUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), params, static_cast<T>(ctx->Attr<double>("scale")),
+        ctx->Attr<float>("l1"), ctx->Attr<float>("l2"), ctx->Attr<float>("weight_decay"),
+        learning_rate->dptr<float>(), GetScaleByPtr<T>(ctx), GetSkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(device, dtype, gtype)                    \
+  REGISTER_USER_KERNEL("multi_tensor_sgd_update")                                        \
+      .SetCreateFn<MultiTensorSGDUpdateKernel<device, dtype, gtype>>()                   \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)                               \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       & (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_SGD_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorMomentumUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorMomentumUpdateKernel() = default;
+  ~MultiTensorMomentumUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    std::vector<MomentumUpdateParam<T, G>> params(ctx->user_op_conf().input_size("model"));
+    FOR_RANGE(int32_t, i, 0, params.size()) {
+      user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+      params.at(i).n = model->shape().elem_cnt();
+      params.at(i).model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i)->dptr<G>();
+      params.at(i).model = model->mut_dptr<T>();
+      params.at(i).momentum = ctx->Tensor4ArgNameAndIndex("momentum", i)->mut_dptr<T>();
+    }
+    MultiTensorMomentumUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), params, static_cast<T>(ctx->Attr<double>("scale")),
+        ctx->Attr<float>("l1"), ctx->Attr<float>("l2"), ctx->Attr<float>("beta"),
+        ctx->Attr<float>("weight_decay"), learning_rate->dptr<float>(), GetScaleByPtr<T>(ctx),
+        GetSkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(device, dtype, gtype)               \
+  REGISTER_USER_KERNEL("multi_tensor_momentum_update")                                   \
+      .SetCreateFn<MultiTensorMomentumUpdateKernel<device, dtype, gtype>>()              \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)                               \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       & (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_MOMENTUM_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+
+template<DeviceType device_type, typename T, typename G>
+class MultiTensorAdamUpdateKernel final : public user_op::OpKernel {
+ public:
+  MultiTensorAdamUpdateKernel() = default;
+  ~MultiTensorAdamUpdateKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* learning_rate = ctx->Tensor4ArgNameAndIndex("learning_rate", 0);
+    std::vector<AdamUpdateParam<T, G>> params(ctx->user_op_conf().input_size("model"));
+    FOR_RANGE(int32_t, i, 0, params.size()) {
+      user_op::Tensor* model = ctx->Tensor4ArgNameAndIndex("model", i);
+      params.at(i).n = model->shape().elem_cnt();
+      params.at(i).model_diff = ctx->Tensor4ArgNameAndIndex("model_diff", i)->dptr<G>();
+      params.at(i).model = model->mut_dptr<T>();
+      params.at(i).m = ctx->Tensor4ArgNameAndIndex("m", i)->mut_dptr<T>();
+      params.at(i).v = ctx->Tensor4ArgNameAndIndex("v", i)->mut_dptr<T>();
+    }
+    MultiTensorAdamUpdateKernelUtil<device_type, T, G>::Update(
+        ctx->device_ctx(), params, static_cast<T>(ctx->Attr<double>("scale")),
+        ctx->Attr<float>("l1"), ctx->Attr<float>("l2"), ctx->Attr<float>("beta1"),
+        ctx->Attr<float>("beta2"), ctx->Attr<float>("epsilon"), ctx->Attr<float>("weight_decay"),
+        learning_rate->dptr<float>(), GetScaleByPtr<T>(ctx), GetSkipIfPtr(ctx));
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
+};
+
+#define REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(device, dtype, gtype)                   \
+  REGISTER_USER_KERNEL("multi_tensor_adam_update")                                       \
+      .SetCreateFn<MultiTensorAdamUpdateKernel<device, dtype, gtype>>()                  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == device)                               \
+                       & (user_op::HobDataType("model", 0) == GetDataType<dtype>::value) \
+                       & (user_op::HobDataType("model_diff", 0) == GetDataType<gtype>::value));
+
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, float, float);
+REGISTER_MULTI_TENSOR_ADAM_UPDATE_KERNEL(DeviceType::kCPU, double, double);
+
 }  // namespace
 
 }  // namespace oneflow
@@ -22,6 +22,7 @@ limitations under the License.
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/user/image/random_crop_generator.h"
 #include "oneflow/user/image/image_util.h"
+#include "oneflow/user/image/jpeg_decoder.h"
 #include "oneflow/user/kernels/random_crop_kernel_state.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 #include "oneflow/user/kernels/random_seed_util.h"
@@ -167,20 +168,41 @@ void DecodeRandomCropImageFromOneRecord(const OFRecord& record, TensorBuffer* bu
   CHECK(feature.bytes_list().value_size() == 1);
   const std::string& src_data = feature.bytes_list().value(0);
 
+  const unsigned char* src_ptr = reinterpret_cast<const unsigned char*>(src_data.data());
+  CropWindow crop;
+  bool has_crop = false;
+  int W = 0;
+  int H = 0;
+  if (random_crop_gen != nullptr && JpegGetImageSize(src_ptr, src_data.size(), &W, &H)) {
+    // decode only the crop window of a JPEG image
+    random_crop_gen->GenerateCropWindow({H, W}, &crop);
+    has_crop = true;
+    std::vector<unsigned char> image;
+    if (JpegDecodeRoi(src_ptr, src_data.size(), color_space, crop.anchor.At(1), crop.anchor.At(0),
+                      crop.shape.At(1), crop.shape.At(0), 0, 0, &image, &W, &H)) {
+      const int c = ImageUtil::IsColor(color_space) ? 3 : 1;
+      Shape image_shape({H, W, c});
+      buffer->Resize(image_shape, DataType::kUInt8);
+      CHECK_EQ(image_shape.elem_cnt(), buffer->nbytes());
+      CHECK_EQ(image_shape.elem_cnt(), static_cast<int64_t>(image.size()));
+      memcpy(buffer->mut_data<uint8_t>(), image.data(), image_shape.elem_cnt());
+      return;
+    }
+  }
+
   // cv::_InputArray image_data(src_data.data(), src_data.size());
   // cv::Mat image = cv::imdecode(image_data, cv::IMREAD_ANYCOLOR);
   cv::Mat image =
       cv::imdecode(cv::Mat(1, src_data.size(), CV_8UC1, (void*)(src_data.data())),  // NOLINT
                    ImageUtil::IsColor(color_space) ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
-  int W = image.cols;
-  int H = image.rows;
+  W = image.cols;
+  H = image.rows;
 
   // random crop
   if (random_crop_gen != nullptr) {
     CHECK(image.data != nullptr);
     cv::Mat image_roi;
-    CropWindow crop;
-    random_crop_gen->GenerateCropWindow({H, W}, &crop);
+    if (!has_crop) { random_crop_gen->GenerateCropWindow({H, W}, &crop); }
     const int y = crop.anchor.At(0);
     const int x = crop.anchor.At(1);
     const int newH = crop.shape.At(0);
@@ -0,0 +1,139 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/device/cpu_device_context.h"
+#include "oneflow/core/ndarray/ndarray_util.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/user/kernels/softmax_cpu_kernel_util.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+// softmax composed from the ndarray primitives, which take a pass over the data for each step and
+// need n * w elements of temp storage for the reductions
+template<typename T>
+class NdarraySoftmax final {
+ public:
+  NdarraySoftmax(int64_t n, int64_t w) : n_(n), w_(w), reduce_tmp_(n * w), row_tmp_(n) {}
+
+  void ComputeProb(const T* in, T* prob) {
+    using NdUtil = NdarrayUtil<DeviceType::kCPU, T>;
+    auto Val = NdUtil::GetValNdarrayBuilder();
+    auto Var = NdUtil::GetVarNdarrayBuilder();
+    NdUtil::ReduceMax(&ctx_, Var({n_, 1}, row_tmp_.data()), Val({n_, w_}, in),
+                      Var({n_ * w_}, reduce_tmp_.data()));
+    NdUtil::BroadcastSub(&ctx_, Var({n_, w_}, prob), Val({n_, w_}, in),
+                         Val({n_, 1}, row_tmp_.data()));
+    NdUtil::InplaceExp(&ctx_, Var({n_, w_}, prob));
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, row_tmp_.data()), Val({n_, w_}, prob),
+                      Var({n_ * w_}, reduce_tmp_.data()));
+    NdUtil::InplaceBroadcastDiv(&ctx_, Var({n_, w_}, prob), Val({n_, 1}, row_tmp_.data()));
+  }
+
+  void ComputeDiff(const T* dy, const T* out, T* dx) {
+    using NdUtil = NdarrayUtil<DeviceType::kCPU, T>;
+    auto Val = NdUtil::GetValNdarrayBuilder();
+    auto Var = NdUtil::GetVarNdarrayBuilder();
+    NdUtil::Mul(&ctx_, Var({n_ * w_}, dx), Val({n_ * w_}, out), Val({n_ * w_}, dy));
+    NdUtil::ReduceSum(&ctx_, Var({n_, 1}, row_tmp_.data()), Val({n_, w_}, dx),
+                      Var({n_ * w_}, reduce_tmp_.data()));
+    NdUtil::BroadcastSub(&ctx_, Var({n_, w_}, dx), Val({n_, w_}, dy),
+                         Val({n_, 1}, row_tmp_.data()));
+    NdUtil::InplaceMul(&ctx_, Var({n_ * w_}, dx), Val({n_ * w_}, out));
+  }
+
+ private:
+  CpuDeviceCtx ctx_;
+  int64_t n_;
+  int64_t w_;
+  std::vector<T> reduce_tmp_;
+  std::vector<T> row_tmp_;
+};
+
+template<typename T>
+double MaxAbsDiff(const std::vector<T>& a, const std::vector<T>& b) {
+  double ret = 0;
+  FOR_RANGE(size_t, i, 0, a.size()) { ret = std::max<double>(ret, std::abs(a.at(i) - b.at(i))); }
+  return ret;
+}
+
+template<typename F>
+double AverageMillis(int64_t iter_num, const F& Run) {
+  Run();
+  const auto start = std::chrono::steady_clock::now();
+  FOR_RANGE(int64_t, i, 0, iter_num) { Run(); }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+         / iter_num;
+}
+
+template<typename T>
+void BenchmarkSoftmax(int64_t n, int64_t w, int64_t iter_num) {
+  const int64_t elem_cnt = n * w;
+  std::mt19937 gen(0);
+  std::normal_distribution<T> dis(0, 4);
+  std::uniform_int_distribution<int32_t> label_dis(0, w - 1);
+  std::vector<T> in(elem_cnt), dy(elem_cnt);
+  std::vector<int32_t> labels(n);
+  for (T& v : in) { v = dis(gen); }
+  for (T& v : dy) { v = dis(gen); }
+  for (int32_t& label : labels) { label = label_dis(gen); }
+  std::vector<T> prob(elem_cnt), dx(elem_cnt), ref_prob(elem_cnt), ref_dx(elem_cnt), entropy(n);
+  NdarraySoftmax<T> ref(n, w);
+  const double ref_prob_ms =
+      AverageMillis(iter_num, [&]() { ref.ComputeProb(in.data(), ref_prob.data()); });
+  const double prob_ms = AverageMillis(iter_num, [&]() {
+    SoftmaxCpuKernelUtil<T>::ComputeProb(n, w, in.data(), prob.data());
+  });
+  const double ref_diff_ms = AverageMillis(
+      iter_num, [&]() { ref.ComputeDiff(dy.data(), ref_prob.data(), ref_dx.data()); });
+  const double diff_ms = AverageMillis(iter_num, [&]() {
+    SoftmaxCpuKernelUtil<T>::ComputeDiff(n, w, dy.data(), prob.data(), dx.data());
+  });
+  const double entropy_ms = AverageMillis(iter_num, [&]() {
+    SparseSoftmaxCrossEntropyCpuKernelUtil<T, int32_t>::ComputeProbAndEntropy(
+        n, w, w, 0, in.data(), labels.data(), prob.data(), entropy.data());
+  });
+  std::cout << DataType_Name(GetDataType<T>::value) << " " << n << "x" << w
+            << " prob ms: " << ref_prob_ms << " -> " << prob_ms << " diff ms: " << ref_diff_ms
+            << " -> " << diff_ms << " prob and entropy ms: " << entropy_ms
+            << " max diff prob: " << MaxAbsDiff(prob, ref_prob) << " dx: " << MaxAbsDiff(dx, ref_dx)
+            << std::endl;
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+DEFINE_int64(thread_num, 8, "number of threads of the compute thread pool");
+DEFINE_int64(iter_num, 20, "number of iterations every case is timed over");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  std::cout << std::setprecision(6);
+  Global<ThreadPool>::New(FLAGS_thread_num);
+  // attention scores, classifiers, and a few long rows of large vocabularies
+  for (const auto& shape : std::vector<std::pair<int64_t, int64_t>>{
+           {65536, 128}, {4096, 1000}, {1024, 32000}, {8, 1000000}}) {
+    BenchmarkSoftmax<float>(shape.first, shape.second, FLAGS_iter_num);
+    BenchmarkSoftmax<double>(shape.first, shape.second, FLAGS_iter_num);
+  }
+  Global<ThreadPool>::Delete();
+  return 0;
+}
@@ -0,0 +1,210 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/softmax_cpu_kernel_util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/kernel/cpu_vectorizable_math.h"
+#include "oneflow/core/kernel/kernel_util.cuh"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace {
+
+// rows are handed to the workers in chunks of at least kParallelGrainElemCnt elements
+constexpr int64_t kParallelGrainElemCnt = 32 * 1024;
+// a row is processed as kLaneNum interleaved lanes, each with its own accumulators, so that the
+// loops vectorize without reassociating floating point sums
+constexpr int64_t kLaneNum = 8;
+// the exps of a block of kSoftmaxBlockSize elements are summed while they are still in l1
+constexpr int64_t kSoftmaxBlockSize = 1024;
+
+void ParallelForRows(int64_t row_num, int64_t row_size,
+                     const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  ThreadPool* thread_pool = Global<ThreadPool>::Get();
+  const int64_t grain_size =
+      std::max<int64_t>(kParallelGrainElemCnt / std::max<int64_t>(row_size, 1), 1);
+  if (thread_pool == nullptr || row_num <= grain_size) {
+    Handler(0, row_num);
+  } else {
+    thread_pool->ParallelFor(0, row_num, grain_size, Handler);
+  }
+}
+
+template<typename T>
+T LaneMax(const T* x, int64_t n) {
+  T lane_max[kLaneNum];
+  std::fill(lane_max, lane_max + kLaneNum, -std::numeric_limits<T>::infinity());
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    FOR_RANGE(int64_t, l, 0, kLaneNum) {
+      const T val = x[i * kLaneNum + l];
+      lane_max[l] = val > lane_max[l] ? val : lane_max[l];
+    }
+  }
+  T max = -std::numeric_limits<T>::infinity();
+  FOR_RANGE(int64_t, l, 0, kLaneNum) { max = lane_max[l] > max ? lane_max[l] : max; }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) { max = x[i] > max ? x[i] : max; }
+  return max;
+}
+
+// exp[i] = exp(x[i] - max), and returns the sum of them
+template<typename T>
+T LaneExpSum(const T* x, int64_t n, T max, T* exp) {
+  T lane_sum[kLaneNum] = {0};
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    FOR_RANGE(int64_t, l, 0, kLaneNum) {
+      const int64_t idx = i * kLaneNum + l;
+      exp[idx] = VectorizableExp(x[idx] - max);
+      lane_sum[l] += exp[idx];
+    }
+  }
+  T sum = 0;
+  FOR_RANGE(int64_t, l, 0, kLaneNum) { sum += lane_sum[l]; }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) {
+    exp[i] = VectorizableExp(x[i] - max);
+    sum += exp[i];
+  }
+  return sum;
+}
+
+template<typename T>
+T LaneDot(const T* x, const T* y, int64_t n) {
+  T lane_sum[kLaneNum] = {0};
+  const int64_t step_num = n / kLaneNum;
+  FOR_RANGE(int64_t, i, 0, step_num) {
+    FOR_RANGE(int64_t, l, 0, kLaneNum) { lane_sum[l] += x[i * kLaneNum + l] * y[i * kLaneNum + l]; }
+  }
+  T sum = 0;
+  FOR_RANGE(int64_t, l, 0, kLaneNum) { sum += lane_sum[l]; }
+  FOR_RANGE(int64_t, i, step_num * kLaneNum, n) { sum += x[i] * y[i]; }
+  return sum;
+}
+
+// The running max and sum of exps of the row are updated block by block, the sum being rescaled
+// when the max grows. The exps of every block are relative to its own max, kept in block_max, and
+// are scaled to the probabilities once the row is done.
+template<typename T>
+void SoftmaxRow(const T* in, int64_t n, T* prob, std::vector<T>* block_max) {
+  const int64_t block_num = (n + kSoftmaxBlockSize - 1) / kSoftmaxBlockSize;
+  block_max->resize(block_num);
+  T row_max = -std::numeric_limits<T>::infinity();
+  T row_sum = 0;
+  FOR_RANGE(int64_t, b, 0, block_num) {
+    const int64_t offset = b * kSoftmaxBlockSize;
+    const int64_t size = std::min(kSoftmaxBlockSize, n - offset);
+    const T max = LaneMax(in + offset, size);
+    block_max->at(b) = max;
+    if (max == -std::numeric_limits<T>::infinity()) {
+      // exp(-inf - -inf) would be nan, while these probabilities are 0 unless all the row is -inf
+      std::fill(prob + offset, prob + offset + size, static_cast<T>(0));
+      continue;
+    }
+    const T sum = LaneExpSum(in + offset, size, max, prob + offset);
+    if (max > row_max) {
+      row_sum = row_sum * std::exp(row_max - max) + sum;
+      row_max = max;
+    } else {
+      row_sum += sum * std::exp(max - row_max);
+    }
+  }
+  const T inv_row_sum = static_cast<T>(1) / row_sum;
+  FOR_RANGE(int64_t, b, 0, block_num) {
+    const int64_t offset = b * kSoftmaxBlockSize;
+    const int64_t size = std::min(kSoftmaxBlockSize, n - offset);
+    const T scale = std::exp(block_max->at(b) - row_max) * inv_row_sum;
+    T* block_prob = prob + offset;
+    FOR_RANGE(int64_t, i, 0, size) { block_prob[i] *= scale; }
+  }
+}
+
+}  // namespace
+
+template<typename T>
+void SoftmaxCpuKernelUtil<T>::ComputeProb(int64_t num_instances, int64_t num_classes, const T* in,
+                                          T* prob) {
+  ParallelForRows(num_instances, num_classes, [&](int64_t begin, int64_t end) {
+    std::vector<T> block_max;
+    FOR_RANGE(int64_t, i, begin, end) {
+      SoftmaxRow(in + i * num_classes, num_classes, prob + i * num_classes, &block_max);
+    }
+  });
+}
+
+template<typename T>
+void SoftmaxCpuKernelUtil<T>::ComputeDiff(int64_t num_instances, int64_t num_classes,
+                                          const T* dy, const T* out, T* dx) {
+  ParallelForRows(num_instances, num_classes, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const int64_t offset = i * num_classes;
+      const T* dy_row = dy + offset;
+      const T* out_row = out + offset;
+      T* dx_row = dx + offset;
+      const T dot = LaneDot(dy_row, out_row, num_classes);
+      FOR_RANGE(int64_t, j, 0, num_classes) { dx_row[j] = (dy_row[j] - dot) * out_row[j]; }
+    }
+  });
+}
+
+template<typename T, typename K>
+void SparseSoftmaxCrossEntropyCpuKernelUtil<T, K>::ComputeProbAndEntropy(
+    int64_t num_instances, int64_t num_classes, int64_t depth, int64_t lower_bound,
+    const T* prediction, const K* labels, T* prob, T* y) {
+  ParallelForRows(num_instances, num_classes, [&](int64_t begin, int64_t end) {
+    std::vector<T> block_max;
+    FOR_RANGE(int64_t, i, begin, end) {
+      T* prob_row = prob + i * num_classes;
+      SoftmaxRow(prediction + i * num_classes, num_classes, prob_row, &block_max);
+      CHECK_GE(labels[i], 0);
+      CHECK_LT(labels[i], depth);
+      const int64_t label = labels[i] - lower_bound;
+      if (label >= 0 && label < num_classes) { y[i] = -SafeLog(prob_row[label]); }
+    }
+  });
+}
+
+template<typename T, typename K>
+void SparseSoftmaxCrossEntropyCpuKernelUtil<T, K>::ComputeDiff(int64_t num_instances,
+                                                               int64_t num_classes, int64_t depth,
+                                                               int64_t lower_bound, const T* prob,
+                                                               const K* labels, const T* dy,
+                                                               T* dx) {
+  ParallelForRows(num_instances, num_classes, [&](int64_t begin, int64_t end) {
+    FOR_RANGE(int64_t, i, begin, end) {
+      const int64_t offset = i * num_classes;
+      const T* prob_row = prob + offset;
+      T* dx_row = dx + offset;
+      const T row_dy = dy[i];
+      FOR_RANGE(int64_t, j, 0, num_classes) { dx_row[j] = row_dy * prob_row[j]; }
+      CHECK_GE(labels[i], 0);
+      CHECK_LT(labels[i], depth);
+      const int64_t label = labels[i] - lower_bound;
+      if (label >= 0 && label < num_classes) { dx_row[label] -= row_dy; }
+    }
+  });
+}
+
+template struct SoftmaxCpuKernelUtil<float>;
+template struct SoftmaxCpuKernelUtil<double>;
+
+#define INSTANTIATE_SPARSE_SOFTMAX_CROSS_ENTROPY_CPU_KERNEL_UTIL(data_type_pair, index_type_pair) \
+  template struct SparseSoftmaxCrossEntropyCpuKernelUtil<OF_PP_PAIR_FIRST(data_type_pair),        \
+                                                         OF_PP_PAIR_FIRST(index_type_pair)>;
+OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(INSTANTIATE_SPARSE_SOFTMAX_CROSS_ENTROPY_CPU_KERNEL_UTIL,
+                                 FLOATING_DATA_TYPE_SEQ, INDEX_DATA_TYPE_SEQ);
+#undef INSTANTIATE_SPARSE_SOFTMAX_CROSS_ENTROPY_CPU_KERNEL_UTIL
+
+}  // namespace oneflow
@@ -0,0 +1,51 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_SOFTMAX_CPU_KERNEL_UTIL_H_
+#define ONEFLOW_USER_KERNELS_SOFTMAX_CPU_KERNEL_UTIL_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// Softmax on CPU over num_instances rows of num_classes elements, without temp storage. The max
+// and the sum of exps of a row are gathered in one pass over the input (online softmax), the exps
+// being stored to prob and scaled in place while the row is still in cache. The rows are spread
+// over the compute thread pool.
+template<typename T>
+struct SoftmaxCpuKernelUtil final {
+  static void ComputeProb(int64_t num_instances, int64_t num_classes, const T* in, T* prob);
+  // dx = (dy - sum(dy * out)) * out, dx may be dy
+  static void ComputeDiff(int64_t num_instances, int64_t num_classes, const T* dy, const T* out,
+                          T* dx);
+};
+
+// Softmax cross entropy with one label per row in [0, depth), of which the rows hold the classes
+// [lower_bound, lower_bound + num_classes)
+template<typename T, typename K>
+struct SparseSoftmaxCrossEntropyCpuKernelUtil final {
+  // prob = softmax(prediction) and y = -log(prob[label]) of the rows holding their label, in one
+  // pass over the rows
+  static void ComputeProbAndEntropy(int64_t num_instances, int64_t num_classes, int64_t depth,
+                                    int64_t lower_bound, const T* prediction, const K* labels,
+                                    T* prob, T* y);
+  // dx = dy * (prob - onehot(label)), dx may be prob
+  static void ComputeDiff(int64_t num_instances, int64_t num_classes, int64_t depth,
+                          int64_t lower_bound, const T* prob, const K* labels, const T* dy, T* dx);
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_SOFTMAX_CPU_KERNEL_UTIL_H_
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/user/kernels/sparse_cross_entropy_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.cuh"
+#include "oneflow/user/kernels/softmax_cpu_kernel_util.h"
 
 namespace oneflow {
 namespace user_op {
@@ -49,19 +50,8 @@ struct SparseCrossEntropyKernelUtil<DeviceType::kCPU, T, K> {
                                      const int64_t num_classes, const int64_t depth,
                                      const int64_t lower_bound, const T* prob, const K* labels,
                                      const T* dy, T* dx) {
-    FOR_RANGE(int64_t, i, 0, elem_cnt) {
-      const int32_t row_id = i / num_classes;
-      const int32_t col_id = i - row_id * num_classes;
-      CHECK_GE(labels[row_id], 0);
-      CHECK_LT(labels[row_id], depth);
-      K label = labels[row_id] - lower_bound;
-
-      if (label == col_id) {
-        dx[i] = dy[row_id] * (prob[i] - 1);
-      } else {
-        dx[i] = dy[row_id] * prob[i];
-      }
-    }
+    SparseSoftmaxCrossEntropyCpuKernelUtil<T, K>::ComputeDiff(
+        elem_cnt / num_classes, num_classes, depth, lower_bound, prob, labels, dy, dx);
   }
 };
 
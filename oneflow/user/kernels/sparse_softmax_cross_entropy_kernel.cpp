@@ -17,10 +17,38 @@ limitations under the License.
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/user/kernels/sparse_cross_entropy_kernel_util.h"
 #include "oneflow/user/kernels/softmax_kernel_util.h"
+#include "oneflow/user/kernels/softmax_cpu_kernel_util.h"
 
 namespace oneflow {
 namespace user_op {
 
+namespace {
+
+template<DeviceType device_type, typename T, typename K>
+struct SparseSoftmaxCrossEntropyForward final {
+  static void Compute(DeviceCtx* ctx, int64_t num_instances, int64_t num_classes, int64_t depth,
+                      const T* prediction, const K* label, T* prob, void* tmp_buffer,
+                      size_t tmp_buffer_bytes, T* out) {
+    SoftmaxKernelUtil<device_type, T>::ComputeProb(ctx, num_instances, num_classes, prediction,
+                                                   prob, tmp_buffer, tmp_buffer_bytes);
+    SparseCrossEntropyKernelUtil<device_type, T, K>::ComputeEntropy(
+        ctx, num_instances, num_classes, depth, 0, prob, label, out);
+  }
+};
+
+// the entropy of a row is taken right after its prob, while the row is in cache
+template<typename T, typename K>
+struct SparseSoftmaxCrossEntropyForward<DeviceType::kCPU, T, K> final {
+  static void Compute(DeviceCtx* ctx, int64_t num_instances, int64_t num_classes, int64_t depth,
+                      const T* prediction, const K* label, T* prob, void* tmp_buffer,
+                      size_t tmp_buffer_bytes, T* out) {
+    SparseSoftmaxCrossEntropyCpuKernelUtil<T, K>::ComputeProbAndEntropy(
+        num_instances, num_classes, depth, 0, prediction, label, prob, out);
+  }
+};
+
+}  // namespace
+
 template<DeviceType device_type, typename T, typename K>
 class SparseSoftmaxCrossEntropyKernel final : public user_op::OpKernel {
  public:
@@ -37,14 +65,11 @@ class SparseSoftmaxCrossEntropyKernel final : public user_op::OpKernel {
     const int64_t num_instances = label->shape().elem_cnt();
     CHECK_EQ(prediction->shape().elem_cnt() % num_instances, 0);
     const int64_t num_classes = prediction->shape().elem_cnt() / num_instances;
-    const int64_t lower_bound = 0;
     const int64_t depth = ctx->Attr<int64_t>("depth");
-    SoftmaxKernelUtil<device_type, T>::ComputeProb(
-        ctx->device_ctx(), num_instances, num_classes, prediction->dptr<T>(), prob->mut_dptr<T>(),
-        tmp_buffer->mut_dptr(), tmp_buffer->shape().elem_cnt());
-    SparseCrossEntropyKernelUtil<device_type, T, K>::ComputeEntropy(
-        ctx->device_ctx(), num_instances, num_classes, depth, lower_bound, prob->dptr<T>(),
-        label->dptr<K>(), out->mut_dptr<T>());
+    SparseSoftmaxCrossEntropyForward<device_type, T, K>::Compute(
+        ctx->device_ctx(), num_instances, num_classes, depth, prediction->dptr<T>(),
+        label->dptr<K>(), prob->mut_dptr<T>(), tmp_buffer->mut_dptr(),
+        tmp_buffer->shape().elem_cnt(), out->mut_dptr<T>());
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
 };
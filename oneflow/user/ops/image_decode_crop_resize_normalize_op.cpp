@@ -0,0 +1,113 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/image/image_util.h"
+
+namespace oneflow {
+
+// image_decode, image_random_crop, image_resize_to_fixed and crop_mirror_normalize in one op, which
+// writes every image straight into its place in the batch
+REGISTER_CPU_ONLY_USER_OP("image_decode_crop_resize_normalize")
+    .Input("in")
+    .OptionalInput("mirror")
+    .Output("out")
+    .Attr<std::string>("color_space", "BGR")
+    .Attr<int64_t>("target_width", 0)
+    .Attr<int64_t>("target_height", 0)
+    .Attr<std::string>("interpolation_type", "bilinear")
+    .Attr<bool>("random_crop", true)
+    .Attr<int32_t>("num_attempts", 10)
+    .Attr<int64_t>("seed", -1)
+    .Attr<bool>("has_seed", false)
+    .Attr<std::vector<float>>("random_area", {0.08, 1.0})
+    .Attr<std::vector<float>>("random_aspect_ratio", {0.75, 1.333333})
+    .Attr<std::vector<float>>("mean", {0.0})
+    .Attr<std::vector<float>>("std", {1.0})
+    .Attr<std::string>("output_layout", "NCHW")
+    .Attr<DataType>("output_dtype", DataType::kFloat)
+    .SetCheckAttrFn([](const user_op::UserOpDefWrapper& def,
+                       const user_op::UserOpConfWrapper& conf) -> Maybe<void> {
+      bool check_failed = false;
+      std::ostringstream err;
+      err << "Illegal attr value for " << conf.op_type_name() << " op, op_name: " << conf.op_name();
+      const std::string& color_space = conf.attr<std::string>("color_space");
+      if (color_space != "BGR" && color_space != "RGB" && color_space != "GRAY") {
+        err << ", color_space: " << color_space
+            << " (color_space can only be one of BGR, RGB and GRAY)";
+        check_failed = true;
+      }
+      int64_t target_width = conf.attr<int64_t>("target_width");
+      int64_t target_height = conf.attr<int64_t>("target_height");
+      if (target_width <= 0 || target_height <= 0) {
+        err << ", target_width: " << target_width << ", target_height: " << target_height;
+        check_failed = true;
+      }
+      const std::string& interp_type = conf.attr<std::string>("interpolation_type");
+      if (!CheckInterpolationValid(interp_type, err)) { check_failed = true; }
+      const std::string& output_layout = conf.attr<std::string>("output_layout");
+      if (output_layout != "NCHW" && output_layout != "NHWC") {
+        err << ", output_layout: " << output_layout << " (only support NCHW and NHWC)";
+        check_failed = true;
+      }
+      DataType output_dtype = conf.attr<DataType>("output_dtype");
+      if (output_dtype != DataType::kFloat && output_dtype != DataType::kFloat16) {
+        err << ", output_dtype: " << output_dtype << " (only support kFloat and kFloat16)";
+        check_failed = true;
+      }
+      if (check_failed) { return oneflow::Error::CheckFailedError() << err.str(); }
+      return Maybe<void>::Ok();
+    })
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc* in_tensor = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in_tensor->data_type(), DataType::kTensorBuffer);
+      CHECK_OR_RETURN(in_tensor->shape().NumAxes() == 1 && in_tensor->shape().At(0) >= 1);
+      const int64_t N = in_tensor->shape().At(0);
+      const user_op::TensorDesc* mirror_tensor = ctx->TensorDesc4ArgNameAndIndex("mirror", 0);
+      if (mirror_tensor) {
+        CHECK_OR_RETURN(mirror_tensor->shape().NumAxes() == 1
+                        && mirror_tensor->shape().At(0) == N);
+        CHECK_EQ_OR_RETURN(mirror_tensor->data_type(), DataType::kInt8);
+      }
+      const int64_t H = ctx->Attr<int64_t>("target_height");
+      const int64_t W = ctx->Attr<int64_t>("target_width");
+      const int64_t C = ImageUtil::IsColor(ctx->Attr<std::string>("color_space")) ? 3 : 1;
+      user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      if (ctx->Attr<std::string>("output_layout") == "NCHW") {
+        *out_tensor->mut_shape() = Shape({N, C, H, W});
+      } else {
+        *out_tensor->mut_shape() = Shape({N, H, W, C});
+      }
+      *out_tensor->mut_data_type() = ctx->Attr<DataType>("output_dtype");
+      out_tensor->set_is_dynamic(in_tensor->is_dynamic());
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder().Split(ctx->inputs(), 0).Split(ctx->outputs(), 0).Build();
+      return Maybe<void>::Ok();
+    })
+    .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper&) {
+      user_op::InputArgModifier* in_modifier = GetInputArgModifierFn("in", 0);
+      CHECK_NOTNULL(in_modifier);
+      in_modifier->set_requires_grad(false);
+    })
+    .SetBatchAxisInferFn([](user_op::BatchAxisContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->BatchAxis4ArgNameAndIndex("in", 0)->value(), 0);
+      ctx->BatchAxis4ArgNameAndIndex("out", 0)->set_value(0);
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -184,6 +184,47 @@ void SetInputArgModifierMutable(const user_op::GetInputArgModifier& GetInputArgM
   arg_modifier->set_is_mutable(true);
 }
 
+// Every variable of a multi-tensor update has its model, model_diff and the states of
+// state_arg_names, of the data types of the first one
+Maybe<void> InferMultiTensorUpdateTensorDesc(user_op::InferContext* ctx,
+                                             const std::vector<std::string>& state_arg_names) {
+  const int32_t num_models = ctx->user_op_conf().input_size("model");
+  CHECK_EQ_OR_RETURN(ctx->user_op_conf().input_size("model_diff"), num_models);
+  for (const std::string& state_arg_name : state_arg_names) {
+    CHECK_EQ_OR_RETURN(ctx->user_op_conf().input_size(state_arg_name), num_models);
+  }
+  const user_op::TensorDesc* model_0 = ctx->TensorDesc4ArgNameAndIndex("model", 0);
+  const user_op::TensorDesc* model_diff_0 = ctx->TensorDesc4ArgNameAndIndex("model_diff", 0);
+  FOR_RANGE(int32_t, i, 0, num_models) {
+    const user_op::TensorDesc* model = ctx->TensorDesc4ArgNameAndIndex("model", i);
+    CHECK_EQ_OR_RETURN(model->data_type(), model_0->data_type());
+    const user_op::TensorDesc* model_diff = ctx->TensorDesc4ArgNameAndIndex("model_diff", i);
+    CHECK_EQ_OR_RETURN(model_diff->shape(), model->shape());
+    CHECK_EQ_OR_RETURN(model_diff->data_type(), model_diff_0->data_type());
+    for (const std::string& state_arg_name : state_arg_names) {
+      JUST(CheckTensorDescLike(ctx->TensorDesc4ArgNameAndIndex(state_arg_name, i), model));
+    }
+  }
+  const user_op::TensorDesc* learning_rate = ctx->TensorDesc4ArgNameAndIndex("learning_rate", 0);
+  JUST(CheckLearningRateTenserDesc(learning_rate));
+  if (ctx->user_op_conf().has_input("scale_by_tensor", 0)) {
+    const auto* scale_by_tensor = ctx->TensorDesc4ArgNameAndIndex("scale_by_tensor", 0);
+    JUST(CheckScalarTensorDesc(scale_by_tensor, model_0->data_type()));
+  }
+  return Maybe<void>::Ok();
+}
+
+void MultiTensorUpdateInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                                       const user_op::UserOpConfWrapper& conf,
+                                       const std::vector<std::string>& state_arg_names) {
+  FOR_RANGE(int32_t, i, 0, conf.input_size("model")) {
+    SetInputArgModifierMutable(GetInputArgModifierFn, "model", i);
+    for (const std::string& state_arg_name : state_arg_names) {
+      SetInputArgModifierMutable(GetInputArgModifierFn, state_arg_name, i);
+    }
+  }
+}
+
 void AdamInputArgModifyFn(const user_op::GetInputArgModifier& GetInputArgModifierFn,
                           const user_op::UserOpConfWrapper& conf) {
   SetInputArgModifierMutable(GetInputArgModifierFn, "model", 0);
@@ -572,6 +613,74 @@ REGISTER_USER_OP("lars_update")
       SetInputArgModifierMutable(GetInputArgModifierFn, "momentum", 0);
     });
 
+// The multi-tensor updates update many variables with the same learning rate and attrs in one op,
+// which MultiTensorModelUpdatePass groups the single cpu ones into, they have cpu kernels only.
+// Every bn has sbp broadcast signature, the pass groups only the variables updated that way
+
+REGISTER_USER_OP("multi_tensor_sgd_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {});
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {});
+    });
+
+REGISTER_USER_OP("multi_tensor_momentum_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .InputWithMinimum("momentum", 1)
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("beta", 0.9)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {"momentum"});
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {"momentum"});
+    });
+
+REGISTER_USER_OP("multi_tensor_adam_update")
+    .InputWithMinimum("model", 1)
+    .InputWithMinimum("model_diff", 1)
+    .Input("learning_rate")
+    .OptionalInput("scale_by_tensor")
+    .OptionalInput("skip_if")
+    .InputWithMinimum("m", 1)
+    .InputWithMinimum("v", 1)
+    .Attr<double>("scale", 1.0)
+    .Attr<float>("l1", 0.0)
+    .Attr<float>("l2", 0.0)
+    .Attr<float>("beta1", 0.9)
+    .Attr<float>("beta2", 0.999)
+    .Attr<float>("epsilon", 1e-8)
+    .Attr<float>("weight_decay", 0.0)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferMultiTensorUpdateTensorDesc(ctx, {"m", "v"});
+    })
+    .SetBatchAxisInferFn(user_op::BatchAxisInferFnUtil::NaiveInferBatchAxis)
+    .SetInputArgModifyFn([](const user_op::GetInputArgModifier& GetInputArgModifierFn,
+                            const user_op::UserOpConfWrapper& conf) -> void {
+      MultiTensorUpdateInputArgModifyFn(GetInputArgModifierFn, conf, {"m", "v"});
+    });
+
 }  // namespace
 
 }  // namespace oneflow
@@ -27,6 +27,8 @@ REGISTER_CPU_ONLY_USER_OP("OneRecReader")
     .Attr<int32_t>("shuffle_buffer_size", 1024)
     .Attr<bool>("shuffle_after_epoch", false)
     .Attr<bool>("verify_example", true)
+    .Attr<std::string>("checksum_policy", "always")
+    .Attr<int32_t>("checksum_sample_interval", 100)
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
       int32_t local_batch_size = ctx->Attr<int32_t>("batch_size");